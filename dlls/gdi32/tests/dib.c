@@ -3529,11 +3529,267 @@ static void test_simple_graphics(void)
     DeleteDC(mem_dc);
 }
 
+/* Large operations are split into bands processed in parallel when the bits are owned by the
+ * driver (DDBs), and done serially on DIB sections. The results must be the same. */
+static void compare_banded_bits( HDC hdc, HBITMAP ddb, const DWORD *expect, int width, int height,
+                                 const char *op )
+{
+    BITMAPINFO info;
+    DWORD *bits;
+    int i, diffs = 0, first = -1;
+
+    memset( &info, 0, sizeof(info) );
+    info.bmiHeader.biSize = sizeof(info.bmiHeader);
+    info.bmiHeader.biWidth = width;
+    info.bmiHeader.biHeight = -height;
+    info.bmiHeader.biPlanes = 1;
+    info.bmiHeader.biBitCount = 32;
+    info.bmiHeader.biCompression = BI_RGB;
+
+    bits = malloc( width * height * sizeof(*bits) );
+    ok( GetDIBits( hdc, ddb, 0, height, bits, &info, DIB_RGB_COLORS ) == height, "%s: GetDIBits failed\n", op );
+    for (i = 0; i < width * height; i++)
+    {
+        if (bits[i] == expect[i]) continue;
+        if (first == -1) first = i;
+        diffs++;
+    }
+    ok( !diffs, "%s: %d pixels differ, first at %d,%d: %08lx / %08lx\n", op, diffs,
+        first % width, first / width, diffs ? bits[first] : 0, diffs ? expect[first] : 0 );
+    free( bits );
+}
+
+static void test_banded_operations(void)
+{
+    static const int width = 640, height = 600;
+    TRIVERTEX vert[4] =
+    {
+        {   0,   0, 0x1200, 0x3400, 0xff00, 0x8000 },
+        { 640, 300, 0xfe00, 0x8000, 0x0100, 0x4000 },
+        {   0, 300, 0x0000, 0xff00, 0x8000, 0xff00 },
+        { 640, 600, 0x8800, 0x0000, 0x4400, 0x0000 },
+    };
+    GRADIENT_RECT rect[2] = { { 0, 1 }, { 2, 3 } };
+    BLENDFUNCTION blend = { AC_SRC_OVER, 0, 0x80, 0 };
+    BITMAPINFO info;
+    HDC ddb_dc, ddb_src_dc, dib_dc, dib_src_dc;
+    HBITMAP ddb, ddb_src, dib, dib_src;
+    BYTE *src_bits;
+    DWORD *dib_bits;
+    HRGN rgn, rgn2;
+    int x, y, stride = (width * 3 + 3) & ~3;
+
+    memset( &info, 0, sizeof(info) );
+    info.bmiHeader.biSize = sizeof(info.bmiHeader);
+    info.bmiHeader.biWidth = width;
+    info.bmiHeader.biHeight = -height;
+    info.bmiHeader.biPlanes = 1;
+    info.bmiHeader.biBitCount = 24;
+    info.bmiHeader.biCompression = BI_RGB;
+
+    /* 24-bpp sources, so that the source bits are converted to a private copy */
+    dib_src = CreateDIBSection( 0, &info, DIB_RGB_COLORS, (void **)&src_bits, NULL, 0 );
+    ok( dib_src != NULL, "CreateDIBSection failed\n" );
+    for (y = 0; y < height; y++)
+        for (x = 0; x < stride; x++)
+            src_bits[y * stride + x] = (x * 7 + y * 13 + ((x * y) >> 5)) & 0xff;
+    ddb_src = CreateBitmap( width, height, 1, 24, NULL );
+    ok( ddb_src != NULL, "CreateBitmap failed\n" );
+
+    dib_src_dc = CreateCompatibleDC( NULL );
+    ddb_src_dc = CreateCompatibleDC( NULL );
+    SelectObject( dib_src_dc, dib_src );
+    SelectObject( ddb_src_dc, ddb_src );
+    ok( SetDIBits( ddb_src_dc, ddb_src, 0, height, src_bits, &info, DIB_RGB_COLORS ) == height,
+        "SetDIBits failed\n" );
+
+    info.bmiHeader.biBitCount = 32;
+    dib = CreateDIBSection( 0, &info, DIB_RGB_COLORS, (void **)&dib_bits, NULL, 0 );
+    ok( dib != NULL, "CreateDIBSection failed\n" );
+    ddb = CreateBitmap( width, height, 1, 32, NULL );
+    ok( ddb != NULL, "CreateBitmap failed\n" );
+    dib_dc = CreateCompatibleDC( NULL );
+    ddb_dc = CreateCompatibleDC( NULL );
+    SelectObject( dib_dc, dib );
+    SelectObject( ddb_dc, ddb );
+
+    BitBlt( dib_dc, 0, 0, width, height, dib_src_dc, 0, 0, SRCCOPY );
+    BitBlt( ddb_dc, 0, 0, width, height, ddb_src_dc, 0, 0, SRCCOPY );
+    compare_banded_bits( ddb_dc, ddb, dib_bits, width, height, "BitBlt" );
+
+    /* clipped rectangles that cross several bands */
+    rgn = CreateRectRgn( 10, 5, 300, 590 );
+    rgn2 = CreateRectRgn( 200, 100, 630, 400 );
+    CombineRgn( rgn, rgn, rgn2, RGN_OR );
+    DeleteObject( rgn2 );
+    SelectClipRgn( dib_dc, rgn );
+    SelectClipRgn( ddb_dc, rgn );
+    BitBlt( dib_dc, 0, 0, width, height, dib_src_dc, 17, 3, SRCCOPY );
+    BitBlt( ddb_dc, 0, 0, width, height, ddb_src_dc, 17, 3, SRCCOPY );
+    compare_banded_bits( ddb_dc, ddb, dib_bits, width, height, "clipped BitBlt" );
+    SelectClipRgn( dib_dc, NULL );
+    SelectClipRgn( ddb_dc, NULL );
+    DeleteObject( rgn );
+
+    SetStretchBltMode( dib_dc, COLORONCOLOR );
+    SetStretchBltMode( ddb_dc, COLORONCOLOR );
+    StretchBlt( dib_dc, 0, 0, width, height, dib_src_dc, 50, 40, 333, 277, SRCCOPY );
+    StretchBlt( ddb_dc, 0, 0, width, height, ddb_src_dc, 50, 40, 333, 277, SRCCOPY );
+    compare_banded_bits( ddb_dc, ddb, dib_bits, width, height, "StretchBlt" );
+
+    StretchBlt( dib_dc, 0, 0, width, height, dib_src_dc, 5, 7, width * 2 - 17, height * 2 - 33, SRCCOPY );
+    StretchBlt( ddb_dc, 0, 0, width, height, ddb_src_dc, 5, 7, width * 2 - 17, height * 2 - 33, SRCCOPY );
+    compare_banded_bits( ddb_dc, ddb, dib_bits, width, height, "shrinking StretchBlt" );
+
+    GdiAlphaBlend( dib_dc, 0, 0, width, height, dib_src_dc, 0, 0, width, height, blend );
+    GdiAlphaBlend( ddb_dc, 0, 0, width, height, ddb_src_dc, 0, 0, width, height, blend );
+    compare_banded_bits( ddb_dc, ddb, dib_bits, width, height, "AlphaBlend" );
+
+    GdiGradientFill( dib_dc, vert, 4, rect, 2, GRADIENT_FILL_RECT_H );
+    GdiGradientFill( ddb_dc, vert, 4, rect, 2, GRADIENT_FILL_RECT_H );
+    compare_banded_bits( ddb_dc, ddb, dib_bits, width, height, "horizontal GradientFill" );
+
+    GdiGradientFill( dib_dc, vert, 4, rect, 2, GRADIENT_FILL_RECT_V );
+    GdiGradientFill( ddb_dc, vert, 4, rect, 2, GRADIENT_FILL_RECT_V );
+    compare_banded_bits( ddb_dc, ddb, dib_bits, width, height, "vertical GradientFill" );
+
+    DeleteDC( ddb_dc );
+    DeleteDC( dib_dc );
+    DeleteDC( ddb_src_dc );
+    DeleteDC( dib_src_dc );
+    DeleteObject( ddb );
+    DeleteObject( dib );
+    DeleteObject( ddb_src );
+    DeleteObject( dib_src );
+}
+
+/* Pixel throughput of the blits, blends and conversions that have SIMD kernels.
+ * Only run when WINETEST_BENCHMARK is set; the scalar code is measured in a child
+ * process started with WINEDIBSIMD=0. */
+static void run_pixel_benchmark( const char *label )
+{
+    static const int width = 1920, height = 1080, iterations = 50;
+    static const struct
+    {
+        const char *name;
+        WORD src_bpp;
+        DWORD rop;          /* 0 for a blend */
+        BYTE const_alpha;
+        BYTE alpha_format;
+    } tests[] =
+    {
+        { "SRCINVERT",      32, SRCINVERT },
+        { "SRCAND",         32, SRCAND },
+        { "24 to 32 bpp",   24, SRCCOPY },
+        { "555 to 32 bpp",  16, SRCCOPY },
+        { "blend argb",     32, 0, 0xff, AC_SRC_ALPHA },
+        { "blend constant", 32, 0, 0x80, 0 },
+    };
+    BLENDFUNCTION blend = { AC_SRC_OVER, 0, 0, 0 };
+    BITMAPINFO info;
+    HDC dst_dc, src_dc;
+    HBITMAP dst, src, orig;
+    LARGE_INTEGER freq, start, end;
+    DWORD *dst_bits;
+    BYTE *src_bits;
+    unsigned int i, j, size;
+    double seconds;
+
+    memset( &info, 0, sizeof(info) );
+    info.bmiHeader.biSize = sizeof(info.bmiHeader);
+    info.bmiHeader.biWidth = width;
+    info.bmiHeader.biHeight = -height;
+    info.bmiHeader.biPlanes = 1;
+    info.bmiHeader.biBitCount = 32;
+    info.bmiHeader.biCompression = BI_RGB;
+    dst = CreateDIBSection( 0, &info, DIB_RGB_COLORS, (void **)&dst_bits, NULL, 0 );
+    ok( dst != NULL, "CreateDIBSection failed\n" );
+    for (i = 0; i < width * height; i++) dst_bits[i] = i * 0x01030507;
+    dst_dc = CreateCompatibleDC( NULL );
+    src_dc = CreateCompatibleDC( NULL );
+    SelectObject( dst_dc, dst );
+    QueryPerformanceFrequency( &freq );
+
+    for (i = 0; i < ARRAY_SIZE(tests); i++)
+    {
+        info.bmiHeader.biBitCount = tests[i].src_bpp;
+        src = CreateDIBSection( 0, &info, DIB_RGB_COLORS, (void **)&src_bits, NULL, 0 );
+        ok( src != NULL, "CreateDIBSection failed\n" );
+        size = ((width * tests[i].src_bpp / 8 + 3) & ~3) * height;
+        for (j = 0; j < size; j++) src_bits[j] = j * 7 + (j >> 11);
+        if (tests[i].alpha_format)  /* premultiply the source */
+            for (j = 0; j < width * height; j++)
+            {
+                BYTE *p = src_bits + 4 * j;
+                p[0] = p[0] * p[3] / 255;
+                p[1] = p[1] * p[3] / 255;
+                p[2] = p[2] * p[3] / 255;
+            }
+        orig = SelectObject( src_dc, src );
+        blend.SourceConstantAlpha = tests[i].const_alpha;
+        blend.AlphaFormat = tests[i].alpha_format;
+
+        QueryPerformanceCounter( &start );
+        for (j = 0; j < iterations; j++)
+        {
+            if (tests[i].rop) BitBlt( dst_dc, 0, 0, width, height, src_dc, 0, 0, tests[i].rop );
+            else GdiAlphaBlend( dst_dc, 0, 0, width, height, src_dc, 0, 0, width, height, blend );
+        }
+        QueryPerformanceCounter( &end );
+
+        seconds = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
+        trace( "%s: %s: %.1f Mpixels/s\n", label, tests[i].name,
+               (double)width * height * iterations / seconds / 1000000 );
+        SelectObject( src_dc, orig );
+        DeleteObject( src );
+    }
+
+    DeleteDC( src_dc );
+    DeleteDC( dst_dc );
+    DeleteObject( dst );
+}
+
+static void test_pixel_throughput(void)
+{
+    STARTUPINFOA startup = { sizeof(startup) };
+    PROCESS_INFORMATION info;
+    char cmdline[MAX_PATH * 2];
+    char **argv;
+
+    if (!GetEnvironmentVariableA( "WINETEST_BENCHMARK", NULL, 0 ))
+    {
+        skip( "set WINETEST_BENCHMARK to measure the pixel throughput\n" );
+        return;
+    }
+
+    run_pixel_benchmark( "default" );
+
+    winetest_get_mainargs( &argv );
+    sprintf( cmdline, "\"%s\" %s scalar_benchmark", argv[0], argv[1] );
+    SetEnvironmentVariableA( "WINEDIBSIMD", "0" );
+    ok( CreateProcessA( NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &startup, &info ),
+        "CreateProcess failed, error %lu\n", GetLastError() );
+    SetEnvironmentVariableA( "WINEDIBSIMD", NULL );
+    wait_child_process( &info );
+    CloseHandle( info.hProcess );
+    CloseHandle( info.hThread );
+}
+
 START_TEST(dib)
 {
+    char **argv;
+
+    if (winetest_get_mainargs( &argv ) >= 3 && !strcmp( argv[2], "scalar_benchmark" ))
+    {
+        run_pixel_benchmark( "WINEDIBSIMD=0" );
+        return;
+    }
+
     CryptAcquireContextW(&crypt_prov, NULL, NULL, PROV_RSA_FULL, CRYPT_VERIFYCONTEXT);
 
     test_simple_graphics();
+    test_banded_operations();
+    test_pixel_throughput();
 
     CryptReleaseContext(crypt_prov, 0);
 }
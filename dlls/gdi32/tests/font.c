@@ -28,6 +28,7 @@
 #include "wingdi.h"
 #include "winuser.h"
 #include "winnls.h"
+#include "winreg.h"
 #include "winternl.h"
 #include "ntgdi.h"
 
@@ -8007,6 +8008,154 @@ static void test_add_font_path(void)
     SetCurrentDirectoryW( cwd );
 }
 
+/* runs a benchmark of this test in several new processes, one after the other */
+static void run_font_children( const char *mode, int count )
+{
+    PROCESS_INFORMATION info;
+    STARTUPINFOA startup;
+    char cmdline[MAX_PATH];
+    char **argv;
+    int i;
+
+    winetest_get_mainargs( &argv );
+    for (i = 0; i < count; i++)
+    {
+        memset( &startup, 0, sizeof(startup) );
+        startup.cb = sizeof(startup);
+        sprintf( cmdline, "%s font %s", argv[0], mode );
+        ok( CreateProcessA( NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &startup, &info ),
+            "CreateProcess failed.\n" );
+        wait_child_process( &info );
+        CloseHandle( info.hProcess );
+        CloseHandle( info.hThread );
+    }
+}
+
+/* run in a child process, measures the time from the process start until the first font
+ * is created and realized, which includes loading the font list */
+static void test_first_font_time(void)
+{
+    FILETIME creation, exit_time, kernel_time, user_time, now;
+    ULARGE_INTEGER start, end;
+    TEXTMETRICA tm;
+    LOGFONTA lf;
+    HFONT hfont, old_hfont;
+    HDC hdc;
+
+    memset( &lf, 0, sizeof(lf) );
+    lf.lfHeight = -12;
+    strcpy( lf.lfFaceName, "Tahoma" );
+    hfont = CreateFontIndirectA( &lf );
+    ok( hfont != NULL, "CreateFontIndirect failed\n" );
+    hdc = CreateCompatibleDC( 0 );
+    old_hfont = SelectObject( hdc, hfont );
+    ok( GetTextMetricsA( hdc, &tm ), "GetTextMetrics failed\n" );
+    GetSystemTimePreciseAsFileTime( &now );
+
+    ok( GetProcessTimes( GetCurrentProcess(), &creation, &exit_time, &kernel_time, &user_time ),
+        "GetProcessTimes failed, error %lu\n", GetLastError() );
+    start.LowPart = creation.dwLowDateTime;
+    start.HighPart = creation.dwHighDateTime;
+    end.LowPart = now.dwLowDateTime;
+    end.HighPart = now.dwHighDateTime;
+    trace( "first font realized %.1f ms after the process start\n", (end.QuadPart - start.QuadPart) / 10000.0 );
+
+    SelectObject( hdc, old_hfont );
+    DeleteDC( hdc );
+    DeleteObject( hfont );
+}
+
+static void test_font_startup_time(void)
+{
+    if (!GetEnvironmentVariableA( "WINETEST_BENCHMARK", NULL, 0 ))
+    {
+        skip( "set WINETEST_BENCHMARK to measure the time to the first font\n" );
+        return;
+    }
+
+    /* the first process may have to build the font list caches */
+    run_font_children( "first_font_time", 5 );
+}
+
+/* run in a child process, measures the time needed to render the ASCII glyphs at various sizes */
+static void test_glyph_render_time(void)
+{
+    static const MAT2 mat = { {0,1}, {0,0}, {0,0}, {0,1} };
+    LARGE_INTEGER freq, start, end;
+    GLYPHMETRICS gm;
+    LOGFONTA lf;
+    HFONT hfont, old_hfont;
+    HDC hdc;
+    BYTE *buffer;
+    WCHAR ch;
+    int height, count = 0;
+
+    buffer = malloc( 0x10000 );
+    hdc = CreateCompatibleDC( 0 );
+    memset( &lf, 0, sizeof(lf) );
+    strcpy( lf.lfFaceName, "Tahoma" );
+
+    QueryPerformanceFrequency( &freq );
+    QueryPerformanceCounter( &start );
+    for (height = 8; height <= 48; height += 2)
+    {
+        lf.lfHeight = -height;
+        hfont = CreateFontIndirectA( &lf );
+        old_hfont = SelectObject( hdc, hfont );
+        for (ch = 0x21; ch < 0x7f; ch++, count++)
+            GetGlyphOutlineW( hdc, ch, GGO_GRAY8_BITMAP, &gm, 0x10000, buffer, &mat );
+        SelectObject( hdc, old_hfont );
+        DeleteObject( hfont );
+    }
+    QueryPerformanceCounter( &end );
+    trace( "rendered %d glyphs in %.1f ms\n", count,
+           (end.QuadPart - start.QuadPart) * 1000.0 / freq.QuadPart );
+
+    DeleteDC( hdc );
+    free( buffer );
+}
+
+/* compare the glyph rendering time of new processes with and without Wine's shared glyph cache */
+static void test_shared_glyph_cache_time(void)
+{
+    DWORD size = 16, type, len;
+    BYTE old_value[64];
+    HANDLE section;
+    LONG has_old;
+    HKEY key;
+
+    if (!GetEnvironmentVariableA( "WINETEST_BENCHMARK", NULL, 0 ))
+    {
+        skip( "set WINETEST_BENCHMARK to measure the shared glyph cache\n" );
+        return;
+    }
+    if (RegCreateKeyExA( HKEY_CURRENT_USER, "Software\\Wine\\Fonts", 0, NULL, 0,
+                         KEY_ALL_ACCESS, NULL, &key, NULL ))
+    {
+        skip( "can't open the Wine fonts key\n" );
+        return;
+    }
+    len = sizeof(old_value);
+    has_old = !RegQueryValueExA( key, "SharedGlyphCacheSize", NULL, &type, old_value, &len );
+
+    RegDeleteValueA( key, "SharedGlyphCacheSize" );
+    trace( "without the shared glyph cache:\n" );
+    run_font_children( "glyph_render_time", 3 );
+
+    RegSetValueExA( key, "SharedGlyphCacheSize", 0, REG_DWORD, (BYTE *)&size, sizeof(size) );
+    /* keep the cache alive between the child processes, the first one fills it */
+    section = CreateFileMappingA( INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, size << 20,
+                                  "Global\\__wine_glyph_cache" );
+    ok( section != NULL, "CreateFileMapping failed, error %lu\n", GetLastError() );
+    trace( "with the shared glyph cache:\n" );
+    run_font_children( "glyph_render_time", 3 );
+    CloseHandle( section );
+
+    if (has_old) RegSetValueExA( key, "SharedGlyphCacheSize", 0, type, old_value, len );
+    else RegDeleteValueA( key, "SharedGlyphCacheSize" );
+    RegCloseKey( key );
+}
+
 START_TEST(font)
 {
     static const char *test_names[] =
@@ -8025,6 +8174,10 @@ START_TEST(font)
     {
         if (!strcmp(argv[2], "AddFontMemResource"))
             test_AddFontMemResource();
+        else if (!strcmp(argv[2], "first_font_time"))
+            test_first_font_time();
+        else if (!strcmp(argv[2], "glyph_render_time"))
+            test_glyph_render_time();
         return;
     }
 
@@ -8098,6 +8251,8 @@ START_TEST(font)
     test_select_object();
     test_font_weight();
     test_add_font_path();
+    test_font_startup_time();
+    test_shared_glyph_cache_time();
 
     /* These tests should be last test until RemoveFontResource
      * is properly implemented.
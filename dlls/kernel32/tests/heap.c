@@ -3864,6 +3864,128 @@ static void test_HeapSummary(void)
     HeapDestroy( heap );
 }
 
+static DWORD WINAPI heap_threads_proc( void *arg )
+{
+    void **ptrs = arg;
+    SIZE_T size;
+    UINT i;
+
+    /* free the blocks allocated by the main thread, and allocate some for it to free */
+    for (i = 0; i < 0x400; i += 2)
+    {
+        size = HeapSize( GetProcessHeap(), 0, ptrs[i] );
+        ok( size == 8 + (i % 0x80) * 8, "%u: got size %#Ix\n", i, size );
+        ok( ((BYTE *)ptrs[i])[size - 1] == (BYTE)i, "%u: block was overwritten\n", i );
+        HeapFree( GetProcessHeap(), 0, ptrs[i] );
+        ptrs[i] = HeapAlloc( GetProcessHeap(), 0, 8 + (i % 0x80) * 8 );
+        ok( !!ptrs[i], "HeapAlloc failed, error %lu\n", GetLastError() );
+        memset( ptrs[i], (BYTE)i, 8 + (i % 0x80) * 8 );
+    }
+
+    return 0;
+}
+
+static void test_heap_threads(void)
+{
+    PROCESS_HEAP_ENTRY entry;
+    void *ptrs[0x400];
+    HANDLE thread;
+    SIZE_T size;
+    DWORD res;
+    BOOL ret;
+    UINT i;
+
+    for (i = 0; i < 0x400; i++)
+    {
+        ptrs[i] = HeapAlloc( GetProcessHeap(), 0, 8 + (i % 0x80) * 8 );
+        ok( !!ptrs[i], "HeapAlloc failed, error %lu\n", GetLastError() );
+        memset( ptrs[i], (BYTE)i, 8 + (i % 0x80) * 8 );
+    }
+
+    thread = CreateThread( NULL, 0, heap_threads_proc, ptrs, 0, NULL );
+    ok( !!thread, "CreateThread failed, error %lu\n", GetLastError() );
+    res = WaitForSingleObject( thread, 5000 );
+    ok( !res, "WaitForSingleObject returned %#lx, error %lu\n", res, GetLastError() );
+    CloseHandle( thread );
+
+    ret = HeapValidate( GetProcessHeap(), 0, NULL );
+    ok( ret, "HeapValidate failed\n" );
+
+    ret = HeapLock( GetProcessHeap() );
+    ok( ret, "HeapLock failed, error %lu\n", GetLastError() );
+    memset( &entry, 0, sizeof(entry) );
+    while ((ret = HeapWalk( GetProcessHeap(), &entry ))) continue;
+    ok( GetLastError() == ERROR_NO_MORE_ITEMS, "got error %lu\n", GetLastError() );
+    ret = HeapUnlock( GetProcessHeap() );
+    ok( ret, "HeapUnlock failed, error %lu\n", GetLastError() );
+
+    for (i = 0; i < 0x400; i++)
+    {
+        size = HeapSize( GetProcessHeap(), 0, ptrs[i] );
+        ok( size == 8 + (i % 0x80) * 8, "%u: got size %#Ix\n", i, size );
+        ok( ((BYTE *)ptrs[i])[size - 1] == (BYTE)i, "%u: block was overwritten\n", i );
+        ret = HeapFree( GetProcessHeap(), 0, ptrs[i] );
+        ok( ret, "HeapFree failed, error %lu\n", GetLastError() );
+    }
+
+    ret = HeapValidate( GetProcessHeap(), 0, NULL );
+    ok( ret, "HeapValidate failed\n" );
+}
+
+static SLIST_HEADER heap_bench_list;
+
+static DWORD WINAPI heap_bench_proc( void *arg )
+{
+    static const SIZE_T sizes[] = { 16, 24, 40, 64, 100, 160, 256, 512, 1000, 4000 };
+    UINT i, count = PtrToUlong( arg );
+    SLIST_ENTRY *entry;
+    void *ptr;
+
+    for (i = 0; i < count; i++)
+    {
+        /* free a block right away, and hand another one over to any thread */
+        ptr = HeapAlloc( GetProcessHeap(), 0, sizes[i % ARRAY_SIZE(sizes)] );
+        HeapFree( GetProcessHeap(), 0, ptr );
+        ptr = HeapAlloc( GetProcessHeap(), 0, sizes[(i * 7) % ARRAY_SIZE(sizes)] );
+        InterlockedPushEntrySList( &heap_bench_list, ptr );
+        if ((entry = InterlockedPopEntrySList( &heap_bench_list ))) HeapFree( GetProcessHeap(), 0, entry );
+    }
+    return 0;
+}
+
+/* Process heap allocations of mixed sizes, with blocks freed by other threads than the one
+ * which allocated them. Only run when WINETEST_BENCHMARK is set. */
+static void test_heap_throughput(void)
+{
+    static const UINT total = 2000000;
+    LARGE_INTEGER freq, start, end;
+    HANDLE threads[16];
+    SLIST_ENTRY *entry;
+    UINT i, count;
+
+    if (!GetEnvironmentVariableA( "WINETEST_BENCHMARK", NULL, 0 ))
+    {
+        skip( "set WINETEST_BENCHMARK to measure the heap throughput\n" );
+        return;
+    }
+
+    InitializeSListHead( &heap_bench_list );
+    QueryPerformanceFrequency( &freq );
+    for (count = 1; count <= ARRAY_SIZE(threads); count *= 2)
+    {
+        QueryPerformanceCounter( &start );
+        for (i = 0; i < count; i++)
+            threads[i] = CreateThread( NULL, 0, heap_bench_proc, ULongToPtr( total / count ), 0, NULL );
+        WaitForMultipleObjects( count, threads, TRUE, INFINITE );
+        QueryPerformanceCounter( &end );
+        for (i = 0; i < count; i++) CloseHandle( threads[i] );
+        while ((entry = InterlockedPopEntrySList( &heap_bench_list ))) HeapFree( GetProcessHeap(), 0, entry );
+
+        trace( "%2u threads: %.0f alloc/free pairs per second\n", count,
+               (double)(total / count) * count * 2 * freq.QuadPart / (end.QuadPart - start.QuadPart) );
+    }
+}
+
 START_TEST(heap)
 {
     int argc;
@@ -3885,6 +4007,7 @@ START_TEST(heap)
     test_GetPhysicallyInstalledSystemMemory();
     test_GlobalMemoryStatus();
     test_HeapSummary();
+    test_heap_threads();
     test_heap_tail_zeroing( 0 );
 
     if (pRtlGetNtGlobalFlags)
@@ -3903,4 +4026,5 @@ START_TEST(heap)
     }
     else win_skip( "RtlGetNtGlobalFlags not found, skipping heap debug tests\n" );
     test_heap_sizes();
+    test_heap_throughput();
 }
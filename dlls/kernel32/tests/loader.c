@@ -4784,6 +4784,169 @@ static void test_dll_file( const char *name )
 #undef OK_FIELD
 }
 
+static void test_named_exports( const char *name )
+{
+    HMODULE module = GetModuleHandleA( name );
+    const IMAGE_EXPORT_DIRECTORY *exports;
+    const WORD *ordinals;
+    const DWORD *names;
+    char buffer[256];
+    ULONG size;
+    DWORD i;
+
+    exports = pRtlImageDirectoryEntryToData( module, TRUE, IMAGE_DIRECTORY_ENTRY_EXPORT, &size );
+    ok( exports != NULL, "%s: no exports\n", name );
+    if (!exports) return;
+    ordinals = (const WORD *)((char *)module + exports->AddressOfNameOrdinals);
+    names = (const DWORD *)((char *)module + exports->AddressOfNames);
+
+    for (i = 0; i < exports->NumberOfNames; i++)
+    {
+        const char *export = (const char *)module + names[i];
+        void *proc = GetProcAddress( module, export );
+
+        ok( proc != NULL, "%s: %s not found\n", name, export );
+        ok( proc == GetProcAddress( module, (const char *)(ULONG_PTR)(ordinals[i] + exports->Base) ),
+            "%s: %s doesn't match its ordinal %lu\n", name, export, ordinals[i] + exports->Base );
+        ok( proc == GetProcAddress( module, export ), "%s: %s lookup changed\n", name, export );
+
+        if (strlen( export ) + 2 > sizeof(buffer)) continue;
+        strcpy( buffer, export );
+        strcat( buffer, "@" );
+        ok( !GetProcAddress( module, buffer ), "%s: %s found\n", name, buffer );
+    }
+}
+
+static BOOL write_bench_dll( const char *path, const void *data, DWORD size, DWORD dir, DWORD dir_size )
+{
+    IMAGE_NT_HEADERS nt_header = nt_header_template;
+    IMAGE_SECTION_HEADER section = { ".data" };
+    DWORD written, rva = page_size;
+    HANDLE file;
+    BOOL ret;
+
+    section.Misc.VirtualSize = size;
+    section.VirtualAddress = rva;
+    section.SizeOfRawData = (size + page_size - 1) & ~(page_size - 1);
+    section.PointerToRawData = rva;
+    section.Characteristics = IMAGE_SCN_CNT_INITIALIZED_DATA | IMAGE_SCN_MEM_READ | IMAGE_SCN_MEM_WRITE;
+
+    nt_header.OptionalHeader.SectionAlignment = page_size;
+    nt_header.OptionalHeader.FileAlignment = page_size;
+    nt_header.OptionalHeader.SizeOfHeaders = sizeof(dos_header) + sizeof(nt_header) + sizeof(section);
+    nt_header.OptionalHeader.SizeOfImage = rva + section.SizeOfRawData;
+    nt_header.OptionalHeader.DataDirectory[dir].VirtualAddress = rva;
+    nt_header.OptionalHeader.DataDirectory[dir].Size = dir_size;
+
+    file = CreateFileA( path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, 0 );
+    ok( file != INVALID_HANDLE_VALUE, "failed to create %s err %lu\n", path, GetLastError() );
+    if (file == INVALID_HANDLE_VALUE) return FALSE;
+    ret = WriteFile( file, &dos_header, sizeof(dos_header), &written, NULL ) &&
+          WriteFile( file, &nt_header, sizeof(nt_header), &written, NULL ) &&
+          WriteFile( file, &section, sizeof(section), &written, NULL ) &&
+          SetFilePointer( file, rva, NULL, FILE_BEGIN ) == rva &&
+          WriteFile( file, data, size, &written, NULL ) &&
+          SetFilePointer( file, rva + section.SizeOfRawData, NULL, FILE_BEGIN ) != INVALID_SET_FILE_POINTER &&
+          SetEndOfFile( file );
+    ok( ret, "failed to write %s err %lu\n", path, GetLastError() );
+    CloseHandle( file );
+    return ret;
+}
+
+/* Load a module importing 50k functions by name from another module, with hints that
+ * all miss. Only run when WINETEST_BENCHMARK is set. */
+static void test_import_time(void)
+{
+    static const DWORD count = 50000, loops = 10;
+    char temp_path[MAX_PATH], exp_path[MAX_PATH], imp_path[MAX_PATH];
+    LARGE_INTEGER freq, start, end;
+    IMAGE_EXPORT_DIRECTORY *exports;
+    IMAGE_IMPORT_DESCRIPTOR *imports;
+    IMAGE_THUNK_DATA *thunks, *original_thunks;
+    DWORD *functions, *names, i, pos, rva = page_size;
+    WORD *ordinals;
+    HMODULE module;
+    char *exp_data, *imp_data;
+    BOOL ret;
+
+    if (!GetEnvironmentVariableA( "WINETEST_BENCHMARK", NULL, 0 ))
+    {
+        skip( "set WINETEST_BENCHMARK to measure the import resolution time\n" );
+        return;
+    }
+
+    GetTempPathA( MAX_PATH, temp_path );
+    sprintf( exp_path, "%sldrbenchexp.dll", temp_path );
+    sprintf( imp_path, "%sldrbenchimp.dll", temp_path );
+
+    /* exporting module: the names are zero-padded so that they are sorted */
+    exp_data = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, count * 24 + 0x100 );
+    exports = (IMAGE_EXPORT_DIRECTORY *)exp_data;
+    functions = (DWORD *)(exports + 1);
+    names = functions + count;
+    ordinals = (WORD *)(names + count);
+    pos = (char *)(ordinals + count) - exp_data;
+    exports->Name = rva + pos;
+    pos += sprintf( exp_data + pos, "ldrbenchexp.dll" ) + 1;
+    exports->Base = 1;
+    exports->NumberOfFunctions = count;
+    exports->NumberOfNames = count;
+    exports->AddressOfFunctions = rva + ((char *)functions - exp_data);
+    exports->AddressOfNames = rva + ((char *)names - exp_data);
+    exports->AddressOfNameOrdinals = rva + ((char *)ordinals - exp_data);
+    for (i = 0; i < count; i++)
+    {
+        names[i] = rva + pos;
+        pos += sprintf( exp_data + pos, "bench_func_%05lu", i ) + 1;
+        ordinals[i] = i;
+    }
+    /* the functions point after the export directory, so that they aren't forwarders */
+    for (i = 0; i < count; i++) functions[i] = rva + pos;
+    ret = write_bench_dll( exp_path, exp_data, pos + 16, IMAGE_DIRECTORY_ENTRY_EXPORT, pos );
+    HeapFree( GetProcessHeap(), 0, exp_data );
+    if (!ret) goto done;
+
+    /* importing module */
+    imp_data = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, count * (2 * sizeof(*thunks) + 20) + 0x100 );
+    imports = (IMAGE_IMPORT_DESCRIPTOR *)imp_data;
+    original_thunks = (IMAGE_THUNK_DATA *)(imports + 2);
+    thunks = original_thunks + count + 1;
+    pos = (char *)(thunks + count + 1) - imp_data;
+    imports->Name = rva + pos;
+    pos += sprintf( imp_data + pos, "ldrbenchexp.dll" ) + 1;
+    imports->OriginalFirstThunk = rva + ((char *)original_thunks - imp_data);
+    imports->FirstThunk = rva + ((char *)thunks - imp_data);
+    for (i = 0; i < count; i++)
+    {
+        pos = (pos + 1) & ~1;
+        original_thunks[i].u1.AddressOfData = thunks[i].u1.AddressOfData = rva + pos;
+        pos += sizeof(WORD);  /* hint 0 */
+        pos += sprintf( imp_data + pos, "bench_func_%05lu", count - 1 - i ) + 1;
+    }
+    ret = write_bench_dll( imp_path, imp_data, pos, IMAGE_DIRECTORY_ENTRY_IMPORT,
+                           2 * sizeof(IMAGE_IMPORT_DESCRIPTOR) );
+    HeapFree( GetProcessHeap(), 0, imp_data );
+    if (!ret) goto done;
+
+    QueryPerformanceFrequency( &freq );
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < loops; i++)
+    {
+        module = LoadLibraryExA( imp_path, NULL, LOAD_WITH_ALTERED_SEARCH_PATH );
+        ok( module != NULL, "failed to load %s err %lu\n", imp_path, GetLastError() );
+        if (!module) break;
+        FreeLibrary( module );
+    }
+    QueryPerformanceCounter( &end );
+    if (i == loops)
+        trace( "%lu imports: %.2f ms per load\n", count,
+               (end.QuadPart - start.QuadPart) * 1000.0 / freq.QuadPart / loops );
+
+done:
+    DeleteFileA( imp_path );
+    DeleteFileA( exp_path );
+}
+
 static void test_LoadPackagedLibrary(void)
 {
     HMODULE h;
@@ -4918,6 +5081,9 @@ START_TEST(loader)
     test_dll_file( "kernel32.dll" );
     test_dll_file( "advapi32.dll" );
     test_dll_file( "user32.dll" );
+    test_named_exports( "ntdll.dll" );
+    test_named_exports( "kernel32.dll" );
+    test_import_time();
     test_Wow64Transition();
     /* loader test must be last, it can corrupt the internal loader state on Windows */
     test_Loader();
@@ -307,8 +307,58 @@ static void test_timeouts(void)
     adjust_system_time(-11);
 }
 
+/* Time needed to arm and cancel 100k waitable timers, which are all pending in the server at
+ * the same time. Only run when WINETEST_BENCHMARK is set. */
+static void test_many_timers_time(void)
+{
+    static const int count = 100000;
+    LARGE_INTEGER freq, start, end, due;
+    HANDLE *timers;
+    DWORD ret;
+    int i;
+
+    if (!GetEnvironmentVariableA( "WINETEST_BENCHMARK", NULL, 0 ))
+    {
+        skip( "set WINETEST_BENCHMARK to measure the time to arm many timers\n" );
+        return;
+    }
+
+    timers = malloc( count * sizeof(*timers) );
+    for (i = 0; i < count; i++)
+    {
+        timers[i] = CreateWaitableTimerA( NULL, TRUE, NULL );
+        ok( timers[i] != NULL, "CreateWaitableTimer failed, error %lu\n", GetLastError() );
+    }
+    QueryPerformanceFrequency( &freq );
+
+    /* arm them in random order, more than a minute in the future */
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < count; i++)
+    {
+        due.QuadPart = -600000000 - (LONGLONG)((unsigned int)i * 7919 % count) * 1000;
+        SetWaitableTimer( timers[i], &due, 0, NULL, NULL, FALSE );
+    }
+    QueryPerformanceCounter( &end );
+    trace( "armed %u timers in %.0f ms\n", count, (end.QuadPart - start.QuadPart) * 1000.0 / freq.QuadPart );
+
+    /* an additional timer still expires on time */
+    due.QuadPart = -1000000;
+    SetWaitableTimer( timers[0], &due, 0, NULL, NULL, FALSE );
+    ret = WaitForSingleObject( timers[0], 1000 );
+    ok( ret == WAIT_OBJECT_0, "WaitForSingleObject returned %lu\n", ret );
+
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < count; i++) CancelWaitableTimer( timers[i] );
+    QueryPerformanceCounter( &end );
+    trace( "cancelled %u timers in %.0f ms\n", count, (end.QuadPart - start.QuadPart) * 1000.0 / freq.QuadPart );
+
+    for (i = 0; i < count; i++) CloseHandle( timers[i] );
+    free( timers );
+}
+
 START_TEST(timer)
 {
     test_timer();
     test_timeouts();
+    test_many_timers_time();
 }
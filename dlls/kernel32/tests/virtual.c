@@ -4692,6 +4692,43 @@ static LONG store_buffer_litmus_test( void (*WINAPI barrier0)(void), void (*WINA
     return reorderings;
 }
 
+static void test_large_pages(void)
+{
+    SIZE_T size = GetLargePageMinimum();
+    MEMORY_BASIC_INFORMATION info;
+    void *ptr;
+
+    if (!size)
+    {
+        skip( "large pages are not supported\n" );
+        return;
+    }
+    ok( !(size & (size - 1)) && size >= si.dwAllocationGranularity, "got large page minimum %#Ix\n", size );
+
+    SetLastError( 0xdeadbeef );
+    ptr = VirtualAlloc( NULL, size, MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE );
+    ok( !ptr, "VirtualAlloc succeeded\n" );
+    ok( GetLastError() == ERROR_INVALID_PARAMETER || GetLastError() == ERROR_PRIVILEGE_NOT_HELD,
+        "got error %lu\n", GetLastError() );
+
+    SetLastError( 0xdeadbeef );
+    ptr = VirtualAlloc( NULL, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE );
+    if (!ptr)
+    {
+        ok( GetLastError() == ERROR_PRIVILEGE_NOT_HELD, "got error %lu\n", GetLastError() );
+        return;
+    }
+    ok( !((ULONG_PTR)ptr & (size - 1)), "got unaligned pointer %p\n", ptr );
+    memset( ptr, 0xcc, size );
+
+    VirtualQuery( ptr, &info, sizeof(info) );
+    ok( info.RegionSize == size, "got size %#Ix\n", info.RegionSize );
+    ok( info.State == MEM_COMMIT, "got state %#lx\n", info.State );
+    ok( info.Protect == PAGE_READWRITE, "got protect %#lx\n", info.Protect );
+
+    ok( VirtualFree( ptr, 0, MEM_RELEASE ), "VirtualFree failed, error %lu\n", GetLastError() );
+}
+
 static void test_FlushProcessWriteBuffers(void)
 {
     LONG reorderings;
@@ -4814,6 +4851,7 @@ START_TEST(virtual)
     test_PrefetchVirtualMemory();
     test_ReadProcessMemory();
     test_FlushProcessWriteBuffers();
+    test_large_pages();
 #if defined(__i386__) || defined(__x86_64__)
     test_stack_commit();
 #endif
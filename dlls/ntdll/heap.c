@@ -1774,14 +1774,23 @@ static inline struct block *group_get_block( struct group *group, SIZE_T block_s
     return (struct block *)(first_block + index * block_size);
 }
 
-/* lookup a free block using the group free_bits, the current thread must own the group */
-static inline struct block *group_find_free_block( struct group *group, SIZE_T block_size )
+/* lookup up to count free blocks using the group free_bits, the current thread must own the group */
+static inline UINT group_find_free_blocks( struct group *group, SIZE_T block_size, struct block **blocks, UINT count )
 {
-    ULONG i, free_bits = ReadNoFence( &group->free_bits );
+    ULONG i, free_bits = ReadNoFence( &group->free_bits ), mask = 0;
+    UINT ret = 0;
+
     /* free_bits will never be 0 as the group is unlinked when it's fully used */
-    BitScanForward( &i, free_bits );
-    InterlockedAnd( &group->free_bits, ~(1 << i) );
-    return group_get_block( group, block_size, i );
+    while (ret < count && (free_bits & ~GROUP_FLAG_FREE))
+    {
+        BitScanForward( &i, free_bits );
+        free_bits &= ~(1 << i);
+        mask |= 1 << i;
+        blocks[ret++] = group_get_block( group, block_size, i );
+    }
+
+    InterlockedAnd( &group->free_bits, ~mask );
+    return ret;
 }
 
 /* allocate a new group block using non-LFH allocation, returns a group owned by current thread */
@@ -1893,19 +1902,20 @@ static NTSTATUS heap_release_bin_group( struct heap *heap, ULONG flags, struct b
     return group_release( heap, flags, bin, group );
 }
 
-static struct block *find_free_bin_block( struct heap *heap, ULONG flags, SIZE_T block_size, struct bin *bin )
+static UINT find_free_bin_blocks( struct heap *heap, ULONG flags, SIZE_T block_size, struct bin *bin,
+                                  struct block **blocks, UINT count )
 {
     ULONG affinity = heap_current_thread_affinity();
-    struct block *block;
     struct group *group;
+    UINT ret;
 
     /* acquire a group, the thread will own it and no other thread can clear free bits.
      * some other thread might still set the free bits if they are freeing blocks.
      */
-    if (!(group = heap_acquire_bin_group( heap, flags, block_size, bin ))) return NULL;
+    if (!(group = heap_acquire_bin_group( heap, flags, block_size, bin ))) return 0;
     group->affinity = affinity;
 
-    block = group_find_free_block( group, block_size );
+    ret = group_find_free_blocks( group, block_size, blocks, count );
 
     /* serialize with heap_free_block_lfh: atomically set GROUP_FLAG_FREE when the free bits are all 0. */
     if (ReadNoFence( &group->free_bits ) || InterlockedCompareExchange( &group->free_bits, GROUP_FLAG_FREE, 0 ))
@@ -1915,14 +1925,100 @@ static struct block *find_free_bin_block( struct heap *heap, ULONG flags, SIZE_T
             RtlInterlockedPushEntrySList( &bin->groups, &group->entry );
     }
 
-    return block;
+    return ret;
+}
+
+/* release a free block to its group, the block must not be owned by any thread cache */
+static NTSTATUS group_free_block( struct heap *heap, ULONG flags, struct bin *bin, struct block *block )
+{
+    struct group *group = block_get_group( block );
+    UINT i = block_get_group_index( block );
+
+    /* if this was the last used block in a group and GROUP_FLAG_FREE was set */
+    if (InterlockedOr( &group->free_bits, 1 << i ) == ~(1 << i))
+    {
+        /* thread now owns the group, and can release it to its bin */
+        group->free_bits = ~GROUP_FLAG_FREE;
+        return heap_release_bin_group( heap, flags, bin, group );
+    }
+
+    return STATUS_SUCCESS;
+}
+
+/* per-thread cache of free LFH blocks, which lets a thread allocate and free small blocks
+ * without touching the shared group bits. it is only used for the process heap, as it is
+ * never destroyed, and blocks are moved to and from the groups in batches.
+ */
+#define THREAD_CACHE_BIN_COUNT   0x30  /* blocks up to 1024 bytes */
+#define THREAD_CACHE_BIN_BLOCKS  16
+
+struct thread_cache_bin
+{
+    UINT          count;
+    struct block *blocks[THREAD_CACHE_BIN_BLOCKS];
+};
+
+struct thread_cache
+{
+    struct thread_cache_bin bins[THREAD_CACHE_BIN_COUNT];
+};
+
+/* the cache is allocated from the process heap, it must not use a cached bin itself */
+C_ASSERT( sizeof(struct thread_cache) > BLOCK_BIN_SIZE( THREAD_CACHE_BIN_COUNT - 1 ) );
+
+static struct thread_cache_bin *heap_get_thread_cache_bin( struct heap *heap, struct bin *bin, BOOL create )
+{
+    struct thread_cache *cache;
+
+    if (heap != process_heap || bin - heap->bins >= THREAD_CACHE_BIN_COUNT) return NULL;
+    if (!(cache = NtCurrentTeb()->TlsSlots[NTDLL_TLS_HEAP_CACHE]))
+    {
+        if (!create || !(cache = RtlAllocateHeap( heap, HEAP_ZERO_MEMORY, sizeof(*cache) ))) return NULL;
+        NtCurrentTeb()->TlsSlots[NTDLL_TLS_HEAP_CACHE] = cache;
+    }
+
+    return cache->bins + (bin - heap->bins);
+}
+
+/* release the count oldest blocks of a thread cache bin to their groups */
+static void thread_cache_bin_flush( struct heap *heap, ULONG flags, struct bin *bin,
+                                    struct thread_cache_bin *cache, UINT count )
+{
+    UINT i;
+
+    /* the blocks are already back in their groups even if a fully freed group
+     * couldn't be released, they must not be freed again by the caller */
+    for (i = 0; i < count; i++)
+        if (group_free_block( heap, flags, bin, cache->blocks[i] ))
+            WARN( "heap %p, block %p: failed to release group\n", heap, cache->blocks[i] );
+
+    memmove( cache->blocks, cache->blocks + count, (cache->count - count) * sizeof(*cache->blocks) );
+    cache->count -= count;
+}
+
+static void heap_thread_detach_cache( struct heap *heap )
+{
+    struct thread_cache *cache;
+    UINT i;
+
+    if (!(cache = NtCurrentTeb()->TlsSlots[NTDLL_TLS_HEAP_CACHE])) return;
+    NtCurrentTeb()->TlsSlots[NTDLL_TLS_HEAP_CACHE] = NULL;
+
+    for (i = 0; i < THREAD_CACHE_BIN_COUNT; ++i)
+    {
+        struct thread_cache_bin *cache_bin = cache->bins + i;
+        thread_cache_bin_flush( heap, heap->flags, heap->bins + i, cache_bin, cache_bin->count );
+    }
+
+    RtlFreeHeap( heap, 0, cache );
 }
 
 static NTSTATUS heap_allocate_block_lfh( struct heap *heap, ULONG flags, SIZE_T block_size,
                                          SIZE_T size, void **ret )
 {
     struct bin *bin, *last = heap->bins + BLOCK_SIZE_BIN_COUNT - 1;
-    struct block *block;
+    struct thread_cache_bin *cache;
+    struct block *block = NULL;
 
     bin = heap->bins + BLOCK_SIZE_BIN( block_size );
     if (bin == last) return STATUS_UNSUCCESSFUL;
@@ -1932,7 +2028,17 @@ static NTSTATUS heap_allocate_block_lfh( struct heap *heap, ULONG flags, SIZE_T
 
     block_size = BLOCK_BIN_SIZE( BLOCK_SIZE_BIN( block_size ) );
 
-    if ((block = find_free_bin_block( heap, flags, block_size, bin )))
+    if (!(cache = heap_get_thread_cache_bin( heap, bin, TRUE )))
+        find_free_bin_blocks( heap, flags, block_size, bin, &block, 1 );
+    else
+    {
+        if (!cache->count)
+            cache->count = find_free_bin_blocks( heap, flags, block_size, bin, cache->blocks,
+                                                 THREAD_CACHE_BIN_BLOCKS / 2 );
+        if (cache->count) block = cache->blocks[--cache->count];
+    }
+
+    if (block)
     {
         block_set_type( block, BLOCK_TYPE_USED );
         block_set_flags( block, (BYTE)~BLOCK_FLAG_LFH, BLOCK_USER_FLAGS( flags ) );
@@ -1948,30 +2054,26 @@ static NTSTATUS heap_allocate_block_lfh( struct heap *heap, ULONG flags, SIZE_T
 static NTSTATUS heap_free_block_lfh( struct heap *heap, ULONG flags, struct block *block )
 {
     struct bin *bin, *last = heap->bins + BLOCK_SIZE_BIN_COUNT - 1;
-    SIZE_T i, block_size = block_get_size( block );
-    struct group *group = block_get_group( block );
-    NTSTATUS status = STATUS_SUCCESS;
+    SIZE_T block_size = block_get_size( block );
+    struct thread_cache_bin *cache;
 
     if (!(block_get_flags( block ) & BLOCK_FLAG_LFH)) return STATUS_UNSUCCESSFUL;
 
     bin = heap->bins + BLOCK_SIZE_BIN( block_size );
     if (bin == last) return STATUS_UNSUCCESSFUL;
 
-    i = block_get_group_index( block );
     valgrind_make_writable( block, sizeof(*block) );
     block_set_type( block, BLOCK_TYPE_FREE );
     block_set_flags( block, (BYTE)~BLOCK_FLAG_LFH, BLOCK_FLAG_FREE );
     mark_block_free( block + 1, (char *)block + block_size - (char *)(block + 1), flags );
 
-    /* if this was the last used block in a group and GROUP_FLAG_FREE was set */
-    if (InterlockedOr( &group->free_bits, 1 << i ) == ~(1 << i))
-    {
-        /* thread now owns the group, and can release it to its bin */
-        group->free_bits = ~GROUP_FLAG_FREE;
-        status = heap_release_bin_group( heap, flags, bin, group );
-    }
+    if (!(cache = heap_get_thread_cache_bin( heap, bin, FALSE )))
+        return group_free_block( heap, flags, bin, block );
 
-    return status;
+    if (cache->count == THREAD_CACHE_BIN_BLOCKS)
+        thread_cache_bin_flush( heap, flags, bin, cache, THREAD_CACHE_BIN_BLOCKS / 2 );
+    cache->blocks[cache->count++] = block;
+    return STATUS_SUCCESS;
 }
 
 static void bin_try_enable( struct heap *heap, struct bin *bin )
@@ -2022,6 +2124,8 @@ void heap_thread_detach(void)
 {
     struct heap *heap;
 
+    if (process_heap->bins) heap_thread_detach_cache( process_heap );
+
     RtlEnterCriticalSection( &process_heap->cs );
 
     LIST_FOR_EACH_ENTRY( heap, &process_heap->entry, struct heap, entry )
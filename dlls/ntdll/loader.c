@@ -139,6 +139,8 @@ typedef struct _wine_modref
     struct file_id        id;
     ULONG                 CheckSum;
     BOOL                  system;
+    DWORD                *export_hash;       /* hash table of export name indices, built on demand */
+    DWORD                 export_hash_mask;  /* size of the export hash table minus one */
 } WINE_MODREF;
 
 static UINT tls_module_count = 32;     /* number of modules with TLS directory */
@@ -189,6 +191,18 @@ static WINE_MODREF *last_failed_modref;
 
 static LDR_DDAG_NODE *node_ntdll, *node_kernel32;
 
+/* cache of resolved forwarded exports, indexed by the address of the forward string */
+#define FORWARD_CACHE_SIZE 1024
+struct forward_cache_entry
+{
+    const char  *forward;     /* forward string in the exporting module */
+    WINE_MODREF *wm;          /* module the forward resolved to */
+    FARPROC      proc;        /* resolved function */
+    ULONG        generation;  /* forward_cache_generation when it was resolved */
+};
+static struct forward_cache_entry forward_cache[FORWARD_CACHE_SIZE];
+static ULONG forward_cache_generation = 1;  /* incremented every time a module is unloaded */
+
 static NTSTATUS load_dll( const WCHAR *load_path, const WCHAR *libname, DWORD flags, WINE_MODREF** pwm, BOOL system );
 static NTSTATUS process_attach( LDR_DDAG_NODE *node, LPVOID lpReserved );
 static FARPROC find_ordinal_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
@@ -953,23 +967,33 @@ static FARPROC find_forwarded_export( HMODULE module, const char *forward, LPCWS
     WINE_MODREF *wm;
     WCHAR mod_name[256];
     const char *end = strrchr(forward, '.');
+    struct forward_cache_entry *cache = &forward_cache[((UINT_PTR)forward >> 3) & (FORWARD_CACHE_SIZE - 1)];
     FARPROC proc = NULL;
     BOOL wm_loaded = FALSE;
 
     if (!end) return NULL;
-    if (build_import_name( importer, mod_name, forward, end - forward )) return NULL;
 
-    if (!(wm = find_basename_module( mod_name )))
+    if (cache->forward == forward && cache->generation == forward_cache_generation)
+    {
+        wm = cache->wm;
+        proc = cache->proc;
+    }
+    else
     {
-        WINE_MODREF *imp = get_modref( module );
-        TRACE( "delay loading %s for '%s'\n", debugstr_w(mod_name), forward );
-        if (load_dll( load_path, mod_name, 0, &wm, imp->system ) != STATUS_SUCCESS)
+        if (build_import_name( importer, mod_name, forward, end - forward )) return NULL;
+
+        if (!(wm = find_basename_module( mod_name )))
         {
-            ERR( "module not found for forward '%s' used by %s\n",
-                 forward, debugstr_w(imp->ldr.FullDllName.Buffer) );
-            return NULL;
+            WINE_MODREF *imp = get_modref( module );
+            TRACE( "delay loading %s for '%s'\n", debugstr_w(mod_name), forward );
+            if (load_dll( load_path, mod_name, 0, &wm, imp->system ) != STATUS_SUCCESS)
+            {
+                ERR( "module not found for forward '%s' used by %s\n",
+                     forward, debugstr_w(imp->ldr.FullDllName.Buffer) );
+                return NULL;
+            }
+            wm_loaded = TRUE;
         }
-        wm_loaded = TRUE;
     }
 
     if (wm->ldr.DdagNode != node_ntdll && wm->ldr.DdagNode != node_kernel32)
@@ -986,6 +1010,8 @@ static FARPROC find_forwarded_export( HMODULE module, const char *forward, LPCWS
         }
     }
 
+    if (proc) return proc;
+
     if ((exports = RtlImageDirectoryEntryToData( wm->ldr.DllBase, TRUE,
                                                  IMAGE_DIRECTORY_ENTRY_EXPORT, &exp_size )))
     {
@@ -1007,6 +1033,15 @@ static FARPROC find_forwarded_export( HMODULE module, const char *forward, LPCWS
             forward, debugstr_w(get_modref(module)->ldr.FullDllName.Buffer),
             debugstr_w(get_modref(module)->ldr.BaseDllName.Buffer) );
     }
+    /* api sets are resolved according to the importer, and relay thunks depend on it too */
+    else if (_strnicmp( forward, "api-", 4 ) && _strnicmp( forward, "ext-", 4 ) &&
+             !TRACE_ON(relay) && !TRACE_ON(snoop))
+    {
+        cache->forward = forward;
+        cache->wm = wm;
+        cache->proc = proc;
+        cache->generation = forward_cache_generation;
+    }
     return proc;
 }
 
@@ -1076,6 +1111,66 @@ static int find_name_in_exports( HMODULE module, const IMAGE_EXPORT_DIRECTORY *e
 }
 
 
+/*************************************************************************
+ *		hash_export_name
+ */
+static inline DWORD hash_export_name( const char *name )
+{
+    DWORD hash = 0x811c9dc5;
+
+    while (*name) hash = (hash ^ (unsigned char)*name++) * 0x01000193;
+    return hash;
+}
+
+
+/*************************************************************************
+ *		get_export_hash
+ *
+ * Build the hash table of the export names of a module the first time it is needed.
+ * Modules with few exports are searched directly instead.
+ */
+static DWORD *get_export_hash( WINE_MODREF *wm, const IMAGE_EXPORT_DIRECTORY *exports )
+{
+    const DWORD *names = get_rva( wm->ldr.DllBase, exports->AddressOfNames );
+    DWORD i, pos, size, *hash;
+
+    if (wm->export_hash) return wm->export_hash;
+    if (exports->NumberOfNames < 64 || exports->NumberOfNames > 0x1000000) return NULL;
+
+    for (size = 128; size < exports->NumberOfNames * 2; size *= 2) /* nothing */;
+    if (!(hash = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, size * sizeof(*hash) ))) return NULL;
+
+    for (i = 0; i < exports->NumberOfNames; i++)
+    {
+        pos = hash_export_name( get_rva( wm->ldr.DllBase, names[i] ) ) & (size - 1);
+        while (hash[pos]) pos = (pos + 1) & (size - 1);
+        hash[pos] = i + 1;
+    }
+    wm->export_hash_mask = size - 1;
+    return wm->export_hash = hash;
+}
+
+
+/*************************************************************************
+ *		find_name_in_export_hash
+ *
+ * Helper for find_named_export.
+ */
+static int find_name_in_export_hash( WINE_MODREF *wm, const IMAGE_EXPORT_DIRECTORY *exports, const char *name )
+{
+    const WORD *ordinals = get_rva( wm->ldr.DllBase, exports->AddressOfNameOrdinals );
+    const DWORD *names = get_rva( wm->ldr.DllBase, exports->AddressOfNames );
+    DWORD pos = hash_export_name( name ) & wm->export_hash_mask;
+
+    for (; wm->export_hash[pos]; pos = (pos + 1) & wm->export_hash_mask)
+    {
+        DWORD idx = wm->export_hash[pos] - 1;
+        if (!strcmp( get_rva( wm->ldr.DllBase, names[idx] ), name )) return ordinals[idx];
+    }
+    return -1;
+}
+
+
 /*************************************************************************
  *		find_named_export
  *
@@ -1088,6 +1183,7 @@ static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *
 {
     const WORD *ordinals = get_rva( module, exports->AddressOfNameOrdinals );
     const DWORD *names = get_rva( module, exports->AddressOfNames );
+    WINE_MODREF *wm;
     int ordinal;
 
     /* first check the hint */
@@ -1098,8 +1194,12 @@ static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *
             return find_ordinal_export( module, exports, exp_size, ordinals[hint], load_path, importer, is_dynamic );
     }
 
-    /* then do a binary search */
-    if ((ordinal = find_name_in_exports( module, exports, name )) == -1) return NULL;
+    /* then use the hash table, or do a binary search */
+    if ((wm = get_modref( module )) && get_export_hash( wm, exports ))
+        ordinal = find_name_in_export_hash( wm, exports, name );
+    else
+        ordinal = find_name_in_exports( module, exports, name );
+    if (ordinal == -1) return NULL;
     return find_ordinal_export( module, exports, exp_size, ordinal, load_path, importer, is_dynamic );
 
 }
@@ -4033,7 +4133,9 @@ static void free_modref( WINE_MODREF *wm )
     RtlReleaseActivationContext( wm->ldr.ActivationContext );
     NtUnmapViewOfSection( NtCurrentProcess(), wm->ldr.DllBase );
     if (cached_modref == wm) cached_modref = NULL;
+    forward_cache_generation++;
     RtlFreeUnicodeString( &wm->ldr.FullDllName );
+    RtlFreeHeap( GetProcessHeap(), 0, wm->export_hash );
     RtlFreeHeap( GetProcessHeap(), 0, wm );
 }
 
@@ -4453,6 +4555,7 @@ void loader_init( CONTEXT *context, void **entry )
         /* TLS index 0 is always reserved, and wow64 reserves extra TLS entries */
         RtlSetBits( peb->TlsBitmap, 0, NtCurrentTeb()->WowTebOffset ? WOW64_TLS_MAX_NUMBER : 1 );
         RtlSetBits( peb->TlsBitmap, NTDLL_TLS_ERRNO, 1 );
+        RtlSetBits( peb->TlsBitmap, NTDLL_TLS_HEAP_CACHE, 1 );
 
         if (!(tls_dirs = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, tls_module_count * sizeof(*tls_dirs) )))
             NtTerminateProcess( GetCurrentProcess(), STATUS_NO_MEMORY );
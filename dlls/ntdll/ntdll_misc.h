@@ -34,6 +34,7 @@
 #define MAX_NT_PATH_LENGTH 277
 
 #define NTDLL_TLS_ERRNO 16  /* TLS slot for _errno() */
+#define NTDLL_TLS_HEAP_CACHE 17  /* TLS slot for the heap thread cache */
 
 #define NTDLL_ACTCTX_STACK_FRAME_HEAP_ALLOCATED 0x8 /* RTL_ACTIVATION_CONTEXT_STACK_FRAME.Flags */
 
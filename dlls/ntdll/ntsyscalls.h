@@ -111,160 +111,163 @@
     SYSCALL_ENTRY( 0x006b, NtAllocateVirtualMemoryEx, 28 ) \
     SYSCALL_ENTRY( 0x006c, NtAreMappedFilesTheSame, 8 ) \
     SYSCALL_ENTRY( 0x006d, NtAssignProcessToJobObject, 8 ) \
-    SYSCALL_ENTRY( 0x006e, NtCancelIoFileEx, 12 ) \
-    SYSCALL_ENTRY( 0x006f, NtCancelSynchronousIoFile, 12 ) \
-    SYSCALL_ENTRY( 0x0070, NtCommitTransaction, 8 ) \
-    SYSCALL_ENTRY( 0x0071, NtCompareObjects, 8 ) \
-    SYSCALL_ENTRY( 0x0072, NtCompareTokens, 12 ) \
-    SYSCALL_ENTRY( 0x0073, NtCompleteConnectPort, 4 ) \
-    SYSCALL_ENTRY( 0x0074, NtConnectPort, 32 ) \
-    SYSCALL_ENTRY( 0x0075, NtContinueEx, 8 ) \
-    SYSCALL_ENTRY( 0x0076, NtConvertBetweenAuxiliaryCounterAndPerformanceCounter, 16 ) \
-    SYSCALL_ENTRY( 0x0077, NtCreateDirectoryObject, 12 ) \
-    SYSCALL_ENTRY( 0x0078, NtCreateIoCompletion, 16 ) \
-    SYSCALL_ENTRY( 0x0079, NtCreateJobObject, 12 ) \
-    SYSCALL_ENTRY( 0x007a, NtCreateKeyTransacted, 32 ) \
-    SYSCALL_ENTRY( 0x007b, NtCreateKeyedEvent, 16 ) \
-    SYSCALL_ENTRY( 0x007c, NtCreateLowBoxToken, 36 ) \
-    SYSCALL_ENTRY( 0x007d, NtCreateMailslotFile, 32 ) \
-    SYSCALL_ENTRY( 0x007e, NtCreateMutant, 16 ) \
-    SYSCALL_ENTRY( 0x007f, NtCreateNamedPipeFile, 56 ) \
-    SYSCALL_ENTRY( 0x0080, NtCreatePagingFile, 16 ) \
-    SYSCALL_ENTRY( 0x0081, NtCreatePort, 20 ) \
-    SYSCALL_ENTRY( 0x0082, NtCreateSectionEx, 36 ) \
-    SYSCALL_ENTRY( 0x0083, NtCreateSemaphore, 20 ) \
-    SYSCALL_ENTRY( 0x0084, NtCreateSymbolicLinkObject, 16 ) \
-    SYSCALL_ENTRY( 0x0085, NtCreateThreadEx, 44 ) \
-    SYSCALL_ENTRY( 0x0086, NtCreateTimer, 16 ) \
-    SYSCALL_ENTRY( 0x0087, NtCreateToken, 52 ) \
-    SYSCALL_ENTRY( 0x0088, NtCreateTransaction, 40 ) \
-    SYSCALL_ENTRY( 0x0089, NtCreateUserProcess, 44 ) \
-    SYSCALL_ENTRY( 0x008a, NtDebugActiveProcess, 8 ) \
-    SYSCALL_ENTRY( 0x008b, NtDebugContinue, 12 ) \
-    SYSCALL_ENTRY( 0x008c, NtDeleteAtom, 4 ) \
-    SYSCALL_ENTRY( 0x008d, NtDeleteFile, 4 ) \
-    SYSCALL_ENTRY( 0x008e, NtDeleteKey, 4 ) \
-    SYSCALL_ENTRY( 0x008f, NtDeleteValueKey, 8 ) \
-    SYSCALL_ENTRY( 0x0090, NtDisplayString, 4 ) \
-    SYSCALL_ENTRY( 0x0091, NtFilterToken, 24 ) \
-    SYSCALL_ENTRY( 0x0092, NtFlushBuffersFileEx, 20 ) \
-    SYSCALL_ENTRY( 0x0093, NtFlushInstructionCache, 12 ) \
-    SYSCALL_ENTRY( 0x0094, NtFlushKey, 4 ) \
-    SYSCALL_ENTRY( 0x0095, NtFlushProcessWriteBuffers, 0 ) \
-    SYSCALL_ENTRY( 0x0096, NtFlushVirtualMemory, 16 ) \
-    SYSCALL_ENTRY( 0x0097, NtGetContextThread, 8 ) \
-    SYSCALL_ENTRY( 0x0098, NtGetCurrentProcessorNumber, 0 ) \
-    SYSCALL_ENTRY( 0x0099, NtGetNextProcess, 20 ) \
-    SYSCALL_ENTRY( 0x009a, NtGetNextThread, 24 ) \
-    SYSCALL_ENTRY( 0x009b, NtGetNlsSectionPtr, 20 ) \
-    SYSCALL_ENTRY( 0x009c, NtGetWriteWatch, 28 ) \
-    SYSCALL_ENTRY( 0x009d, NtImpersonateAnonymousToken, 4 ) \
-    SYSCALL_ENTRY( 0x009e, NtInitializeNlsFiles, 12 ) \
-    SYSCALL_ENTRY( 0x009f, NtInitiatePowerAction, 16 ) \
-    SYSCALL_ENTRY( 0x00a0, NtListenPort, 8 ) \
-    SYSCALL_ENTRY( 0x00a1, NtLoadDriver, 4 ) \
-    SYSCALL_ENTRY( 0x00a2, NtLoadKey, 8 ) \
-    SYSCALL_ENTRY( 0x00a3, NtLoadKey2, 12 ) \
-    SYSCALL_ENTRY( 0x00a4, NtLoadKeyEx, 32 ) \
-    SYSCALL_ENTRY( 0x00a5, NtLockFile, 40 ) \
+    SYSCALL_ENTRY( 0x006e, NtAssociateWaitCompletionPacket, 32 ) \
+    SYSCALL_ENTRY( 0x006f, NtCancelIoFileEx, 12 ) \
+    SYSCALL_ENTRY( 0x0070, NtCancelSynchronousIoFile, 12 ) \
+    SYSCALL_ENTRY( 0x0071, NtCancelWaitCompletionPacket, 8 ) \
+    SYSCALL_ENTRY( 0x0072, NtCommitTransaction, 8 ) \
+    SYSCALL_ENTRY( 0x0073, NtCompareObjects, 8 ) \
+    SYSCALL_ENTRY( 0x0074, NtCompareTokens, 12 ) \
+    SYSCALL_ENTRY( 0x0075, NtCompleteConnectPort, 4 ) \
+    SYSCALL_ENTRY( 0x0076, NtConnectPort, 32 ) \
+    SYSCALL_ENTRY( 0x0077, NtContinueEx, 8 ) \
+    SYSCALL_ENTRY( 0x0078, NtConvertBetweenAuxiliaryCounterAndPerformanceCounter, 16 ) \
+    SYSCALL_ENTRY( 0x0079, NtCreateDirectoryObject, 12 ) \
+    SYSCALL_ENTRY( 0x007a, NtCreateIoCompletion, 16 ) \
+    SYSCALL_ENTRY( 0x007b, NtCreateJobObject, 12 ) \
+    SYSCALL_ENTRY( 0x007c, NtCreateKeyTransacted, 32 ) \
+    SYSCALL_ENTRY( 0x007d, NtCreateKeyedEvent, 16 ) \
+    SYSCALL_ENTRY( 0x007e, NtCreateLowBoxToken, 36 ) \
+    SYSCALL_ENTRY( 0x007f, NtCreateMailslotFile, 32 ) \
+    SYSCALL_ENTRY( 0x0080, NtCreateMutant, 16 ) \
+    SYSCALL_ENTRY( 0x0081, NtCreateNamedPipeFile, 56 ) \
+    SYSCALL_ENTRY( 0x0082, NtCreatePagingFile, 16 ) \
+    SYSCALL_ENTRY( 0x0083, NtCreatePort, 20 ) \
+    SYSCALL_ENTRY( 0x0084, NtCreateSectionEx, 36 ) \
+    SYSCALL_ENTRY( 0x0085, NtCreateSemaphore, 20 ) \
+    SYSCALL_ENTRY( 0x0086, NtCreateSymbolicLinkObject, 16 ) \
+    SYSCALL_ENTRY( 0x0087, NtCreateThreadEx, 44 ) \
+    SYSCALL_ENTRY( 0x0088, NtCreateTimer, 16 ) \
+    SYSCALL_ENTRY( 0x0089, NtCreateToken, 52 ) \
+    SYSCALL_ENTRY( 0x008a, NtCreateTransaction, 40 ) \
+    SYSCALL_ENTRY( 0x008b, NtCreateUserProcess, 44 ) \
+    SYSCALL_ENTRY( 0x008c, NtCreateWaitCompletionPacket, 12 ) \
+    SYSCALL_ENTRY( 0x008d, NtDebugActiveProcess, 8 ) \
+    SYSCALL_ENTRY( 0x008e, NtDebugContinue, 12 ) \
+    SYSCALL_ENTRY( 0x008f, NtDeleteAtom, 4 ) \
+    SYSCALL_ENTRY( 0x0090, NtDeleteFile, 4 ) \
+    SYSCALL_ENTRY( 0x0091, NtDeleteKey, 4 ) \
+    SYSCALL_ENTRY( 0x0092, NtDeleteValueKey, 8 ) \
+    SYSCALL_ENTRY( 0x0093, NtDisplayString, 4 ) \
+    SYSCALL_ENTRY( 0x0094, NtFilterToken, 24 ) \
+    SYSCALL_ENTRY( 0x0095, NtFlushBuffersFileEx, 20 ) \
+    SYSCALL_ENTRY( 0x0096, NtFlushInstructionCache, 12 ) \
+    SYSCALL_ENTRY( 0x0097, NtFlushKey, 4 ) \
+    SYSCALL_ENTRY( 0x0098, NtFlushProcessWriteBuffers, 0 ) \
+    SYSCALL_ENTRY( 0x0099, NtFlushVirtualMemory, 16 ) \
+    SYSCALL_ENTRY( 0x009a, NtGetContextThread, 8 ) \
+    SYSCALL_ENTRY( 0x009b, NtGetCurrentProcessorNumber, 0 ) \
+    SYSCALL_ENTRY( 0x009c, NtGetNextProcess, 20 ) \
+    SYSCALL_ENTRY( 0x009d, NtGetNextThread, 24 ) \
+    SYSCALL_ENTRY( 0x009e, NtGetNlsSectionPtr, 20 ) \
+    SYSCALL_ENTRY( 0x009f, NtGetWriteWatch, 28 ) \
+    SYSCALL_ENTRY( 0x00a0, NtImpersonateAnonymousToken, 4 ) \
+    SYSCALL_ENTRY( 0x00a1, NtInitializeNlsFiles, 12 ) \
+    SYSCALL_ENTRY( 0x00a2, NtInitiatePowerAction, 16 ) \
+    SYSCALL_ENTRY( 0x00a3, NtListenPort, 8 ) \
+    SYSCALL_ENTRY( 0x00a4, NtLoadDriver, 4 ) \
+    SYSCALL_ENTRY( 0x00a5, NtLoadKey, 8 ) \
     SYSCALL_ENTRY( 0x00a6, NtCreateDebugObject, 16 ) \
-    SYSCALL_ENTRY( 0x00a7, NtLockVirtualMemory, 16 ) \
-    SYSCALL_ENTRY( 0x00a8, NtMakePermanentObject, 4 ) \
-    SYSCALL_ENTRY( 0x00a9, NtMakeTemporaryObject, 4 ) \
-    SYSCALL_ENTRY( 0x00aa, NtMapViewOfSectionEx, 36 ) \
-    SYSCALL_ENTRY( 0x00ab, NtNotifyChangeDirectoryFile, 36 ) \
-    SYSCALL_ENTRY( 0x00ac, NtNotifyChangeKey, 40 ) \
-    SYSCALL_ENTRY( 0x00ad, NtNotifyChangeMultipleKeys, 48 ) \
-    SYSCALL_ENTRY( 0x00ae, NtOpenIoCompletion, 12 ) \
-    SYSCALL_ENTRY( 0x00af, NtOpenJobObject, 12 ) \
-    SYSCALL_ENTRY( 0x00b0, NtOpenKeyEx, 16 ) \
-    SYSCALL_ENTRY( 0x00b1, NtOpenKeyTransacted, 16 ) \
-    SYSCALL_ENTRY( 0x00b2, NtOpenKeyTransactedEx, 20 ) \
-    SYSCALL_ENTRY( 0x00b3, NtOpenKeyedEvent, 12 ) \
-    SYSCALL_ENTRY( 0x00b4, NtOpenMutant, 12 ) \
-    SYSCALL_ENTRY( 0x00b5, NtOpenProcessToken, 12 ) \
-    SYSCALL_ENTRY( 0x00b6, NtOpenSemaphore, 12 ) \
-    SYSCALL_ENTRY( 0x00b7, NtOpenSymbolicLinkObject, 12 ) \
-    SYSCALL_ENTRY( 0x00b8, NtOpenThread, 16 ) \
-    SYSCALL_ENTRY( 0x00b9, NtOpenTimer, 12 ) \
-    SYSCALL_ENTRY( 0x00ba, NtPrivilegeCheck, 12 ) \
-    SYSCALL_ENTRY( 0x00bb, NtPulseEvent, 8 ) \
-    SYSCALL_ENTRY( 0x00bc, NtQueryDirectoryObject, 28 ) \
-    SYSCALL_ENTRY( 0x00bd, NtQueryEaFile, 36 ) \
-    SYSCALL_ENTRY( 0x00be, NtQueryFullAttributesFile, 8 ) \
-    SYSCALL_ENTRY( 0x00bf, NtQueryInformationAtom, 20 ) \
-    SYSCALL_ENTRY( 0x00c0, NtQueryInformationJobObject, 20 ) \
-    SYSCALL_ENTRY( 0x00c1, NtQueryInstallUILanguage, 4 ) \
-    SYSCALL_ENTRY( 0x00c2, NtQueryIoCompletion, 20 ) \
-    SYSCALL_ENTRY( 0x00c3, NtQueryLicenseValue, 20 ) \
-    SYSCALL_ENTRY( 0x00c4, NtQueryMultipleValueKey, 24 ) \
-    SYSCALL_ENTRY( 0x00c5, NtQueryMutant, 20 ) \
-    SYSCALL_ENTRY( 0x00c6, NtQuerySecurityObject, 20 ) \
-    SYSCALL_ENTRY( 0x00c7, NtQuerySemaphore, 20 ) \
-    SYSCALL_ENTRY( 0x00c8, NtQuerySymbolicLinkObject, 12 ) \
-    SYSCALL_ENTRY( 0x00c9, NtQuerySystemEnvironmentValue, 16 ) \
-    SYSCALL_ENTRY( 0x00ca, NtQuerySystemEnvironmentValueEx, 20 ) \
-    SYSCALL_ENTRY( 0x00cb, NtQuerySystemInformationEx, 24 ) \
-    SYSCALL_ENTRY( 0x00cc, NtQueryTimerResolution, 12 ) \
-    SYSCALL_ENTRY( 0x00cd, NtQueueApcThreadEx, 24 ) \
-    SYSCALL_ENTRY( 0x00ce, NtQueueApcThreadEx2, 28 ) \
-    SYSCALL_ENTRY( 0x00cf, NtRaiseException, 12 ) \
-    SYSCALL_ENTRY( 0x00d0, NtRaiseHardError, 24 ) \
-    SYSCALL_ENTRY( 0x00d1, NtRegisterThreadTerminatePort, 4 ) \
-    SYSCALL_ENTRY( 0x00d2, NtReleaseKeyedEvent, 16 ) \
-    SYSCALL_ENTRY( 0x00d3, NtRemoveIoCompletionEx, 24 ) \
-    SYSCALL_ENTRY( 0x00d4, NtRemoveProcessDebug, 8 ) \
-    SYSCALL_ENTRY( 0x00d5, NtRenameKey, 8 ) \
-    SYSCALL_ENTRY( 0x00d6, NtReplaceKey, 12 ) \
-    SYSCALL_ENTRY( 0x00d7, NtResetEvent, 8 ) \
-    SYSCALL_ENTRY( 0x00d8, NtResetWriteWatch, 12 ) \
-    SYSCALL_ENTRY( 0x00d9, NtRestoreKey, 12 ) \
-    SYSCALL_ENTRY( 0x00da, NtResumeProcess, 4 ) \
-    SYSCALL_ENTRY( 0x00db, NtRollbackTransaction, 8 ) \
-    SYSCALL_ENTRY( 0x00dc, NtSaveKey, 8 ) \
-    SYSCALL_ENTRY( 0x00dd, NtSecureConnectPort, 36 ) \
-    SYSCALL_ENTRY( 0x00de, NtSetContextThread, 8 ) \
-    SYSCALL_ENTRY( 0x00df, NtSetDebugFilterState, 12 ) \
-    SYSCALL_ENTRY( 0x00e0, NtSetDefaultLocale, 8 ) \
-    SYSCALL_ENTRY( 0x00e1, NtSetDefaultUILanguage, 4 ) \
-    SYSCALL_ENTRY( 0x00e2, NtSetEaFile, 16 ) \
-    SYSCALL_ENTRY( 0x00e3, NtSetInformationDebugObject, 20 ) \
-    SYSCALL_ENTRY( 0x00e4, NtSetInformationJobObject, 16 ) \
-    SYSCALL_ENTRY( 0x00e5, NtSetInformationKey, 16 ) \
-    SYSCALL_ENTRY( 0x00e6, NtSetInformationToken, 16 ) \
-    SYSCALL_ENTRY( 0x00e7, NtSetInformationVirtualMemory, 24 ) \
-    SYSCALL_ENTRY( 0x00e8, NtSetIntervalProfile, 8 ) \
-    SYSCALL_ENTRY( 0x00e9, NtSetIoCompletion, 20 ) \
-    SYSCALL_ENTRY( 0x00ea, NtSetIoCompletionEx, 24 ) \
-    SYSCALL_ENTRY( 0x00eb, NtSetLdtEntries, 24 ) \
-    SYSCALL_ENTRY( 0x00ec, NtSetSecurityObject, 12 ) \
-    SYSCALL_ENTRY( 0x00ed, NtSetSystemInformation, 12 ) \
-    SYSCALL_ENTRY( 0x00ee, NtSetSystemTime, 8 ) \
-    SYSCALL_ENTRY( 0x00ef, NtSetThreadExecutionState, 8 ) \
-    SYSCALL_ENTRY( 0x00f0, NtSetTimerResolution, 12 ) \
-    SYSCALL_ENTRY( 0x00f1, NtSetVolumeInformationFile, 20 ) \
-    SYSCALL_ENTRY( 0x00f2, NtShutdownSystem, 4 ) \
-    SYSCALL_ENTRY( 0x00f3, NtSignalAndWaitForSingleObject, 16 ) \
-    SYSCALL_ENTRY( 0x00f4, NtSuspendProcess, 4 ) \
-    SYSCALL_ENTRY( 0x00f5, NtSuspendThread, 8 ) \
-    SYSCALL_ENTRY( 0x00f6, NtSystemDebugControl, 24 ) \
-    SYSCALL_ENTRY( 0x00f7, NtTerminateJobObject, 8 ) \
-    SYSCALL_ENTRY( 0x00f8, NtTestAlert, 0 ) \
-    SYSCALL_ENTRY( 0x00f9, NtTraceControl, 24 ) \
-    SYSCALL_ENTRY( 0x00fa, NtUnloadDriver, 4 ) \
-    SYSCALL_ENTRY( 0x00fb, NtUnloadKey, 4 ) \
-    SYSCALL_ENTRY( 0x00fc, NtUnlockFile, 20 ) \
-    SYSCALL_ENTRY( 0x00fd, NtUnlockVirtualMemory, 16 ) \
-    SYSCALL_ENTRY( 0x00fe, NtUnmapViewOfSectionEx, 12 ) \
-    SYSCALL_ENTRY( 0x00ff, NtWaitForAlertByThreadId, 8 ) \
-    SYSCALL_ENTRY( 0x0100, NtWaitForDebugEvent, 16 ) \
-    SYSCALL_ENTRY( 0x0101, NtWaitForKeyedEvent, 16 ) \
-    SYSCALL_ENTRY( 0x0102, NtWow64AllocateVirtualMemory64, 28 ) \
-    SYSCALL_ENTRY( 0x0103, NtWow64GetNativeSystemInformation, 16 ) \
-    SYSCALL_ENTRY( 0x0104, NtWow64IsProcessorFeaturePresent, 4 ) \
-    SYSCALL_ENTRY( 0x0105, NtWow64QueryInformationProcess64, 20 ) \
-    SYSCALL_ENTRY( 0x0106, NtWow64ReadVirtualMemory64, 28 ) \
-    SYSCALL_ENTRY( 0x0107, NtWow64WriteVirtualMemory64, 28 )
+    SYSCALL_ENTRY( 0x00a7, NtLoadKey2, 12 ) \
+    SYSCALL_ENTRY( 0x00a8, NtLoadKeyEx, 32 ) \
+    SYSCALL_ENTRY( 0x00a9, NtLockFile, 40 ) \
+    SYSCALL_ENTRY( 0x00aa, NtLockVirtualMemory, 16 ) \
+    SYSCALL_ENTRY( 0x00ab, NtMakePermanentObject, 4 ) \
+    SYSCALL_ENTRY( 0x00ac, NtMakeTemporaryObject, 4 ) \
+    SYSCALL_ENTRY( 0x00ad, NtMapViewOfSectionEx, 36 ) \
+    SYSCALL_ENTRY( 0x00ae, NtNotifyChangeDirectoryFile, 36 ) \
+    SYSCALL_ENTRY( 0x00af, NtNotifyChangeKey, 40 ) \
+    SYSCALL_ENTRY( 0x00b0, NtNotifyChangeMultipleKeys, 48 ) \
+    SYSCALL_ENTRY( 0x00b1, NtOpenIoCompletion, 12 ) \
+    SYSCALL_ENTRY( 0x00b2, NtOpenJobObject, 12 ) \
+    SYSCALL_ENTRY( 0x00b3, NtOpenKeyEx, 16 ) \
+    SYSCALL_ENTRY( 0x00b4, NtOpenKeyTransacted, 16 ) \
+    SYSCALL_ENTRY( 0x00b5, NtOpenKeyTransactedEx, 20 ) \
+    SYSCALL_ENTRY( 0x00b6, NtOpenKeyedEvent, 12 ) \
+    SYSCALL_ENTRY( 0x00b7, NtOpenMutant, 12 ) \
+    SYSCALL_ENTRY( 0x00b8, NtOpenProcessToken, 12 ) \
+    SYSCALL_ENTRY( 0x00b9, NtOpenSemaphore, 12 ) \
+    SYSCALL_ENTRY( 0x00ba, NtOpenSymbolicLinkObject, 12 ) \
+    SYSCALL_ENTRY( 0x00bb, NtOpenThread, 16 ) \
+    SYSCALL_ENTRY( 0x00bc, NtOpenTimer, 12 ) \
+    SYSCALL_ENTRY( 0x00bd, NtPrivilegeCheck, 12 ) \
+    SYSCALL_ENTRY( 0x00be, NtPulseEvent, 8 ) \
+    SYSCALL_ENTRY( 0x00bf, NtQueryDirectoryObject, 28 ) \
+    SYSCALL_ENTRY( 0x00c0, NtQueryEaFile, 36 ) \
+    SYSCALL_ENTRY( 0x00c1, NtQueryFullAttributesFile, 8 ) \
+    SYSCALL_ENTRY( 0x00c2, NtQueryInformationAtom, 20 ) \
+    SYSCALL_ENTRY( 0x00c3, NtQueryInformationJobObject, 20 ) \
+    SYSCALL_ENTRY( 0x00c4, NtQueryInstallUILanguage, 4 ) \
+    SYSCALL_ENTRY( 0x00c5, NtQueryIoCompletion, 20 ) \
+    SYSCALL_ENTRY( 0x00c6, NtQueryLicenseValue, 20 ) \
+    SYSCALL_ENTRY( 0x00c7, NtQueryMultipleValueKey, 24 ) \
+    SYSCALL_ENTRY( 0x00c8, NtQueryMutant, 20 ) \
+    SYSCALL_ENTRY( 0x00c9, NtQuerySecurityObject, 20 ) \
+    SYSCALL_ENTRY( 0x00ca, NtQuerySemaphore, 20 ) \
+    SYSCALL_ENTRY( 0x00cb, NtQuerySymbolicLinkObject, 12 ) \
+    SYSCALL_ENTRY( 0x00cc, NtQuerySystemEnvironmentValue, 16 ) \
+    SYSCALL_ENTRY( 0x00cd, NtQuerySystemEnvironmentValueEx, 20 ) \
+    SYSCALL_ENTRY( 0x00ce, NtQuerySystemInformationEx, 24 ) \
+    SYSCALL_ENTRY( 0x00cf, NtQueryTimerResolution, 12 ) \
+    SYSCALL_ENTRY( 0x00d0, NtQueueApcThreadEx, 24 ) \
+    SYSCALL_ENTRY( 0x00d1, NtQueueApcThreadEx2, 28 ) \
+    SYSCALL_ENTRY( 0x00d2, NtRaiseException, 12 ) \
+    SYSCALL_ENTRY( 0x00d3, NtRaiseHardError, 24 ) \
+    SYSCALL_ENTRY( 0x00d4, NtRegisterThreadTerminatePort, 4 ) \
+    SYSCALL_ENTRY( 0x00d5, NtReleaseKeyedEvent, 16 ) \
+    SYSCALL_ENTRY( 0x00d6, NtRemoveIoCompletionEx, 24 ) \
+    SYSCALL_ENTRY( 0x00d7, NtRemoveProcessDebug, 8 ) \
+    SYSCALL_ENTRY( 0x00d8, NtRenameKey, 8 ) \
+    SYSCALL_ENTRY( 0x00d9, NtReplaceKey, 12 ) \
+    SYSCALL_ENTRY( 0x00da, NtResetEvent, 8 ) \
+    SYSCALL_ENTRY( 0x00db, NtResetWriteWatch, 12 ) \
+    SYSCALL_ENTRY( 0x00dc, NtRestoreKey, 12 ) \
+    SYSCALL_ENTRY( 0x00dd, NtResumeProcess, 4 ) \
+    SYSCALL_ENTRY( 0x00de, NtRollbackTransaction, 8 ) \
+    SYSCALL_ENTRY( 0x00df, NtSaveKey, 8 ) \
+    SYSCALL_ENTRY( 0x00e0, NtSecureConnectPort, 36 ) \
+    SYSCALL_ENTRY( 0x00e1, NtSetContextThread, 8 ) \
+    SYSCALL_ENTRY( 0x00e2, NtSetDebugFilterState, 12 ) \
+    SYSCALL_ENTRY( 0x00e3, NtSetDefaultLocale, 8 ) \
+    SYSCALL_ENTRY( 0x00e4, NtSetDefaultUILanguage, 4 ) \
+    SYSCALL_ENTRY( 0x00e5, NtSetEaFile, 16 ) \
+    SYSCALL_ENTRY( 0x00e6, NtSetInformationDebugObject, 20 ) \
+    SYSCALL_ENTRY( 0x00e7, NtSetInformationJobObject, 16 ) \
+    SYSCALL_ENTRY( 0x00e8, NtSetInformationKey, 16 ) \
+    SYSCALL_ENTRY( 0x00e9, NtSetInformationToken, 16 ) \
+    SYSCALL_ENTRY( 0x00ea, NtSetInformationVirtualMemory, 24 ) \
+    SYSCALL_ENTRY( 0x00eb, NtSetIntervalProfile, 8 ) \
+    SYSCALL_ENTRY( 0x00ec, NtSetIoCompletion, 20 ) \
+    SYSCALL_ENTRY( 0x00ed, NtSetIoCompletionEx, 24 ) \
+    SYSCALL_ENTRY( 0x00ee, NtSetLdtEntries, 24 ) \
+    SYSCALL_ENTRY( 0x00ef, NtSetSecurityObject, 12 ) \
+    SYSCALL_ENTRY( 0x00f0, NtSetSystemInformation, 12 ) \
+    SYSCALL_ENTRY( 0x00f1, NtSetSystemTime, 8 ) \
+    SYSCALL_ENTRY( 0x00f2, NtSetThreadExecutionState, 8 ) \
+    SYSCALL_ENTRY( 0x00f3, NtSetTimerResolution, 12 ) \
+    SYSCALL_ENTRY( 0x00f4, NtSetVolumeInformationFile, 20 ) \
+    SYSCALL_ENTRY( 0x00f5, NtShutdownSystem, 4 ) \
+    SYSCALL_ENTRY( 0x00f6, NtSignalAndWaitForSingleObject, 16 ) \
+    SYSCALL_ENTRY( 0x00f7, NtSuspendProcess, 4 ) \
+    SYSCALL_ENTRY( 0x00f8, NtSuspendThread, 8 ) \
+    SYSCALL_ENTRY( 0x00f9, NtSystemDebugControl, 24 ) \
+    SYSCALL_ENTRY( 0x00fa, NtTerminateJobObject, 8 ) \
+    SYSCALL_ENTRY( 0x00fb, NtTestAlert, 0 ) \
+    SYSCALL_ENTRY( 0x00fc, NtTraceControl, 24 ) \
+    SYSCALL_ENTRY( 0x00fd, NtUnloadDriver, 4 ) \
+    SYSCALL_ENTRY( 0x00fe, NtUnloadKey, 4 ) \
+    SYSCALL_ENTRY( 0x00ff, NtUnlockFile, 20 ) \
+    SYSCALL_ENTRY( 0x0100, NtUnlockVirtualMemory, 16 ) \
+    SYSCALL_ENTRY( 0x0101, NtUnmapViewOfSectionEx, 12 ) \
+    SYSCALL_ENTRY( 0x0102, NtWaitForAlertByThreadId, 8 ) \
+    SYSCALL_ENTRY( 0x0103, NtWaitForDebugEvent, 16 ) \
+    SYSCALL_ENTRY( 0x0104, NtWaitForKeyedEvent, 16 ) \
+    SYSCALL_ENTRY( 0x0105, NtWow64AllocateVirtualMemory64, 28 ) \
+    SYSCALL_ENTRY( 0x0106, NtWow64GetNativeSystemInformation, 16 ) \
+    SYSCALL_ENTRY( 0x0107, NtWow64IsProcessorFeaturePresent, 4 ) \
+    SYSCALL_ENTRY( 0x0108, NtWow64QueryInformationProcess64, 20 ) \
+    SYSCALL_ENTRY( 0x0109, NtWow64ReadVirtualMemory64, 28 ) \
+    SYSCALL_ENTRY( 0x010a, NtWow64WriteVirtualMemory64, 28 )
 #ifdef _WIN64
 #define ALL_SYSCALLS \
     SYSCALL_ENTRY( 0x0000, NtAccessCheck, 64 ) \
@@ -377,154 +380,157 @@
     SYSCALL_ENTRY( 0x006b, NtAllocateVirtualMemoryEx, 56 ) \
     SYSCALL_ENTRY( 0x006c, NtAreMappedFilesTheSame, 16 ) \
     SYSCALL_ENTRY( 0x006d, NtAssignProcessToJobObject, 16 ) \
-    SYSCALL_ENTRY( 0x006e, NtCancelIoFileEx, 24 ) \
-    SYSCALL_ENTRY( 0x006f, NtCancelSynchronousIoFile, 24 ) \
-    SYSCALL_ENTRY( 0x0070, NtCommitTransaction, 16 ) \
-    SYSCALL_ENTRY( 0x0071, NtCompareObjects, 16 ) \
-    SYSCALL_ENTRY( 0x0072, NtCompareTokens, 24 ) \
-    SYSCALL_ENTRY( 0x0073, NtCompleteConnectPort, 8 ) \
-    SYSCALL_ENTRY( 0x0074, NtConnectPort, 64 ) \
-    SYSCALL_ENTRY( 0x0075, NtContinueEx, 16 ) \
-    SYSCALL_ENTRY( 0x0076, NtConvertBetweenAuxiliaryCounterAndPerformanceCounter, 32 ) \
-    SYSCALL_ENTRY( 0x0077, NtCreateDirectoryObject, 24 ) \
-    SYSCALL_ENTRY( 0x0078, NtCreateIoCompletion, 32 ) \
-    SYSCALL_ENTRY( 0x0079, NtCreateJobObject, 24 ) \
-    SYSCALL_ENTRY( 0x007a, NtCreateKeyTransacted, 64 ) \
-    SYSCALL_ENTRY( 0x007b, NtCreateKeyedEvent, 32 ) \
-    SYSCALL_ENTRY( 0x007c, NtCreateLowBoxToken, 72 ) \
-    SYSCALL_ENTRY( 0x007d, NtCreateMailslotFile, 64 ) \
-    SYSCALL_ENTRY( 0x007e, NtCreateMutant, 32 ) \
-    SYSCALL_ENTRY( 0x007f, NtCreateNamedPipeFile, 112 ) \
-    SYSCALL_ENTRY( 0x0080, NtCreatePagingFile, 32 ) \
-    SYSCALL_ENTRY( 0x0081, NtCreatePort, 40 ) \
-    SYSCALL_ENTRY( 0x0082, NtCreateSectionEx, 72 ) \
-    SYSCALL_ENTRY( 0x0083, NtCreateSemaphore, 40 ) \
-    SYSCALL_ENTRY( 0x0084, NtCreateSymbolicLinkObject, 32 ) \
-    SYSCALL_ENTRY( 0x0085, NtCreateThreadEx, 88 ) \
-    SYSCALL_ENTRY( 0x0086, NtCreateTimer, 32 ) \
-    SYSCALL_ENTRY( 0x0087, NtCreateToken, 104 ) \
-    SYSCALL_ENTRY( 0x0088, NtCreateTransaction, 80 ) \
-    SYSCALL_ENTRY( 0x0089, NtCreateUserProcess, 88 ) \
-    SYSCALL_ENTRY( 0x008a, NtDebugActiveProcess, 16 ) \
-    SYSCALL_ENTRY( 0x008b, NtDebugContinue, 24 ) \
-    SYSCALL_ENTRY( 0x008c, NtDeleteAtom, 8 ) \
-    SYSCALL_ENTRY( 0x008d, NtDeleteFile, 8 ) \
-    SYSCALL_ENTRY( 0x008e, NtDeleteKey, 8 ) \
-    SYSCALL_ENTRY( 0x008f, NtDeleteValueKey, 16 ) \
-    SYSCALL_ENTRY( 0x0090, NtDisplayString, 8 ) \
-    SYSCALL_ENTRY( 0x0091, NtFilterToken, 48 ) \
-    SYSCALL_ENTRY( 0x0092, NtFlushBuffersFileEx, 40 ) \
-    SYSCALL_ENTRY( 0x0093, NtFlushInstructionCache, 24 ) \
-    SYSCALL_ENTRY( 0x0094, NtFlushKey, 8 ) \
-    SYSCALL_ENTRY( 0x0095, NtFlushProcessWriteBuffers, 0 ) \
-    SYSCALL_ENTRY( 0x0096, NtFlushVirtualMemory, 32 ) \
-    SYSCALL_ENTRY( 0x0097, NtGetContextThread, 16 ) \
-    SYSCALL_ENTRY( 0x0098, NtGetCurrentProcessorNumber, 0 ) \
-    SYSCALL_ENTRY( 0x0099, NtGetNextProcess, 40 ) \
-    SYSCALL_ENTRY( 0x009a, NtGetNextThread, 48 ) \
-    SYSCALL_ENTRY( 0x009b, NtGetNlsSectionPtr, 40 ) \
-    SYSCALL_ENTRY( 0x009c, NtGetWriteWatch, 56 ) \
-    SYSCALL_ENTRY( 0x009d, NtImpersonateAnonymousToken, 8 ) \
-    SYSCALL_ENTRY( 0x009e, NtInitializeNlsFiles, 24 ) \
-    SYSCALL_ENTRY( 0x009f, NtInitiatePowerAction, 32 ) \
-    SYSCALL_ENTRY( 0x00a0, NtListenPort, 16 ) \
-    SYSCALL_ENTRY( 0x00a1, NtLoadDriver, 8 ) \
-    SYSCALL_ENTRY( 0x00a2, NtLoadKey, 16 ) \
-    SYSCALL_ENTRY( 0x00a3, NtLoadKey2, 24 ) \
-    SYSCALL_ENTRY( 0x00a4, NtLoadKeyEx, 64 ) \
-    SYSCALL_ENTRY( 0x00a5, NtLockFile, 80 ) \
+    SYSCALL_ENTRY( 0x006e, NtAssociateWaitCompletionPacket, 64 ) \
+    SYSCALL_ENTRY( 0x006f, NtCancelIoFileEx, 24 ) \
+    SYSCALL_ENTRY( 0x0070, NtCancelSynchronousIoFile, 24 ) \
+    SYSCALL_ENTRY( 0x0071, NtCancelWaitCompletionPacket, 16 ) \
+    SYSCALL_ENTRY( 0x0072, NtCommitTransaction, 16 ) \
+    SYSCALL_ENTRY( 0x0073, NtCompareObjects, 16 ) \
+    SYSCALL_ENTRY( 0x0074, NtCompareTokens, 24 ) \
+    SYSCALL_ENTRY( 0x0075, NtCompleteConnectPort, 8 ) \
+    SYSCALL_ENTRY( 0x0076, NtConnectPort, 64 ) \
+    SYSCALL_ENTRY( 0x0077, NtContinueEx, 16 ) \
+    SYSCALL_ENTRY( 0x0078, NtConvertBetweenAuxiliaryCounterAndPerformanceCounter, 32 ) \
+    SYSCALL_ENTRY( 0x0079, NtCreateDirectoryObject, 24 ) \
+    SYSCALL_ENTRY( 0x007a, NtCreateIoCompletion, 32 ) \
+    SYSCALL_ENTRY( 0x007b, NtCreateJobObject, 24 ) \
+    SYSCALL_ENTRY( 0x007c, NtCreateKeyTransacted, 64 ) \
+    SYSCALL_ENTRY( 0x007d, NtCreateKeyedEvent, 32 ) \
+    SYSCALL_ENTRY( 0x007e, NtCreateLowBoxToken, 72 ) \
+    SYSCALL_ENTRY( 0x007f, NtCreateMailslotFile, 64 ) \
+    SYSCALL_ENTRY( 0x0080, NtCreateMutant, 32 ) \
+    SYSCALL_ENTRY( 0x0081, NtCreateNamedPipeFile, 112 ) \
+    SYSCALL_ENTRY( 0x0082, NtCreatePagingFile, 32 ) \
+    SYSCALL_ENTRY( 0x0083, NtCreatePort, 40 ) \
+    SYSCALL_ENTRY( 0x0084, NtCreateSectionEx, 72 ) \
+    SYSCALL_ENTRY( 0x0085, NtCreateSemaphore, 40 ) \
+    SYSCALL_ENTRY( 0x0086, NtCreateSymbolicLinkObject, 32 ) \
+    SYSCALL_ENTRY( 0x0087, NtCreateThreadEx, 88 ) \
+    SYSCALL_ENTRY( 0x0088, NtCreateTimer, 32 ) \
+    SYSCALL_ENTRY( 0x0089, NtCreateToken, 104 ) \
+    SYSCALL_ENTRY( 0x008a, NtCreateTransaction, 80 ) \
+    SYSCALL_ENTRY( 0x008b, NtCreateUserProcess, 88 ) \
+    SYSCALL_ENTRY( 0x008c, NtCreateWaitCompletionPacket, 24 ) \
+    SYSCALL_ENTRY( 0x008d, NtDebugActiveProcess, 16 ) \
+    SYSCALL_ENTRY( 0x008e, NtDebugContinue, 24 ) \
+    SYSCALL_ENTRY( 0x008f, NtDeleteAtom, 8 ) \
+    SYSCALL_ENTRY( 0x0090, NtDeleteFile, 8 ) \
+    SYSCALL_ENTRY( 0x0091, NtDeleteKey, 8 ) \
+    SYSCALL_ENTRY( 0x0092, NtDeleteValueKey, 16 ) \
+    SYSCALL_ENTRY( 0x0093, NtDisplayString, 8 ) \
+    SYSCALL_ENTRY( 0x0094, NtFilterToken, 48 ) \
+    SYSCALL_ENTRY( 0x0095, NtFlushBuffersFileEx, 40 ) \
+    SYSCALL_ENTRY( 0x0096, NtFlushInstructionCache, 24 ) \
+    SYSCALL_ENTRY( 0x0097, NtFlushKey, 8 ) \
+    SYSCALL_ENTRY( 0x0098, NtFlushProcessWriteBuffers, 0 ) \
+    SYSCALL_ENTRY( 0x0099, NtFlushVirtualMemory, 32 ) \
+    SYSCALL_ENTRY( 0x009a, NtGetContextThread, 16 ) \
+    SYSCALL_ENTRY( 0x009b, NtGetCurrentProcessorNumber, 0 ) \
+    SYSCALL_ENTRY( 0x009c, NtGetNextProcess, 40 ) \
+    SYSCALL_ENTRY( 0x009d, NtGetNextThread, 48 ) \
+    SYSCALL_ENTRY( 0x009e, NtGetNlsSectionPtr, 40 ) \
+    SYSCALL_ENTRY( 0x009f, NtGetWriteWatch, 56 ) \
+    SYSCALL_ENTRY( 0x00a0, NtImpersonateAnonymousToken, 8 ) \
+    SYSCALL_ENTRY( 0x00a1, NtInitializeNlsFiles, 24 ) \
+    SYSCALL_ENTRY( 0x00a2, NtInitiatePowerAction, 32 ) \
+    SYSCALL_ENTRY( 0x00a3, NtListenPort, 16 ) \
+    SYSCALL_ENTRY( 0x00a4, NtLoadDriver, 8 ) \
+    SYSCALL_ENTRY( 0x00a5, NtLoadKey, 16 ) \
     SYSCALL_ENTRY( 0x00a6, NtCreateDebugObject, 32 ) \
-    SYSCALL_ENTRY( 0x00a7, NtLockVirtualMemory, 32 ) \
-    SYSCALL_ENTRY( 0x00a8, NtMakePermanentObject, 8 ) \
-    SYSCALL_ENTRY( 0x00a9, NtMakeTemporaryObject, 8 ) \
-    SYSCALL_ENTRY( 0x00aa, NtMapViewOfSectionEx, 72 ) \
-    SYSCALL_ENTRY( 0x00ab, NtNotifyChangeDirectoryFile, 72 ) \
-    SYSCALL_ENTRY( 0x00ac, NtNotifyChangeKey, 80 ) \
-    SYSCALL_ENTRY( 0x00ad, NtNotifyChangeMultipleKeys, 96 ) \
-    SYSCALL_ENTRY( 0x00ae, NtOpenIoCompletion, 24 ) \
-    SYSCALL_ENTRY( 0x00af, NtOpenJobObject, 24 ) \
-    SYSCALL_ENTRY( 0x00b0, NtOpenKeyEx, 32 ) \
-    SYSCALL_ENTRY( 0x00b1, NtOpenKeyTransacted, 32 ) \
-    SYSCALL_ENTRY( 0x00b2, NtOpenKeyTransactedEx, 40 ) \
-    SYSCALL_ENTRY( 0x00b3, NtOpenKeyedEvent, 24 ) \
-    SYSCALL_ENTRY( 0x00b4, NtOpenMutant, 24 ) \
-    SYSCALL_ENTRY( 0x00b5, NtOpenProcessToken, 24 ) \
-    SYSCALL_ENTRY( 0x00b6, NtOpenSemaphore, 24 ) \
-    SYSCALL_ENTRY( 0x00b7, NtOpenSymbolicLinkObject, 24 ) \
-    SYSCALL_ENTRY( 0x00b8, NtOpenThread, 32 ) \
-    SYSCALL_ENTRY( 0x00b9, NtOpenTimer, 24 ) \
-    SYSCALL_ENTRY( 0x00ba, NtPrivilegeCheck, 24 ) \
-    SYSCALL_ENTRY( 0x00bb, NtPulseEvent, 16 ) \
-    SYSCALL_ENTRY( 0x00bc, NtQueryDirectoryObject, 56 ) \
-    SYSCALL_ENTRY( 0x00bd, NtQueryEaFile, 72 ) \
-    SYSCALL_ENTRY( 0x00be, NtQueryFullAttributesFile, 16 ) \
-    SYSCALL_ENTRY( 0x00bf, NtQueryInformationAtom, 40 ) \
-    SYSCALL_ENTRY( 0x00c0, NtQueryInformationJobObject, 40 ) \
-    SYSCALL_ENTRY( 0x00c1, NtQueryInstallUILanguage, 8 ) \
-    SYSCALL_ENTRY( 0x00c2, NtQueryIoCompletion, 40 ) \
-    SYSCALL_ENTRY( 0x00c3, NtQueryLicenseValue, 40 ) \
-    SYSCALL_ENTRY( 0x00c4, NtQueryMultipleValueKey, 48 ) \
-    SYSCALL_ENTRY( 0x00c5, NtQueryMutant, 40 ) \
-    SYSCALL_ENTRY( 0x00c6, NtQuerySecurityObject, 40 ) \
-    SYSCALL_ENTRY( 0x00c7, NtQuerySemaphore, 40 ) \
-    SYSCALL_ENTRY( 0x00c8, NtQuerySymbolicLinkObject, 24 ) \
-    SYSCALL_ENTRY( 0x00c9, NtQuerySystemEnvironmentValue, 32 ) \
-    SYSCALL_ENTRY( 0x00ca, NtQuerySystemEnvironmentValueEx, 40 ) \
-    SYSCALL_ENTRY( 0x00cb, NtQuerySystemInformationEx, 48 ) \
-    SYSCALL_ENTRY( 0x00cc, NtQueryTimerResolution, 24 ) \
-    SYSCALL_ENTRY( 0x00cd, NtQueueApcThreadEx, 48 ) \
-    SYSCALL_ENTRY( 0x00ce, NtQueueApcThreadEx2, 56 ) \
-    SYSCALL_ENTRY( 0x00cf, NtRaiseException, 24 ) \
-    SYSCALL_ENTRY( 0x00d0, NtRaiseHardError, 48 ) \
-    SYSCALL_ENTRY( 0x00d1, NtRegisterThreadTerminatePort, 8 ) \
-    SYSCALL_ENTRY( 0x00d2, NtReleaseKeyedEvent, 32 ) \
-    SYSCALL_ENTRY( 0x00d3, NtRemoveIoCompletionEx, 48 ) \
-    SYSCALL_ENTRY( 0x00d4, NtRemoveProcessDebug, 16 ) \
-    SYSCALL_ENTRY( 0x00d5, NtRenameKey, 16 ) \
-    SYSCALL_ENTRY( 0x00d6, NtReplaceKey, 24 ) \
-    SYSCALL_ENTRY( 0x00d7, NtResetEvent, 16 ) \
-    SYSCALL_ENTRY( 0x00d8, NtResetWriteWatch, 24 ) \
-    SYSCALL_ENTRY( 0x00d9, NtRestoreKey, 24 ) \
-    SYSCALL_ENTRY( 0x00da, NtResumeProcess, 8 ) \
-    SYSCALL_ENTRY( 0x00db, NtRollbackTransaction, 16 ) \
-    SYSCALL_ENTRY( 0x00dc, NtSaveKey, 16 ) \
-    SYSCALL_ENTRY( 0x00dd, NtSecureConnectPort, 72 ) \
-    SYSCALL_ENTRY( 0x00de, NtSetContextThread, 16 ) \
-    SYSCALL_ENTRY( 0x00df, NtSetDebugFilterState, 24 ) \
-    SYSCALL_ENTRY( 0x00e0, NtSetDefaultLocale, 16 ) \
-    SYSCALL_ENTRY( 0x00e1, NtSetDefaultUILanguage, 8 ) \
-    SYSCALL_ENTRY( 0x00e2, NtSetEaFile, 32 ) \
-    SYSCALL_ENTRY( 0x00e3, NtSetInformationDebugObject, 40 ) \
-    SYSCALL_ENTRY( 0x00e4, NtSetInformationJobObject, 32 ) \
-    SYSCALL_ENTRY( 0x00e5, NtSetInformationKey, 32 ) \
-    SYSCALL_ENTRY( 0x00e6, NtSetInformationToken, 32 ) \
-    SYSCALL_ENTRY( 0x00e7, NtSetInformationVirtualMemory, 48 ) \
-    SYSCALL_ENTRY( 0x00e8, NtSetIntervalProfile, 16 ) \
-    SYSCALL_ENTRY( 0x00e9, NtSetIoCompletion, 40 ) \
-    SYSCALL_ENTRY( 0x00ea, NtSetIoCompletionEx, 48 ) \
-    SYSCALL_ENTRY( 0x00eb, NtSetLdtEntries, 48 ) \
-    SYSCALL_ENTRY( 0x00ec, NtSetSecurityObject, 24 ) \
-    SYSCALL_ENTRY( 0x00ed, NtSetSystemInformation, 24 ) \
-    SYSCALL_ENTRY( 0x00ee, NtSetSystemTime, 16 ) \
-    SYSCALL_ENTRY( 0x00ef, NtSetThreadExecutionState, 16 ) \
-    SYSCALL_ENTRY( 0x00f0, NtSetTimerResolution, 24 ) \
-    SYSCALL_ENTRY( 0x00f1, NtSetVolumeInformationFile, 40 ) \
-    SYSCALL_ENTRY( 0x00f2, NtShutdownSystem, 8 ) \
-    SYSCALL_ENTRY( 0x00f3, NtSignalAndWaitForSingleObject, 32 ) \
-    SYSCALL_ENTRY( 0x00f4, NtSuspendProcess, 8 ) \
-    SYSCALL_ENTRY( 0x00f5, NtSuspendThread, 16 ) \
-    SYSCALL_ENTRY( 0x00f6, NtSystemDebugControl, 48 ) \
-    SYSCALL_ENTRY( 0x00f7, NtTerminateJobObject, 16 ) \
-    SYSCALL_ENTRY( 0x00f8, NtTestAlert, 0 ) \
-    SYSCALL_ENTRY( 0x00f9, NtTraceControl, 48 ) \
-    SYSCALL_ENTRY( 0x00fa, NtUnloadDriver, 8 ) \
-    SYSCALL_ENTRY( 0x00fb, NtUnloadKey, 8 ) \
-    SYSCALL_ENTRY( 0x00fc, NtUnlockFile, 40 ) \
-    SYSCALL_ENTRY( 0x00fd, NtUnlockVirtualMemory, 32 ) \
-    SYSCALL_ENTRY( 0x00fe, NtUnmapViewOfSectionEx, 24 ) \
-    SYSCALL_ENTRY( 0x00ff, NtWaitForAlertByThreadId, 16 ) \
-    SYSCALL_ENTRY( 0x0100, NtWaitForDebugEvent, 32 ) \
-    SYSCALL_ENTRY( 0x0101, NtWaitForKeyedEvent, 32 )
+    SYSCALL_ENTRY( 0x00a7, NtLoadKey2, 24 ) \
+    SYSCALL_ENTRY( 0x00a8, NtLoadKeyEx, 64 ) \
+    SYSCALL_ENTRY( 0x00a9, NtLockFile, 80 ) \
+    SYSCALL_ENTRY( 0x00aa, NtLockVirtualMemory, 32 ) \
+    SYSCALL_ENTRY( 0x00ab, NtMakePermanentObject, 8 ) \
+    SYSCALL_ENTRY( 0x00ac, NtMakeTemporaryObject, 8 ) \
+    SYSCALL_ENTRY( 0x00ad, NtMapViewOfSectionEx, 72 ) \
+    SYSCALL_ENTRY( 0x00ae, NtNotifyChangeDirectoryFile, 72 ) \
+    SYSCALL_ENTRY( 0x00af, NtNotifyChangeKey, 80 ) \
+    SYSCALL_ENTRY( 0x00b0, NtNotifyChangeMultipleKeys, 96 ) \
+    SYSCALL_ENTRY( 0x00b1, NtOpenIoCompletion, 24 ) \
+    SYSCALL_ENTRY( 0x00b2, NtOpenJobObject, 24 ) \
+    SYSCALL_ENTRY( 0x00b3, NtOpenKeyEx, 32 ) \
+    SYSCALL_ENTRY( 0x00b4, NtOpenKeyTransacted, 32 ) \
+    SYSCALL_ENTRY( 0x00b5, NtOpenKeyTransactedEx, 40 ) \
+    SYSCALL_ENTRY( 0x00b6, NtOpenKeyedEvent, 24 ) \
+    SYSCALL_ENTRY( 0x00b7, NtOpenMutant, 24 ) \
+    SYSCALL_ENTRY( 0x00b8, NtOpenProcessToken, 24 ) \
+    SYSCALL_ENTRY( 0x00b9, NtOpenSemaphore, 24 ) \
+    SYSCALL_ENTRY( 0x00ba, NtOpenSymbolicLinkObject, 24 ) \
+    SYSCALL_ENTRY( 0x00bb, NtOpenThread, 32 ) \
+    SYSCALL_ENTRY( 0x00bc, NtOpenTimer, 24 ) \
+    SYSCALL_ENTRY( 0x00bd, NtPrivilegeCheck, 24 ) \
+    SYSCALL_ENTRY( 0x00be, NtPulseEvent, 16 ) \
+    SYSCALL_ENTRY( 0x00bf, NtQueryDirectoryObject, 56 ) \
+    SYSCALL_ENTRY( 0x00c0, NtQueryEaFile, 72 ) \
+    SYSCALL_ENTRY( 0x00c1, NtQueryFullAttributesFile, 16 ) \
+    SYSCALL_ENTRY( 0x00c2, NtQueryInformationAtom, 40 ) \
+    SYSCALL_ENTRY( 0x00c3, NtQueryInformationJobObject, 40 ) \
+    SYSCALL_ENTRY( 0x00c4, NtQueryInstallUILanguage, 8 ) \
+    SYSCALL_ENTRY( 0x00c5, NtQueryIoCompletion, 40 ) \
+    SYSCALL_ENTRY( 0x00c6, NtQueryLicenseValue, 40 ) \
+    SYSCALL_ENTRY( 0x00c7, NtQueryMultipleValueKey, 48 ) \
+    SYSCALL_ENTRY( 0x00c8, NtQueryMutant, 40 ) \
+    SYSCALL_ENTRY( 0x00c9, NtQuerySecurityObject, 40 ) \
+    SYSCALL_ENTRY( 0x00ca, NtQuerySemaphore, 40 ) \
+    SYSCALL_ENTRY( 0x00cb, NtQuerySymbolicLinkObject, 24 ) \
+    SYSCALL_ENTRY( 0x00cc, NtQuerySystemEnvironmentValue, 32 ) \
+    SYSCALL_ENTRY( 0x00cd, NtQuerySystemEnvironmentValueEx, 40 ) \
+    SYSCALL_ENTRY( 0x00ce, NtQuerySystemInformationEx, 48 ) \
+    SYSCALL_ENTRY( 0x00cf, NtQueryTimerResolution, 24 ) \
+    SYSCALL_ENTRY( 0x00d0, NtQueueApcThreadEx, 48 ) \
+    SYSCALL_ENTRY( 0x00d1, NtQueueApcThreadEx2, 56 ) \
+    SYSCALL_ENTRY( 0x00d2, NtRaiseException, 24 ) \
+    SYSCALL_ENTRY( 0x00d3, NtRaiseHardError, 48 ) \
+    SYSCALL_ENTRY( 0x00d4, NtRegisterThreadTerminatePort, 8 ) \
+    SYSCALL_ENTRY( 0x00d5, NtReleaseKeyedEvent, 32 ) \
+    SYSCALL_ENTRY( 0x00d6, NtRemoveIoCompletionEx, 48 ) \
+    SYSCALL_ENTRY( 0x00d7, NtRemoveProcessDebug, 16 ) \
+    SYSCALL_ENTRY( 0x00d8, NtRenameKey, 16 ) \
+    SYSCALL_ENTRY( 0x00d9, NtReplaceKey, 24 ) \
+    SYSCALL_ENTRY( 0x00da, NtResetEvent, 16 ) \
+    SYSCALL_ENTRY( 0x00db, NtResetWriteWatch, 24 ) \
+    SYSCALL_ENTRY( 0x00dc, NtRestoreKey, 24 ) \
+    SYSCALL_ENTRY( 0x00dd, NtResumeProcess, 8 ) \
+    SYSCALL_ENTRY( 0x00de, NtRollbackTransaction, 16 ) \
+    SYSCALL_ENTRY( 0x00df, NtSaveKey, 16 ) \
+    SYSCALL_ENTRY( 0x00e0, NtSecureConnectPort, 72 ) \
+    SYSCALL_ENTRY( 0x00e1, NtSetContextThread, 16 ) \
+    SYSCALL_ENTRY( 0x00e2, NtSetDebugFilterState, 24 ) \
+    SYSCALL_ENTRY( 0x00e3, NtSetDefaultLocale, 16 ) \
+    SYSCALL_ENTRY( 0x00e4, NtSetDefaultUILanguage, 8 ) \
+    SYSCALL_ENTRY( 0x00e5, NtSetEaFile, 32 ) \
+    SYSCALL_ENTRY( 0x00e6, NtSetInformationDebugObject, 40 ) \
+    SYSCALL_ENTRY( 0x00e7, NtSetInformationJobObject, 32 ) \
+    SYSCALL_ENTRY( 0x00e8, NtSetInformationKey, 32 ) \
+    SYSCALL_ENTRY( 0x00e9, NtSetInformationToken, 32 ) \
+    SYSCALL_ENTRY( 0x00ea, NtSetInformationVirtualMemory, 48 ) \
+    SYSCALL_ENTRY( 0x00eb, NtSetIntervalProfile, 16 ) \
+    SYSCALL_ENTRY( 0x00ec, NtSetIoCompletion, 40 ) \
+    SYSCALL_ENTRY( 0x00ed, NtSetIoCompletionEx, 48 ) \
+    SYSCALL_ENTRY( 0x00ee, NtSetLdtEntries, 48 ) \
+    SYSCALL_ENTRY( 0x00ef, NtSetSecurityObject, 24 ) \
+    SYSCALL_ENTRY( 0x00f0, NtSetSystemInformation, 24 ) \
+    SYSCALL_ENTRY( 0x00f1, NtSetSystemTime, 16 ) \
+    SYSCALL_ENTRY( 0x00f2, NtSetThreadExecutionState, 16 ) \
+    SYSCALL_ENTRY( 0x00f3, NtSetTimerResolution, 24 ) \
+    SYSCALL_ENTRY( 0x00f4, NtSetVolumeInformationFile, 40 ) \
+    SYSCALL_ENTRY( 0x00f5, NtShutdownSystem, 8 ) \
+    SYSCALL_ENTRY( 0x00f6, NtSignalAndWaitForSingleObject, 32 ) \
+    SYSCALL_ENTRY( 0x00f7, NtSuspendProcess, 8 ) \
+    SYSCALL_ENTRY( 0x00f8, NtSuspendThread, 16 ) \
+    SYSCALL_ENTRY( 0x00f9, NtSystemDebugControl, 48 ) \
+    SYSCALL_ENTRY( 0x00fa, NtTerminateJobObject, 16 ) \
+    SYSCALL_ENTRY( 0x00fb, NtTestAlert, 0 ) \
+    SYSCALL_ENTRY( 0x00fc, NtTraceControl, 48 ) \
+    SYSCALL_ENTRY( 0x00fd, NtUnloadDriver, 8 ) \
+    SYSCALL_ENTRY( 0x00fe, NtUnloadKey, 8 ) \
+    SYSCALL_ENTRY( 0x00ff, NtUnlockFile, 40 ) \
+    SYSCALL_ENTRY( 0x0100, NtUnlockVirtualMemory, 32 ) \
+    SYSCALL_ENTRY( 0x0101, NtUnmapViewOfSectionEx, 24 ) \
+    SYSCALL_ENTRY( 0x0102, NtWaitForAlertByThreadId, 16 ) \
+    SYSCALL_ENTRY( 0x0103, NtWaitForDebugEvent, 32 ) \
+    SYSCALL_ENTRY( 0x0104, NtWaitForKeyedEvent, 32 )
 #else
 #define ALL_SYSCALLS ALL_SYSCALLS32
 #endif
@@ -3881,9 +3881,130 @@ static void test_NtAllocateReserveObject(void)
     }
 }
 
+struct request_bench
+{
+    HANDLE start;
+    HANDLE event;
+    LONG stop;
+    LONG64 calls;
+};
+
+static DWORD WINAPI request_bench_thread(void *arg)
+{
+    struct request_bench *bench = arg;
+    OBJECT_BASIC_INFORMATION info;
+    LONG64 calls = 0;
+    HANDLE dup;
+
+    WaitForSingleObject(bench->start, INFINITE);
+    while (!ReadNoFence(&bench->stop))
+    {
+        pNtQueryObject(bench->event, ObjectBasicInformation, &info, sizeof(info), NULL);
+        pNtDuplicateObject(GetCurrentProcess(), bench->event, GetCurrentProcess(), &dup, 0, 0, DUPLICATE_SAME_ACCESS);
+        pNtClose(dup);
+        calls += 3;
+    }
+    InterlockedAdd64(&bench->calls, calls);
+    return 0;
+}
+
+/* Total server request throughput with an increasing number of threads making independent
+ * requests. Only run when WINETEST_BENCHMARK is set. */
+static void test_request_throughput(void)
+{
+    static const DWORD duration = 1000;
+    struct request_bench bench;
+    HANDLE threads[64];
+    SYSTEM_INFO si;
+    unsigned int i, count, max_count;
+    DWORD ticks;
+
+    if (!GetEnvironmentVariableA("WINETEST_BENCHMARK", NULL, 0))
+    {
+        skip("set WINETEST_BENCHMARK to measure the server request throughput\n");
+        return;
+    }
+
+    GetSystemInfo(&si);
+    max_count = min(2 * si.dwNumberOfProcessors, ARRAY_SIZE(threads));
+    bench.event = CreateEventA(NULL, FALSE, FALSE, NULL);
+    bench.start = CreateEventA(NULL, TRUE, FALSE, NULL);
+
+    for (count = 1; count <= max_count; count *= 2)
+    {
+        bench.stop = 0;
+        bench.calls = 0;
+        ResetEvent(bench.start);
+        for (i = 0; i < count; i++)
+            threads[i] = CreateThread(NULL, 0, request_bench_thread, &bench, 0, NULL);
+
+        ticks = GetTickCount();
+        SetEvent(bench.start);
+        Sleep(duration);
+        InterlockedExchange(&bench.stop, 1);
+        WaitForMultipleObjects(count, threads, TRUE, INFINITE);
+        ticks = GetTickCount() - ticks;
+        for (i = 0; i < count; i++) CloseHandle(threads[i]);
+
+        trace("%u threads: %.0f requests/s\n", count, bench.calls * 1000.0 / ticks);
+    }
+
+    CloseHandle(bench.start);
+    CloseHandle(bench.event);
+}
+
+/* Latency of a small server request. With WINESERVERRING=1, Wine sends it through the shared
+ * memory request ring instead of the pipes; that is measured in a child process. Only run
+ * when WINETEST_BENCHMARK is set. */
+static void run_request_latency(const char *label)
+{
+    static const int count = 200000;
+    LARGE_INTEGER freq, start, end;
+    OBJECT_BASIC_INFORMATION info;
+    HANDLE event;
+    int i;
+
+    event = CreateEventA(NULL, FALSE, FALSE, NULL);
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&start);
+    for (i = 0; i < count; i++)
+        pNtQueryObject(event, ObjectBasicInformation, &info, sizeof(info), NULL);
+    QueryPerformanceCounter(&end);
+    trace("%s: %.2f us per NtQueryObject call\n", label,
+          (end.QuadPart - start.QuadPart) * 1000000.0 / freq.QuadPart / count);
+    CloseHandle(event);
+}
+
+static void test_request_latency(void)
+{
+    STARTUPINFOA startup = { sizeof(startup) };
+    PROCESS_INFORMATION info;
+    char cmdline[MAX_PATH * 2];
+    char **argv;
+
+    if (!GetEnvironmentVariableA("WINETEST_BENCHMARK", NULL, 0))
+    {
+        skip("set WINETEST_BENCHMARK to measure the server request latency\n");
+        return;
+    }
+
+    run_request_latency("default");
+
+    winetest_get_mainargs(&argv);
+    sprintf(cmdline, "\"%s\" %s request_latency", argv[0], argv[1]);
+    SetEnvironmentVariableA("WINESERVERRING", "1");
+    ok(CreateProcessA(NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &startup, &info),
+       "CreateProcess failed, error %lu\n", GetLastError());
+    SetEnvironmentVariableA("WINESERVERRING", NULL);
+    wait_child_process(&info);
+    CloseHandle(info.hProcess);
+    CloseHandle(info.hThread);
+}
+
 START_TEST(om)
 {
     HMODULE hntdll = GetModuleHandleA("ntdll.dll");
+    char **argv;
 
     pNtAllocateReserveObject= (void *)GetProcAddress(hntdll, "NtAllocateReserveObject");
     pNtCreateEvent          = (void *)GetProcAddress(hntdll, "NtCreateEvent");
@@ -3929,6 +4050,12 @@ START_TEST(om)
     pNtCompareObjects       =  (void *)GetProcAddress(hntdll, "NtCompareObjects");
     pNtOpenThread           =  (void *)GetProcAddress(hntdll, "NtOpenThread");
 
+    if (winetest_get_mainargs(&argv) >= 3 && !strcmp(argv[2], "request_latency"))
+    {
+        run_request_latency("WINESERVERRING=1");
+        return;
+    }
+
     test_null_in_object_name();
     test_case_sensitive();
     test_namespace_pipe();
@@ -3951,4 +4078,6 @@ START_TEST(om)
     test_object_permanence();
     test_zero_access();
     test_NtAllocateReserveObject();
+    test_request_throughput();
+    test_request_latency();
 }
@@ -650,7 +650,9 @@ static void test_NtQueryValueKey(void)
     KEY_VALUE_PARTIAL_INFORMATION *partial_info, pi;
     KEY_VALUE_PARTIAL_INFORMATION_ALIGN64 *aligned_info;
     KEY_VALUE_FULL_INFORMATION *full_info;
-    DWORD len, expected;
+    DWORD len, expected, dw;
+    HANDLE key2;
+    char buffer[64];
 
     pRtlCreateUnicodeStringFromAsciiz(&ValName, "deletetest");
 
@@ -798,6 +800,41 @@ static void test_NtQueryValueKey(void)
     ok(pi.DataLength == 0, "DataLength=%lu\n", pi.DataLength);
     pRtlFreeUnicodeString(&ValName);
 
+    /* changes made through another handle are visible immediately */
+    status = pNtOpenKey(&key2, KEY_READ|KEY_SET_VALUE, &attr);
+    ok(status == STATUS_SUCCESS, "NtOpenKey Failed: 0x%08lx\n", status);
+    pRtlCreateUnicodeStringFromAsciiz(&ValName, "cachetest");
+    dw = 1;
+    status = pNtSetValueKey(key2, &ValName, 0, REG_DWORD, &dw, sizeof(dw));
+    ok(status == STATUS_SUCCESS, "NtSetValueKey Failed: 0x%08lx\n", status);
+    memset(buffer, 0, sizeof(buffer));
+    partial_info = (KEY_VALUE_PARTIAL_INFORMATION *)buffer;
+    status = pNtQueryValueKey(key, &ValName, KeyValuePartialInformation, buffer, sizeof(buffer), &len);
+    ok(status == STATUS_SUCCESS, "NtQueryValueKey wrong status 0x%08lx\n", status);
+    ok(*(DWORD *)partial_info->Data == 1, "incorrect Data returned: 0x%lx\n", *(DWORD *)partial_info->Data);
+
+    dw = 2;
+    status = pNtSetValueKey(key2, &ValName, 0, REG_DWORD, &dw, sizeof(dw));
+    ok(status == STATUS_SUCCESS, "NtSetValueKey Failed: 0x%08lx\n", status);
+    status = pNtQueryValueKey(key, &ValName, KeyValuePartialInformation, buffer, sizeof(buffer), &len);
+    ok(status == STATUS_SUCCESS, "NtQueryValueKey wrong status 0x%08lx\n", status);
+    ok(*(DWORD *)partial_info->Data == 2, "incorrect Data returned: 0x%lx\n", *(DWORD *)partial_info->Data);
+
+    status = pNtDeleteValueKey(key2, &ValName);
+    ok(status == STATUS_SUCCESS, "NtDeleteValueKey Failed: 0x%08lx\n", status);
+    status = pNtQueryValueKey(key, &ValName, KeyValuePartialInformation, buffer, sizeof(buffer), &len);
+    ok(status == STATUS_OBJECT_NAME_NOT_FOUND, "NtQueryValueKey wrong status 0x%08lx\n", status);
+
+    status = pNtSetValueKey(key2, &ValName, 0, REG_DWORD, &dw, sizeof(dw));
+    ok(status == STATUS_SUCCESS, "NtSetValueKey Failed: 0x%08lx\n", status);
+    status = pNtQueryValueKey(key, &ValName, KeyValuePartialInformation, buffer, sizeof(buffer), &len);
+    ok(status == STATUS_SUCCESS, "NtQueryValueKey wrong status 0x%08lx\n", status);
+    ok(*(DWORD *)partial_info->Data == 2, "incorrect Data returned: 0x%lx\n", *(DWORD *)partial_info->Data);
+    status = pNtDeleteValueKey(key2, &ValName);
+    ok(status == STATUS_SUCCESS, "NtDeleteValueKey Failed: 0x%08lx\n", status);
+    pRtlFreeUnicodeString(&ValName);
+    pNtClose(key2);
+
     pNtClose(key);
 }
 
@@ -2495,6 +2532,87 @@ static void test_NtRenameKey(void)
     pNtClose(key);
 }
 
+static void test_many_subkeys(void)
+{
+    KEY_BASIC_INFORMATION *info;
+    OBJECT_ATTRIBUTES attr;
+    UNICODE_STRING str;
+    HANDLE key, subkey;
+    WCHAR name[16];
+    char buffer[256];
+    NTSTATUS status;
+    DWORD size;
+    int i;
+
+    info = (KEY_BASIC_INFORMATION *)buffer;
+    InitializeObjectAttributes(&attr, &winetestpath, 0, 0, 0);
+    status = pNtCreateKey(&key, KEY_ALL_ACCESS, &attr, 0, 0, 0, 0);
+    ok(!status, "Unexpected status %#lx.\n", status);
+    attr.RootDirectory = key;
+    attr.ObjectName = &str;
+
+    /* create them in reverse order, enumeration must still be sorted */
+    for (i = 599; i >= 0; i--)
+    {
+        swprintf(name, ARRAY_SIZE(name), L"many%03u", i);
+        pRtlInitUnicodeString(&str, name);
+        status = pNtCreateKey(&subkey, KEY_ALL_ACCESS, &attr, 0, 0, REG_OPTION_VOLATILE, 0);
+        ok(!status, "Create subkey %s failed, status %#lx.\n", wine_dbgstr_w(name), status);
+        pNtClose(subkey);
+    }
+
+    for (i = 0; i < 600; i++)
+    {
+        status = pNtEnumerateKey(key, i, KeyBasicInformation, info, sizeof(buffer), &size);
+        ok(!status, "NtEnumerateKey %u failed, status %#lx.\n", i, status);
+        swprintf(name, ARRAY_SIZE(name), L"many%03u", i);
+        ok(info->NameLength == wcslen(name) * sizeof(WCHAR) && !memcmp(info->Name, name, info->NameLength),
+           "%u: got %s.\n", i, wine_dbgstr_wn(info->Name, info->NameLength / sizeof(WCHAR)));
+    }
+    status = pNtEnumerateKey(key, 600, KeyBasicInformation, info, sizeof(buffer), &size);
+    ok(status == STATUS_NO_MORE_ENTRIES, "Unexpected status %#lx.\n", status);
+
+    /* lookups are case insensitive */
+    pRtlInitUnicodeString(&str, L"MANY123");
+    status = pNtOpenKey(&subkey, KEY_ALL_ACCESS, &attr);
+    ok(!status, "Open subkey failed, status %#lx.\n", status);
+
+    /* renamed keys are moved to their new position */
+    pRtlInitUnicodeString(&str, L"many000");
+    status = NtRenameKey(subkey, &str);
+    ok(status == STATUS_CANNOT_DELETE, "Unexpected status %#lx.\n", status);
+    pRtlInitUnicodeString(&str, L"many999");
+    status = NtRenameKey(subkey, &str);
+    ok(!status, "NtRenameKey failed, status %#lx.\n", status);
+    pNtClose(subkey);
+
+    status = pNtEnumerateKey(key, 123, KeyBasicInformation, info, sizeof(buffer), &size);
+    ok(!status, "NtEnumerateKey failed, status %#lx.\n", status);
+    ok(info->NameLength == 7 * sizeof(WCHAR) && !memcmp(info->Name, L"many124", info->NameLength),
+       "got %s.\n", wine_dbgstr_wn(info->Name, info->NameLength / sizeof(WCHAR)));
+    status = pNtEnumerateKey(key, 599, KeyBasicInformation, info, sizeof(buffer), &size);
+    ok(!status, "NtEnumerateKey failed, status %#lx.\n", status);
+    ok(info->NameLength == 7 * sizeof(WCHAR) && !memcmp(info->Name, L"many999", info->NameLength),
+       "got %s.\n", wine_dbgstr_wn(info->Name, info->NameLength / sizeof(WCHAR)));
+
+    /* delete them, checking that the remaining ones can still be found */
+    for (i = 0; i < 600; i++)
+    {
+        swprintf(name, ARRAY_SIZE(name), L"many%03u", i == 123 ? 999 : i);
+        pRtlInitUnicodeString(&str, name);
+        status = pNtOpenKey(&subkey, KEY_ALL_ACCESS, &attr);
+        ok(!status, "Open subkey %s failed, status %#lx.\n", wine_dbgstr_w(name), status);
+        status = pNtDeleteKey(subkey);
+        ok(!status, "NtDeleteKey failed, status %#lx.\n", status);
+        pNtClose(subkey);
+    }
+    status = pNtEnumerateKey(key, 0, KeyBasicInformation, info, sizeof(buffer), &size);
+    ok(status == STATUS_NO_MORE_ENTRIES, "Unexpected status %#lx.\n", status);
+
+    pNtDeleteKey(key);
+    pNtClose(key);
+}
+
 static BOOL set_privileges(LPCSTR privilege, BOOL set)
 {
     TOKEN_PRIVILEGES tp;
@@ -3153,6 +3271,130 @@ static void test_RtlQueryRegistryValues(void)
     ok(status == ERROR_FILE_NOT_FOUND, "Registry value WindowsDrive should have been deleted already\n");
 }
 
+/* NtQueryValueKey calls per second. Values larger than 128 bytes are never cached on the
+ * client side, so they measure the cost of the server call. Only run when WINETEST_BENCHMARK
+ * is set. */
+static void test_query_value_throughput(void)
+{
+    static const struct
+    {
+        const WCHAR *name;
+        DWORD size;
+    }
+    tests[] =
+    {
+        { L"small", sizeof(DWORD) },
+        { L"large", 256 },
+    };
+    static const DWORD duration = 1000;
+    OBJECT_ATTRIBUTES attr;
+    UNICODE_STRING str;
+    NTSTATUS status;
+    HANDLE key;
+    char buffer[512];
+    DWORD len, ticks, start, calls;
+    int i;
+
+    if (!GetEnvironmentVariableA("WINETEST_BENCHMARK", NULL, 0))
+    {
+        skip("set WINETEST_BENCHMARK to measure the registry query throughput\n");
+        return;
+    }
+
+    InitializeObjectAttributes(&attr, &winetestpath, 0, 0, 0);
+    status = pNtCreateKey(&key, KEY_ALL_ACCESS, &attr, 0, 0, 0, 0);
+    ok(!status, "Unexpected status %#lx.\n", status);
+    memset(buffer, 0x55, sizeof(buffer));
+
+    for (i = 0; i < ARRAY_SIZE(tests); i++)
+    {
+        pRtlInitUnicodeString(&str, tests[i].name);
+        status = pNtSetValueKey(key, &str, 0, REG_BINARY, buffer, tests[i].size);
+        ok(!status, "NtSetValueKey failed, status %#lx.\n", status);
+
+        calls = 0;
+        start = GetTickCount();
+        do
+        {
+            status = pNtQueryValueKey(key, &str, KeyValuePartialInformation, buffer, sizeof(buffer), &len);
+            calls++;
+        } while ((ticks = GetTickCount() - start) < duration);
+        ok(!status, "NtQueryValueKey failed, status %#lx.\n", status);
+        trace("%lu byte value: %.0f calls/s\n", tests[i].size, calls * 1000.0 / ticks);
+
+        pNtDeleteValueKey(key, &str);
+    }
+
+    pNtClose(key);
+}
+
+/* Time needed to create, open, enumerate and delete the subkeys of a key with 500k subkeys.
+ * Only run when WINETEST_BENCHMARK is set. */
+static void test_wide_key_time(void)
+{
+    static const int count = 500000;
+    KEY_BASIC_INFORMATION *info;
+    LARGE_INTEGER freq, start, end;
+    OBJECT_ATTRIBUTES attr;
+    UNICODE_STRING str;
+    HANDLE key, subkey;
+    WCHAR name[16];
+    char buffer[256];
+    NTSTATUS status;
+    DWORD size;
+    int i, phase;
+
+    if (!GetEnvironmentVariableA("WINETEST_BENCHMARK", NULL, 0))
+    {
+        skip("set WINETEST_BENCHMARK to measure the time to populate a wide key\n");
+        return;
+    }
+
+    info = (KEY_BASIC_INFORMATION *)buffer;
+    InitializeObjectAttributes(&attr, &winetestpath, 0, 0, 0);
+    status = pNtCreateKey(&key, KEY_ALL_ACCESS, &attr, 0, 0, 0, 0);
+    ok(!status, "Unexpected status %#lx.\n", status);
+    attr.RootDirectory = key;
+    attr.ObjectName = &str;
+    QueryPerformanceFrequency(&freq);
+
+    for (phase = 0; phase < 4; phase++)
+    {
+        static const char * const phases[] = { "create", "open", "enumerate", "delete" };
+
+        QueryPerformanceCounter(&start);
+        for (i = 0; i < count; i++)
+        {
+            /* don't create them in order, so that the keys have to be sorted */
+            swprintf(name, ARRAY_SIZE(name), L"wide%06u", (unsigned int)i * 7919 % count);
+            pRtlInitUnicodeString(&str, name);
+            switch (phase)
+            {
+            case 0:
+                status = pNtCreateKey(&subkey, KEY_ALL_ACCESS, &attr, 0, 0, REG_OPTION_VOLATILE, 0);
+                break;
+            case 1:
+                status = pNtOpenKey(&subkey, KEY_READ, &attr);
+                break;
+            case 2:
+                if ((status = pNtEnumerateKey(key, i, KeyBasicInformation, info, sizeof(buffer), &size))) break;
+                continue;
+            case 3:
+                if (!(status = pNtOpenKey(&subkey, KEY_ALL_ACCESS, &attr))) status = pNtDeleteKey(subkey);
+                break;
+            }
+            if (status) break;
+            pNtClose(subkey);
+        }
+        QueryPerformanceCounter(&end);
+        ok(!status, "%s %u failed, status %#lx.\n", phases[phase], i, status);
+        trace("%s %u subkeys: %.0f ms\n", phases[phase], count,
+              (end.QuadPart - start.QuadPart) * 1000.0 / freq.QuadPart);
+    }
+
+    pNtClose(key);
+}
+
 START_TEST(reg)
 {
     LSTATUS status;
@@ -3183,8 +3425,11 @@ START_TEST(reg)
     test_symlinks();
     test_redirection();
     test_NtRenameKey();
+    test_many_subkeys();
     test_NtRegLoadKeyEx();
     test_RtlQueryRegistryValues();
+    test_query_value_throughput();
+    test_wide_key_time();
 
     status = RegDeleteTreeW(HKEY_CURRENT_USER, L"WineTest");
     ok(status == ERROR_SUCCESS, "Failed to delete the WineTest registry key: %lu\n", status);
@@ -29,11 +29,14 @@
 
 static NTSTATUS (WINAPI *pNtAlertMultipleThreadByThreadId)( HANDLE *, ULONG, void *, void * );
 static NTSTATUS (WINAPI *pNtAlertThreadByThreadId)( HANDLE );
+static NTSTATUS (WINAPI *pNtAssociateWaitCompletionPacket)( HANDLE, HANDLE, HANDLE, void *, void *, NTSTATUS, ULONG_PTR, BOOLEAN * );
+static NTSTATUS (WINAPI *pNtCancelWaitCompletionPacket)( HANDLE, BOOLEAN );
 static NTSTATUS (WINAPI *pNtClose)( HANDLE );
 static NTSTATUS (WINAPI *pNtCreateEvent) ( PHANDLE, ACCESS_MASK, const OBJECT_ATTRIBUTES *, EVENT_TYPE, BOOLEAN);
 static NTSTATUS (WINAPI *pNtCreateKeyedEvent)( HANDLE *, ACCESS_MASK, const OBJECT_ATTRIBUTES *, ULONG );
 static NTSTATUS (WINAPI *pNtCreateMutant)( HANDLE *, ACCESS_MASK, const OBJECT_ATTRIBUTES *, BOOLEAN );
 static NTSTATUS (WINAPI *pNtCreateSemaphore)( HANDLE *, ACCESS_MASK, const OBJECT_ATTRIBUTES *, LONG, LONG );
+static NTSTATUS (WINAPI *pNtCreateWaitCompletionPacket)( HANDLE *, ACCESS_MASK, OBJECT_ATTRIBUTES * );
 static NTSTATUS (WINAPI *pNtDelayExecution)( BOOLEAN, const LARGE_INTEGER * );
 static NTSTATUS (WINAPI *pNtOpenEvent)( HANDLE *, ACCESS_MASK, const OBJECT_ATTRIBUTES * );
 static NTSTATUS (WINAPI *pNtOpenKeyedEvent)( HANDLE *, ACCESS_MASK, const OBJECT_ATTRIBUTES * );
@@ -1427,6 +1430,110 @@ static void test_barrier(void)
     }
 }
 
+static void test_wait_completion_packet(void)
+{
+    LARGE_INTEGER timeout = {{ 0 }};
+    HANDLE port, packet, event;
+    IO_STATUS_BLOCK iosb;
+    ULONG_PTR key, value;
+    BOOLEAN signaled;
+    NTSTATUS status;
+
+    if (!pNtCreateWaitCompletionPacket)
+    {
+        win_skip( "NtCreateWaitCompletionPacket is not available.\n" );
+        return;
+    }
+
+    status = NtCreateIoCompletion( &port, IO_COMPLETION_ALL_ACCESS, NULL, 0 );
+    ok( !status, "got %#lx.\n", status );
+    status = pNtCreateEvent( &event, EVENT_ALL_ACCESS, NULL, SynchronizationEvent, FALSE );
+    ok( !status, "got %#lx.\n", status );
+    status = pNtCreateWaitCompletionPacket( &packet, GENERIC_ALL, NULL );
+    ok( !status, "got %#lx.\n", status );
+
+    status = pNtCancelWaitCompletionPacket( packet, FALSE );
+    ok( status == STATUS_CANCELLED, "got %#lx.\n", status );
+
+    signaled = 0xcc;
+    status = pNtAssociateWaitCompletionPacket( packet, port, event, (void *)1, (void *)2, 0xdeadbeef, 3, &signaled );
+    if (status == STATUS_OBJECT_TYPE_MISMATCH)
+    {
+        skip( "wait completion packets are not supported with in-process synchronization.\n" );
+        goto done;
+    }
+    ok( !status, "got %#lx.\n", status );
+    ok( !signaled, "got %d.\n", signaled );
+    status = NtRemoveIoCompletion( port, &key, &value, &iosb, &timeout );
+    ok( status == STATUS_TIMEOUT, "got %#lx.\n", status );
+
+    pNtSetEvent( event, NULL );
+    status = NtRemoveIoCompletion( port, &key, &value, &iosb, &timeout );
+    ok( !status, "got %#lx.\n", status );
+    ok( key == 1, "got %Iu.\n", key );
+    ok( value == 2, "got %Iu.\n", value );
+    ok( iosb.Status == 0xdeadbeef, "got %#lx.\n", iosb.Status );
+    ok( iosb.Information == 3, "got %Iu.\n", iosb.Information );
+    /* the wait has been satisfied */
+    status = NtWaitForSingleObject( event, FALSE, &timeout );
+    ok( status == STATUS_TIMEOUT, "got %#lx.\n", status );
+    status = pNtCancelWaitCompletionPacket( packet, FALSE );
+    ok( status == STATUS_CANCELLED, "got %#lx.\n", status );
+
+    pNtSetEvent( event, NULL );
+    signaled = 0xcc;
+    status = pNtAssociateWaitCompletionPacket( packet, port, event, (void *)4, (void *)5, 0, 6, &signaled );
+    ok( !status, "got %#lx.\n", status );
+    ok( signaled == TRUE, "got %d.\n", signaled );
+    status = NtRemoveIoCompletion( port, &key, &value, &iosb, &timeout );
+    ok( !status, "got %#lx.\n", status );
+    ok( key == 4, "got %Iu.\n", key );
+
+    /* a queued packet can be removed from the port */
+    pNtSetEvent( event, NULL );
+    status = pNtAssociateWaitCompletionPacket( packet, port, event, (void *)10, (void *)11, 0, 12, &signaled );
+    ok( !status, "got %#lx.\n", status );
+    ok( signaled == TRUE, "got %d.\n", signaled );
+    status = pNtCancelWaitCompletionPacket( packet, FALSE );
+    ok( status == STATUS_CANCELLED, "got %#lx.\n", status );
+    status = pNtCancelWaitCompletionPacket( packet, TRUE );
+    ok( !status, "got %#lx.\n", status );
+    status = NtRemoveIoCompletion( port, &key, &value, &iosb, &timeout );
+    ok( status == STATUS_TIMEOUT, "got %#lx.\n", status );
+    status = pNtCancelWaitCompletionPacket( packet, TRUE );
+    ok( status == STATUS_CANCELLED, "got %#lx.\n", status );
+
+    /* other completions are left alone */
+    status = pNtAssociateWaitCompletionPacket( packet, port, event, (void *)13, (void *)14, 0, 15, &signaled );
+    ok( !status, "got %#lx.\n", status );
+    ok( !signaled, "got %d.\n", signaled );
+    status = NtSetIoCompletion( port, 16, 17, STATUS_SUCCESS, 18 );
+    ok( !status, "got %#lx.\n", status );
+    pNtSetEvent( event, NULL );
+    status = pNtCancelWaitCompletionPacket( packet, TRUE );
+    ok( !status, "got %#lx.\n", status );
+    status = NtRemoveIoCompletion( port, &key, &value, &iosb, &timeout );
+    ok( !status, "got %#lx.\n", status );
+    ok( key == 16, "got %Iu.\n", key );
+    status = NtRemoveIoCompletion( port, &key, &value, &iosb, &timeout );
+    ok( status == STATUS_TIMEOUT, "got %#lx.\n", status );
+
+    status = pNtAssociateWaitCompletionPacket( packet, port, event, (void *)7, (void *)8, 0, 9, &signaled );
+    ok( !status, "got %#lx.\n", status );
+    status = pNtCancelWaitCompletionPacket( packet, FALSE );
+    ok( !status, "got %#lx.\n", status );
+    pNtSetEvent( event, NULL );
+    status = NtRemoveIoCompletion( port, &key, &value, &iosb, &timeout );
+    ok( status == STATUS_TIMEOUT, "got %#lx.\n", status );
+    status = NtWaitForSingleObject( event, FALSE, &timeout );
+    ok( !status, "got %#lx.\n", status );
+
+done:
+    pNtClose( packet );
+    pNtClose( event );
+    pNtClose( port );
+}
+
 START_TEST(sync)
 {
     HMODULE module = GetModuleHandleA("ntdll.dll");
@@ -1439,11 +1546,14 @@ START_TEST(sync)
 
     pNtAlertMultipleThreadByThreadId = (void *)GetProcAddress(module, "NtAlertMultipleThreadByThreadId");
     pNtAlertThreadByThreadId        = (void *)GetProcAddress(module, "NtAlertThreadByThreadId");
+    pNtAssociateWaitCompletionPacket = (void *)GetProcAddress(module, "NtAssociateWaitCompletionPacket");
+    pNtCancelWaitCompletionPacket   = (void *)GetProcAddress(module, "NtCancelWaitCompletionPacket");
     pNtClose                        = (void *)GetProcAddress(module, "NtClose");
     pNtCreateEvent                  = (void *)GetProcAddress(module, "NtCreateEvent");
     pNtCreateKeyedEvent             = (void *)GetProcAddress(module, "NtCreateKeyedEvent");
     pNtCreateMutant                 = (void *)GetProcAddress(module, "NtCreateMutant");
     pNtCreateSemaphore              = (void *)GetProcAddress(module, "NtCreateSemaphore");
+    pNtCreateWaitCompletionPacket   = (void *)GetProcAddress(module, "NtCreateWaitCompletionPacket");
     pNtDelayExecution               = (void *)GetProcAddress(module, "NtDelayExecution");
     pNtOpenEvent                    = (void *)GetProcAddress(module, "NtOpenEvent");
     pNtOpenKeyedEvent               = (void *)GetProcAddress(module, "NtOpenKeyedEvent");
@@ -1483,4 +1593,5 @@ START_TEST(sync)
     test_completion_port_scheduling();
     test_delayexecution();
     test_barrier();
+    test_wait_completion_packet();
 }
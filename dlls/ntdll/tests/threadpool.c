@@ -1512,6 +1512,73 @@ static void test_tp_timer(void)
     CloseHandle(semaphore);
 }
 
+static BOOL adjust_system_time(LONGLONG diff)
+{
+    LARGE_INTEGER now;
+
+    NtQuerySystemTime(&now);
+    now.QuadPart += diff;
+    return !NtSetSystemTime(&now, NULL);
+}
+
+static void test_tp_timer_clock_step(void)
+{
+    TP_CALLBACK_ENVIRON environment;
+    LARGE_INTEGER when;
+    HANDLE semaphore;
+    NTSTATUS status;
+    TP_TIMER *timer;
+    TP_POOL *pool;
+    DWORD result;
+    int i;
+
+    semaphore = CreateSemaphoreA(NULL, 0, 1, NULL);
+    ok(semaphore != NULL, "CreateSemaphoreA failed %lu\n", GetLastError());
+
+    pool = NULL;
+    status = pTpAllocPool(&pool, NULL);
+    ok(!status, "TpAllocPool failed with status %lx\n", status);
+
+    timer = NULL;
+    memset(&environment, 0, sizeof(environment));
+    environment.Version = 1;
+    environment.Pool = pool;
+    status = pTpAllocTimer(&timer, timer_cb, semaphore, &environment);
+    ok(!status, "TpAllocTimer failed with status %lx\n", status);
+
+    /* let an absolute timer expire at the current time first */
+    NtQuerySystemTime(&when);
+    when.QuadPart += (ULONGLONG)50 * 10000;
+    pTpSetTimer(timer, &when, 0, 0);
+    result = WaitForSingleObject(semaphore, 1000);
+    ok(result == WAIT_OBJECT_0, "WaitForSingleObject returned %lu\n", result);
+
+    if (!adjust_system_time((LONGLONG)-3600 * 10000000))
+    {
+        skip("can't adjust system clock\n");
+        goto done;
+    }
+
+    /* absolute timers armed after the clock was set back still expire */
+    for (i = 0; i < 2; i++)
+    {
+        NtQuerySystemTime(&when);
+        when.QuadPart += (ULONGLONG)100 * 10000;
+        pTpSetTimer(timer, &when, 0, 0);
+        result = WaitForSingleObject(semaphore, 1000);
+        ok(result == WAIT_OBJECT_0, "%d: WaitForSingleObject returned %lu\n", i, result);
+    }
+
+    adjust_system_time((LONGLONG)3600 * 10000000);
+
+done:
+    pTpSetTimer(timer, NULL, 0, 0);
+    pTpWaitForTimer(timer, TRUE);
+    pTpReleaseTimer(timer);
+    pTpReleasePool(pool);
+    CloseHandle(semaphore);
+}
+
 struct window_length_info
 {
     HANDLE semaphore;
@@ -1883,6 +1950,71 @@ static void test_tp_wait(void)
     CloseHandle(semaphores[1]);
 }
 
+static void test_tp_wait_clock_step(void)
+{
+    TP_CALLBACK_ENVIRON environment;
+    struct wait_info info;
+    HANDLE semaphores[2];
+    LARGE_INTEGER when;
+    NTSTATUS status;
+    TP_WAIT *wait;
+    TP_POOL *pool;
+    DWORD result;
+    int i;
+
+    semaphores[0] = CreateSemaphoreW(NULL, 0, 1, NULL);
+    ok(semaphores[0] != NULL, "failed to create semaphore\n");
+    semaphores[1] = CreateSemaphoreW(NULL, 0, 1, NULL);
+    ok(semaphores[1] != NULL, "failed to create semaphore\n");
+    info.semaphore = semaphores[0];
+
+    pool = NULL;
+    status = pTpAllocPool(&pool, NULL);
+    ok(!status, "TpAllocPool failed with status %lx\n", status);
+
+    memset(&environment, 0, sizeof(environment));
+    environment.Version = 1;
+    environment.Pool = pool;
+    wait = NULL;
+    status = pTpAllocWait(&wait, wait_cb, &info, &environment);
+    ok(!status, "TpAllocWait failed with status %lx\n", status);
+
+    /* let a timeout expire at the current time first */
+    info.userdata = 0;
+    when.QuadPart = (ULONGLONG)50 * -10000;
+    pTpSetWait(wait, semaphores[1], &when);
+    result = WaitForSingleObject(semaphores[0], 1000);
+    ok(result == WAIT_OBJECT_0, "WaitForSingleObject returned %lu\n", result);
+    ok(info.userdata == 0x10000, "expected info.userdata = 0x10000, got %lu\n", info.userdata);
+
+    if (!adjust_system_time((LONGLONG)-3600 * 10000000))
+    {
+        skip("can't adjust system clock\n");
+        goto done;
+    }
+
+    /* timeouts armed after the clock was set back still expire */
+    for (i = 0; i < 2; i++)
+    {
+        info.userdata = 0;
+        when.QuadPart = (ULONGLONG)100 * -10000;
+        pTpSetWait(wait, semaphores[1], &when);
+        result = WaitForSingleObject(semaphores[0], 1000);
+        ok(result == WAIT_OBJECT_0, "%d: WaitForSingleObject returned %lu\n", i, result);
+        ok(info.userdata == 0x10000, "%d: expected info.userdata = 0x10000, got %lu\n", i, info.userdata);
+    }
+
+    adjust_system_time((LONGLONG)3600 * 10000000);
+
+done:
+    pTpSetWait(wait, NULL, NULL);
+    pTpWaitForWait(wait, TRUE);
+    pTpReleaseWait(wait);
+    pTpReleasePool(pool);
+    CloseHandle(semaphores[0]);
+    CloseHandle(semaphores[1]);
+}
+
 static struct
 {
     HANDLE semaphore;
@@ -2473,6 +2605,81 @@ static void test_tp_wait_early_closure(void)
     CloseHandle(semaphore);
 }
 
+struct work_bench
+{
+    int count;
+    BOOL simple;
+};
+
+static LONG work_bench_count;
+
+static void CALLBACK work_bench_simple_cb(TP_CALLBACK_INSTANCE *instance, void *userdata)
+{
+    InterlockedIncrement(&work_bench_count);
+}
+
+static void CALLBACK work_bench_cb(TP_CALLBACK_INSTANCE *instance, void *userdata, TP_WORK *work)
+{
+    InterlockedIncrement(&work_bench_count);
+}
+
+static DWORD WINAPI work_bench_thread(void *arg)
+{
+    struct work_bench *bench = arg;
+    TP_WORK *work;
+    int i;
+
+    if (bench->simple)
+    {
+        for (i = 0; i < bench->count; i++) pTpSimpleTryPost(work_bench_simple_cb, NULL, NULL);
+        return 0;
+    }
+    pTpAllocWork(&work, work_bench_cb, NULL, NULL);
+    for (i = 0; i < bench->count; i++) pTpPostWork(work);
+    pTpWaitForWork(work, FALSE);
+    pTpReleaseWork(work);
+    return 0;
+}
+
+/* Throughput of tiny work items posted to the default pool from several threads at once.
+ * Only run when WINETEST_BENCHMARK is set. */
+static void test_tp_work_throughput(void)
+{
+    static const int total = 200000;
+    struct work_bench bench;
+    LARGE_INTEGER freq, start, end;
+    HANDLE threads[16];
+    int i, count, simple;
+
+    if (!GetEnvironmentVariableA("WINETEST_BENCHMARK", NULL, 0))
+    {
+        skip("set WINETEST_BENCHMARK to measure the threadpool throughput\n");
+        return;
+    }
+
+    QueryPerformanceFrequency(&freq);
+    for (simple = 0; simple < 2; simple++)
+    {
+        for (count = 1; count <= ARRAY_SIZE(threads); count *= 4)
+        {
+            bench.count = total / count;
+            bench.simple = simple;
+            work_bench_count = 0;
+
+            QueryPerformanceCounter(&start);
+            for (i = 0; i < count; i++)
+                threads[i] = CreateThread(NULL, 0, work_bench_thread, &bench, 0, NULL);
+            WaitForMultipleObjects(count, threads, TRUE, INFINITE);
+            while (ReadAcquire(&work_bench_count) < bench.count * count) Sleep(1);
+            QueryPerformanceCounter(&end);
+            for (i = 0; i < count; i++) CloseHandle(threads[i]);
+
+            trace("%s, %2u threads: %.0f items/s\n", simple ? "TpSimpleTryPost" : "TpPostWork", count,
+                  bench.count * count * (double)freq.QuadPart / (end.QuadPart - start.QuadPart));
+        }
+    }
+}
+
 START_TEST(threadpool)
 {
     test_RtlQueueWorkItem();
@@ -2489,10 +2696,13 @@ START_TEST(threadpool)
     test_tp_instance();
     test_tp_disassociate();
     test_tp_timer();
+    test_tp_timer_clock_step();
     test_tp_window_length();
     test_tp_wait();
+    test_tp_wait_clock_step();
     test_tp_multi_wait();
     test_tp_io();
     test_kernel32_tp_io();
     test_tp_wait_early_closure();
+    test_tp_work_throughput();
 }
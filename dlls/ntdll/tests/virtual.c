@@ -3550,6 +3550,89 @@ static void test_exec_memory_writes(void)
     RtlRemoveVectoredExceptionHandler( handler );
 }
 
+/* Time needed to walk a 64 GB reservation with NtQueryVirtualMemory, and to change the protection
+ * of a large committed range. Only run when WINETEST_BENCHMARK is set. */
+static void test_large_view_query_time(void)
+{
+    static const SIZE_T reserve_size = (SIZE_T)64 << 30, chunk = (SIZE_T)256 << 20;
+    static const int walks = 100, protects = 20;
+    LARGE_INTEGER freq, start, end;
+    MEMORY_BASIC_INFORMATION mbi;
+    SIZE_T size, offset;
+    ULONG old_prot;
+    NTSTATUS status;
+    char *base, *ptr;
+    void *addr;
+    int i, regions;
+
+    if (!GetEnvironmentVariableA("WINETEST_BENCHMARK", NULL, 0))
+    {
+        skip("set WINETEST_BENCHMARK to measure large view queries\n");
+        return;
+    }
+    if (!is_win64)
+    {
+        skip("no room for a 64 GB reservation\n");
+        return;
+    }
+
+    addr = NULL;
+    size = reserve_size;
+    status = NtAllocateVirtualMemory(NtCurrentProcess(), &addr, 0, &size, MEM_RESERVE, PAGE_NOACCESS);
+    if (status)
+    {
+        skip("failed to reserve 64 GB, status %08lx\n", status);
+        return;
+    }
+    base = addr;
+
+    /* commit a megabyte with alternating protections in each chunk */
+    for (offset = 0; offset < reserve_size; offset += chunk)
+    {
+        addr = base + offset;
+        size = 1 << 20;
+        status = NtAllocateVirtualMemory(NtCurrentProcess(), &addr, 0, &size, MEM_COMMIT,
+                                         (offset / chunk) % 2 ? PAGE_READONLY : PAGE_READWRITE);
+        ok(!status, "failed to commit %p, status %08lx\n", addr, status);
+    }
+
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&start);
+    for (i = 0; i < walks; i++)
+    {
+        regions = 0;
+        for (ptr = base; ptr < base + reserve_size; ptr += mbi.RegionSize, regions++)
+        {
+            status = NtQueryVirtualMemory(NtCurrentProcess(), ptr, MemoryBasicInformation, &mbi, sizeof(mbi), NULL);
+            if (status) break;
+        }
+    }
+    QueryPerformanceCounter(&end);
+    ok(!status, "NtQueryVirtualMemory failed, status %08lx\n", status);
+    trace("walked %u regions in %.3f ms\n", regions,
+          (end.QuadPart - start.QuadPart) * 1000.0 / freq.QuadPart / walks);
+
+    /* commit and protect a whole gigabyte */
+    addr = base;
+    size = (SIZE_T)1 << 30;
+    status = NtAllocateVirtualMemory(NtCurrentProcess(), &addr, 0, &size, MEM_COMMIT, PAGE_READWRITE);
+    ok(!status, "failed to commit 1 GB, status %08lx\n", status);
+    QueryPerformanceCounter(&start);
+    for (i = 0; i < protects; i++)
+    {
+        addr = base;
+        size = (SIZE_T)1 << 30;
+        NtProtectVirtualMemory(NtCurrentProcess(), &addr, &size, i % 2 ? PAGE_READWRITE : PAGE_READONLY, &old_prot);
+    }
+    QueryPerformanceCounter(&end);
+    trace("protected 1 GB in %.3f ms\n", (end.QuadPart - start.QuadPart) * 1000.0 / freq.QuadPart / protects);
+
+    addr = base;
+    size = 0;
+    status = NtFreeVirtualMemory(NtCurrentProcess(), &addr, &size, MEM_RELEASE);
+    ok(!status, "NtFreeVirtualMemory failed, status %08lx\n", status);
+}
+
 START_TEST(virtual)
 {
     HMODULE mod;
@@ -3605,4 +3688,5 @@ START_TEST(virtual)
     test_query_region_information();
     test_query_image_information();
     test_exec_memory_writes();
+    test_large_view_query_time();
 }
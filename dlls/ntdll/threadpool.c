@@ -66,11 +66,39 @@ static RTL_CRITICAL_SECTION_DEBUG critsect_compl_debug =
       0, 0, { (DWORD_PTR)(__FILE__ ": threadpool_compl_cs") }
 };
 
+#define TIMER_WHEEL_BITS     6
+#define TIMER_WHEEL_SLOTS    (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS   4
+#define TIMER_WHEEL_OVERFLOW (TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS)
+
+/* Hierarchical timer wheel, used by both the timer queue and the threadpool
+ * timers. Level n holds the timers which only differ from the current tick in
+ * the n-th group of TIMER_WHEEL_BITS bits, in the slot selected by these bits.
+ * When the wheel moves past the start of an upper level slot, its timers are
+ * redistributed to the lower levels. Timers beyond the last level are kept in
+ * an overflow slot. */
+struct timer_wheel
+{
+    ULONGLONG   resolution;     /* length of a tick in clock units */
+    ULONGLONG   tick;           /* current tick */
+    ULONG64     bitmap[TIMER_WHEEL_LEVELS];     /* non-empty slots of each level */
+    struct list slots[TIMER_WHEEL_OVERFLOW + 1];
+};
+
+struct timer_wheel_entry
+{
+    struct list entry;
+    ULONGLONG   expire;         /* expiration time in clock units */
+    ULONGLONG   window;         /* tolerable delay in clock units */
+    int         slot;           /* slot in the wheel, -1 if not in a wheel */
+};
+
 struct timer_queue;
 struct queue_timer
 {
     struct timer_queue *q;
     struct list entry;
+    struct timer_wheel_entry wheel_entry;
     ULONG runcount;             /* number of callbacks pending execution */
     RTL_WAITORTIMERCALLBACKFUNC callback;
     PVOID param;
@@ -85,7 +113,9 @@ struct timer_queue
 {
     DWORD magic;
     RTL_CRITICAL_SECTION cs;
-    struct list timers;         /* sorted by expiration time */
+    struct list timers;         /* all timers of the queue */
+    struct timer_wheel wheel;   /* armed timers */
+    struct list expired;        /* expired timers waiting to be run */
     BOOL quit;                  /* queue should be deleted; once set, never unset */
     HANDLE event;
     HANDLE thread;
@@ -97,6 +127,19 @@ struct timer_queue
 
 #define THREADPOOL_WORKER_TIMEOUT 5000
 #define MAXIMUM_WAITQUEUE_OBJECTS (MAXIMUM_WAIT_OBJECTS - 1)
+#define THREADPOOL_MAX_QUEUES     16
+
+/* Work queue shard. Objects are spread over the shards of their pool, so that
+ * submitting and dequeuing work from several threads doesn't serialize on a
+ * single lock. Idle workers take work from any shard. */
+struct threadpool_queue
+{
+    CRITICAL_SECTION        cs;
+    /* Pools of work items, locked via .cs, order matches TP_CALLBACK_PRIORITY - high, normal, low. */
+    struct list             pools[3];
+    /* number of entries in each list, used to skip empty shards without locking them */
+    LONG                    counts[3];
+};
 
 /* internal threadpool representation */
 struct threadpool
@@ -105,14 +148,19 @@ struct threadpool
     LONG                    objcount;
     BOOL                    shutdown;
     CRITICAL_SECTION        cs;
-    /* Pools of work items, locked via .cs, order matches TP_CALLBACK_PRIORITY - high, normal, low. */
-    struct list             pools[3];
+    /* work queue shards, see struct threadpool_queue */
+    struct threadpool_queue queues[THREADPOOL_MAX_QUEUES];
+    unsigned int            num_queues;
+    LONG                    next_queue;
     RTL_CONDITION_VARIABLE  update_event;
     /* information about worker threads, locked via .cs */
     int                     max_workers;
     int                     min_workers;
-    int                     num_workers;
-    int                     num_busy_workers;
+    LONG                    num_workers;
+    /* modified with interlocked operations */
+    LONG                    num_busy_workers;
+    LONG                    num_idle_workers;
+    LONG                    num_queued;
     HANDLE                  compl_port;
     TP_POOL_STACK_INFORMATION stack_info;
 };
@@ -151,7 +199,8 @@ struct threadpool_object
     /* information about the group, locked via .group->cs */
     struct list             group_entry;
     BOOL                    is_group_member;
-    /* information about the pool, locked via .pool->cs */
+    /* information about the pool, locked via .queue->cs */
+    struct threadpool_queue *queue;
     struct list             pool_entry;
     RTL_CONDITION_VARIABLE  finished_event;
     RTL_CONDITION_VARIABLE  group_finished_event;
@@ -177,11 +226,10 @@ struct threadpool_object
             /* information about the timer, locked via timerqueue.cs */
             BOOL            timer_initialized;
             BOOL            timer_pending;
-            struct list     timer_entry;
+            struct timer_wheel_entry timer_entry;
+            struct timer_wheel *timer_wheel;
             BOOL            timer_set;
-            ULONGLONG       timeout;
             LONG            period;
-            LONG            window_length;
         } timer;
         struct
         {
@@ -196,11 +244,17 @@ struct threadpool_object
             HANDLE          duped_handle;
             DWORD           flags;
             RTL_WAITORTIMERCALLBACKFUNC rtl_callback;
+            /* wait completion packet, used instead of a bucket if available */
+            HANDLE          packet;
+            BOOL            packet_associated;
+            LONG            packet_serial;
+            struct timer_wheel_entry timeout_entry;
+            ULONGLONG       interval;
         } wait;
         struct
         {
             PTP_IO_CALLBACK callback;
-            /* locked via .pool->cs */
+            /* locked via .queue->cs */
             unsigned int    pending_count, skipped_count, completion_count, completion_max;
             BOOL            shutting_down;
             struct io_completion *completions;
@@ -251,8 +305,8 @@ static struct
     LONG                    objcount;
     BOOL                    thread_running;
     HANDLE                  timers[2];
-    struct list             abs_timers;
-    struct list             rel_timers;
+    /* pending timers, initialized when the thread is started */
+    struct timer_wheel      wheels[2];
 }
 timerqueue =
 {
@@ -260,8 +314,6 @@ timerqueue =
     0,                                          /* objcount */
     FALSE,                                      /* thread_running */
     { 0, 0 },                                   /* timers */
-    LIST_INIT( timerqueue.abs_timers ),         /* abs_timers */
-    LIST_INIT( timerqueue.rel_timers )          /* rel_timers */
 };
 
 static RTL_CRITICAL_SECTION_DEBUG timerqueue_debug =
@@ -279,12 +331,18 @@ static struct
     CRITICAL_SECTION        cs;
     LONG                    num_buckets;
     struct list             buckets;
+    /* waits using wait completion packets, all handled by a single thread */
+    BOOL                    thread_running;
+    LONG                    num_packets;
+    HANDLE                  port;
+    ULONGLONG               next_wakeup;
+    struct timer_wheel      timeouts;
 }
 waitqueue =
 {
     { &waitqueue_debug, -1, 0, 0, 0, 0 },       /* cs */
     0,                                          /* num_buckets */
-    LIST_INIT( waitqueue.buckets )              /* buckets */
+    LIST_INIT( waitqueue.buckets ),             /* buckets */
 };
 
 static RTL_CRITICAL_SECTION_DEBUG waitqueue_debug =
@@ -563,8 +621,206 @@ static inline PLARGE_INTEGER get_nt_timeout( PLARGE_INTEGER pTime, ULONG timeout
 }
 
 
+/************************** Timer Wheel Impl **************************/
+
+static void timer_wheel_init( struct timer_wheel *wheel, ULONGLONG resolution, ULONGLONG now )
+{
+    unsigned int i;
+
+    wheel->resolution = resolution;
+    wheel->tick = now / resolution;
+    memset( wheel->bitmap, 0, sizeof(wheel->bitmap) );
+    for (i = 0; i < ARRAY_SIZE(wheel->slots); i++)
+        list_init( &wheel->slots[i] );
+}
+
+/* Adds an entry to the wheel, entry->expire has to be set. */
+static void timer_wheel_insert( struct timer_wheel *wheel, struct timer_wheel_entry *entry )
+{
+    ULONGLONG tick = max( entry->expire / wheel->resolution, wheel->tick );
+    ULONGLONG diff = tick ^ wheel->tick;
+    unsigned int level = 0, slot;
+
+    while (level < TIMER_WHEEL_LEVELS && (diff >> (TIMER_WHEEL_BITS * (level + 1))))
+        level++;
+
+    if (level == TIMER_WHEEL_LEVELS)
+        slot = TIMER_WHEEL_OVERFLOW;
+    else
+    {
+        slot = (tick >> (TIMER_WHEEL_BITS * level)) & (TIMER_WHEEL_SLOTS - 1);
+        wheel->bitmap[level] |= (ULONG64)1 << slot;
+        slot += level * TIMER_WHEEL_SLOTS;
+    }
+
+    list_add_tail( &wheel->slots[slot], &entry->entry );
+    entry->slot = slot;
+}
+
+/* Removes an entry from the wheel, or from the expired list it was moved to. */
+static void timer_wheel_remove( struct timer_wheel *wheel, struct timer_wheel_entry *entry )
+{
+    list_remove( &entry->entry );
+    if (entry->slot != -1 && entry->slot != TIMER_WHEEL_OVERFLOW && list_empty( &wheel->slots[entry->slot] ))
+        wheel->bitmap[entry->slot / TIMER_WHEEL_SLOTS] &= ~((ULONG64)1 << (entry->slot % TIMER_WHEEL_SLOTS));
+    entry->slot = -1;
+}
+
+/* Returns the first tick covered by a slot. */
+static ULONGLONG timer_wheel_slot_tick( const struct timer_wheel *wheel, unsigned int slot )
+{
+    unsigned int shift = TIMER_WHEEL_BITS * (slot / TIMER_WHEEL_SLOTS);
+    ULONGLONG mask;
+
+    if (slot == TIMER_WHEEL_OVERFLOW)
+        return (wheel->tick | (((ULONGLONG)1 << shift) - 1)) + 1;
+
+    mask = ((ULONGLONG)1 << (shift + TIMER_WHEEL_BITS)) - 1;
+    return (wheel->tick & ~mask) | ((ULONGLONG)(slot % TIMER_WHEEL_SLOTS) << shift);
+}
+
+/* Returns the first non-empty slot, or -1 if the wheel is empty. */
+static int timer_wheel_first_slot( const struct timer_wheel *wheel )
+{
+    unsigned int level, pos;
+    DWORD index;
+
+    for (level = 0; level < TIMER_WHEEL_LEVELS; level++)
+    {
+        pos = (wheel->tick >> (TIMER_WHEEL_BITS * level)) & (TIMER_WHEEL_SLOTS - 1);
+        if (BitScanForward64( &index, wheel->bitmap[level] & (~(ULONG64)0 << pos) ))
+            return level * TIMER_WHEEL_SLOTS + index;
+    }
+
+    if (!list_empty( &wheel->slots[TIMER_WHEEL_OVERFLOW] ))
+        return TIMER_WHEEL_OVERFLOW;
+    return -1;
+}
+
+/* Moves the wheel back to an earlier tick, e.g. after the system time was set
+ * back, and redistributes all entries relative to it. */
+static void timer_wheel_rebase( struct timer_wheel *wheel, ULONGLONG tick )
+{
+    struct timer_wheel_entry *entry, *next_entry;
+    struct list entries = LIST_INIT( entries );
+    unsigned int i;
+
+    for (i = 0; i < ARRAY_SIZE(wheel->slots); i++)
+        list_move_tail( &entries, &wheel->slots[i] );
+    memset( wheel->bitmap, 0, sizeof(wheel->bitmap) );
+    wheel->tick = tick;
+
+    LIST_FOR_EACH_ENTRY_SAFE( entry, next_entry, &entries, struct timer_wheel_entry, entry )
+    {
+        list_remove( &entry->entry );
+        timer_wheel_insert( wheel, entry );
+    }
+}
+
+/* Advances the wheel to the time now and moves all entries which are expired
+ * at this time to the expired list. */
+static void timer_wheel_expire( struct timer_wheel *wheel, ULONGLONG now, struct list *expired )
+{
+    ULONGLONG tick = now / wheel->resolution, next;
+    struct timer_wheel_entry *entry, *next_entry;
+    struct list cascade;
+    int slot;
+
+    /* entries inserted since the clock went back were clamped to the old tick */
+    if (tick < wheel->tick) timer_wheel_rebase( wheel, tick );
+
+    while ((slot = timer_wheel_first_slot( wheel )) != -1)
+    {
+        next = timer_wheel_slot_tick( wheel, slot );
+        if (next > tick) break;
+
+        if (slot < TIMER_WHEEL_SLOTS)
+        {
+            wheel->tick = next;
+            LIST_FOR_EACH_ENTRY_SAFE( entry, next_entry, &wheel->slots[slot], struct timer_wheel_entry, entry )
+            {
+                if (entry->expire > now) continue;
+                timer_wheel_remove( wheel, entry );
+                list_add_tail( expired, &entry->entry );
+            }
+            /* the remaining entries expire later during the current tick */
+            if (!list_empty( &wheel->slots[slot] )) break;
+        }
+        else
+        {
+            /* all lower levels are empty, skip directly to the slot, or to the
+             * current block of the overflow slot */
+            if (slot == TIMER_WHEEL_OVERFLOW)
+                next = max( next, tick & ~(((ULONGLONG)1 << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1) );
+            wheel->tick = next;
+
+            list_init( &cascade );
+            list_move_tail( &cascade, &wheel->slots[slot] );
+            if (slot != TIMER_WHEEL_OVERFLOW)
+                wheel->bitmap[slot / TIMER_WHEEL_SLOTS] &= ~((ULONG64)1 << (slot % TIMER_WHEEL_SLOTS));
+            LIST_FOR_EACH_ENTRY_SAFE( entry, next_entry, &cascade, struct timer_wheel_entry, entry )
+            {
+                list_remove( &entry->entry );
+                timer_wheel_insert( wheel, entry );
+            }
+        }
+    }
+
+    if (tick > wheel->tick) wheel->tick = tick;
+}
+
+/* Returns the time when timer_wheel_expire has to be called next, or EXPIRE_NEVER.
+ * If the earliest timers tolerate some delay, the wakeup is postponed so that
+ * later timers expire at the same time. */
+static ULONGLONG timer_wheel_next( const struct timer_wheel *wheel )
+{
+    ULONGLONG lower = EXPIRE_NEVER, upper = EXPIRE_NEVER;
+    const struct timer_wheel_entry *entry;
+    unsigned int level, pos, slot;
+    ULONG64 bits;
+    DWORD index;
+
+    for (level = 0; level < TIMER_WHEEL_LEVELS; level++)
+    {
+        pos = (wheel->tick >> (TIMER_WHEEL_BITS * level)) & (TIMER_WHEEL_SLOTS - 1);
+        bits = wheel->bitmap[level] & (~(ULONG64)0 << pos);
+
+        while (BitScanForward64( &index, bits ))
+        {
+            slot = level * TIMER_WHEEL_SLOTS + index;
+
+            /* upper level slots have to be redistributed first */
+            if (level && lower == EXPIRE_NEVER)
+                return timer_wheel_slot_tick( wheel, slot ) * wheel->resolution;
+            if (timer_wheel_slot_tick( wheel, slot ) * wheel->resolution >= upper)
+                return min( lower, upper );
+
+            LIST_FOR_EACH_ENTRY( entry, &wheel->slots[slot], struct timer_wheel_entry, entry )
+            {
+                if (entry->expire >= upper) continue;
+                if (lower == EXPIRE_NEVER || entry->expire > lower) lower = entry->expire;
+                upper = min( upper, entry->expire + entry->window );
+            }
+
+            bits &= bits - 1;
+        }
+    }
+
+    if (lower == EXPIRE_NEVER && !list_empty( &wheel->slots[TIMER_WHEEL_OVERFLOW] ))
+        return timer_wheel_slot_tick( wheel, TIMER_WHEEL_OVERFLOW ) * wheel->resolution;
+    return min( lower, upper );
+}
+
 /************************** Timer Queue Impl **************************/
 
+static void queue_disarm_timer(struct queue_timer *t)
+{
+    /* We MUST hold the queue cs while calling this function.  */
+    if (t->expire != EXPIRE_NEVER)
+        timer_wheel_remove(&t->q->wheel, &t->wheel_entry);
+    t->expire = EXPIRE_NEVER;
+}
+
 static void queue_remove_timer(struct queue_timer *t)
 {
     /* We MUST hold the queue cs while calling this function.  This ensures
@@ -575,6 +831,7 @@ static void queue_remove_timer(struct queue_timer *t)
     assert(t->runcount == 0);
     assert(t->destroy);
 
+    queue_disarm_timer(t);
     list_remove(&t->entry);
     if (t->event)
         NtSetEvent(t->event, NULL);
@@ -613,38 +870,44 @@ static inline ULONGLONG queue_current_time(void)
     return now.QuadPart * 1000 / freq.QuadPart;
 }
 
-static void queue_add_timer(struct queue_timer *t, ULONGLONG time,
+static void queue_arm_timer(struct queue_timer *t, ULONGLONG time,
                             BOOL set_event)
 {
     /* We MUST hold the queue cs while calling this function.  */
     struct timer_queue *q = t->q;
-    struct list *ptr = &q->timers;
+    ULONGLONG next;
 
     assert(!q->quit || (t->destroy && time == EXPIRE_NEVER));
 
-    if (time != EXPIRE_NEVER)
-        LIST_FOR_EACH(ptr, &q->timers)
-        {
-            struct queue_timer *cur = LIST_ENTRY(ptr, struct queue_timer, entry);
-            if (time < cur->expire)
-                break;
-        }
-    list_add_before(ptr, &t->entry);
-
     t->expire = time;
+    if (time == EXPIRE_NEVER)
+        return;
+
+    next = list_empty(&q->expired) ? timer_wheel_next(&q->wheel) : 0;
+    t->wheel_entry.expire = time;
+    t->wheel_entry.window = 0;
+    timer_wheel_insert(&q->wheel, &t->wheel_entry);
 
-    /* If we insert at the head of the list, we need to expire sooner
-       than expected.  */
-    if (set_event && &t->entry == list_head(&q->timers))
+    /* If the timer expires first, we need to expire sooner than
+       expected.  */
+    if (set_event && time < next)
         NtSetEvent(q->event, NULL);
 }
 
+static void queue_add_timer(struct queue_timer *t, ULONGLONG time,
+                            BOOL set_event)
+{
+    /* We MUST hold the queue cs while calling this function.  */
+    list_add_tail(&t->q->timers, &t->entry);
+    queue_arm_timer(t, time, set_event);
+}
+
 static inline void queue_move_timer(struct queue_timer *t, ULONGLONG time,
                                     BOOL set_event)
 {
     /* We MUST hold the queue cs while calling this function.  */
-    list_remove(&t->entry);
-    queue_add_timer(t, time, set_event);
+    queue_disarm_timer(t);
+    queue_arm_timer(t, time, set_event);
 }
 
 static void queue_timer_expire(struct timer_queue *q)
@@ -652,26 +915,24 @@ static void queue_timer_expire(struct timer_queue *q)
     struct queue_timer *t = NULL;
 
     RtlEnterCriticalSection(&q->cs);
-    if (list_head(&q->timers))
+    if (list_empty(&q->expired))
+        timer_wheel_expire(&q->wheel, queue_current_time(), &q->expired);
+    if (list_head(&q->expired))
     {
-        ULONGLONG now, next;
-        t = LIST_ENTRY(list_head(&q->timers), struct queue_timer, entry);
-        if (!t->destroy && t->expire <= ((now = queue_current_time())))
+        ULONGLONG now = queue_current_time(), next;
+        t = LIST_ENTRY(list_head(&q->expired), struct queue_timer, wheel_entry.entry);
+        assert(!t->destroy);
+        ++t->runcount;
+        if (t->period)
         {
-            ++t->runcount;
-            if (t->period)
-            {
-                next = t->expire + t->period;
-                /* avoid trigger cascade if overloaded / hibernated */
-                if (next < now)
-                    next = now + t->period;
-            }
-            else
-                next = EXPIRE_NEVER;
-            queue_move_timer(t, next, FALSE);
+            next = t->expire + t->period;
+            /* avoid trigger cascade if overloaded / hibernated */
+            if (next < now)
+                next = now + t->period;
         }
         else
-            t = NULL;
+            next = EXPIRE_NEVER;
+        queue_move_timer(t, next, FALSE);
     }
     RtlLeaveCriticalSection(&q->cs);
 
@@ -694,20 +955,16 @@ static void queue_timer_expire(struct timer_queue *q)
 
 static ULONG queue_get_timeout(struct timer_queue *q)
 {
-    struct queue_timer *t;
+    ULONGLONG expire;
     ULONG timeout = INFINITE;
 
     RtlEnterCriticalSection(&q->cs);
-    if (list_head(&q->timers))
+    if (!list_empty(&q->expired))
+        timeout = 0;
+    else if ((expire = timer_wheel_next(&q->wheel)) != EXPIRE_NEVER)
     {
-        t = LIST_ENTRY(list_head(&q->timers), struct queue_timer, entry);
-        assert(!t->destroy || t->expire == EXPIRE_NEVER);
-
-        if (t->expire != EXPIRE_NEVER)
-        {
-            ULONGLONG time = queue_current_time();
-            timeout = t->expire < time ? 0 : t->expire - time;
-        }
+        ULONGLONG time = queue_current_time();
+        timeout = expire < time ? 0 : min(expire - time, INFINITE - 1);
     }
     RtlLeaveCriticalSection(&q->cs);
 
@@ -767,9 +1024,8 @@ static void queue_destroy_timer(struct queue_timer *t)
            cleanup wrapper.  */
         queue_remove_timer(t);
     else
-        /* Make sure no destroyed timer masks an active timer at the head
-           of the sorted list.  */
-        queue_move_timer(t, EXPIRE_NEVER, FALSE);
+        /* Make sure no destroyed timer fires again.  */
+        queue_disarm_timer(t);
 }
 
 /***********************************************************************
@@ -793,6 +1049,8 @@ NTSTATUS WINAPI RtlCreateTimerQueue(PHANDLE NewTimerQueue)
 
     RtlInitializeCriticalSection(&q->cs);
     list_init(&q->timers);
+    timer_wheel_init(&q->wheel, 1, queue_current_time());
+    list_init(&q->expired);
     q->quit = FALSE;
     q->magic = TIMER_QUEUE_MAGIC;
     status = NtCreateEvent(&q->event, EVENT_ALL_ACCESS, NULL, SynchronizationEvent, FALSE);
@@ -1058,26 +1316,40 @@ NTSTATUS WINAPI RtlDeleteTimer(HANDLE TimerQueue, HANDLE Timer,
     return status;
 }
 
+/***********************************************************************
+ *           add_pending_timer         (internal)
+ *
+ * timerqueue.cs held by caller.
+ */
+static void add_pending_timer( struct threadpool_object *timer, unsigned int type, ULONGLONG timeout )
+{
+    timer->u.timer.timer_wheel = &timerqueue.wheels[type];
+    timer->u.timer.timer_entry.expire = timeout;
+    timer_wheel_insert( timer->u.timer.timer_wheel, &timer->u.timer.timer_entry );
+    timer->u.timer.timer_pending = TRUE;
+}
+
 /***********************************************************************
  *           submit_expired_timers     (internal)
  *
  * timerqueue.cs held by caller.
  */
-static void submit_expired_timers( struct list *queue, ULONGLONG queue_now, ULONGLONG rel_now )
+static void submit_expired_timers( unsigned int type, ULONGLONG queue_now, ULONGLONG rel_now )
 {
-    struct threadpool_object *other_timer;
+    struct list expired = LIST_INIT( expired );
     struct list *ptr;
 
-    while ((ptr = list_head( queue )))
+    timer_wheel_expire( &timerqueue.wheels[type], queue_now, &expired );
+
+    while ((ptr = list_head( &expired )))
     {
-        struct threadpool_object *timer = LIST_ENTRY( ptr, struct threadpool_object, u.timer.timer_entry );
+        struct threadpool_object *timer = LIST_ENTRY( ptr, struct threadpool_object, u.timer.timer_entry.entry );
+        ULONGLONG timeout = timer->u.timer.timer_entry.expire;
         assert( timer->type == TP_OBJECT_TYPE_TIMER );
         assert( timer->u.timer.timer_pending );
-        if (timer->u.timer.timeout > queue_now)
-            return;
 
         /* Queue a new callback in one of the worker threads. */
-        list_remove( &timer->u.timer.timer_entry );
+        list_remove( &timer->u.timer.timer_entry.entry );
         timer->u.timer.timer_pending = FALSE;
         tp_object_submit( timer, FALSE );
 
@@ -1085,22 +1357,14 @@ static void submit_expired_timers( struct list *queue, ULONGLONG queue_now, ULON
         if (timer->u.timer.period && !timer->shutdown)
         {
             /* Update timeout when moving timer to relative queue */
-            if (queue == &timerqueue.abs_timers)
-                timer->u.timer.timeout = rel_now;
+            if (type == ABS_TIMER)
+                timeout = rel_now;
 
-            timer->u.timer.timeout += (ULONGLONG)timer->u.timer.period * 10000;
-            if (timer->u.timer.timeout <= rel_now)
-                timer->u.timer.timeout = rel_now + 1;
+            timeout += (ULONGLONG)timer->u.timer.period * 10000;
+            if (timeout <= rel_now)
+                timeout = rel_now + 1;
 
-            LIST_FOR_EACH_ENTRY( other_timer, &timerqueue.rel_timers,
-                    struct threadpool_object, u.timer.timer_entry )
-            {
-                assert( other_timer->type == TP_OBJECT_TYPE_TIMER );
-                if (timer->u.timer.timeout < other_timer->u.timer.timeout)
-                    break;
-            }
-            list_add_before( &other_timer->u.timer.timer_entry, &timer->u.timer.timer_entry );
-            timer->u.timer.timer_pending = TRUE;
+            add_pending_timer( timer, REL_TIMER, timeout );
         }
     }
 }
@@ -1110,26 +1374,10 @@ static void submit_expired_timers( struct list *queue, ULONGLONG queue_now, ULON
  *
  * timerqueue.cs held by caller.
  */
-static ULONGLONG get_next_timeout( struct list *list )
+static ULONGLONG get_next_timeout( unsigned int type )
 {
-    ULONGLONG timeout_lower, timeout_upper, new_timeout;
-    struct threadpool_object *other_timer;
-
-    timeout_lower = timeout_upper = MAXLONGLONG;
-
-    /* Determine next timeout and use the window length to optimize wakeup times. */
-    LIST_FOR_EACH_ENTRY( other_timer, list, struct threadpool_object, u.timer.timer_entry )
-    {
-        assert( other_timer->type == TP_OBJECT_TYPE_TIMER );
-        if (other_timer->u.timer.timeout >= timeout_upper)
-            break;
-
-        timeout_lower = other_timer->u.timer.timeout;
-        new_timeout   = timeout_lower + (ULONGLONG)other_timer->u.timer.window_length * 10000;
-        if (new_timeout < timeout_upper)
-            timeout_upper = new_timeout;
-    }
-    return timeout_lower;
+    ULONGLONG timeout = timer_wheel_next( &timerqueue.wheels[type] );
+    return timeout == EXPIRE_NEVER ? MAXLONGLONG : timeout;
 }
 
 /***********************************************************************
@@ -1141,12 +1389,12 @@ static void update_timers( ULONGLONG rel_now )
 {
     LARGE_INTEGER timeout;
 
-    timeout.QuadPart = get_next_timeout( &timerqueue.abs_timers );
+    timeout.QuadPart = get_next_timeout( ABS_TIMER );
     NtSetTimer( timerqueue.timers[ABS_TIMER], &timeout, NULL, NULL, FALSE, 0, NULL );
 
     if (timerqueue.objcount)
     {
-        timeout.QuadPart = get_next_timeout( &timerqueue.rel_timers );
+        timeout.QuadPart = get_next_timeout( REL_TIMER );
         if (timeout.QuadPart > rel_now)
             timeout.QuadPart = rel_now - timeout.QuadPart;
         else
@@ -1177,8 +1425,8 @@ static void CALLBACK timerqueue_thread_proc( void *param )
         NtQuerySystemTime( &abs_now );
         NtQueryPerformanceCounter( &rel_now, NULL );
 
-        submit_expired_timers( &timerqueue.abs_timers, abs_now.QuadPart, rel_now.QuadPart );
-        submit_expired_timers( &timerqueue.rel_timers, rel_now.QuadPart, rel_now.QuadPart );
+        submit_expired_timers( ABS_TIMER, abs_now.QuadPart, rel_now.QuadPart );
+        submit_expired_timers( REL_TIMER, rel_now.QuadPart, rel_now.QuadPart );
         update_timers( rel_now.QuadPart );
 
         RtlLeaveCriticalSection( &timerqueue.cs );
@@ -1234,16 +1482,17 @@ static NTSTATUS tp_timerqueue_lock( struct threadpool_object *timer )
 
     timer->u.timer.timer_initialized    = FALSE;
     timer->u.timer.timer_pending        = FALSE;
+    timer->u.timer.timer_wheel          = NULL;
     timer->u.timer.timer_set            = FALSE;
-    timer->u.timer.timeout              = 0;
     timer->u.timer.period               = 0;
-    timer->u.timer.window_length        = 0;
+    memset( &timer->u.timer.timer_entry, 0, sizeof(timer->u.timer.timer_entry) );
 
     RtlEnterCriticalSection( &timerqueue.cs );
 
     /* Make sure that the timerqueue thread is running. */
     if (!timerqueue.thread_running)
     {
+        LARGE_INTEGER abs_now, rel_now;
         NTSTATUS status;
         HANDLE thread;
 
@@ -1273,6 +1522,12 @@ static NTSTATUS tp_timerqueue_lock( struct threadpool_object *timer )
             RtlLeaveCriticalSection( &timerqueue.cs );
             return status;
         }
+        /* Timer wheels are empty when the thread isn't running, use a resolution of 1ms. */
+        NtQuerySystemTime( &abs_now );
+        NtQueryPerformanceCounter( &rel_now, NULL );
+        timer_wheel_init( &timerqueue.wheels[ABS_TIMER], 10000, abs_now.QuadPart );
+        timer_wheel_init( &timerqueue.wheels[REL_TIMER], 10000, rel_now.QuadPart );
+
         timerqueue.thread_running = TRUE;
         NtClose( thread );
     }
@@ -1299,7 +1554,7 @@ static void tp_timerqueue_unlock( struct threadpool_object *timer )
         /* If timer was pending, remove it. */
         if (timer->u.timer.timer_pending)
         {
-            list_remove( &timer->u.timer.timer_entry );
+            timer_wheel_remove( timer->u.timer.timer_wheel, &timer->u.timer.timer_entry );
             timer->u.timer.timer_pending = FALSE;
         }
 
@@ -1308,8 +1563,8 @@ static void tp_timerqueue_unlock( struct threadpool_object *timer )
         {
             LARGE_INTEGER rel_now;
 
-            assert( list_empty( &timerqueue.abs_timers ) );
-            assert( list_empty( &timerqueue.rel_timers ) );
+            assert( timer_wheel_first_slot( &timerqueue.wheels[ABS_TIMER] ) == -1 );
+            assert( timer_wheel_first_slot( &timerqueue.wheels[REL_TIMER] ) == -1 );
             NtQueryPerformanceCounter( &rel_now, NULL );
             update_timers( rel_now.QuadPart );
         }
@@ -1361,10 +1616,10 @@ static void CALLBACK waitqueue_thread_proc( void *param )
                 if ((wait->u.wait.flags & (WT_EXECUTEINWAITTHREAD | WT_EXECUTEINIOTHREAD)))
                 {
                     InterlockedIncrement( &wait->refcount );
+                    RtlEnterCriticalSection( &wait->queue->cs );
                     wait->num_pending_callbacks++;
-                    RtlEnterCriticalSection( &wait->pool->cs );
                     tp_object_execute( wait, TRUE );
-                    RtlLeaveCriticalSection( &wait->pool->cs );
+                    RtlLeaveCriticalSection( &wait->queue->cs );
                     tp_object_release( wait );
                 }
                 else tp_object_submit( wait, FALSE );
@@ -1422,11 +1677,11 @@ static void CALLBACK waitqueue_thread_proc( void *param )
                     }
                     if ((wait->u.wait.flags & (WT_EXECUTEINWAITTHREAD | WT_EXECUTEINIOTHREAD)))
                     {
+                        RtlEnterCriticalSection( &wait->queue->cs );
                         wait->u.wait.signaled++;
                         wait->num_pending_callbacks++;
-                        RtlEnterCriticalSection( &wait->pool->cs );
                         tp_object_execute( wait, TRUE );
-                        RtlLeaveCriticalSection( &wait->pool->cs );
+                        RtlLeaveCriticalSection( &wait->queue->cs );
                     }
                     else tp_object_submit( wait, TRUE );
                 }
@@ -1505,26 +1760,326 @@ static void CALLBACK waitqueue_thread_proc( void *param )
     RtlExitUserThread( 0 );
 }
 
+static NTSTATUS tp_waitqueue_add_bucket( struct threadpool_object *wait );
+
 /***********************************************************************
- *           tp_waitqueue_lock    (internal)
+ *           tp_wait_dispatch    (internal)
+ *
+ * Runs or queues the callback of a wait object which has been signaled or timed out.
+ * waitqueue.cs held by caller.
  */
-static NTSTATUS tp_waitqueue_lock( struct threadpool_object *wait )
+static void tp_wait_dispatch( struct threadpool_object *wait, BOOL signaled )
 {
-    struct waitqueue_bucket *bucket;
+    if ((wait->u.wait.flags & (WT_EXECUTEINWAITTHREAD | WT_EXECUTEINIOTHREAD)))
+    {
+        InterlockedIncrement( &wait->refcount );
+        RtlEnterCriticalSection( &wait->queue->cs );
+        if (signaled) wait->u.wait.signaled++;
+        wait->num_pending_callbacks++;
+        tp_object_execute( wait, TRUE );
+        RtlLeaveCriticalSection( &wait->queue->cs );
+        tp_object_release( wait );
+    }
+    else tp_object_submit( wait, signaled );
+}
+
+/***********************************************************************
+ *           tp_wait_packet_arm_timeout    (internal)
+ *
+ * waitqueue.cs held by caller.
+ */
+static void tp_wait_packet_arm_timeout( struct threadpool_object *wait, ULONGLONG timeout )
+{
+    wait->u.wait.timeout = timeout;
+    wait->u.wait.timeout_entry.expire = timeout;
+    timer_wheel_insert( &waitqueue.timeouts, &wait->u.wait.timeout_entry );
+
+    /* Wake up the wait queue thread if it sleeps for too long. */
+    if (timeout < waitqueue.next_wakeup)
+    {
+        waitqueue.next_wakeup = timeout;
+        NtSetIoCompletion( waitqueue.port, 0, 0, STATUS_SUCCESS, 0 );
+    }
+}
+
+/***********************************************************************
+ *           tp_wait_packet_associate    (internal)
+ *
+ * Associates the packet of a wait object with its handle. The pending
+ * association holds a reference to the wait object.
+ * waitqueue.cs held by caller.
+ */
+static NTSTATUS tp_wait_packet_associate( struct threadpool_object *wait )
+{
+    HANDLE handle = wait->u.wait.duped_handle ? wait->u.wait.duped_handle : wait->u.wait.handle;
     NTSTATUS status;
-    HANDLE thread;
-    BOOL alertable = (wait->u.wait.flags & WT_EXECUTEINIOTHREAD) != 0;
+
+    assert( !wait->u.wait.packet_associated );
+
+    InterlockedIncrement( &wait->refcount );
+    status = NtAssociateWaitCompletionPacket( wait->u.wait.packet, waitqueue.port, handle, wait,
+                                              LongToPtr( wait->update_serial ), STATUS_SUCCESS,
+                                              ++wait->u.wait.packet_serial, NULL );
+    if (status)
+    {
+        tp_object_release( wait );
+        return status;
+    }
+
+    wait->u.wait.packet_associated = TRUE;
+    return STATUS_SUCCESS;
+}
+
+/***********************************************************************
+ *           tp_wait_packet_cancel    (internal)
+ *
+ * Cancels the pending association and the timeout of a wait object.
+ * waitqueue.cs held by caller.
+ */
+static void tp_wait_packet_cancel( struct threadpool_object *wait )
+{
+    if (wait->u.wait.packet_associated)
+    {
+        /* If the packet has already been queued, the reference is released
+         * by the wait queue thread when it is received. */
+        wait->u.wait.packet_associated = FALSE;
+        if (!NtCancelWaitCompletionPacket( wait->u.wait.packet, TRUE ))
+            tp_object_release( wait );
+    }
+
+    if (wait->u.wait.timeout_entry.expire != EXPIRE_NEVER)
+    {
+        timer_wheel_remove( &waitqueue.timeouts, &wait->u.wait.timeout_entry );
+        wait->u.wait.timeout_entry.expire = EXPIRE_NEVER;
+    }
+}
+
+/***********************************************************************
+ *           tp_wait_packet_signaled    (internal)
+ *
+ * waitqueue.cs held by caller.
+ */
+static void tp_wait_packet_signaled( struct threadpool_object *wait, LONG update_serial, LONG packet_serial )
+{
     assert( wait->type == TP_OBJECT_TYPE_WAIT );
 
-    wait->u.wait.signaled       = 0;
-    wait->u.wait.bucket         = NULL;
-    wait->u.wait.wait_pending   = FALSE;
-    wait->u.wait.timeout        = 0;
-    wait->u.wait.handle         = NULL;
-    wait->u.wait.duped_handle   = NULL;
+    /* The packet may belong to an association which was already dequeued when
+     * it got cancelled, only the current association may trigger the wait. */
+    if (!wait->u.wait.packet_associated || packet_serial != wait->u.wait.packet_serial)
+    {
+        TRACE( "ignoring stale packet %ld for wait object %p\n", packet_serial, wait );
+        tp_object_release( wait );
+        return;
+    }
+    wait->u.wait.packet_associated = FALSE;
+
+    if (wait->u.wait.wait_pending && wait->update_serial == update_serial)
+    {
+        if ((wait->u.wait.flags & WT_EXECUTEONLYONCE))
+        {
+            wait->u.wait.wait_pending = FALSE;
+            tp_wait_packet_cancel( wait );
+        }
+        else if (tp_wait_packet_associate( wait ))
+            WARN( "failed to associate wait object %p again\n", wait );
+
+        tp_wait_dispatch( wait, TRUE );
+    }
+    else
+    {
+        WARN( "wait object %p triggered while object was %s.\n",
+              wait, wait->u.wait.packet ? "updated" : "destroyed" );
+    }
+
+    /* Release the reference held by the association. */
+    tp_object_release( wait );
+}
+
+/***********************************************************************
+ *           tp_wait_packet_timeout    (internal)
+ *
+ * waitqueue.cs held by caller.
+ */
+static void tp_wait_packet_timeout( struct threadpool_object *wait )
+{
+    LARGE_INTEGER now;
+
+    assert( wait->type == TP_OBJECT_TYPE_WAIT );
+    assert( wait->u.wait.wait_pending );
+
+    if ((wait->u.wait.flags & WT_EXECUTEONLYONCE))
+    {
+        wait->u.wait.wait_pending = FALSE;
+        tp_wait_packet_cancel( wait );
+    }
+    else if (wait->u.wait.interval)
+    {
+        /* Restart the timeout, like a new wait would do. */
+        NtQuerySystemTime( &now );
+        tp_wait_packet_arm_timeout( wait, now.QuadPart + wait->u.wait.interval );
+    }
+
+    tp_wait_dispatch( wait, FALSE );
+}
+
+/***********************************************************************
+ *           tp_wait_packet_update    (internal)
+ *
+ * Replaces the handle and timeout of a wait object using a wait completion
+ * packet. When the handle cannot be waited upon this way, the wait object is
+ * moved to a wait queue bucket and STATUS_MORE_PROCESSING_REQUIRED is returned.
+ * waitqueue.cs held by caller.
+ */
+static NTSTATUS tp_wait_packet_update( struct threadpool_object *wait, ULONGLONG timeout, ULONGLONG interval )
+{
+    NTSTATUS status;
+
+    wait->u.wait.wait_pending = FALSE;
+    tp_wait_packet_cancel( wait );
+    if (!wait->u.wait.handle) return STATUS_SUCCESS;
+
+    if (!(status = tp_wait_packet_associate( wait )))
+    {
+        wait->u.wait.wait_pending = TRUE;
+        wait->u.wait.interval = interval;
+        if (timeout != MAXLONGLONG) tp_wait_packet_arm_timeout( wait, timeout );
+        return STATUS_SUCCESS;
+    }
+
+    /* Objects using inproc synchronization and mutexes cannot be waited upon with
+     * a packet, only this wait object falls back to a bucket. */
+    TRACE( "cannot use wait completion packet for %p, status %#lx\n", wait->u.wait.handle, status );
+
+    NtClose( wait->u.wait.packet );
+    wait->u.wait.packet = NULL;
+    --waitqueue.num_packets;
+
+    if ((status = tp_waitqueue_add_bucket( wait ))) return status;
+    return STATUS_MORE_PROCESSING_REQUIRED;
+}
+
+/***********************************************************************
+ *           waitqueue_packet_thread_proc    (internal)
+ */
+static void CALLBACK waitqueue_packet_thread_proc( void *param )
+{
+    FILE_IO_COMPLETION_INFORMATION info[MAXIMUM_WAITQUEUE_OBJECTS];
+    struct threadpool_object *wait;
+    struct list expired, *ptr;
+    LARGE_INTEGER now, timeout;
+    ULONG i, count;
+    NTSTATUS status;
+
+    TRACE( "starting wait queue packet thread\n" );
+    set_thread_name(L"wine_threadpool_waitqueue");
 
     RtlEnterCriticalSection( &waitqueue.cs );
 
+    for (;;)
+    {
+        NtQuerySystemTime( &now );
+        list_init( &expired );
+        timer_wheel_expire( &waitqueue.timeouts, now.QuadPart, &expired );
+
+        while ((ptr = list_head( &expired )))
+        {
+            wait = LIST_ENTRY( ptr, struct threadpool_object, u.wait.timeout_entry.entry );
+            list_remove( ptr );
+            wait->u.wait.timeout_entry.expire = EXPIRE_NEVER;
+            tp_wait_packet_timeout( wait );
+        }
+
+        if (!waitqueue.num_packets)
+        {
+            /* All wait objects have been destroyed, if no new wait objects are created
+             * within some amount of time, then we can shutdown this thread. */
+            timeout.QuadPart = (ULONGLONG)THREADPOOL_WORKER_TIMEOUT * -10000;
+            waitqueue.next_wakeup = EXPIRE_NEVER;
+        }
+        else
+        {
+            timeout.QuadPart = waitqueue.next_wakeup = timer_wheel_next( &waitqueue.timeouts );
+            if (waitqueue.next_wakeup == EXPIRE_NEVER) timeout.QuadPart = MAXLONGLONG;
+        }
+
+        RtlLeaveCriticalSection( &waitqueue.cs );
+        status = NtRemoveIoCompletionEx( waitqueue.port, info, ARRAY_SIZE(info), &count,
+                                         timeout.QuadPart == MAXLONGLONG ? NULL : &timeout, FALSE );
+        RtlEnterCriticalSection( &waitqueue.cs );
+
+        waitqueue.next_wakeup = 0;
+        if (status == STATUS_TIMEOUT && !waitqueue.num_packets)
+            break;
+        if (status) continue;
+
+        for (i = 0; i < count; i++)
+        {
+            /* Entries without a wait object are only used to wake up this thread. */
+            if (!(wait = (struct threadpool_object *)info[i].CompletionKey)) continue;
+            tp_wait_packet_signaled( wait, PtrToLong( (void *)info[i].CompletionValue ),
+                                     info[i].IoStatusBlock.Information );
+        }
+    }
+
+    waitqueue.thread_running = FALSE;
+    RtlLeaveCriticalSection( &waitqueue.cs );
+
+    TRACE( "terminating wait queue packet thread\n" );
+    RtlExitUserThread( 0 );
+}
+
+/***********************************************************************
+ *           tp_waitqueue_add_packet    (internal)
+ *
+ * waitqueue.cs held by caller.
+ */
+static NTSTATUS tp_waitqueue_add_packet( struct threadpool_object *wait )
+{
+    LARGE_INTEGER now;
+    NTSTATUS status;
+    HANDLE thread;
+
+    if (!waitqueue.port && (status = NtCreateIoCompletion( &waitqueue.port, IO_COMPLETION_ALL_ACCESS, NULL, 0 )))
+        return status;
+
+    if ((status = NtCreateWaitCompletionPacket( &wait->u.wait.packet, MAXIMUM_ALLOWED, NULL )))
+    {
+        wait->u.wait.packet = NULL;
+        return status;
+    }
+
+    if (!waitqueue.thread_running)
+    {
+        NtQuerySystemTime( &now );
+        timer_wheel_init( &waitqueue.timeouts, 10000, now.QuadPart );
+
+        if ((status = RtlCreateUserThread( GetCurrentProcess(), NULL, FALSE, 0, 0, 0,
+                                           waitqueue_packet_thread_proc, NULL, &thread, NULL )))
+        {
+            NtClose( wait->u.wait.packet );
+            wait->u.wait.packet = NULL;
+            return status;
+        }
+        waitqueue.thread_running = TRUE;
+        NtClose( thread );
+    }
+
+    waitqueue.num_packets++;
+    return STATUS_SUCCESS;
+}
+
+/***********************************************************************
+ *           tp_waitqueue_add_bucket    (internal)
+ *
+ * waitqueue.cs held by caller.
+ */
+static NTSTATUS tp_waitqueue_add_bucket( struct threadpool_object *wait )
+{
+    struct waitqueue_bucket *bucket;
+    NTSTATUS status;
+    HANDLE thread;
+    BOOL alertable = (wait->u.wait.flags & WT_EXECUTEINIOTHREAD) != 0;
+
     /* Try to assign to existing bucket if possible. */
     LIST_FOR_EACH_ENTRY( bucket, &waitqueue.buckets, struct waitqueue_bucket, bucket_entry )
     {
@@ -1533,19 +2088,14 @@ static NTSTATUS tp_waitqueue_lock( struct threadpool_object *wait )
             list_add_tail( &bucket->reserved, &wait->u.wait.wait_entry );
             wait->u.wait.bucket = bucket;
             bucket->objcount++;
-
-            status = STATUS_SUCCESS;
-            goto out;
+            return STATUS_SUCCESS;
         }
     }
 
     /* Create a new bucket and corresponding worker thread. */
     bucket = RtlAllocateHeap( GetProcessHeap(), 0, sizeof(*bucket) );
     if (!bucket)
-    {
-        status = STATUS_NO_MEMORY;
-        goto out;
-    }
+        return STATUS_NO_MEMORY;
 
     bucket->objcount = 0;
     bucket->alertable = alertable;
@@ -1557,7 +2107,7 @@ static NTSTATUS tp_waitqueue_lock( struct threadpool_object *wait )
     if (status)
     {
         RtlFreeHeap( GetProcessHeap(), 0, bucket );
-        goto out;
+        return status;
     }
 
     status = RtlCreateUserThread( GetCurrentProcess(), NULL, FALSE, 0, 0, 0,
@@ -1579,7 +2129,39 @@ static NTSTATUS tp_waitqueue_lock( struct threadpool_object *wait )
         RtlFreeHeap( GetProcessHeap(), 0, bucket );
     }
 
-out:
+    return status;
+}
+
+/***********************************************************************
+ *           tp_waitqueue_lock    (internal)
+ */
+static NTSTATUS tp_waitqueue_lock( struct threadpool_object *wait )
+{
+    NTSTATUS status;
+    assert( wait->type == TP_OBJECT_TYPE_WAIT );
+
+    wait->u.wait.signaled       = 0;
+    wait->u.wait.bucket         = NULL;
+    wait->u.wait.wait_pending   = FALSE;
+    wait->u.wait.timeout        = 0;
+    wait->u.wait.handle         = NULL;
+    wait->u.wait.duped_handle   = NULL;
+    wait->u.wait.packet         = NULL;
+    wait->u.wait.packet_associated = FALSE;
+    wait->u.wait.packet_serial  = 0;
+    wait->u.wait.timeout_entry.expire = EXPIRE_NEVER;
+    wait->u.wait.timeout_entry.window = 0;
+    wait->u.wait.timeout_entry.slot   = -1;
+    wait->u.wait.interval       = 0;
+
+    RtlEnterCriticalSection( &waitqueue.cs );
+
+    /* Alertable waits need a dedicated thread, use a bucket for them. */
+    if ((wait->u.wait.flags & WT_EXECUTEINIOTHREAD) || tp_waitqueue_add_packet( wait ))
+        status = tp_waitqueue_add_bucket( wait );
+    else
+        status = STATUS_SUCCESS;
+
     RtlLeaveCriticalSection( &waitqueue.cs );
     return status;
 }
@@ -1603,6 +2185,16 @@ static void tp_waitqueue_unlock( struct threadpool_object *wait )
 
         NtSetEvent( bucket->update_event, NULL );
     }
+    else if (wait->u.wait.packet)
+    {
+        wait->u.wait.wait_pending = FALSE;
+        tp_wait_packet_cancel( wait );
+        NtClose( wait->u.wait.packet );
+        wait->u.wait.packet = NULL;
+
+        if (!--waitqueue.num_packets)
+            NtSetIoCompletion( waitqueue.port, 0, 0, STATUS_SUCCESS, 0 );
+    }
     RtlLeaveCriticalSection( &waitqueue.cs );
 }
 
@@ -1634,7 +2226,7 @@ static void CALLBACK ioqueue_thread_proc( void *param )
 
         if (io && (io->shutdown || io->u.io.shutting_down))
         {
-            RtlEnterCriticalSection( &io->pool->cs );
+            RtlEnterCriticalSection( &io->queue->cs );
             if (!io->u.io.pending_count)
             {
                 if (io->u.io.skipped_count)
@@ -1645,7 +2237,7 @@ static void CALLBACK ioqueue_thread_proc( void *param )
                 else
                     destroy = TRUE;
             }
-            RtlLeaveCriticalSection( &io->pool->cs );
+            RtlLeaveCriticalSection( &io->queue->cs );
             if (skip) continue;
         }
 
@@ -1658,7 +2250,7 @@ static void CALLBACK ioqueue_thread_proc( void *param )
         }
         else if (io)
         {
-            RtlEnterCriticalSection( &io->pool->cs );
+            RtlEnterCriticalSection( &io->queue->cs );
 
             TRACE( "pending_count %u.\n", io->u.io.pending_count );
 
@@ -1669,7 +2261,7 @@ static void CALLBACK ioqueue_thread_proc( void *param )
                         io->u.io.completion_count + 1, sizeof(*io->u.io.completions)))
                 {
                     ERR( "Failed to allocate memory.\n" );
-                    RtlLeaveCriticalSection( &io->pool->cs );
+                    RtlLeaveCriticalSection( &io->queue->cs );
                     continue;
                 }
 
@@ -1679,7 +2271,7 @@ static void CALLBACK ioqueue_thread_proc( void *param )
 
                 tp_object_submit( io, FALSE );
             }
-            RtlLeaveCriticalSection( &io->pool->cs );
+            RtlLeaveCriticalSection( &io->queue->cs );
         }
 
         if (!ioqueue.objcount)
@@ -1759,7 +2351,7 @@ static NTSTATUS tp_threadpool_alloc( struct threadpool **out )
 {
     IMAGE_NT_HEADERS *nt = RtlImageNtHeader( NtCurrentTeb()->Peb->ImageBaseAddress );
     struct threadpool *pool;
-    unsigned int i;
+    unsigned int i, j;
 
     pool = RtlAllocateHeap( GetProcessHeap(), 0, sizeof(*pool) );
     if (!pool)
@@ -1772,14 +2364,28 @@ static NTSTATUS tp_threadpool_alloc( struct threadpool **out )
     RtlInitializeCriticalSectionEx( &pool->cs, 0, RTL_CRITICAL_SECTION_FLAG_FORCE_DEBUG_INFO );
     pool->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": threadpool.cs");
 
-    for (i = 0; i < ARRAY_SIZE(pool->pools); ++i)
-        list_init( &pool->pools[i] );
+    pool->num_queues = min( max( NtCurrentTeb()->Peb->NumberOfProcessors, 1 ), THREADPOOL_MAX_QUEUES );
+    pool->next_queue = 0;
+    for (i = 0; i < pool->num_queues; ++i)
+    {
+        struct threadpool_queue *queue = &pool->queues[i];
+
+        RtlInitializeCriticalSectionEx( &queue->cs, 0, RTL_CRITICAL_SECTION_FLAG_FORCE_DEBUG_INFO );
+        queue->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": threadpool_queue.cs");
+        for (j = 0; j < ARRAY_SIZE(queue->pools); ++j)
+        {
+            list_init( &queue->pools[j] );
+            queue->counts[j] = 0;
+        }
+    }
     RtlInitializeConditionVariable( &pool->update_event );
 
     pool->max_workers             = 500;
     pool->min_workers             = 0;
     pool->num_workers             = 0;
     pool->num_busy_workers        = 0;
+    pool->num_idle_workers        = 0;
+    pool->num_queued              = 0;
     pool->stack_info.StackReserve = nt->OptionalHeader.SizeOfStackReserve;
     pool->stack_info.StackCommit  = nt->OptionalHeader.SizeOfStackCommit;
 
@@ -1811,7 +2417,7 @@ static void tp_threadpool_shutdown( struct threadpool *pool )
  */
 static BOOL tp_threadpool_release( struct threadpool *pool )
 {
-    unsigned int i;
+    unsigned int i, j;
 
     if (InterlockedDecrement( &pool->refcount ))
         return FALSE;
@@ -1820,8 +2426,16 @@ static BOOL tp_threadpool_release( struct threadpool *pool )
 
     assert( pool->shutdown );
     assert( !pool->objcount );
-    for (i = 0; i < ARRAY_SIZE(pool->pools); ++i)
-        assert( list_empty( &pool->pools[i] ) );
+    assert( !pool->num_queued );
+    for (i = 0; i < pool->num_queues; ++i)
+    {
+        struct threadpool_queue *queue = &pool->queues[i];
+
+        for (j = 0; j < ARRAY_SIZE(queue->pools); ++j)
+            assert( list_empty( &queue->pools[j] ) );
+        queue->cs.DebugInfo->Spare[0] = 0;
+        RtlDeleteCriticalSection( &queue->cs );
+    }
 
     pool->cs.DebugInfo->Spare[0] = 0;
     RtlDeleteCriticalSection( &pool->cs );
@@ -1990,6 +2604,7 @@ static void tp_object_initialize( struct threadpool_object *object, struct threa
     object->shutdown                = FALSE;
 
     object->pool                    = pool;
+    object->queue                   = &pool->queues[(ULONG)InterlockedIncrement( &pool->next_queue ) % pool->num_queues];
     object->group                   = NULL;
     object->userdata                = userdata;
     object->group_cancel_callback   = NULL;
@@ -2025,7 +2640,7 @@ static void tp_object_initialize( struct threadpool_object *object, struct threa
             TP_CALLBACK_ENVIRON_V3 *environment_v3 = (TP_CALLBACK_ENVIRON_V3 *)environment;
 
             object->priority = environment_v3->CallbackPriority;
-            assert( object->priority < ARRAY_SIZE(pool->pools) );
+            assert( object->priority < ARRAY_SIZE(object->queue->pools) );
         }
 
         if (environment->ActivationContext)
@@ -2062,10 +2677,23 @@ static void tp_object_initialize( struct threadpool_object *object, struct threa
         tp_object_release( object );
 }
 
+/* object->queue->cs has to be held */
 static void tp_object_prio_queue( struct threadpool_object *object )
 {
-    ++object->pool->num_busy_workers;
-    list_add_tail( &object->pool->pools[object->priority], &object->pool_entry );
+    struct threadpool_queue *queue = object->queue;
+
+    InterlockedIncrement( &object->pool->num_busy_workers );
+    list_add_tail( &queue->pools[object->priority], &object->pool_entry );
+    queue->counts[object->priority]++;
+    InterlockedIncrement( &object->pool->num_queued );
+}
+
+/* object->queue->cs has to be held */
+static void tp_object_prio_dequeue( struct threadpool_object *object )
+{
+    list_remove( &object->pool_entry );
+    object->queue->counts[object->priority]--;
+    InterlockedDecrement( &object->pool->num_queued );
 }
 
 /***********************************************************************
@@ -2082,12 +2710,7 @@ static void tp_object_submit( struct threadpool_object *object, BOOL signaled )
     assert( !object->shutdown );
     assert( !pool->shutdown );
 
-    RtlEnterCriticalSection( &pool->cs );
-
-    /* Start new worker threads if required. */
-    if (pool->num_busy_workers >= pool->num_workers &&
-        pool->num_workers < pool->max_workers)
-        status = tp_new_worker_thread( pool );
+    RtlEnterCriticalSection( &object->queue->cs );
 
     /* Queue work item and increment refcount. */
     InterlockedIncrement( &object->refcount );
@@ -2098,14 +2721,30 @@ static void tp_object_submit( struct threadpool_object *object, BOOL signaled )
     if (object->type == TP_OBJECT_TYPE_WAIT && signaled)
         object->u.wait.signaled++;
 
-    /* No new thread started - wake up one existing thread. */
-    if (status != STATUS_SUCCESS)
+    RtlLeaveCriticalSection( &object->queue->cs );
+
+    /* Start new worker threads if required. The pool lock is only needed
+     * when the worker count has to change or when a worker is sleeping. */
+    if (pool->num_busy_workers >= pool->num_workers &&
+        pool->num_workers < pool->max_workers)
     {
+        RtlEnterCriticalSection( &pool->cs );
+        if (pool->num_busy_workers >= pool->num_workers &&
+            pool->num_workers < pool->max_workers)
+            status = tp_new_worker_thread( pool );
+        RtlLeaveCriticalSection( &pool->cs );
+    }
+
+    /* No new thread started - wake up one existing thread. Workers check
+     * num_queued after announcing that they are idle, so a work item can't
+     * be missed. */
+    if (status != STATUS_SUCCESS && pool->num_idle_workers)
+    {
+        RtlEnterCriticalSection( &pool->cs );
         assert( pool->num_workers > 0 );
         RtlWakeConditionVariable( &pool->update_event );
+        RtlLeaveCriticalSection( &pool->cs );
     }
-
-    RtlLeaveCriticalSection( &pool->cs );
 }
 
 /***********************************************************************
@@ -2115,15 +2754,16 @@ static void tp_object_submit( struct threadpool_object *object, BOOL signaled )
  */
 static void tp_object_cancel( struct threadpool_object *object )
 {
-    struct threadpool *pool = object->pool;
+    struct threadpool_queue *queue = object->queue;
     LONG pending_callbacks = 0;
 
-    RtlEnterCriticalSection( &pool->cs );
+    RtlEnterCriticalSection( &queue->cs );
     if (object->num_pending_callbacks)
     {
         pending_callbacks = object->num_pending_callbacks;
         object->num_pending_callbacks = 0;
-        list_remove( &object->pool_entry );
+        tp_object_prio_dequeue( object );
+        InterlockedDecrement( &object->pool->num_busy_workers );
 
         if (object->type == TP_OBJECT_TYPE_WAIT)
             object->u.wait.signaled = 0;
@@ -2133,7 +2773,7 @@ static void tp_object_cancel( struct threadpool_object *object )
         object->u.io.skipped_count += object->u.io.pending_count;
         object->u.io.pending_count = 0;
     }
-    RtlLeaveCriticalSection( &pool->cs );
+    RtlLeaveCriticalSection( &queue->cs );
 
     while (pending_callbacks--)
         tp_object_release( object );
@@ -2160,17 +2800,17 @@ static BOOL object_is_finished( struct threadpool_object *object, BOOL group )
  */
 static void tp_object_wait( struct threadpool_object *object, BOOL group_wait )
 {
-    struct threadpool *pool = object->pool;
+    struct threadpool_queue *queue = object->queue;
 
-    RtlEnterCriticalSection( &pool->cs );
+    RtlEnterCriticalSection( &queue->cs );
     while (!RtlDllShutdownInProgress() && !object_is_finished( object, group_wait ))
     {
         if (group_wait)
-            RtlSleepConditionVariableCS( &object->group_finished_event, &pool->cs, NULL );
+            RtlSleepConditionVariableCS( &object->group_finished_event, &queue->cs, NULL );
         else
-            RtlSleepConditionVariableCS( &object->finished_event, &pool->cs, NULL );
+            RtlSleepConditionVariableCS( &object->finished_event, &queue->cs, NULL );
     }
-    RtlLeaveCriticalSection( &pool->cs );
+    RtlLeaveCriticalSection( &queue->cs );
 }
 
 static void tp_ioqueue_unlock( struct threadpool_object *io )
@@ -2259,24 +2899,56 @@ static BOOL tp_object_release( struct threadpool_object *object )
     return TRUE;
 }
 
-static struct list *threadpool_get_next_item( const struct threadpool *pool )
+/***********************************************************************
+ *           tp_threadpool_dequeue    (internal)
+ *
+ * Takes the next work item from the queue shards of a pool, starting at
+ * *start so that workers spread over the shards. On success, the queue
+ * lock of the returned object is held.
+ */
+static struct threadpool_object *tp_threadpool_dequeue( struct threadpool *pool, unsigned int *start )
 {
+    struct threadpool_object *object;
+    struct threadpool_queue *queue;
+    unsigned int i, j, index;
     struct list *ptr;
-    unsigned int i;
 
-    for (i = 0; i < ARRAY_SIZE(pool->pools); ++i)
+    for (i = 0; i < ARRAY_SIZE(pool->queues[0].pools); ++i)
     {
-        if ((ptr = list_head( &pool->pools[i] )))
-            break;
+        for (j = 0; j < pool->num_queues; ++j)
+        {
+            index = (*start + j) % pool->num_queues;
+            queue = &pool->queues[index];
+            if (!ReadNoFence( &queue->counts[i] )) continue;
+
+            RtlEnterCriticalSection( &queue->cs );
+            if ((ptr = list_head( &queue->pools[i] )))
+            {
+                object = LIST_ENTRY( ptr, struct threadpool_object, pool_entry );
+                assert( object->num_pending_callbacks > 0 );
+
+                /* If further pending callbacks are queued, move the work item to
+                 * the end of the pool list. Otherwise remove it from the pool. */
+                tp_object_prio_dequeue( object );
+                if (object->num_pending_callbacks > 1)
+                    tp_object_prio_queue( object );
+
+                /* Continue with the next shard, so that items of other
+                 * shards aren't starved. */
+                *start = index + 1;
+                return object;
+            }
+            RtlLeaveCriticalSection( &queue->cs );
+        }
     }
 
-    return ptr;
+    return NULL;
 }
 
 /***********************************************************************
  *           tp_object_execute    (internal)
  *
- * Executes a threadpool object callback, object->pool->cs has to be
+ * Executes a threadpool object callback, object->queue->cs has to be
  * held.
  */
 static void tp_object_execute( struct threadpool_object *object, BOOL wait_thread )
@@ -2284,7 +2956,7 @@ static void tp_object_execute( struct threadpool_object *object, BOOL wait_threa
     TP_CALLBACK_INSTANCE *callback_instance;
     struct threadpool_instance instance;
     struct io_completion completion;
-    struct threadpool *pool = object->pool;
+    struct threadpool_queue *queue = object->queue;
     TP_WAIT_RESULT wait_result = 0;
     NTSTATUS status;
 
@@ -2305,7 +2977,7 @@ static void tp_object_execute( struct threadpool_object *object, BOOL wait_threa
     /* Leave critical section and do the actual callback. */
     object->num_associated_callbacks++;
     object->num_running_callbacks++;
-    RtlLeaveCriticalSection( &pool->cs );
+    RtlLeaveCriticalSection( &queue->cs );
     if (wait_thread) RtlLeaveCriticalSection( &waitqueue.cs );
 
     /* Initialize threadpool instance struct. */
@@ -2411,7 +3083,7 @@ static void tp_object_execute( struct threadpool_object *object, BOOL wait_threa
 
 skip_cleanup:
     if (wait_thread) RtlEnterCriticalSection( &waitqueue.cs );
-    RtlEnterCriticalSection( &pool->cs );
+    RtlEnterCriticalSection( &queue->cs );
 
     /* Simple callbacks are automatically shutdown after execution. */
     if (object->type == TP_OBJECT_TYPE_SIMPLE)
@@ -2438,50 +3110,58 @@ skip_cleanup:
 static void CALLBACK threadpool_worker_proc( void *param )
 {
     struct threadpool *pool = param;
+    struct threadpool_object *object;
     LARGE_INTEGER timeout;
-    struct list *ptr;
+    unsigned int start = GetCurrentThreadId() / 4; /* spread workers over the queue shards */
+    NTSTATUS status;
 
     TRACE( "starting worker thread for pool %p\n", pool );
     set_thread_name(L"wine_threadpool_worker");
 
-    RtlEnterCriticalSection( &pool->cs );
     for (;;)
     {
-        while ((ptr = threadpool_get_next_item( pool )))
+        while ((object = tp_threadpool_dequeue( pool, &start )))
         {
-            struct threadpool_object *object = LIST_ENTRY( ptr, struct threadpool_object, pool_entry );
-            assert( object->num_pending_callbacks > 0 );
-
-            /* If further pending callbacks are queued, move the work item to
-             * the end of the pool list. Otherwise remove it from the pool. */
-            list_remove( &object->pool_entry );
-            if (object->num_pending_callbacks > 1)
-                tp_object_prio_queue( object );
-
             tp_object_execute( object, FALSE );
+            RtlLeaveCriticalSection( &object->queue->cs );
 
             assert(pool->num_busy_workers);
-            pool->num_busy_workers--;
+            InterlockedDecrement( &pool->num_busy_workers );
 
             tp_object_release( object );
         }
 
+        RtlEnterCriticalSection( &pool->cs );
+
         /* Shutdown worker thread if requested. */
-        if (pool->shutdown)
+        if (pool->shutdown && !pool->num_queued)
             break;
 
+        /* Announce that this thread is going to sleep before checking for
+         * work again, tp_object_submit only wakes up idle threads. */
+        InterlockedIncrement( &pool->num_idle_workers );
+        if (pool->num_queued)
+        {
+            InterlockedDecrement( &pool->num_idle_workers );
+            RtlLeaveCriticalSection( &pool->cs );
+            continue;
+        }
+
         /* Wait for new tasks or until the timeout expires. A thread only terminates
          * when no new tasks are available, and the number of threads can be
          * decreased without violating the min_workers limit. An exception is when
          * min_workers == 0, then objcount is used to detect if the last thread
          * can be terminated. */
         timeout.QuadPart = (ULONGLONG)THREADPOOL_WORKER_TIMEOUT * -10000;
-        if (RtlSleepConditionVariableCS( &pool->update_event, &pool->cs, &timeout ) == STATUS_TIMEOUT &&
-            !threadpool_get_next_item( pool ) && (pool->num_workers > max( pool->min_workers, 1 ) ||
+        status = RtlSleepConditionVariableCS( &pool->update_event, &pool->cs, &timeout );
+        InterlockedDecrement( &pool->num_idle_workers );
+        if (status == STATUS_TIMEOUT && !pool->num_queued &&
+            (pool->num_workers > max( pool->min_workers, 1 ) ||
             (!pool->min_workers && !pool->objcount)))
         {
             break;
         }
+        RtlLeaveCriticalSection( &pool->cs );
     }
     pool->num_workers--;
     RtlLeaveCriticalSection( &pool->cs );
@@ -2684,7 +3364,7 @@ void WINAPI TpCancelAsyncIoOperation( TP_IO *io )
 
     TRACE( "%p\n", io );
 
-    RtlEnterCriticalSection( &this->pool->cs );
+    RtlEnterCriticalSection( &this->queue->cs );
 
     TRACE("pending_count %u.\n", this->u.io.pending_count);
 
@@ -2694,7 +3374,7 @@ void WINAPI TpCancelAsyncIoOperation( TP_IO *io )
     if (object_is_finished( this, FALSE ))
         RtlWakeAllConditionVariable( &this->finished_event );
 
-    RtlLeaveCriticalSection( &this->pool->cs );
+    RtlLeaveCriticalSection( &this->queue->cs );
 }
 
 /***********************************************************************
@@ -2814,7 +3494,6 @@ VOID WINAPI TpDisassociateCallback( TP_CALLBACK_INSTANCE *instance )
 {
     struct threadpool_instance *this = impl_from_TP_CALLBACK_INSTANCE( instance );
     struct threadpool_object *object = this->object;
-    struct threadpool *pool;
 
     TRACE( "%p\n", instance );
 
@@ -2827,14 +3506,13 @@ VOID WINAPI TpDisassociateCallback( TP_CALLBACK_INSTANCE *instance )
     if (!this->associated)
         return;
 
-    pool = object->pool;
-    RtlEnterCriticalSection( &pool->cs );
+    RtlEnterCriticalSection( &object->queue->cs );
 
     object->num_associated_callbacks--;
     if (object_is_finished( object, FALSE ))
         RtlWakeAllConditionVariable( &object->finished_event );
 
-    RtlLeaveCriticalSection( &pool->cs );
+    RtlLeaveCriticalSection( &object->queue->cs );
     this->associated = FALSE;
 }
 
@@ -2958,10 +3636,10 @@ void WINAPI TpReleaseIoCompletion( TP_IO *io )
 
     TRACE( "%p\n", io );
 
-    RtlEnterCriticalSection( &this->pool->cs );
+    RtlEnterCriticalSection( &this->queue->cs );
     this->u.io.shutting_down = TRUE;
     can_destroy = !this->u.io.pending_count && !this->u.io.skipped_count;
-    RtlLeaveCriticalSection( &this->pool->cs );
+    RtlLeaveCriticalSection( &this->queue->cs );
 
     if (can_destroy)
     {
@@ -3076,10 +3754,9 @@ BOOL WINAPI TpSetPoolMinThreads( TP_POOL *pool, DWORD minimum )
 VOID WINAPI TpSetTimer( TP_TIMER *timer, LARGE_INTEGER *timeout, LONG period, LONG window_length )
 {
     struct threadpool_object *this = impl_from_TP_TIMER( timer );
-    struct threadpool_object *other_timer;
-    struct list *pending_timers;
+    unsigned int type;
     BOOL submit_timer = FALSE;
-    ULONGLONG timestamp;
+    ULONGLONG timestamp, next;
 
     TRACE( "%p %p %lu %lu\n", timer, timeout, period, window_length );
 
@@ -3095,14 +3772,14 @@ VOID WINAPI TpSetTimer( TP_TIMER *timer, LARGE_INTEGER *timeout, LONG period, LO
         if (timeout->QuadPart > 0)
         {
             timestamp = timeout->QuadPart;
-            pending_timers = &timerqueue.abs_timers;
+            type = ABS_TIMER;
         }
         else if (timeout->QuadPart < 0)
         {
             LARGE_INTEGER rel_now;
             NtQueryPerformanceCounter( &rel_now, NULL );
             timestamp = rel_now.QuadPart - timeout->QuadPart;
-            pending_timers = &timerqueue.rel_timers;
+            type = REL_TIMER;
         }
         else if (!period)
         {
@@ -3114,7 +3791,7 @@ VOID WINAPI TpSetTimer( TP_TIMER *timer, LARGE_INTEGER *timeout, LONG period, LO
             LARGE_INTEGER rel_now;
             NtQueryPerformanceCounter( &rel_now, NULL );
             timestamp = rel_now.QuadPart + (ULONGLONG)period * 10000;
-            pending_timers = &timerqueue.rel_timers;
+            type = REL_TIMER;
             submit_timer = TRUE;
         }
     }
@@ -3122,35 +3799,26 @@ VOID WINAPI TpSetTimer( TP_TIMER *timer, LARGE_INTEGER *timeout, LONG period, LO
     /* First remove existing timeout. */
     if (this->u.timer.timer_pending)
     {
-        list_remove( &this->u.timer.timer_entry );
+        timer_wheel_remove( this->u.timer.timer_wheel, &this->u.timer.timer_entry );
         this->u.timer.timer_pending = FALSE;
     }
 
     /* If the timer was enabled, then add it back to the queue. */
     if (timeout)
     {
-        this->u.timer.timeout       = timestamp;
-        this->u.timer.period        = period;
-        this->u.timer.window_length = window_length;
+        next = get_next_timeout( type );
 
-        LIST_FOR_EACH_ENTRY( other_timer, pending_timers, struct threadpool_object,
-                             u.timer.timer_entry )
-        {
-            assert( other_timer->type == TP_OBJECT_TYPE_TIMER );
-            if (this->u.timer.timeout < other_timer->u.timer.timeout)
-                break;
-        }
-        list_add_before( &other_timer->u.timer.timer_entry, &this->u.timer.timer_entry );
+        this->u.timer.period = period;
+        this->u.timer.timer_entry.window = (ULONGLONG)window_length * 10000;
+        add_pending_timer( this, type, timestamp );
 
         /* Update timeout if needed. */
-        if (list_head( pending_timers ) == &this->u.timer.timer_entry )
+        if (get_next_timeout( type ) != next)
         {
             LARGE_INTEGER rel_now;
             NtQueryPerformanceCounter( &rel_now, NULL );
             update_timers( rel_now.QuadPart );
         }
-
-        this->u.timer.timer_pending = TRUE;
     }
 
     RtlLeaveCriticalSection( &timerqueue.cs );
@@ -3165,14 +3833,15 @@ VOID WINAPI TpSetTimer( TP_TIMER *timer, LARGE_INTEGER *timeout, LONG period, LO
 VOID WINAPI TpSetWait( TP_WAIT *wait, HANDLE handle, LARGE_INTEGER *timeout )
 {
     struct threadpool_object *this = impl_from_TP_WAIT( wait );
-    ULONGLONG timestamp = MAXLONGLONG;
+    ULONGLONG timestamp = MAXLONGLONG, interval = 0;
     BOOL same_handle;
+    NTSTATUS status;
 
     TRACE( "%p %p %p\n", wait, handle, timeout );
 
     RtlEnterCriticalSection( &waitqueue.cs );
 
-    assert( this->u.wait.bucket );
+    assert( this->u.wait.bucket || this->u.wait.packet );
 
     same_handle = this->u.wait.handle == handle;
     tp_wait_close_duped_handle( this );
@@ -3183,22 +3852,36 @@ VOID WINAPI TpSetWait( TP_WAIT *wait, HANDLE handle, LARGE_INTEGER *timeout )
     }
     this->u.wait.handle = handle;
 
-    if (handle || this->u.wait.wait_pending)
+    /* Convert relative timeout to absolute timestamp. */
+    if (handle && timeout)
     {
-        struct waitqueue_bucket *bucket = this->u.wait.bucket;
-        list_remove( &this->u.wait.wait_entry );
+        timestamp = timeout->QuadPart;
+        if ((LONGLONG)timestamp < 0)
+        {
+            LARGE_INTEGER now;
+            NtQuerySystemTime( &now );
+            timestamp = now.QuadPart - timestamp;
+            interval = -timeout->QuadPart;
+        }
+    }
 
-        /* Convert relative timeout to absolute timestamp. */
-        if (handle && timeout)
+    if (this->u.wait.packet && (handle || this->u.wait.wait_pending))
+    {
+        if (!same_handle)
+            ++this->update_serial;
+
+        status = tp_wait_packet_update( this, timestamp, interval );
+        if (status != STATUS_MORE_PROCESSING_REQUIRED)
         {
-            timestamp = timeout->QuadPart;
-            if ((LONGLONG)timestamp < 0)
-            {
-                LARGE_INTEGER now;
-                NtQuerySystemTime( &now );
-                timestamp = now.QuadPart - timestamp;
-            }
+            if (status) ERR( "failed to wait for %p, status %#lx\n", handle, status );
+            goto done;
         }
+    }
+
+    if (handle || this->u.wait.wait_pending)
+    {
+        struct waitqueue_bucket *bucket = this->u.wait.bucket;
+        list_remove( &this->u.wait.wait_entry );
 
         /* Add wait object back into one of the queues. */
         if (handle)
@@ -3219,6 +3902,7 @@ VOID WINAPI TpSetWait( TP_WAIT *wait, HANDLE handle, LARGE_INTEGER *timeout )
         NtSetEvent( bucket->update_event, NULL );
     }
 
+done:
     RtlLeaveCriticalSection( &waitqueue.cs );
 }
 
@@ -3261,11 +3945,11 @@ void WINAPI TpStartAsyncIoOperation( TP_IO *io )
 
     TRACE( "%p\n", io );
 
-    RtlEnterCriticalSection( &this->pool->cs );
+    RtlEnterCriticalSection( &this->queue->cs );
 
     this->u.io.pending_count++;
 
-    RtlLeaveCriticalSection( &this->pool->cs );
+    RtlLeaveCriticalSection( &this->queue->cs );
 }
 
 /***********************************************************************
@@ -3457,11 +4141,11 @@ NTSTATUS WINAPI RtlDeregisterWaitEx( HANDLE handle, HANDLE event )
         object->completed_event = event;
     }
 
-    RtlEnterCriticalSection( &object->pool->cs );
+    RtlEnterCriticalSection( &object->queue->cs );
     if (object->num_pending_callbacks + object->num_running_callbacks
         + object->num_associated_callbacks) status = STATUS_PENDING;
     else status = STATUS_SUCCESS;
-    RtlLeaveCriticalSection( &object->pool->cs );
+    RtlLeaveCriticalSection( &object->queue->cs );
 
     TpReleaseWait( (TP_WAIT *)object );
     return status;
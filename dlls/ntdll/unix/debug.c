@@ -25,13 +25,19 @@
 #include "config.h"
 
 #include <assert.h>
+#include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <sys/types.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include "ntstatus.h"
@@ -64,6 +70,37 @@ static struct __wine_debug_channel *debug_options;
 
 static const char * const debug_classes[] = { "fixme", "err", "warn", "trace" };
 
+/* binary debug log, enabled by setting WINEDEBUGLOG to a file name; the output of each thread
+ * is stored in a ring buffer that is drained to the file by a separate thread */
+
+#define DEBUG_LOG_MAGIC 0x47424457  /* "WDBG" */
+#define DEBUG_LOG_SIZE  (256 * 1024)
+
+struct debug_log_record
+{
+    unsigned int magic;  /* DEBUG_LOG_MAGIC */
+    unsigned int len;    /* length of the text following the record, which is padded to 8 bytes */
+    unsigned int pid;    /* process id */
+    unsigned int tid;    /* thread id */
+    ULONGLONG    time;   /* monotonic time in nanoseconds */
+};
+
+C_ASSERT( sizeof(struct debug_log_record) == 24 );
+
+struct debug_log
+{
+    struct debug_log *next;                 /* next buffer in the list */
+    LONG              owner;                /* id of the thread using the buffer, 0 if free */
+    LONG              lost;                 /* number of records dropped when the buffer was full */
+    LONG64            head;                 /* write position, only updated by the owner thread */
+    LONG64            tail;                 /* read position, only updated when draining */
+    char              data[DEBUG_LOG_SIZE];
+};
+
+static int debug_log_fd = -1;
+static struct debug_log *debug_logs;  /* list of all buffers, they are never freed */
+static pthread_mutex_t debug_log_mutex = PTHREAD_MUTEX_INITIALIZER;  /* serializes draining */
+
 /* get the debug info pointer for the current thread */
 static inline struct debug_info *get_info(void)
 {
@@ -187,7 +224,9 @@ static void debug_usage(void)
         "  WINEDEBUG=[[process:]class]+xxx,[[process:]class]-yyy,...\n\n"
         "Example: WINEDEBUG=+relay,warn-heap\n"
         "    turns on relay traces, disable heap warnings\n"
-        "Available message classes: err, warn, fixme, trace\n";
+        "Available message classes: err, warn, fixme, trace\n\n"
+        "Set WINEDEBUGLOG to a file name to store the output in binary form,\n"
+        "to be converted back to text with tools/decode-debuglog.\n";
     write( 2, usage, sizeof(usage) - 1 );
     exit(1);
 }
@@ -202,7 +241,7 @@ static void init_options(void)
     nb_debug_options = 0;
 
     /* check for stderr pointing to /dev/null */
-    if (!fstat( 2, &st1 ) && S_ISCHR(st1.st_mode) &&
+    if (!getenv( "WINEDEBUGLOG" ) && !fstat( 2, &st1 ) && S_ISCHR(st1.st_mode) &&
         !stat( "/dev/null", &st2 ) && S_ISCHR(st2.st_mode) &&
         st1.st_rdev == st2.st_rdev)
     {
@@ -267,6 +306,218 @@ const char * __cdecl __wine_dbg_strdup( const char *str )
     return memcpy( info->strings + pos, str, n );
 }
 
+/* copy data into a log buffer, wrapping around at the end */
+static void copy_to_debug_log( struct debug_log *log, LONG64 pos, const void *data, unsigned int len )
+{
+    unsigned int start = pos % DEBUG_LOG_SIZE, count = min( len, DEBUG_LOG_SIZE - start );
+
+    memcpy( log->data + start, data, count );
+    memcpy( log->data, (const char *)data + count, len - count );
+}
+
+/* get the log buffer of the current thread, allocating it if needed */
+static struct debug_log *get_debug_log( struct thread_data *data )
+{
+    struct debug_log *log;
+
+    if ((log = data->debug_log)) return log;
+
+    /* reuse the buffer of a thread that has exited */
+    for (log = ReadPointerAcquire( (void **)&debug_logs ); log; log = log->next)
+        if (!log->owner && !InterlockedCompareExchange( &log->owner, data->tid, 0 )) break;
+
+    if (!log)
+    {
+        if ((log = anon_mmap_alloc( sizeof(*log), PROT_READ | PROT_WRITE )) == MAP_FAILED) return NULL;
+        log->owner = data->tid;
+        do log->next = ReadPointerAcquire( (void **)&debug_logs );
+        while (InterlockedCompareExchangePointer( (void **)&debug_logs, log, log->next ) != log->next);
+    }
+    return data->debug_log = log;
+}
+
+/* append a record to the log buffer of the current thread */
+static void write_debug_log( struct debug_log *log, DWORD tid, const char *str, unsigned int len )
+{
+    struct debug_log_record record;
+    struct timespec ts;
+    LONG64 head = log->head;
+    unsigned int size = sizeof(record) + ((len + 7) & ~7);
+
+    if (size > DEBUG_LOG_SIZE - (head - ReadAcquire64( &log->tail )))
+    {
+        InterlockedIncrement( &log->lost );
+        return;
+    }
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    record.magic = DEBUG_LOG_MAGIC;
+    record.len   = len;
+    record.pid   = pid;
+    record.tid   = tid;
+    record.time  = ts.tv_sec * (ULONGLONG)1000000000 + ts.tv_nsec;
+    copy_to_debug_log( log, head, &record, sizeof(record) );
+    copy_to_debug_log( log, head + sizeof(record), str, len );
+    WriteRelease64( &log->head, head + size );
+}
+
+/* write the contents of all the log buffers to the log file, debug_log_mutex must be held */
+static void drain_debug_logs_locked(void)
+{
+    struct debug_log *log;
+    struct iovec iov[2];
+    LONG64 head, tail;
+    unsigned int start;
+    LONG lost;
+
+    for (log = ReadPointerAcquire( (void **)&debug_logs ); log; log = log->next)
+    {
+        head = ReadAcquire64( &log->head );
+        tail = log->tail;
+        if (head != tail)
+        {
+            /* records are only appended once complete, so the file never contains partial ones */
+            start = tail % DEBUG_LOG_SIZE;
+            iov[0].iov_base = log->data + start;
+            iov[0].iov_len  = min( head - tail, DEBUG_LOG_SIZE - start );
+            iov[1].iov_base = log->data;
+            iov[1].iov_len  = head - tail - iov[0].iov_len;
+            writev( debug_log_fd, iov, 2 );
+            WriteRelease64( &log->tail, head );
+        }
+        if ((lost = InterlockedExchange( &log->lost, 0 )))
+        {
+            struct
+            {
+                struct debug_log_record record;
+                char text[64];
+            } msg;
+            struct timespec ts;
+
+            memset( &msg, 0, sizeof(msg) );
+            clock_gettime( CLOCK_MONOTONIC, &ts );
+            msg.record.magic = DEBUG_LOG_MAGIC;
+            msg.record.len   = snprintf( msg.text, sizeof(msg.text), "%04x:debug log: %d records lost\n",
+                                         (int)log->owner, (int)lost );
+            msg.record.pid   = pid;
+            msg.record.tid   = log->owner;
+            msg.record.time  = ts.tv_sec * (ULONGLONG)1000000000 + ts.tv_nsec;
+            write( debug_log_fd, &msg, sizeof(msg.record) + ((msg.record.len + 7) & ~7) );
+        }
+    }
+}
+
+/* write the contents of all the log buffers to the log file */
+static void drain_debug_logs(void)
+{
+    pthread_mutex_lock( &debug_log_mutex );
+    drain_debug_logs_locked();
+    pthread_mutex_unlock( &debug_log_mutex );
+}
+
+/***********************************************************************
+ *		flush_debug_log
+ *
+ * Write out the pending debug log records before the process is terminated.
+ */
+void flush_debug_log(void)
+{
+    if (debug_log_fd != -1) drain_debug_logs();
+}
+
+/* handler for the signals that terminate the process by default */
+static void debug_log_signal_handler( int sig )
+{
+    struct timespec ts = { 0, 1000000 };
+    int i;
+
+    /* the draining thread may be holding the mutex, but don't wait forever
+     * in case this thread was interrupted while draining */
+    for (i = 0; i < 100; i++)
+    {
+        if (!pthread_mutex_trylock( &debug_log_mutex ))
+        {
+            drain_debug_logs_locked();
+            pthread_mutex_unlock( &debug_log_mutex );
+            break;
+        }
+        nanosleep( &ts, NULL );
+    }
+    signal( sig, SIG_DFL );
+    raise( sig );
+}
+
+/* thread draining the log buffers */
+static void *debug_log_thread( void *arg )
+{
+    for (;;)
+    {
+        drain_debug_logs();
+        usleep( 10000 );
+    }
+    return NULL;
+}
+
+/* open the binary log file and start the thread writing to it */
+static void init_debug_log( const char *name )
+{
+    pthread_attr_t attr;
+    pthread_t thread;
+    sigset_t sigset, old_sigset;
+
+    if ((debug_log_fd = open( name, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0666 )) == -1)
+    {
+        fprintf( stderr, "wine: failed to open debug log %s: %s\n", name, strerror( errno ));
+        return;
+    }
+
+    /* the thread doesn't have a TEB, make sure it never handles any signal */
+    sigfillset( &sigset );
+    pthread_sigmask( SIG_SETMASK, &sigset, &old_sigset );
+    pthread_attr_init( &attr );
+    pthread_attr_setdetachstate( &attr, PTHREAD_CREATE_DETACHED );
+    pthread_attr_setstacksize( &attr, 0x10000 );
+    if (pthread_create( &thread, &attr, debug_log_thread, NULL ))
+    {
+        close( debug_log_fd );
+        debug_log_fd = -1;
+    }
+    else
+    {
+        atexit( drain_debug_logs );
+        signal( SIGTERM, debug_log_signal_handler );
+        signal( SIGHUP, debug_log_signal_handler );
+    }
+    pthread_attr_destroy( &attr );
+    pthread_sigmask( SIG_SETMASK, &old_sigset, NULL );
+}
+
+/* write a line of debug output */
+static int dbg_write( const char *str, unsigned int len )
+{
+    struct thread_data *data;
+    struct debug_log *log;
+
+    if (debug_log_fd == -1 || !init_done) return write( 2, str, len );
+    if (!(data = get_thread_data()) || !(log = get_debug_log( data ))) return write( 2, str, len );
+    write_debug_log( log, data->tid, str, len );
+    return len;
+}
+
+/***********************************************************************
+ *		dbg_thread_exit
+ *
+ * Release the log buffer of the current thread.
+ */
+void dbg_thread_exit(void)
+{
+    struct thread_data *data = get_thread_data();
+    struct debug_log *log = data->debug_log;
+
+    if (!log) return;
+    data->debug_log = NULL;
+    InterlockedExchange( &log->owner, 0 );
+}
+
 /***********************************************************************
  *		unixcall_wine_dbg_write
  */
@@ -274,7 +525,7 @@ NTSTATUS unixcall_wine_dbg_write( void *args )
 {
     struct wine_dbg_write_params *params = args;
 
-    return write( 2, params->str, params->len );
+    return dbg_write( params->str, params->len );
 }
 
 #ifdef _WIN64
@@ -289,7 +540,7 @@ NTSTATUS wow64_wine_dbg_write( void *args )
         unsigned int len;
     } const *params32 = args;
 
-    return write( 2, ULongToPtr(params32->str), params32->len );
+    return dbg_write( ULongToPtr(params32->str), params32->len );
 }
 #endif
 
@@ -305,7 +556,7 @@ int __cdecl __wine_dbg_output( const char *str )
     if (end)
     {
         ret += append_output( info, str, end + 1 - str );
-        write( 2, info->output, info->out_pos );
+        dbg_write( info->output, info->out_pos );
         info->out_pos = 0;
         str = end + 1;
     }
@@ -351,6 +602,7 @@ int __cdecl __wine_dbg_header( enum __wine_debug_class cls, struct __wine_debug_
 void dbg_init(void)
 {
     struct __wine_debug_channel *options, default_option = { default_flags };
+    const char *log_name = getenv( "WINEDEBUGLOG" );
 
     setbuf( stdout, NULL );
     setbuf( stderr, NULL );
@@ -362,6 +614,7 @@ void dbg_init(void)
     free( debug_options );
     debug_options = options;
     options[nb_debug_options] = default_option;
+    if (log_name && *log_name) init_debug_log( log_name );
     init_done = TRUE;
 }
 
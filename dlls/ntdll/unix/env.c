@@ -163,7 +163,7 @@ static NTSTATUS open_nls_data_file( const char *path, const WCHAR *sysdir, HANDL
     InitializeObjectAttributes( &attr, &valueW, 0, 0, NULL );
 
     status = open_unix_file( file, path, GENERIC_READ, &attr, 0, FILE_SHARE_READ,
-                             FILE_OPEN, FILE_SYNCHRONOUS_IO_ALERT, NULL, 0 );
+                             FILE_OPEN, FILE_SYNCHRONOUS_IO_ALERT, NULL, 0, FALSE );
     if (status != STATUS_NO_SUCH_FILE) return status;
 
     return NtOpenFile( file, GENERIC_READ, &attr, &io, FILE_SHARE_READ, FILE_SYNCHRONOUS_IO_ALERT );
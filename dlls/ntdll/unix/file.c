@@ -99,6 +99,10 @@
 #ifdef HAVE_SYS_XATTR_H
 #include <sys/xattr.h>
 #endif
+#if defined(HAVE_SYS_INOTIFY_H) && defined(__linux__)
+#include <sys/inotify.h>
+#define USE_DIR_LISTING_CACHE
+#endif
 #ifdef HAVE_SYS_EXTATTR_H
 #undef XATTR_ADDITIONAL_OPTIONS
 #include <sys/extattr.h>
@@ -255,6 +259,48 @@ static const BOOL is_case_sensitive = FALSE;
 static pthread_mutex_t dir_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_mutex_t mnt_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+#ifdef USE_DIR_LISTING_CACHE
+
+/* cache of directory listings used for case-insensitive lookups, kept up to date with inotify,
+ * and revalidated against the directory mtime in case a change was missed. A process uses a
+ * single inotify instance (counted against fs.inotify.max_user_instances) holding at most one
+ * watch per cached listing; the cache is disabled if the instance cannot be created. */
+
+struct dir_listing_entry
+{
+    unsigned int   next;         /* index of the next entry in the hash chain, plus one */
+    unsigned int   hash;         /* hash of the upper-cased Unicode name */
+    unsigned int   name;         /* offset of the Unicode name in the data buffer */
+    unsigned int   unix_name;    /* offset of the Unix name in the data buffer */
+    unsigned short len;          /* length of the Unicode name */
+};
+
+struct dir_listing
+{
+    dev_t                     dev;        /* device of the directory */
+    ino_t                     ino;        /* inode of the directory */
+    struct timespec           mtime;      /* modification time of the directory */
+    int                       wd;         /* inotify watch descriptor */
+    unsigned int              last_use;   /* last use of the entry, for eviction */
+    unsigned int              hash_size;  /* size of the hash table (power of 2) */
+    unsigned int             *hash;       /* index of the first entry of each chain, plus one */
+    struct dir_listing_entry *entries;    /* directory entries */
+    char                     *data;       /* buffer for the names */
+};
+
+#define DIR_LISTING_CACHE_SIZE 32
+#define DIR_LISTING_UNSUPPORTED_DEVS 4
+
+static struct dir_listing *dir_listings[DIR_LISTING_CACHE_SIZE];
+static dev_t dir_listing_unsupported_devs[DIR_LISTING_UNSUPPORTED_DEVS];  /* filesystems we can't watch */
+static unsigned int dir_listing_unsupported_count;
+static unsigned int dir_listing_use;
+static int dir_listing_inotify = -1;
+static BOOL dir_listing_disabled;
+static pthread_mutex_t dir_listing_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+#endif  /* USE_DIR_LISTING_CACHE */
+
 /* check if a given Unicode char is OK in a DOS short name */
 static inline BOOL is_invalid_dos_char( WCHAR ch )
 {
@@ -2988,6 +3034,261 @@ NTSTATUS WINAPI NtQueryDirectoryFile( HANDLE handle, HANDLE event, PIO_APC_ROUTI
 }
 
 
+#ifdef USE_DIR_LISTING_CACHE
+
+static unsigned int hash_dir_listing_name( const WCHAR *name, int length )
+{
+    unsigned int hash = 0;
+
+    while (length--) hash = hash * 31 + towupper( *name++ );
+    return hash;
+}
+
+/* free a cached listing, the directory mutex must be held */
+static void free_dir_listing( unsigned int index )
+{
+    struct dir_listing *listing = dir_listings[index];
+
+    inotify_rm_watch( dir_listing_inotify, listing->wd );
+    free( listing->hash );
+    free( listing->entries );
+    free( listing->data );
+    free( listing );
+    dir_listings[index] = NULL;
+}
+
+/* process the pending inotify events, the directory mutex must be held */
+static void update_dir_listings(void)
+{
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    const struct inotify_event *event;
+    unsigned int i;
+    ssize_t ret;
+    char *ptr;
+
+    while ((ret = read( dir_listing_inotify, buffer, sizeof(buffer) )) > 0 || (ret == -1 && errno == EINTR))
+    {
+        for (ptr = buffer; ptr < buffer + ret; ptr += sizeof(*event) + event->len)
+        {
+            event = (const struct inotify_event *)ptr;
+            for (i = 0; i < DIR_LISTING_CACHE_SIZE; i++)
+            {
+                if (!dir_listings[i]) continue;
+                if ((event->mask & IN_Q_OVERFLOW) || dir_listings[i]->wd == event->wd)
+                    free_dir_listing( i );
+            }
+        }
+    }
+}
+
+/* inotify doesn't report changes made by other hosts or through userspace filesystems */
+static BOOL dir_listing_fs_supported( int fd )
+{
+    struct statfs stfs;
+
+    if (fstatfs( fd, &stfs ) == -1) return FALSE;
+    switch ((unsigned int)stfs.f_type)
+    {
+    case 0x6969:      /* nfs */
+    case 0xff534d42:  /* cifs */
+    case 0xfe534d42:  /* smb2 */
+    case 0x517b:      /* smbfs */
+    case 0x564c:      /* ncpfs */
+    case 0x65735546:  /* fuse */
+    case 0x01021997:  /* 9p */
+    case 0x5346414f:  /* afs */
+    case 0x00c36400:  /* ceph */
+        return FALSE;
+    default:
+        return TRUE;
+    }
+}
+
+/* read a directory into a new cached listing, the directory mutex must be held */
+static struct dir_listing *read_dir_listing( int root_fd, const char *unix_name, const struct stat *st )
+{
+    WCHAR buffer[MAX_DIR_ENTRY_LEN];
+    struct dir_listing *listing;
+    struct dir_listing_entry *entry;
+    unsigned int i, count = 0, size = 64, data_pos = 0, data_size = 4096;
+    char path[32];
+    struct dirent *de;
+    struct stat dir_st;
+    DIR *dir;
+    int fd, ret, unix_len;
+
+    if ((fd = openat( root_fd, unix_name, O_RDONLY | O_DIRECTORY )) == -1) return NULL;
+    if (fstat( fd, &dir_st ) == -1 || dir_st.st_dev != st->st_dev || dir_st.st_ino != st->st_ino)
+    {
+        close( fd );
+        return NULL;
+    }
+    if (!dir_listing_fs_supported( fd ))
+    {
+        i = dir_listing_unsupported_count++ % DIR_LISTING_UNSUPPORTED_DEVS;
+        dir_listing_unsupported_devs[i] = st->st_dev;
+        close( fd );
+        return NULL;
+    }
+    if (!(dir = fdopendir( fd )))
+    {
+        close( fd );
+        return NULL;
+    }
+    if (!(listing = calloc( 1, sizeof(*listing) ))) goto failed;
+    listing->dev = st->st_dev;
+    listing->ino = st->st_ino;
+    listing->mtime = dir_st.st_mtim;
+
+    /* the watch must be in place before reading the directory, so that we don't miss any change */
+    snprintf( path, sizeof(path), "/proc/self/fd/%d", fd );
+    listing->wd = inotify_add_watch( dir_listing_inotify, path, IN_CREATE | IN_DELETE | IN_MOVED_FROM |
+                                     IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR );
+    if (listing->wd == -1) goto failed;
+
+    if (!(listing->entries = malloc( size * sizeof(*listing->entries) ))) goto failed;
+    if (!(listing->data = malloc( data_size ))) goto failed;
+
+    while ((de = readdir( dir )))
+    {
+        ret = ntdll_umbstowcs( de->d_name, strlen(de->d_name), buffer, MAX_DIR_ENTRY_LEN );
+        unix_len = strlen( de->d_name ) + 1;
+        if (count == size)
+        {
+            struct dir_listing_entry *new_entries;
+            if (!(new_entries = realloc( listing->entries, 2 * size * sizeof(*new_entries) ))) goto failed;
+            listing->entries = new_entries;
+            size *= 2;
+        }
+        while (data_pos + ret * sizeof(WCHAR) + unix_len > data_size)
+        {
+            char *new_data;
+            if (!(new_data = realloc( listing->data, 2 * data_size ))) goto failed;
+            listing->data = new_data;
+            data_size *= 2;
+        }
+        entry = &listing->entries[count++];
+        entry->hash = hash_dir_listing_name( buffer, ret );
+        entry->len = ret;
+        entry->name = data_pos;
+        memcpy( listing->data + data_pos, buffer, ret * sizeof(WCHAR) );
+        data_pos += ret * sizeof(WCHAR);
+        entry->unix_name = data_pos;
+        memcpy( listing->data + data_pos, de->d_name, unix_len );
+        data_pos = (data_pos + unix_len + sizeof(WCHAR) - 1) & ~(sizeof(WCHAR) - 1);
+    }
+    closedir( dir );
+    dir = NULL;
+
+    for (listing->hash_size = 16; listing->hash_size < count; listing->hash_size *= 2) ;
+    if (!(listing->hash = calloc( listing->hash_size, sizeof(*listing->hash) ))) goto failed;
+    for (i = 0; i < count; i++)
+    {
+        unsigned int *head = &listing->hash[listing->entries[i].hash & (listing->hash_size - 1)];
+        listing->entries[i].next = *head;
+        *head = i + 1;
+    }
+    return listing;
+
+failed:
+    if (dir) closedir( dir );
+    if (listing)
+    {
+        if (listing->wd != -1) inotify_rm_watch( dir_listing_inotify, listing->wd );
+        free( listing->entries );
+        free( listing->data );
+        free( listing );
+    }
+    return NULL;
+}
+
+/* get the cached listing of a directory, the directory mutex must be held */
+static struct dir_listing *get_dir_listing( int root_fd, const char *unix_name )
+{
+    struct dir_listing *listing;
+    struct stat st;
+    unsigned int i, free_index = 0;
+
+    if (dir_listing_disabled) return NULL;
+    if (dir_listing_inotify == -1 &&
+        (dir_listing_inotify = inotify_init1( IN_NONBLOCK | IN_CLOEXEC )) == -1)
+    {
+        WARN( "inotify not available, not caching directory listings\n" );
+        dir_listing_disabled = TRUE;
+        return NULL;
+    }
+    if (fstatat( root_fd, unix_name, &st, 0 ) == -1) return NULL;
+    for (i = 0; i < min( dir_listing_unsupported_count, DIR_LISTING_UNSUPPORTED_DEVS ); i++)
+        if (dir_listing_unsupported_devs[i] == st.st_dev) return NULL;
+
+    update_dir_listings();
+
+    for (i = 0; i < DIR_LISTING_CACHE_SIZE; i++)
+    {
+        if (!dir_listings[i])
+        {
+            free_index = i;
+            continue;
+        }
+        if (dir_listings[i]->dev == st.st_dev && dir_listings[i]->ino == st.st_ino)
+        {
+            if (dir_listings[i]->mtime.tv_sec != st.st_mtim.tv_sec ||
+                dir_listings[i]->mtime.tv_nsec != st.st_mtim.tv_nsec)
+            {
+                /* changed without an inotify event reaching us yet */
+                free_dir_listing( i );
+                free_index = i;
+                break;
+            }
+            dir_listings[i]->last_use = ++dir_listing_use;
+            return dir_listings[i];
+        }
+        if (dir_listings[free_index] && dir_listings[i]->last_use < dir_listings[free_index]->last_use)
+            free_index = i;
+    }
+
+    /* don't evict anything if the directory can't be cached */
+    if (!(listing = read_dir_listing( root_fd, unix_name, &st ))) return NULL;
+    if (dir_listings[free_index]) free_dir_listing( free_index );
+    dir_listings[free_index] = listing;
+    listing->last_use = ++dir_listing_use;
+    return listing;
+}
+
+/***********************************************************************
+ *           find_file_in_dir_listing
+ *
+ * Find a file using the cached listing of the directory.
+ * Returns STATUS_NOT_SUPPORTED if the listing cannot be cached.
+ */
+static NTSTATUS find_file_in_dir_listing( int root_fd, char *unix_name, int pos, const WCHAR *name, int length )
+{
+    const struct dir_listing_entry *entry;
+    struct dir_listing *listing;
+    unsigned int index, hash = hash_dir_listing_name( name, length );
+    NTSTATUS status = STATUS_NOT_SUPPORTED;
+
+    mutex_lock( &dir_listing_mutex );
+    if ((listing = get_dir_listing( root_fd, unix_name )))
+    {
+        status = STATUS_OBJECT_NAME_NOT_FOUND;
+        for (index = listing->hash[hash & (listing->hash_size - 1)]; index; index = entry->next)
+        {
+            entry = &listing->entries[index - 1];
+            if (entry->hash != hash || entry->len != length) continue;
+            if (wcsnicmp( (const WCHAR *)(listing->data + entry->name), name, length )) continue;
+            unix_name[pos - 1] = '/';
+            strcpy( unix_name + pos, listing->data + entry->unix_name );
+            status = STATUS_SUCCESS;
+            break;
+        }
+    }
+    mutex_unlock( &dir_listing_mutex );
+    return status;
+}
+
+#endif  /* USE_DIR_LISTING_CACHE */
+
 /***********************************************************************
  *           find_file_in_dir
  *
@@ -3078,6 +3379,17 @@ static NTSTATUS find_file_in_dir( int root_fd, char *unix_name, int pos, const W
     }
 #endif /* VFAT_IOCTL_READDIR_BOTH */
 
+#ifdef USE_DIR_LISTING_CACHE
+    /* the cache only contains long names, and hashed short names always contain a '~' */
+    for (ret = 0; ret < length; ret++) if (name[ret] == '~') break;
+    if (!is_name_8_dot_3 || ret == length)
+    {
+        NTSTATUS status = find_file_in_dir_listing( root_fd, unix_name, pos, name, length );
+        if (status == STATUS_SUCCESS) return status;
+        if (status == STATUS_OBJECT_NAME_NOT_FOUND) goto not_found;
+    }
+#endif
+
     if ((fd = openat( root_fd, unix_name, O_RDONLY )) == -1) return errno_to_status( errno );
     if (!(dir = fdopendir( fd )))
     {
@@ -4612,17 +4924,21 @@ static NTSTATUS unmount_device( HANDLE handle )
  *              open_unix_file
  *
  * Helper for NtCreateFile that takes a Unix path.
+ * If want_fd is set, the unix fd is received along with the handle and cached.
  */
 NTSTATUS open_unix_file( HANDLE *handle, const char *unix_name, ACCESS_MASK access,
                          OBJECT_ATTRIBUTES *attr, ULONG attributes, ULONG sharing, ULONG disposition,
-                         ULONG options, void *ea_buffer, ULONG ea_length )
+                         ULONG options, void *ea_buffer, ULONG ea_length, BOOL want_fd )
 {
     struct object_attributes *objattr;
     unsigned int status;
     data_size_t len;
+    sigset_t sigset;
 
     if ((status = alloc_object_attributes( attr, &objattr, &len ))) return status;
 
+    /* the fd must be received once it has been sent, so don't let signals interrupt us */
+    if (want_fd) pthread_sigmask( SIG_BLOCK, &server_block_set, &sigset );
     SERVER_START_REQ( create_file )
     {
         req->access     = access;
@@ -4630,12 +4946,16 @@ NTSTATUS open_unix_file( HANDLE *handle, const char *unix_name, ACCESS_MASK acce
         req->create     = disposition;
         req->options    = options;
         req->attrs      = attributes;
+        req->want_fd    = want_fd;
         wine_server_add_data( req, objattr, len );
         wine_server_add_data( req, unix_name, strlen(unix_name) );
         status = wine_server_call( req );
         *handle = wine_server_ptr_handle( reply->handle );
+        if (reply->type != FD_TYPE_INVALID)
+            server_receive_cacheable_fd( *handle, reply->type, reply->access, reply->options );
     }
     SERVER_END_REQ;
+    if (want_fd) pthread_sigmask( SIG_SETMASK, &sigset, NULL );
     free( objattr );
     return status;
 }
@@ -4693,7 +5013,7 @@ NTSTATUS WINAPI NtCreateFile( HANDLE *handle, ACCESS_MASK access, OBJECT_ATTRIBU
     {
         name_hidden = is_hidden_file( unix_name );
         status = open_unix_file( handle, unix_name, access, &new_attr, attributes,
-                                 sharing, disposition, options, ea_buffer, ea_length );
+                                 sharing, disposition, options, ea_buffer, ea_length, TRUE );
     }
     else WARN( "%s not found (%x)\n", debugstr_us(attr->ObjectName), status );
 
@@ -4859,7 +5179,7 @@ NTSTATUS WINAPI NtDeleteFile( OBJECT_ATTRIBUTES *attr )
     {
         if (!(status = open_unix_file( &handle, unix_name, GENERIC_READ | GENERIC_WRITE | DELETE, &new_attr,
                                        0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, FILE_OPEN,
-                                       FILE_DELETE_ON_CLOSE, NULL, 0 )))
+                                       FILE_DELETE_ON_CLOSE, NULL, 0, FALSE )))
             NtClose( handle );
     }
     free( unix_name );
@@ -271,7 +271,7 @@ static unsigned int get_pe_file_info( OBJECT_ATTRIBUTES *attr, UNICODE_STRING *n
     {
         status = open_unix_file( handle, *unix_name, GENERIC_READ, attr, 0,
                                  FILE_SHARE_READ | FILE_SHARE_DELETE,
-                                 FILE_OPEN, FILE_SYNCHRONOUS_IO_NONALERT, NULL, 0 );
+                                 FILE_OPEN, FILE_SYNCHRONOUS_IO_NONALERT, NULL, 0, FALSE );
     }
     if (status)
     {
@@ -355,7 +355,7 @@ static int get_unix_curdir( const RTL_USER_PROCESS_PARAMETERS *params )
     if (status) goto done;
     status = open_unix_file( &handle, unix_name, FILE_TRAVERSE | SYNCHRONIZE, &attr, 0,
                              FILE_SHARE_READ | FILE_SHARE_DELETE,
-                             FILE_OPEN, FILE_SYNCHRONOUS_IO_NONALERT, NULL, 0 );
+                             FILE_OPEN, FILE_SYNCHRONOUS_IO_NONALERT, NULL, 0, TRUE );
     if (status) goto done;
     wine_server_handle_to_fd( handle, FILE_TRAVERSE, &fd, NULL );
     NtClose( handle );
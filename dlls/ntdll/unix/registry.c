@@ -38,6 +38,193 @@ WINE_DEFAULT_DEBUG_CHANNEL(reg);
 /* maximum length of a value name in bytes (without terminating null) */
 #define MAX_VALUE_LENGTH (16383 * sizeof(WCHAR))
 
+/* Small values are cached per key handle, and validated against the key serials that the
+ * server publishes in the session mapping, so that repeated queries don't need a server call.
+ * The cache is organized in sets indexed by handle, so that closing a handle is cheap.
+ * The server also bumps the serial of a key when one of its handles is closed, so that an
+ * entry filled for a handle value that was closed and reused in the meantime can't match. */
+
+#define KEY_VALUE_CACHE_SETS     64   /* number of sets, must be a power of 2 */
+#define KEY_VALUE_CACHE_WAYS     8    /* number of entries per set, must be a power of 2 */
+#define KEY_VALUE_CACHE_MAX_NAME 32   /* max. length of a cached value name in WCHARs */
+#define KEY_VALUE_CACHE_MAX_DATA 128  /* max. size of cached value data in bytes */
+
+struct key_value_cache_entry
+{
+    LONG          seq;        /* sequence number, odd while the entry is being updated */
+    HANDLE        key;        /* key handle, NULL if the entry is unused */
+    unsigned int  slot;       /* index of the key serial in the session mapping */
+    LONG64        serial;     /* key serial at the time the value was retrieved */
+    unsigned int  status;     /* STATUS_SUCCESS or STATUS_OBJECT_NAME_NOT_FOUND */
+    int           type;       /* value type */
+    data_size_t   total;      /* value data size */
+    USHORT        name_len;   /* value name length in bytes */
+    WCHAR         name[KEY_VALUE_CACHE_MAX_NAME];
+    BYTE          data[KEY_VALUE_CACHE_MAX_DATA];
+};
+
+static struct key_value_cache_entry key_value_cache[KEY_VALUE_CACHE_SETS][KEY_VALUE_CACHE_WAYS];
+static const volatile LONG64 *registry_serials;  /* serials in the session mapping */
+static LONG registry_serials_init;  /* non-zero once we tried to map the serials */
+static pthread_mutex_t key_value_cache_mutex = PTHREAD_MUTEX_INITIALIZER;  /* serializes cache updates */
+
+
+static struct key_value_cache_entry *get_key_value_cache_set( HANDLE key )
+{
+    return key_value_cache[((ULONG_PTR)key >> 2) & (KEY_VALUE_CACHE_SETS - 1)];
+}
+
+static struct key_value_cache_entry *get_key_value_cache_entry( HANDLE key, const UNICODE_STRING *name )
+{
+    unsigned int i, hash = 0;
+
+    for (i = 0; i < name->Length / sizeof(WCHAR); i++) hash = hash * 31 + name->Buffer[i];
+    return &get_key_value_cache_set( key )[hash & (KEY_VALUE_CACHE_WAYS - 1)];
+}
+
+/* map the key serials published by the server; fails if the session isn't available */
+static const volatile LONG64 *map_registry_serials(void)
+{
+    static const WCHAR nameW[] =
+    {
+        '\\','K','e','r','n','e','l','O','b','j','e','c','t','s','\\',
+        '_','_','w','i','n','e','_','s','e','s','s','i','o','n',0
+    };
+    UNICODE_STRING name;
+    OBJECT_ATTRIBUTES attr;
+    LARGE_INTEGER offset = {{0}};
+    SIZE_T size = sizeof(session_shm_t);
+    const session_shm_t *session = NULL;
+    HANDLE handle;
+
+    if (InterlockedExchange( &registry_serials_init, 1 )) return registry_serials;
+
+    init_unicode_string( &name, nameW );
+    InitializeObjectAttributes( &attr, &name, 0, NULL, NULL );
+    if (NtOpenSection( &handle, SECTION_MAP_READ, &attr )) return NULL;
+    if (!NtMapViewOfSection( handle, NtCurrentProcess(), (void **)&session, 0, 0, &offset, &size,
+                             ViewUnmap, 0, PAGE_READONLY ))
+        registry_serials = session->registry_serials;
+    else
+        WARN( "failed to map the session, not caching key values\n" );
+    NtClose( handle );
+    return registry_serials;
+}
+
+/* look for a value in the cache, and copy it if the key serial shows it's still valid */
+static BOOL get_cached_key_value( HANDLE key, const UNICODE_STRING *name, void *data, DWORD size,
+                                  unsigned int *status, int *type, data_size_t *total )
+{
+    struct key_value_cache_entry *entry;
+    LONG seq;
+
+    if (!registry_serials || name->Length > sizeof(entry->name)) return FALSE;
+
+    entry = get_key_value_cache_entry( key, name );
+    if ((seq = ReadAcquire( &entry->seq )) & 1) return FALSE;
+    if (entry->key != key || entry->name_len != name->Length) return FALSE;
+    if (memcmp( entry->name, name->Buffer, name->Length )) return FALSE;
+    if (registry_serials[entry->slot % REGISTRY_SERIAL_COUNT] != entry->serial) return FALSE;
+
+    *status = entry->status;
+    *type   = entry->type;
+    *total  = entry->total;
+    /* the entry may be modified concurrently, don't trust its size until seq is checked */
+    if (data) memcpy( data, entry->data, min( size, min( entry->total, sizeof(entry->data) )));
+
+    MemoryBarrier();
+    return ReadNoFence( &entry->seq ) == seq;
+}
+
+static void cache_key_value( HANDLE key, const UNICODE_STRING *name, const void *data,
+                             unsigned int status, int type, data_size_t total,
+                             unsigned int slot, LONG64 serial )
+{
+    struct key_value_cache_entry *entry = get_key_value_cache_entry( key, name );
+    sigset_t sigset;
+
+    server_enter_uninterrupted_section( &key_value_cache_mutex, &sigset );
+    WriteRelease( &entry->seq, entry->seq + 1 );
+    entry->key      = key;
+    entry->slot     = slot % REGISTRY_SERIAL_COUNT;
+    entry->serial   = serial;
+    entry->status   = status;
+    entry->type     = type;
+    entry->total    = total;
+    entry->name_len = name->Length;
+    memcpy( entry->name, name->Buffer, name->Length );
+    memcpy( entry->data, data, total );
+    WriteRelease( &entry->seq, entry->seq + 1 );
+    server_leave_uninterrupted_section( &key_value_cache_mutex, &sigset );
+}
+
+/* caller must have signals blocked */
+void close_key_value_cache( HANDLE key )
+{
+    struct key_value_cache_entry *set = get_key_value_cache_set( key );
+    unsigned int i;
+
+    if (!registry_serials) return;
+
+    mutex_lock( &key_value_cache_mutex );
+    for (i = 0; i < KEY_VALUE_CACHE_WAYS; i++)
+    {
+        if (set[i].key != key) continue;
+        WriteRelease( &set[i].seq, set[i].seq + 1 );
+        set[i].key = NULL;
+        WriteRelease( &set[i].seq, set[i].seq + 1 );
+    }
+    mutex_unlock( &key_value_cache_mutex );
+}
+
+/* retrieve a value from the server, and add it to the cache if possible */
+static unsigned int query_key_value( HANDLE key, const UNICODE_STRING *name, void *data, DWORD size,
+                                     int *type, data_size_t *total )
+{
+    BYTE buffer[KEY_VALUE_CACHE_MAX_DATA];
+    void *ptr = data;
+    unsigned int ret, slot;
+    LONG64 serial;
+
+    if (!map_registry_serials() || name->Length > KEY_VALUE_CACHE_MAX_NAME * sizeof(WCHAR))
+    {
+        SERVER_START_REQ( get_key_value )
+        {
+            req->hkey = wine_server_obj_handle( key );
+            wine_server_add_data( req, name->Buffer, name->Length );
+            if (size) wine_server_set_reply( req, data, size );
+            ret = wine_server_call( req );
+            *type  = reply->type;
+            *total = reply->total;
+        }
+        SERVER_END_REQ;
+        return ret;
+    }
+
+    /* retrieve small values in full, even if the caller's buffer is too small to hold them */
+    if (size < sizeof(buffer)) ptr = buffer;
+
+    SERVER_START_REQ( get_key_value )
+    {
+        req->hkey = wine_server_obj_handle( key );
+        wine_server_add_data( req, name->Buffer, name->Length );
+        wine_server_set_reply( req, ptr, ptr == buffer ? sizeof(buffer) : size );
+        ret = wine_server_call( req );
+        *type  = reply->type;
+        *total = reply->total;
+        slot   = reply->serial_slot;
+        serial = reply->serial;
+        if (!ret && ptr == buffer && data) memcpy( data, buffer, min( size, wine_server_reply_size( reply )));
+    }
+    SERVER_END_REQ;
+
+    /* if the handle was closed in the meantime, the server bumped the serial
+     * after returning it to us, so the entry won't ever be used */
+    if (ret == STATUS_OBJECT_NAME_NOT_FOUND || (!ret && *total <= sizeof(buffer)))
+        cache_key_value( key, name, ptr, ret, *type, ret ? 0 : *total, slot, serial );
+    return ret;
+}
+
 
 NTSTATUS open_hkcu_key( const char *path, HANDLE *key )
 {
@@ -493,6 +680,9 @@ NTSTATUS WINAPI NtQueryValueKey( HANDLE handle, const UNICODE_STRING *name,
     unsigned int ret;
     UCHAR *data_ptr;
     unsigned int fixed_size, min_size;
+    DWORD data_size;
+    data_size_t total;
+    int type;
 
     TRACE( "(%p,%s,%d,%p,%d)\n", handle, debugstr_us(name), info_class, info, length );
 
@@ -538,21 +728,17 @@ NTSTATUS WINAPI NtQueryValueKey( HANDLE handle, const UNICODE_STRING *name,
         return STATUS_INVALID_PARAMETER;
     }
 
-    SERVER_START_REQ( get_key_value )
+    data_size = (length > fixed_size && data_ptr) ? length - fixed_size : 0;
+    if (!get_cached_key_value( handle, name, data_ptr, data_size, &ret, &type, &total ))
+        ret = query_key_value( handle, name, data_ptr, data_size, &type, &total );
+
+    if (!ret)
     {
-        req->hkey = wine_server_obj_handle( handle );
-        wine_server_add_data( req, name->Buffer, name->Length );
-        if (length > fixed_size && data_ptr) wine_server_set_reply( req, data_ptr, length - fixed_size );
-        if (!(ret = wine_server_call( req )))
-        {
-            copy_key_value_info( info_class, info, length, reply->type,
-                                 name->Length, reply->total );
-            *result_len = fixed_size + (info_class == KeyValueBasicInformation ? 0 : reply->total);
-            if (length < min_size) ret = STATUS_BUFFER_TOO_SMALL;
-            else if (length < *result_len) ret = STATUS_BUFFER_OVERFLOW;
-        }
+        copy_key_value_info( info_class, info, length, type, name->Length, total );
+        *result_len = fixed_size + (info_class == KeyValueBasicInformation ? 0 : total);
+        if (length < min_size) ret = STATUS_BUFFER_TOO_SMALL;
+        else if (length < *result_len) ret = STATUS_BUFFER_OVERFLOW;
     }
-    SERVER_END_REQ;
     return ret;
 }
 
@@ -735,7 +921,7 @@ NTSTATUS WINAPI NtLoadKeyEx( const OBJECT_ATTRIBUTES *attr, OBJECT_ATTRIBUTES *f
     if (!(ret = get_nt_and_unix_names( &new_attr, &nt_name, &unix_name, FILE_OPEN, FALSE )))
     {
         ret = open_unix_file( &key, unix_name, GENERIC_READ | SYNCHRONIZE,
-                              &new_attr, 0, 0, FILE_OPEN, 0, NULL, 0 );
+                              &new_attr, 0, 0, FILE_OPEN, 0, NULL, 0, FALSE );
     }
     free( unix_name );
     free( nt_name.Buffer );
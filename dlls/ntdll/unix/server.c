@@ -63,6 +63,11 @@
 #include <sys/thr.h>
 #endif
 #include <unistd.h>
+#ifdef __linux__
+#include <poll.h>
+#include <linux/futex.h>
+#define USE_REQUEST_RING
+#endif
 #ifdef __APPLE__
 #include <crt_externs.h>
 #include <spawn.h>
@@ -105,6 +110,12 @@ static int initial_cwd = -1;
 static pid_t server_pid;
 pthread_mutex_t fd_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+#ifdef USE_REQUEST_RING
+static request_ring_shm_t *request_ring;  /* shared memory request ring, if enabled */
+static int request_ring_doorbell = -1;    /* eventfd to wake up the server */
+static LONG64 request_ring_used;          /* bitmap of the slots allocated to threads */
+#endif
+
 /* atomically exchange a 64-bit value */
 static inline LONG64 interlocked_xchg64( LONG64 *dest, LONG64 val )
 {
@@ -279,6 +290,156 @@ static inline unsigned int wait_reply( int reply_fd, struct __server_request_inf
 }
 
 
+#ifdef USE_REQUEST_RING
+
+/***********************************************************************
+ *           ring_server_call
+ *
+ * Perform a server call through the request slot of the thread.
+ */
+static unsigned int ring_server_call( struct thread_data *data, struct __server_request_info *req )
+{
+    request_slot_shm_t *slot = &request_ring->slots[data->request_slot];
+    struct timespec timeout = { 1, 0 };
+    data_size_t reply_size;
+    struct pollfd pfd;
+    int state;
+
+    memcpy( (char *)slot->data, &req->u.req, sizeof(req->u.req) );
+    slot->size = sizeof(req->u.req);
+    InterlockedExchange( (LONG *)&slot->state, REQUEST_SLOT_POSTED );
+
+    /* the server drains all the posted slots when woken up, so only ring if none was pending */
+    if (!InterlockedOr64( &request_ring->posted, (LONG64)1 << data->request_slot ))
+    {
+        static const ULONG64 one = 1;
+        if (write( request_ring_doorbell, &one, sizeof(one) ) == -1) server_protocol_perror( "write" );
+    }
+
+    while ((state = ReadAcquire( (LONG *)&slot->state )) == REQUEST_SLOT_POSTED)
+    {
+        if (!syscall( __NR_futex, &slot->state, FUTEX_WAIT, REQUEST_SLOT_POSTED, &timeout, 0, 0 ) ||
+            errno != ETIMEDOUT) continue;
+
+        /* make sure the server is still around */
+        pfd.fd = data->reply_fd;
+        pfd.events = POLLIN;
+        if (poll( &pfd, 1, 0 ) == 1 && (pfd.revents & (POLLHUP | POLLERR))) abort_thread(0);
+    }
+    if (state != REQUEST_SLOT_REPLIED) abort_thread(0);  /* the server killed us */
+
+    memcpy( &req->u.reply, (char *)slot->data, sizeof(req->u.reply) );
+    reply_size = req->u.reply.reply_header.reply_size;
+    if (reply_size > req->u.req.request_header.reply_size ||
+        slot->size != sizeof(req->u.reply) + reply_size)
+        server_protocol_error( "bad reply size %u in request slot\n", reply_size );
+    if (reply_size) memcpy( req->reply_data, (char *)slot->data + sizeof(req->u.reply), reply_size );
+    slot->state = REQUEST_SLOT_IDLE;
+    return req->u.reply.reply_header.error;
+}
+
+
+/***********************************************************************
+ *           init_request_slot
+ *
+ * Allocate a request ring slot to the current thread.
+ */
+static void init_request_slot(void)
+{
+    struct thread_data *data = get_thread_data();
+    LONG64 used;
+    int slot;
+
+    if (!request_ring) return;
+    do
+    {
+        used = ReadNoFence64( &request_ring_used );
+        if (!~used) return;  /* all slots are taken, keep using the pipe */
+        for (slot = 0; used & ((LONG64)1 << slot); slot++) ;
+    } while (InterlockedCompareExchange64( &request_ring_used, used | ((LONG64)1 << slot), used ) != used);
+
+    SERVER_START_REQ( set_request_slot )
+    {
+        req->slot = slot;
+        if (!wine_server_call( req )) data->request_slot = slot;
+    }
+    SERVER_END_REQ;
+    if (data->request_slot == -1) InterlockedAnd64( &request_ring_used, ~((LONG64)1 << slot) );
+}
+
+
+/***********************************************************************
+ *           init_request_ring
+ *
+ * Create the shared memory request ring if enabled.
+ */
+static void init_request_ring(void)
+{
+    const char *env = getenv( "WINESERVERRING" );
+    obj_handle_t ring_handle = 0, doorbell_handle = 0, handle;
+    unsigned int status;
+    void *ptr;
+    int fd;
+
+    if (!env || !atoi( env )) return;
+
+    SERVER_START_REQ( init_request_ring )
+    {
+        if (!(status = wine_server_call( req )))
+        {
+            ring_handle = reply->ring;
+            doorbell_handle = reply->doorbell;
+        }
+    }
+    SERVER_END_REQ;
+    if (status)
+    {
+        WARN( "request ring not supported by the server, status %x\n", status );
+        return;
+    }
+
+    fd = wine_server_receive_fd( &handle );
+    assert( handle == ring_handle );
+    request_ring_doorbell = wine_server_receive_fd( &handle );
+    assert( handle == doorbell_handle );
+
+    ptr = mmap( NULL, sizeof(*request_ring), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+    close( fd );
+    if (ptr == MAP_FAILED) server_protocol_perror( "mmap" );
+    request_ring = ptr;
+    init_request_slot();
+}
+
+
+/***********************************************************************
+ *           server_free_request_slot
+ *
+ * Give back the request slot of an exiting thread.
+ */
+void server_free_request_slot( struct thread_data *data )
+{
+    if (data->request_slot == -1) return;
+    InterlockedAnd64( &request_ring_used, ~((LONG64)1 << data->request_slot) );
+    data->request_slot = -1;
+}
+
+#else  /* USE_REQUEST_RING */
+
+static void init_request_slot(void)
+{
+}
+
+static void init_request_ring(void)
+{
+}
+
+void server_free_request_slot( struct thread_data *data )
+{
+}
+
+#endif  /* USE_REQUEST_RING */
+
+
 /***********************************************************************
  *           server_call_unlocked
  */
@@ -288,6 +449,12 @@ unsigned int server_call_unlocked( void *req_ptr )
     struct __server_request_info * const req = req_ptr;
     unsigned int ret;
 
+#ifdef USE_REQUEST_RING
+    /* requests with variable-size data use the pipe, so that bad client buffers are reported as EFAULT */
+    if (data->request_slot != -1 && !req->u.req.request_header.request_size &&
+        req->u.req.request_header.reply_size <= sizeof(request_ring->slots[0].data) - sizeof(req->u.reply))
+        return ring_server_call( data, req );
+#endif
     if ((ret = send_request( data->request_fd, req ))) return ret;
     return wait_reply( data->reply_fd, req );
 }
@@ -1033,6 +1200,57 @@ int wine_server_receive_fd( obj_handle_t *handle )
 }
 
 
+/* fds received while waiting for the fd of another handle, protected by fd_cache_mutex */
+struct pending_fd
+{
+    obj_handle_t handle;
+    int          fd;
+};
+
+static struct pending_fd *pending_fds;
+static unsigned int pending_fds_count, pending_fds_size;
+
+/***********************************************************************
+ *           server_receive_handle_fd
+ *
+ * Receive the unix fd sent by the server for a given handle.
+ * The fd of a new file can be sent while another thread waits for its own fd,
+ * so fds for other handles are kept until their thread picks them up.
+ * Caller must hold fd_cache_mutex.
+ */
+int server_receive_handle_fd( obj_handle_t handle )
+{
+    obj_handle_t fd_handle;
+    unsigned int i;
+    int fd;
+
+    for (i = 0; i < pending_fds_count; i++)
+    {
+        if (pending_fds[i].handle != handle) continue;
+        fd = pending_fds[i].fd;
+        pending_fds[i] = pending_fds[--pending_fds_count];
+        return fd;
+    }
+
+    while ((fd = wine_server_receive_fd( &fd_handle )), fd_handle != handle)
+    {
+        if (pending_fds_count == pending_fds_size)
+        {
+            unsigned int new_size = max( 16, pending_fds_size * 2 );
+            struct pending_fd *new_fds = realloc( pending_fds, new_size * sizeof(*new_fds) );
+
+            if (!new_fds) server_protocol_error( "out of memory for pending fds\n" );
+            pending_fds = new_fds;
+            pending_fds_size = new_size;
+        }
+        pending_fds[pending_fds_count].handle = fd_handle;
+        pending_fds[pending_fds_count].fd = fd;
+        pending_fds_count++;
+    }
+    return fd;
+}
+
+
 /***********************************************************************/
 /* fd cache support */
 
@@ -1051,7 +1269,7 @@ union fd_cache_entry
 C_ASSERT( sizeof(union fd_cache_entry) == sizeof(LONG64) );
 
 #define FD_CACHE_BLOCK_SIZE  (65536 / sizeof(union fd_cache_entry))
-#define FD_CACHE_ENTRIES     128
+#define FD_CACHE_ENTRIES     (0x1000000 / FD_CACHE_BLOCK_SIZE)  /* enough for all the server handles */
 
 static union fd_cache_entry *fd_cache[FD_CACHE_ENTRIES];
 static union fd_cache_entry fd_cache_initial_block[FD_CACHE_BLOCK_SIZE];
@@ -1157,7 +1375,6 @@ int server_get_unix_fd( HANDLE handle, unsigned int wanted_access, int *unix_fd,
                         int *needs_close, enum server_fd_type *type, unsigned int *options )
 {
     sigset_t sigset;
-    obj_handle_t fd_handle;
     int ret, fd = -1;
     unsigned int access = 0;
 
@@ -1180,9 +1397,8 @@ int server_get_unix_fd( HANDLE handle, unsigned int wanted_access, int *unix_fd,
                 if (type) *type = reply->type;
                 if (options) *options = reply->options;
                 access = reply->access;
-                if ((fd = wine_server_receive_fd( &fd_handle )) != -1)
+                if ((fd = server_receive_handle_fd( wine_server_obj_handle( handle ) )) != -1)
                 {
-                    assert( wine_server_ptr_handle(fd_handle) == handle );
                     *needs_close = (!reply->cacheable ||
                                     !add_fd_to_cache( handle, fd, reply->type,
                                                       reply->access, reply->options ));
@@ -1209,6 +1425,25 @@ done:
 }
 
 
+/***********************************************************************
+ *           server_receive_cacheable_fd
+ *
+ * Receive the unix fd sent along with a new handle, and store it in the cache.
+ * Caller must have signals blocked, and must not hold fd_cache_mutex.
+ */
+void server_receive_cacheable_fd( HANDLE handle, enum server_fd_type type,
+                                  unsigned int access, unsigned int options )
+{
+    int fd;
+
+    mutex_lock( &fd_cache_mutex );
+    if ((fd = server_receive_handle_fd( wine_server_obj_handle( handle ) )) != -1 &&
+        !add_fd_to_cache( handle, fd, type, access, options ))
+        close( fd );
+    mutex_unlock( &fd_cache_mutex );
+}
+
+
 /***********************************************************************
  *           wine_server_fd_to_handle
  */
@@ -1718,6 +1953,7 @@ size_t server_init_process(void)
     }
 
     set_thread_id( data );
+    init_request_ring();
 
     for (i = 0; i < supported_machines_count; i++)
         if (supported_machines[i] == current_machine) return info_size;
@@ -1797,6 +2033,7 @@ void server_init_thread( void *entry_point, BOOL *suspend )
     }
     SERVER_END_REQ;
     close( reply_pipe );
+    init_request_slot();
 }
 
 NTSTATUS WINAPI NtAllocateReserveObject( HANDLE *handle, const OBJECT_ATTRIBUTES *attr,
@@ -1868,6 +2105,7 @@ NTSTATUS WINAPI NtDuplicateObject( HANDLE source_process, HANDLE source, HANDLE
     {
         fd = remove_fd_from_cache( source );
         close_inproc_sync( source );
+        close_key_value_cache( source );
     }
 
     SERVER_START_REQ( dup_handle )
@@ -1942,6 +2180,7 @@ NTSTATUS WINAPI NtClose( HANDLE handle )
      * retrieve it again */
     fd = remove_fd_from_cache( handle );
     close_inproc_sync( handle );
+    close_key_value_cache( handle );
 
     SERVER_START_REQ( close_handle )
     {
@@ -29,6 +29,10 @@
 #include <sys/socket.h>
 #include <sys/ioctl.h>
 #include <unistd.h>
+#if defined(HAVE_SYS_SENDFILE_H) && defined(__linux__)
+# include <sys/sendfile.h>
+# define USE_SENDFILE
+#endif
 #ifdef HAVE_IFADDRS_H
 # include <ifaddrs.h>
 #endif
@@ -151,6 +155,7 @@ struct async_transmit_ioctl
     unsigned int head_len;
     unsigned int tail_len;
     LARGE_INTEGER offset;
+    BOOL no_sendfile;           /* sendfile() isn't supported for this file */
 };
 
 static NTSTATUS sock_errno_to_status( int err )
@@ -1361,6 +1366,53 @@ static ssize_t do_send( int fd, const void *buffer, size_t len, int flags )
     return ret;
 }
 
+#ifdef USE_SENDFILE
+/* send the file data directly from the page cache, without copying it through the buffer */
+static NTSTATUS try_sendfile( int sock_fd, int file_fd, struct async_transmit_ioctl *async )
+{
+    ssize_t ret;
+
+    while (async->file)
+    {
+        size_t count = 0x7ffff000;  /* maximum transfer size on Linux */
+        off_t offset = async->offset.QuadPart;
+
+        if (async->file_len)
+            count = min( count, async->file_len - async->file_cursor );
+
+        TRACE( "sending %zu bytes of file data\n", count );
+        do
+        {
+            if (async->offset.QuadPart == FILE_USE_FILE_POINTER_POSITION)
+                ret = sendfile( sock_fd, file_fd, NULL, count );
+            else
+                ret = sendfile( sock_fd, file_fd, &offset, count );
+        } while (ret < 0 && errno == EINTR);
+        if (ret < 0)
+        {
+            if (errno == EINVAL || errno == ENOSYS)
+            {
+                /* not supported for this file, fall back to reading it */
+                TRACE( "sendfile failed: %s\n", strerror( errno ) );
+                async->no_sendfile = TRUE;
+                return STATUS_SUCCESS;
+            }
+            if (errno != EWOULDBLOCK) WARN( "sendfile: %s\n", strerror( errno ) );
+            return sock_errno_to_status( errno );
+        }
+        TRACE( "sendfile returned %zd\n", ret );
+
+        async->file_cursor += ret;
+        if (async->offset.QuadPart != FILE_USE_FILE_POINTER_POSITION)
+            async->offset.QuadPart += ret;
+
+        if (!ret || (async->file_len && async->file_cursor == async->file_len))
+            async->file = NULL;
+    }
+    return STATUS_SUCCESS;
+}
+#endif
+
 static NTSTATUS try_transmit( int sock_fd, int file_fd, struct async_transmit_ioctl *async )
 {
     ssize_t ret;
@@ -1386,6 +1438,14 @@ static NTSTATUS try_transmit( int sock_fd, int file_fd, struct async_transmit_io
         async->file_cursor += ret;
     }
 
+#ifdef USE_SENDFILE
+    if (async->file && !async->no_sendfile)
+    {
+        NTSTATUS status = try_sendfile( sock_fd, file_fd, async );
+        if (status) return status;
+    }
+#endif
+
     if (async->file && async->buffer_cursor == async->read_len)
     {
         unsigned int read_size = async->buffer_size;
@@ -1510,6 +1570,7 @@ static NTSTATUS sock_transmit( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc,
     async->tail = u64_to_user_ptr(params->tail_ptr);
     async->tail_len = params->tail_len;
     async->offset = params->offset;
+    async->no_sendfile = FALSE;
 
     SERVER_START_REQ( send_socket )
     {
@@ -673,10 +673,8 @@ static NTSTATUS get_server_inproc_sync( HANDLE handle, struct inproc_sync *sync
         req->handle = wine_server_obj_handle( handle );
         if (!(ret = wine_server_call( req )))
         {
-            obj_handle_t fd_handle;
             sync->refcount = 1;
-            sync->fd = wine_server_receive_fd( &fd_handle );
-            assert( wine_server_ptr_handle(fd_handle) == handle );
+            sync->fd = server_receive_handle_fd( req->handle );
             sync->access = reply->access;
             sync->type = reply->type;
             sync->closed = 0;
@@ -872,7 +870,6 @@ static NTSTATUS inproc_query_mutex( HANDLE handle, MUTANT_BASIC_INFORMATION *inf
 static int get_inproc_alert_fd(void)
 {
     struct thread_data *data = get_thread_data();
-    obj_handle_t token;
     sigset_t sigset;
     int fd;
 
@@ -883,10 +880,7 @@ static int get_inproc_alert_fd(void)
         SERVER_START_REQ( get_inproc_alert_fd )
         {
             if (!server_call_unlocked( req ))
-            {
-                data->alert_fd = fd = wine_server_receive_fd( &token );
-                assert( token == reply->handle );
-            }
+                data->alert_fd = fd = server_receive_handle_fd( reply->handle );
         }
         SERVER_END_REQ;
 
@@ -2970,6 +2964,85 @@ NTSTATUS WINAPI NtQueryIoCompletion( HANDLE handle, IO_COMPLETION_INFORMATION_CL
 }
 
 
+/***********************************************************************
+ *             NtCreateWaitCompletionPacket (NTDLL.@)
+ */
+NTSTATUS WINAPI NtCreateWaitCompletionPacket( HANDLE *handle, ACCESS_MASK access, OBJECT_ATTRIBUTES *attr )
+{
+    unsigned int status;
+    data_size_t len;
+    struct object_attributes *objattr;
+
+    TRACE( "(%p, %x, %p)\n", handle, access, attr );
+
+    *handle = 0;
+    if ((status = alloc_object_attributes( attr, &objattr, &len ))) return status;
+
+    SERVER_START_REQ( create_wait_completion_packet )
+    {
+        req->access = access;
+        wine_server_add_data( req, objattr, len );
+        status = wine_server_call( req );
+        *handle = wine_server_ptr_handle( reply->handle );
+    }
+    SERVER_END_REQ;
+
+    free( objattr );
+    return status;
+}
+
+
+/***********************************************************************
+ *             NtAssociateWaitCompletionPacket (NTDLL.@)
+ */
+NTSTATUS WINAPI NtAssociateWaitCompletionPacket( HANDLE packet, HANDLE completion, HANDLE target,
+                                                 void *key_context, void *apc_context, NTSTATUS io_status,
+                                                 ULONG_PTR io_status_information, BOOLEAN *already_signaled )
+{
+    unsigned int status;
+
+    TRACE( "(%p, %p, %p, %p, %p, %#x, %#lx, %p)\n", packet, completion, target, key_context,
+           apc_context, (int)io_status, io_status_information, already_signaled );
+
+    SERVER_START_REQ( associate_wait_completion_packet )
+    {
+        req->packet      = wine_server_obj_handle( packet );
+        req->completion  = wine_server_obj_handle( completion );
+        req->target      = wine_server_obj_handle( target );
+        req->ckey        = wine_server_client_ptr( key_context );
+        req->cvalue      = wine_server_client_ptr( apc_context );
+        req->information = io_status_information;
+        req->status      = io_status;
+        if (!(status = wine_server_call( req )) && already_signaled)
+            *already_signaled = reply->signaled;
+    }
+    SERVER_END_REQ;
+
+    return status;
+}
+
+
+/***********************************************************************
+ *             NtCancelWaitCompletionPacket (NTDLL.@)
+ */
+NTSTATUS WINAPI NtCancelWaitCompletionPacket( HANDLE packet, BOOLEAN remove_signaled )
+{
+    unsigned int status;
+
+    TRACE( "(%p, %d)\n", packet, remove_signaled );
+
+    SERVER_START_REQ( cancel_wait_completion_packet )
+    {
+        req->packet          = wine_server_obj_handle( packet );
+        req->remove_signaled = remove_signaled;
+        status = wine_server_call( req );
+    }
+    SERVER_END_REQ;
+
+    return status;
+}
+
+
 /***********************************************************************
  *             NtCreateSection (NTDLL.@)
  */
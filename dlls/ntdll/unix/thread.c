@@ -1103,6 +1103,8 @@ static void contexts_from_server( CONTEXT *context, struct context_data server_c
 static DECLSPEC_NORETURN void pthread_exit_wrapper( int status )
 {
     struct thread_data *data = get_thread_data();
+    dbg_thread_exit();
+    server_free_request_slot( data );
     close( data->alert_fd );
     close( data->wait_fd[0] );
     close( data->wait_fd[1] );
@@ -1511,6 +1513,7 @@ void abort_thread( int status )
  */
 void abort_process( int status )
 {
+    flush_debug_log();
     _exit( get_unix_exit_code( status ));
 }
 
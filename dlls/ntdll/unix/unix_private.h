@@ -107,6 +107,7 @@ struct thread_data
     int          reply_fd;          /* fd for receiving server replies */
     int          wait_fd[2];        /* fd for sleeping server requests */
     int          alert_fd;          /* inproc sync fd for user apc alerts */
+    int          request_slot;      /* slot in the shared memory request ring, -1 if none */
     DWORD        tid;               /* thread id */
     BOOL         allow_writes;      /* ThreadAllowWrites flags */
     pthread_t    pthread_id;        /* pthread thread id */
@@ -114,6 +115,7 @@ struct thread_data
     void        *start;             /* thread entry point */
     void        *param;             /* thread entry point parameter */
     struct list  entry;             /* entry in TEB list */
+    void        *debug_log;         /* binary debug log buffer */
     char         debug_info[0x800]; /* debug_info structure */
     char         signal_stack[];    /* signal stack */
     /* char kernel_stack[] */
@@ -159,6 +161,8 @@ struct async_fileio
 struct pe_mapping_info
 {
     HANDLE               shared_file;
+    HANDLE               relocated_file;
+    BOOL                 relocated_build;
     UNICODE_STRING       nt_name;
     ANSI_STRING          exp_name;
     void                *version_res;
@@ -251,11 +255,15 @@ extern unsigned int server_queue_process_apc( HANDLE process, const union apc_ca
                                               union apc_result *result );
 extern int server_get_unix_fd( HANDLE handle, unsigned int wanted_access, int *unix_fd,
                                int *needs_close, enum server_fd_type *type, unsigned int *options );
+extern int server_receive_handle_fd( obj_handle_t handle );
+extern void server_receive_cacheable_fd( HANDLE handle, enum server_fd_type type,
+                                         unsigned int access, unsigned int options );
 extern int wine_server_receive_fd( obj_handle_t *handle );
 extern void process_exit_wrapper( int status ) DECLSPEC_NORETURN;
 extern size_t server_init_process(void);
 extern void server_init_process_done(void);
 extern void server_init_thread( void *entry_point, BOOL *suspend );
+extern void server_free_request_slot( struct thread_data *data );
 extern int server_pipe( int fd[2] );
 
 extern void fpux_to_fpu( I386_FLOATING_SAVE_AREA *fpu, const XSAVE_FORMAT *fpux );
@@ -383,7 +391,7 @@ extern NTSTATUS get_full_path( char *name, const WCHAR *curdir, UNICODE_STRING *
 extern NTSTATUS get_nt_path( const WCHAR *name, UNICODE_STRING *nt_name );
 extern NTSTATUS open_unix_file( HANDLE *handle, const char *unix_name, ACCESS_MASK access,
                                 OBJECT_ATTRIBUTES *attr, ULONG attributes, ULONG sharing, ULONG disposition,
-                                ULONG options, void *ea_buffer, ULONG ea_length );
+                                ULONG options, void *ea_buffer, ULONG ea_length, BOOL want_fd );
 extern NTSTATUS get_device_info( int fd, struct _FILE_FS_DEVICE_INFORMATION *info );
 extern void init_files(void);
 extern void init_cpu_info(void);
@@ -407,8 +415,11 @@ extern NTSTATUS wow64_wine_spawnvp( void *args );
 #endif
 
 extern void dbg_init(void);
+extern void dbg_thread_exit(void);
+extern void flush_debug_log(void);
 
 extern void close_inproc_sync( HANDLE handle );
+extern void close_key_value_cache( HANDLE handle );
 
 extern NTSTATUS call_user_apc_dispatcher( CONTEXT *context_ptr, unsigned int flags, ULONG_PTR arg1, ULONG_PTR arg2,
                                           ULONG_PTR arg3, PNTAPCFUNC func, NTSTATUS status );
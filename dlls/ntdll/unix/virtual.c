@@ -225,6 +225,11 @@ static const size_t pages_vprot_shift = 20;
 static const size_t pages_vprot_mask = (1 << 20) - 1;
 static size_t pages_vprot_size;
 static BYTE **pages_vprot;
+/* each table is followed by a summary of its blocks of pages, a block with a uniform
+ * protection only stores it in its summary and its page bytes are left untouched */
+static const size_t pages_vprot_block_shift = 12;
+static const size_t pages_vprot_block_mask = (1 << 12) - 1;
+#define VPROT_BLOCK_MIXED 0x100  /* block pages have different protections, use the page bytes */
 #else  /* on 32-bit we use a simple array with one byte per page */
 static BYTE *pages_vprot;
 #endif
@@ -240,6 +245,8 @@ static void *preload_reserve_start;
 static void *preload_reserve_end;
 static BOOL force_exec_prot;  /* whether to force PROT_EXEC on all PROT_READ mmaps */
 static BOOL enable_write_exceptions;  /* raise exception on writes to executable memory */
+static size_t large_page_size = 2 * 1024 * 1024;  /* host huge page size, used for MEM_LARGE_PAGES */
+static BOOL use_huge_pages;  /* whether to use transparent huge pages for large reservations */
 
 struct range_entry
 {
@@ -278,6 +285,44 @@ void *anon_mmap_alloc( size_t size, int prot )
     return mmap( NULL, size, prot, MAP_PRIVATE | MAP_ANON, -1, 0 );
 }
 
+static void huge_pages_init(void)
+{
+    const char *env;
+#ifdef __linux__
+    unsigned long size;
+    char buffer[64];
+    FILE *f;
+
+    if ((f = fopen( "/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", "r" )))
+    {
+        if (fscanf( f, "%lu", &size ) == 1 && size > host_page_size && !(size & (size - 1)))
+            large_page_size = size;
+        fclose( f );
+    }
+    else if ((f = fopen( "/proc/meminfo", "r" )))
+    {
+        while (fgets( buffer, sizeof(buffer), f ))
+        {
+            if (sscanf( buffer, "Hugepagesize: %lu kB", &size ) != 1) continue;
+            size *= 1024;
+            if (size > host_page_size && !(size & (size - 1))) large_page_size = size;
+            break;
+        }
+        fclose( f );
+    }
+#endif
+    if ((env = getenv( "WINEHUGEPAGES" ))) use_huge_pages = atoi( env );
+    TRACE( "large page size %#zx, huge pages %u\n", large_page_size, use_huge_pages );
+}
+
+/* ask the host to back a range with huge pages */
+static void set_huge_pages( void *base, size_t size )
+{
+#ifdef MADV_HUGEPAGE
+    if (madvise( base, size, MADV_HUGEPAGE )) WARN( "madvise %p-%p failed %s\n", base, (char *)base + size, strerror(errno) );
+#endif
+}
+
 #ifdef USE_UFFD_WRITEWATCH
 static void kernel_writewatch_init(void)
 {
@@ -1081,6 +1126,55 @@ static inline int is_view_valloc( const struct file_view *view )
     return !(view->protect & (SEC_FILE | SEC_RESERVE | SEC_COMMIT));
 }
 
+#ifdef _WIN64
+static inline BYTE *get_vprot_ptr( size_t idx )
+{
+    return pages_vprot[idx >> pages_vprot_shift] + (idx & pages_vprot_mask);
+}
+
+static inline USHORT *get_vprot_block( size_t idx )
+{
+    USHORT *blocks = (USHORT *)(pages_vprot[idx >> pages_vprot_shift] + pages_vprot_mask + 1);
+    return blocks + ((idx & pages_vprot_mask) >> pages_vprot_block_shift);
+}
+
+/* store the uniform protection of a block in its page bytes, to allow changing part of it */
+static void split_vprot_block( size_t idx )
+{
+    USHORT *block = get_vprot_block( idx );
+
+    if (*block & VPROT_BLOCK_MIXED) return;
+    memset( get_vprot_ptr( idx & ~pages_vprot_block_mask ), *block, pages_vprot_block_mask + 1 );
+    *block = VPROT_BLOCK_MIXED;
+}
+
+/* set the uniform protection of a whole block, releasing its page bytes */
+static void merge_vprot_block( size_t idx, BYTE vprot )
+{
+    USHORT *block = get_vprot_block( idx );
+
+    if ((*block & VPROT_BLOCK_MIXED) && host_page_size == pages_vprot_block_mask + 1)
+        madvise( get_vprot_ptr( idx ), host_page_size, MADV_DONTNEED );
+    *block = vprot;
+}
+
+/* return the number of page bytes with the same masked protection */
+static size_t scan_vprot_bytes( const BYTE *vprot_ptr, size_t count, BYTE vprot, BYTE mask )
+{
+    static const UINT_PTR word_from_byte = (UINT_PTR)0x101010101010101;
+    UINT_PTR vprot_word = word_from_byte * vprot, mask_word = word_from_byte * mask;
+    size_t i = 0;
+
+    for (; i < count && ((UINT_PTR)(vprot_ptr + i) & (sizeof(UINT_PTR) - 1)); i++)
+        if ((vprot ^ vprot_ptr[i]) & mask) return i;
+    for (; i + sizeof(UINT_PTR) <= count; i += sizeof(UINT_PTR))
+        if ((vprot_word ^ *(const UINT_PTR *)(vprot_ptr + i)) & mask_word) break;
+    for (; i < count; i++)
+        if ((vprot ^ vprot_ptr[i]) & mask) return i;
+    return i;
+}
+#endif
+
 /***********************************************************************
  *           get_page_vprot
  *
@@ -1091,9 +1185,12 @@ static BYTE get_page_vprot( const void *addr )
     size_t idx = (size_t)addr >> page_shift;
 
 #ifdef _WIN64
+    USHORT block;
+
     if ((idx >> pages_vprot_shift) >= pages_vprot_size) return 0;
     if (!pages_vprot[idx >> pages_vprot_shift]) return 0;
-    return pages_vprot[idx >> pages_vprot_shift][idx & pages_vprot_mask];
+    if (!((block = *get_vprot_block( idx )) & VPROT_BLOCK_MIXED)) return block;
+    return *get_vprot_ptr( idx );
 #else
     return pages_vprot[idx];
 #endif
@@ -1112,10 +1209,13 @@ static BYTE get_host_page_vprot( const void *addr )
     BYTE vprot = 0;
 
 #ifdef _WIN64
+    USHORT block;
+
     if ((idx >> pages_vprot_shift) >= pages_vprot_size) return 0;
     if (!pages_vprot[idx >> pages_vprot_shift]) return 0;
-    assert( host_page_mask >> page_shift <= pages_vprot_mask );
-    vprot_ptr = pages_vprot[idx >> pages_vprot_shift] + (idx & pages_vprot_mask);
+    assert( host_page_mask >> page_shift <= pages_vprot_block_mask );
+    if (!((block = *get_vprot_block( idx )) & VPROT_BLOCK_MIXED)) return block;
+    vprot_ptr = get_vprot_ptr( idx );
 #else
     vprot_ptr = pages_vprot + idx;
 #endif
@@ -1134,6 +1234,31 @@ static BYTE get_host_page_vprot( const void *addr )
  * vprot bytes are allocated for the range. */
 static SIZE_T get_vprot_range_size( char *base, SIZE_T size, BYTE mask, BYTE *vprot )
 {
+#ifdef _WIN64
+    SIZE_T curr_idx, start_idx, end_idx, block_end;
+    USHORT block;
+
+    TRACE("base %p, size %p, mask %#x.\n", base, (void *)size, mask);
+
+    curr_idx = start_idx = (size_t)base >> page_shift;
+    end_idx = start_idx + (size >> page_shift);
+    *vprot = get_page_vprot( base );
+
+    /* uniform blocks are compared at once, only the others need their page bytes scanned */
+    while (curr_idx < end_idx)
+    {
+        block_end = min( (curr_idx | pages_vprot_block_mask) + 1, end_idx );
+        if (!((block = *get_vprot_block( curr_idx )) & VPROT_BLOCK_MIXED))
+        {
+            if ((*vprot ^ block) & mask) break;
+            curr_idx = block_end;
+            continue;
+        }
+        curr_idx += scan_vprot_bytes( get_vprot_ptr( curr_idx ), block_end - curr_idx, *vprot, mask );
+        if (curr_idx < block_end) break;
+    }
+    return (curr_idx - start_idx) << page_shift;
+#else
     static const UINT_PTR word_from_byte = (UINT_PTR)0x101010101010101;
     static const UINT_PTR index_align_mask = sizeof(UINT_PTR) - 1;
     SIZE_T curr_idx, start_idx, end_idx, aligned_start_idx;
@@ -1148,11 +1273,7 @@ static SIZE_T get_vprot_range_size( char *base, SIZE_T size, BYTE mask, BYTE *vp
     aligned_start_idx = ROUND_SIZE( 0, start_idx, index_align_mask );
     if (aligned_start_idx > end_idx) aligned_start_idx = end_idx;
 
-#ifdef _WIN64
-    vprot_ptr = pages_vprot[curr_idx >> pages_vprot_shift] + (curr_idx & pages_vprot_mask);
-#else
     vprot_ptr = pages_vprot + curr_idx;
-#endif
     *vprot = *vprot_ptr;
 
     /* Page count page table is at least the multiples of sizeof(UINT_PTR)
@@ -1165,9 +1286,6 @@ static SIZE_T get_vprot_range_size( char *base, SIZE_T size, BYTE mask, BYTE *vp
     mask_word = word_from_byte * mask;
     for (; curr_idx < end_idx; curr_idx += sizeof(UINT_PTR), vprot_ptr += sizeof(UINT_PTR))
     {
-#ifdef _WIN64
-        if (!(curr_idx & pages_vprot_mask)) vprot_ptr = pages_vprot[curr_idx >> pages_vprot_shift];
-#endif
         if ((vprot_word ^ *(UINT_PTR *)vprot_ptr) & mask_word)
         {
             for (; curr_idx < end_idx; ++curr_idx, ++vprot_ptr)
@@ -1176,6 +1294,7 @@ static SIZE_T get_vprot_range_size( char *base, SIZE_T size, BYTE mask, BYTE *vp
         }
     }
     return size;
+#endif
 }
 
 /***********************************************************************
@@ -1189,13 +1308,19 @@ static void set_page_vprot( const void *addr, size_t size, BYTE vprot )
     size_t end = ((size_t)addr + size + page_mask) >> page_shift;
 
 #ifdef _WIN64
-    while (idx >> pages_vprot_shift != end >> pages_vprot_shift)
+    while (idx < end)
     {
-        size_t dir_size = pages_vprot_mask + 1 - (idx & pages_vprot_mask);
-        memset( pages_vprot[idx >> pages_vprot_shift] + (idx & pages_vprot_mask), vprot, dir_size );
-        idx += dir_size;
+        size_t block_end = min( (idx | pages_vprot_block_mask) + 1, end );
+
+        if (!(idx & pages_vprot_block_mask) && block_end - idx == pages_vprot_block_mask + 1)
+            merge_vprot_block( idx, vprot );
+        else if (*get_vprot_block( idx ) != vprot)
+        {
+            split_vprot_block( idx );
+            memset( get_vprot_ptr( idx ), vprot, block_end - idx );
+        }
+        idx = block_end;
     }
-    memset( pages_vprot[idx >> pages_vprot_shift] + (idx & pages_vprot_mask), vprot, end - idx );
 #else
     memset( pages_vprot + idx, vprot, end - idx );
 #endif
@@ -1213,10 +1338,33 @@ static void set_page_vprot_bits( const void *addr, size_t size, BYTE set, BYTE c
     size_t end = ((size_t)addr + size + page_mask) >> page_shift;
 
 #ifdef _WIN64
-    for ( ; idx < end; idx++)
+    while (idx < end)
     {
-        BYTE *ptr = pages_vprot[idx >> pages_vprot_shift] + (idx & pages_vprot_mask);
-        *ptr = (*ptr & ~clear) | set;
+        size_t block_end = min( (idx | pages_vprot_block_mask) + 1, end );
+        USHORT block = *get_vprot_block( idx );
+
+        if (!(block & VPROT_BLOCK_MIXED))
+        {
+            BYTE vprot = (block & ~clear) | set;
+
+            if (vprot == block)
+            {
+                idx = block_end;
+                continue;
+            }
+            if (!(idx & pages_vprot_block_mask) && block_end - idx == pages_vprot_block_mask + 1)
+            {
+                *get_vprot_block( idx ) = vprot;
+                idx = block_end;
+                continue;
+            }
+            split_vprot_block( idx );
+        }
+        for ( ; idx < block_end; idx++)
+        {
+            BYTE *ptr = get_vprot_ptr( idx );
+            *ptr = (*ptr & ~clear) | set;
+        }
     }
 #else
     for ( ; idx < end; idx++) pages_vprot[idx] = (pages_vprot[idx] & ~clear) | set;
@@ -1236,12 +1384,34 @@ static BOOL set_page_vprot_exec_write_protect( const void *addr, size_t size )
     size_t idx = (size_t)addr >> page_shift;
     size_t end = ((size_t)addr + size + page_mask) >> page_shift;
 
-    for ( ; idx < end; idx++)
+    while (idx < end)
     {
-        BYTE *ptr = pages_vprot[idx >> pages_vprot_shift] + (idx & pages_vprot_mask);
-        if (!is_vprot_exec_write( *ptr )) continue;
-        *ptr |= VPROT_WRITEWATCH;
-        ret = TRUE;
+        size_t block_end = min( (idx | pages_vprot_block_mask) + 1, end );
+        USHORT block = *get_vprot_block( idx );
+
+        if (!(block & VPROT_BLOCK_MIXED))
+        {
+            if (!is_vprot_exec_write( block ))
+            {
+                idx = block_end;
+                continue;
+            }
+            ret = TRUE;
+            if (!(idx & pages_vprot_block_mask) && block_end - idx == pages_vprot_block_mask + 1)
+            {
+                *get_vprot_block( idx ) = block | VPROT_WRITEWATCH;
+                idx = block_end;
+                continue;
+            }
+            split_vprot_block( idx );
+        }
+        for ( ; idx < block_end; idx++)
+        {
+            BYTE *ptr = get_vprot_ptr( idx );
+            if (!is_vprot_exec_write( *ptr )) continue;
+            *ptr |= VPROT_WRITEWATCH;
+            ret = TRUE;
+        }
     }
 #endif
     return ret;
@@ -1258,16 +1428,16 @@ static BOOL alloc_pages_vprot( const void *addr, size_t size )
 #ifdef _WIN64
     size_t idx = (size_t)addr >> page_shift;
     size_t end = ((size_t)addr + size + page_mask) >> page_shift;
-    size_t i;
+    size_t i, table_size = pages_vprot_mask + 1 + ((pages_vprot_mask + 1) >> pages_vprot_block_shift) * sizeof(USHORT);
     void *ptr;
 
     assert( end <= pages_vprot_size << pages_vprot_shift );
     for (i = idx >> pages_vprot_shift; i < (end + pages_vprot_mask) >> pages_vprot_shift; i++)
     {
         if (pages_vprot[i]) continue;
-        if ((ptr = anon_mmap_alloc( pages_vprot_mask + 1, PROT_READ | PROT_WRITE )) == MAP_FAILED)
+        if ((ptr = anon_mmap_alloc( table_size, PROT_READ | PROT_WRITE )) == MAP_FAILED)
         {
-            ERR( "anon mmap error %s for vprot table, size %08lx\n", strerror(errno), pages_vprot_mask + 1 );
+            ERR( "anon mmap error %s for vprot table, size %08lx\n", strerror(errno), table_size );
             return FALSE;
         }
         pages_vprot[i] = ptr;
@@ -3021,15 +3191,59 @@ static IMAGE_BASE_RELOCATION *process_relocation_block( char *page, IMAGE_BASE_R
 }
 
 
+/***********************************************************************
+ *           write_relocated_sections
+ *
+ * Write the relocated sections of an image to a file that other processes map it from.
+ */
+static BOOL write_relocated_sections( struct file_view *view, const IMAGE_NT_HEADERS *nt,
+                                      const IMAGE_SECTION_HEADER *sec, const IMAGE_DATA_DIRECTORY *dir,
+                                      SIZE_T align_mask, int fd )
+{
+    static const SIZE_T sector_align = 0x1ff;
+    const IMAGE_BASE_RELOCATION *rel = (const IMAGE_BASE_RELOCATION *)((char *)view->base + dir->VirtualAddress);
+    const IMAGE_BASE_RELOCATION *end = (const IMAGE_BASE_RELOCATION *)((const char *)rel + dir->Size);
+    SIZE_T map_size, file_size;
+    int i, count = nt->FileHeader.NumberOfSections;
+
+    /* relocations in sections that aren't mapped from the file would be lost */
+    while (rel < end - 1 && rel->SizeOfBlock)
+    {
+        for (i = 0; i < count; i++)
+        {
+            if (!sec[i].PointerToRawData || !sec[i].SizeOfRawData) continue;
+            map_size = ROUND_SIZE( 0, sec[i].Misc.VirtualSize ? sec[i].Misc.VirtualSize : sec[i].SizeOfRawData,
+                                   align_mask );
+            if (rel->VirtualAddress - sec[i].VirtualAddress < map_size) break;
+        }
+        if (i == count) return FALSE;
+        rel = (const IMAGE_BASE_RELOCATION *)((const char *)rel + rel->SizeOfBlock);
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        map_size = ROUND_SIZE( 0, sec[i].Misc.VirtualSize ? sec[i].Misc.VirtualSize : sec[i].SizeOfRawData,
+                               align_mask );
+        file_size = min( ROUND_SIZE( sec[i].PointerToRawData, sec[i].SizeOfRawData, sector_align ), map_size );
+        if (!sec[i].PointerToRawData || !file_size) continue;
+        if (pwrite( fd, (char *)view->base + sec[i].VirtualAddress, map_size,
+                    sec[i].VirtualAddress ) != map_size)
+            return FALSE;
+    }
+    return TRUE;
+}
+
+
 /***********************************************************************
  *           map_image_into_view
  *
  * Map an executable (PE format) image into an existing view.
+ * If build_fd is set, the relocated sections are written to it, it is reset to -1 if they couldn't be.
  * virtual_mutex must be held by caller.
  */
 static NTSTATUS map_image_into_view( struct file_view *view, const UNICODE_STRING *nt_name, int fd,
                                      struct pe_image_info *image_info, USHORT machine,
-                                     int shared_fd, BOOL removable )
+                                     int shared_fd, int relocated_fd, int *build_fd, BOOL removable )
 {
     IMAGE_DOS_HEADER *dos;
     IMAGE_NT_HEADERS *nt;
@@ -3044,9 +3258,12 @@ static NTSTATUS map_image_into_view( struct file_view *view, const UNICODE_STRIN
     SIZE_T header_size, header_map_size, total_size = view->size;
     SIZE_T align_mask = max( image_info->alignment - 1, page_mask );
     INT_PTR delta;
+    int write_fd = *build_fd;
 
     TRACE_(module)( "mapping PE file %s at %p-%p\n", debugstr_us(nt_name), ptr, ptr + total_size );
 
+    *build_fd = -1;  /* set again once the relocated sections have been written */
+
     /* map the header */
 
     fstat( fd, &st );
@@ -3073,6 +3290,14 @@ static NTSTATUS map_image_into_view( struct file_view *view, const UNICODE_STRIN
     }
     imports = get_data_dir( nt, total_size, IMAGE_DIRECTORY_ENTRY_IMPORT );
 
+#ifdef __aarch64__
+    /* the ARM64X mapping update changes the relocations */
+    if (image_info->machine == IMAGE_FILE_MACHINE_ARM64 &&
+        (machine == IMAGE_FILE_MACHINE_AMD64 ||
+         (!machine && main_image_info.Machine == IMAGE_FILE_MACHINE_AMD64)))
+        relocated_fd = write_fd = -1;
+#endif
+
     /* check for non page-aligned binary */
 
     if (image_info->image_flags & IMAGE_FLAGS_ImageMappedFlat)
@@ -3164,6 +3389,16 @@ static NTSTATUS map_image_into_view( struct file_view *view, const UNICODE_STRIN
 
         if (!sec[i].PointerToRawData || !file_size) continue;
 
+        if (relocated_fd != -1)
+        {
+            /* another process has already applied the relocations to the section data */
+            if (map_file_into_view( view, relocated_fd, sec[i].VirtualAddress, map_size, sec[i].VirtualAddress,
+                                    VPROT_COMMITTED | VPROT_READ | VPROT_WRITECOPY, FALSE ) == STATUS_SUCCESS)
+                continue;
+            ERR_(module)( "Could not map %s relocated section %.8s\n", debugstr_us(nt_name), sec[i].Name );
+            goto done;
+        }
+
         /* Note: if the section is not aligned properly map_file_into_view will magically
          *       fall back to read(), so we don't need to check anything here.
          */
@@ -3224,13 +3459,17 @@ static NTSTATUS map_image_into_view( struct file_view *view, const UNICODE_STRIN
         else
             ((IMAGE_NT_HEADERS32 *)nt)->OptionalHeader.ImageBase = image_info->map_addr;
 
-        if ((dir = get_data_dir( nt, total_size, IMAGE_DIRECTORY_ENTRY_BASERELOC )))
+        if (relocated_fd == -1 && (dir = get_data_dir( nt, total_size, IMAGE_DIRECTORY_ENTRY_BASERELOC )))
         {
             IMAGE_BASE_RELOCATION *rel = (IMAGE_BASE_RELOCATION *)(ptr + dir->VirtualAddress);
             IMAGE_BASE_RELOCATION *end = (IMAGE_BASE_RELOCATION *)((char *)rel + dir->Size);
 
             while (rel && rel < end - 1 && rel->SizeOfBlock && rel->VirtualAddress < total_size)
                 rel = process_relocation_block( ptr + rel->VirtualAddress, rel, delta );
+
+            /* the pages can't be read anymore once the protections are set */
+            if (write_fd != -1 && write_relocated_sections( view, nt, sec, dir, align_mask, write_fd ))
+                *build_fd = write_fd;
         }
     }
 
@@ -3274,6 +3513,7 @@ done:
 static void free_pe_mapping_info( struct pe_mapping_info *info )
 {
     if (info->shared_file) NtClose( info->shared_file );
+    if (info->relocated_file) NtClose( info->relocated_file );
     free( info );
 }
 
@@ -3303,6 +3543,8 @@ static unsigned int get_mapping_info( HANDLE handle, ACCESS_MASK access, unsigne
             *full_size   = reply->size;
             total        = reply->total;
             info->shared_file = wine_server_ptr_handle( reply->shared_file );
+            info->relocated_file = wine_server_ptr_handle( reply->relocated_file );
+            info->relocated_build = reply->relocated_build;
             info->version_len = reply->ver_len;
             info->nt_name.Length = info->nt_name.MaximumLength = reply->name_len;
         }
@@ -3400,6 +3642,10 @@ static NTSTATUS virtual_map_image( HANDLE mapping, void **addr_ptr, SIZE_T *size
 {
     int unix_fd = -1, needs_close;
     int shared_fd = -1, shared_needs_close = 0;
+    int relocated_fd = -1, relocated_needs_close = 0;
+    int build_fd = -1, build_needs_close = 0, written_fd;
+    HANDLE build_file = 0;
+    BOOL built = FALSE;
     SIZE_T size = pe_mapping->image.map_size;
     struct file_view *view;
     unsigned int status;
@@ -3419,6 +3665,12 @@ static NTSTATUS virtual_map_image( HANDLE mapping, void **addr_ptr, SIZE_T *size
         return status;
     }
 
+    /* failing to use the relocated sections is not fatal, they get relocated here instead */
+    if (pe_mapping->relocated_file &&
+        server_get_unix_fd( pe_mapping->relocated_file, FILE_READ_DATA,
+                            &relocated_fd, &relocated_needs_close, NULL, NULL ))
+        relocated_fd = -1;
+
     if (!pe_mapping->image.map_addr &&
         (pe_mapping->image.image_charact & IMAGE_FILE_DLL) &&
         (pe_mapping->image.image_flags & IMAGE_FLAGS_ImageDynamicallyRelocated))
@@ -3431,13 +3683,28 @@ static NTSTATUS virtual_map_image( HANDLE mapping, void **addr_ptr, SIZE_T *size
         SERVER_END_REQ;
     }
 
+    /* we are the first process to map the image at this address, share our relocations */
+    if (pe_mapping->relocated_build)
+    {
+        SERVER_START_REQ( create_relocated_image )
+        {
+            req->handle = wine_server_obj_handle( mapping );
+            if (!wine_server_call( req )) build_file = wine_server_ptr_handle( reply->file );
+        }
+        SERVER_END_REQ;
+        if (build_file && server_get_unix_fd( build_file, FILE_WRITE_DATA, &build_fd, &build_needs_close, NULL, NULL ))
+            build_fd = -1;
+    }
+
     server_enter_uninterrupted_section( &virtual_mutex, &sigset );
 
     status = map_image_view( &view, &pe_mapping->image, size, limit_low, limit_high, alloc_type );
     if (status) goto done;
 
+    written_fd = build_fd;
     status = map_image_into_view( view, &pe_mapping->nt_name, unix_fd, &pe_mapping->image,
-                                  machine, shared_fd, needs_close );
+                                  machine, shared_fd, relocated_fd, &written_fd, needs_close );
+    built = !status && written_fd != -1;
     if (status == STATUS_SUCCESS)
     {
         if (offset)
@@ -3472,6 +3739,19 @@ done:
     server_leave_uninterrupted_section( &virtual_mutex, &sigset );
     if (needs_close) close( unix_fd );
     if (shared_needs_close) close( shared_fd );
+    if (relocated_needs_close) close( relocated_fd );
+    if (build_needs_close) close( build_fd );
+    if (build_file)
+    {
+        SERVER_START_REQ( set_relocated_image )
+        {
+            req->handle  = wine_server_obj_handle( mapping );
+            req->success = built;
+            wine_server_call( req );
+        }
+        SERVER_END_REQ;
+        NtClose( build_file );
+    }
     return status;
 }
 
@@ -3677,6 +3957,7 @@ void virtual_init(void)
 #endif
 
     kernel_writewatch_init();
+    huge_pages_init();
 
     if (preload_info && *preload_info)
         for (i = 0; (*preload_info)[i].size; i++)
@@ -4138,6 +4419,7 @@ struct thread_data *virtual_alloc_thread_data(void)
         data->wait_fd[0] = -1;
         data->wait_fd[1] = -1;
         data->alert_fd   = -1;
+        data->request_slot = -1;
 #ifdef VALGRIND_STACK_REGISTER
         VALGRIND_STACK_REGISTER( (char *)data + signal_stack_mask + 1, (char *)data + view->size );
 #endif
@@ -4493,7 +4775,7 @@ void virtual_init_user_shared_data(void)
     virtual_get_system_info( &info, FALSE );
 
     data->TickCountMultiplier   = 1 << 24;
-    data->LargePageMinimum      = 2 * 1024 * 1024;
+    data->LargePageMinimum      = large_page_size;
     data->SystemCall            = 1;
     data->NumberOfPhysicalPages = info.MmNumberOfPhysicalPages;
     data->NXSupportPolicy       = NX_SUPPORT_POLICY_OPTIN;
@@ -5101,7 +5383,7 @@ static NTSTATUS allocate_virtual_memory( void **ret, SIZE_T *size_ptr, ULONG typ
 {
     void *base;
     unsigned int vprot;
-    BOOL is_dos_memory = FALSE;
+    BOOL is_dos_memory = FALSE, huge_pages = FALSE;
     struct file_view *view;
     sigset_t sigset;
     SIZE_T size = *size_ptr;
@@ -5147,6 +5429,22 @@ static NTSTATUS allocate_virtual_memory( void **ret, SIZE_T *size_ptr, ULONG typ
     if (type & MEM_RESERVE_PLACEHOLDER && (protect != PAGE_NOACCESS)) return STATUS_INVALID_PARAMETER;
     if (!arm64ec_view && (attributes & MEM_EXTENDED_PARAMETER_EC_CODE)) return STATUS_INVALID_PARAMETER;
 
+    /* large pages must be reserved and committed at once, in multiples of the large page size */
+    if (type & MEM_LARGE_PAGES)
+    {
+        if ((type & (MEM_RESERVE | MEM_COMMIT)) != (MEM_RESERVE | MEM_COMMIT)) return STATUS_INVALID_PARAMETER;
+        if ((size | (UINT_PTR)*ret) & (large_page_size - 1)) return STATUS_INVALID_PARAMETER;
+        if (type & (MEM_WRITE_WATCH | MEM_RESERVE_PLACEHOLDER)) return STATUS_INVALID_PARAMETER;
+        if (align < large_page_size) align = large_page_size;
+        huge_pages = TRUE;
+    }
+    else if (use_huge_pages && !base && (type & MEM_RESERVE) && !(type & MEM_WRITE_WATCH) &&
+             size >= large_page_size)
+    {
+        if (align < large_page_size) align = large_page_size;
+        huge_pages = TRUE;
+    }
+
     /* Reserve the memory */
 
     server_enter_uninterrupted_section( &virtual_mutex, &sigset );
@@ -5169,6 +5467,7 @@ static NTSTATUS allocate_virtual_memory( void **ret, SIZE_T *size_ptr, ULONG typ
             {
                 base = view->base;
                 if (vprot & VPROT_EXEC || force_exec_prot) mprotect_range( base, size, 0, 0 );
+                if (huge_pages) set_huge_pages( base, size );
             }
         }
     }
@@ -5224,7 +5523,8 @@ static NTSTATUS allocate_virtual_memory( void **ret, SIZE_T *size_ptr, ULONG typ
 NTSTATUS WINAPI NtAllocateVirtualMemory( HANDLE process, PVOID *ret, ULONG_PTR zero_bits,
                                          SIZE_T *size_ptr, ULONG type, ULONG protect )
 {
-    static const ULONG type_mask = MEM_COMMIT | MEM_RESERVE | MEM_TOP_DOWN | MEM_WRITE_WATCH | MEM_RESET;
+    static const ULONG type_mask = MEM_COMMIT | MEM_RESERVE | MEM_TOP_DOWN | MEM_WRITE_WATCH | MEM_RESET
+                                   | MEM_LARGE_PAGES;
     ULONG_PTR limit;
 
     TRACE("%p %p %08lx %x %08x\n", process, *ret, *size_ptr, type, protect );
@@ -5364,7 +5664,8 @@ NTSTATUS WINAPI NtAllocateVirtualMemoryEx( HANDLE process, PVOID *ret, SIZE_T *s
                                            ULONG count )
 {
     static const ULONG type_mask = MEM_COMMIT | MEM_RESERVE | MEM_TOP_DOWN | MEM_WRITE_WATCH
-                                   | MEM_RESET | MEM_RESERVE_PLACEHOLDER | MEM_REPLACE_PLACEHOLDER;
+                                   | MEM_RESET | MEM_RESERVE_PLACEHOLDER | MEM_REPLACE_PLACEHOLDER
+                                   | MEM_LARGE_PAGES;
     ULONG_PTR limit_low = 0;
     ULONG_PTR limit_high = 0;
     ULONG_PTR align = 0;
@@ -23,6 +23,11 @@
 #endif
 
 #include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "ntgdi_private.h"
 #include "dibdrv.h"
@@ -470,6 +475,213 @@ static int get_overlap( const dib_info *dst, const RECT *dst_rect,
     return ret;
 }
 
+/* Large operations are split into horizontal bands that are processed in parallel by a
+ * small pool of worker threads, which exit after a few idle seconds. Bands never share
+ * destination rows, so the result is the same as when running on a single thread. The
+ * workers are not Wine threads and can't handle page faults, so only memory owned by the
+ * driver is processed in bands; bits that the app can access, such as DIB sections, may
+ * have guard pages or write watches and are always processed on the calling thread. */
+
+#define BAND_MIN_PIXELS  (512 * 512)  /* smaller operations stay on the calling thread */
+#define BAND_MIN_ROWS    32
+#define MAX_BAND_WORKERS 7
+#define BAND_WORKER_TIMEOUT 5        /* seconds before an idle worker exits */
+
+struct band_job
+{
+    void (*func)( struct band_job *job, int band );
+    int count;    /* number of bands */
+    int next;     /* next band to process */
+    int pending;  /* number of bands not finished yet */
+};
+
+static pthread_mutex_t band_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t band_start_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t band_done_cond = PTHREAD_COND_INITIALIZER;
+static struct band_job *current_band_job;
+static int band_workers;      /* running workers */
+static int max_band_workers;
+
+/* process the next band of the current job, called with band_mutex held */
+static BOOL run_next_band( struct band_job *job )
+{
+    int band;
+
+    if (job->next == job->count) return FALSE;
+    band = job->next++;
+    pthread_mutex_unlock( &band_mutex );
+    job->func( job, band );
+    pthread_mutex_lock( &band_mutex );
+    if (!--job->pending) pthread_cond_broadcast( &band_done_cond );
+    return TRUE;
+}
+
+/* the workers don't have a TEB, they must not call anything but the primitives */
+static void *band_worker( void *arg )
+{
+    struct timespec timeout;
+
+    pthread_mutex_lock( &band_mutex );
+    for (;;)
+    {
+        if (current_band_job && run_next_band( current_band_job )) continue;
+        clock_gettime( CLOCK_REALTIME, &timeout );
+        timeout.tv_sec += BAND_WORKER_TIMEOUT;
+        if (pthread_cond_timedwait( &band_start_cond, &band_mutex, &timeout ) == ETIMEDOUT &&
+            !current_band_job)
+            break;
+    }
+    band_workers--;
+    pthread_mutex_unlock( &band_mutex );
+    return NULL;
+}
+
+/* start the workers that exited while idle, called with band_mutex held */
+static void start_band_workers(void)
+{
+    sigset_t sigset, old_sigset;
+    pthread_attr_t attr;
+    pthread_t thread;
+
+    if (band_workers == max_band_workers) return;
+
+    /* make sure the workers never handle any signal */
+    sigfillset( &sigset );
+    pthread_sigmask( SIG_BLOCK, &sigset, &old_sigset );
+    pthread_attr_init( &attr );
+    pthread_attr_setdetachstate( &attr, PTHREAD_CREATE_DETACHED );
+    while (band_workers < max_band_workers)
+    {
+        if (pthread_create( &thread, &attr, band_worker, NULL )) break;
+        band_workers++;
+    }
+    pthread_attr_destroy( &attr );
+    pthread_sigmask( SIG_SETMASK, &old_sigset, NULL );
+    TRACE( "%u band workers running\n", band_workers );
+}
+
+static void init_band_workers(void)
+{
+    long cpus = sysconf( _SC_NPROCESSORS_ONLN );
+
+    max_band_workers = max( 0, min( cpus - 1, MAX_BAND_WORKERS ));
+}
+
+/* check whether the bits of a dib can be accessed from the band workers */
+static inline BOOL can_use_bands( const dib_info *dib )
+{
+    return dib->private_bits || dib->bits.is_copy;
+}
+
+/* number of bands to split an operation on the given destination area into */
+static int get_band_count( const RECT *rect )
+{
+    static pthread_once_t init_once = PTHREAD_ONCE_INIT;
+    int rows = rect->bottom - rect->top;
+
+    if ((LONGLONG)rows * (rect->right - rect->left) < BAND_MIN_PIXELS) return 1;
+    pthread_once( &init_once, init_band_workers );
+    if (!max_band_workers) return 1;
+    return max( 1, min( rows / BAND_MIN_ROWS, 4 * (max_band_workers + 1) ));
+}
+
+/* process all the bands of a job; the calling thread takes its share of the work */
+static void run_band_job( struct band_job *job )
+{
+    int band;
+
+    job->next = 0;
+    job->pending = job->count;
+
+    pthread_mutex_lock( &band_mutex );
+    if (current_band_job)  /* the workers are busy with another thread's job */
+    {
+        pthread_mutex_unlock( &band_mutex );
+        for (band = 0; band < job->count; band++) job->func( job, band );
+        return;
+    }
+    start_band_workers();
+    current_band_job = job;
+    pthread_cond_broadcast( &band_start_cond );
+    while (run_next_band( job )) /* nothing */;
+    while (job->pending) pthread_cond_wait( &band_done_cond, &band_mutex );
+    current_band_job = NULL;
+    pthread_mutex_unlock( &band_mutex );
+}
+
+/* job applying a function to the parts of a list of clipped rectangles in each band */
+struct rects_band_job
+{
+    struct band_job job;
+    const RECT *rects;
+    int count;
+    RECT bounds;
+    LONG failed;
+    BOOL (*func)( struct rects_band_job *job, const RECT *rect );
+};
+
+static void rects_band_func( struct band_job *job, int band )
+{
+    struct rects_band_job *rects_job = CONTAINING_RECORD( job, struct rects_band_job, job );
+    const RECT *bounds = &rects_job->bounds;
+    int i, height = bounds->bottom - bounds->top;
+    RECT rect;
+
+    rect.top    = bounds->top + height * band / job->count;
+    rect.bottom = bounds->top + height * (band + 1) / job->count;
+    for (i = 0; i < rects_job->count; i++)
+    {
+        if (rects_job->rects[i].bottom <= rect.top) continue;
+        if (rects_job->rects[i].top >= rect.bottom) break;  /* the rectangles are sorted by rows */
+        rect.left  = rects_job->rects[i].left;
+        rect.right = rects_job->rects[i].right;
+        if (!rects_job->func( rects_job, &rect )) InterlockedExchange( &rects_job->failed, TRUE );
+    }
+}
+
+/* split the rectangles into bands if they cover a large enough area, and return FALSE
+ * if the operation should be done directly instead */
+static BOOL run_rects_band_job( struct rects_band_job *job, const RECT *rects, int count )
+{
+    int i;
+
+    if (!count) return FALSE;
+    job->rects = rects;
+    job->count = count;
+    job->failed = FALSE;
+    job->bounds = rects[0];
+    for (i = 1; i < count; i++)
+    {
+        job->bounds.left   = min( job->bounds.left, rects[i].left );
+        job->bounds.right  = max( job->bounds.right, rects[i].right );
+        job->bounds.bottom = max( job->bounds.bottom, rects[i].bottom );
+    }
+    if ((job->job.count = get_band_count( &job->bounds )) <= 1) return FALSE;
+    job->job.func = rects_band_func;
+    run_band_job( &job->job );
+    return TRUE;
+}
+
+struct copy_rect_job
+{
+    struct rects_band_job rects_job;
+    dib_info *dst;
+    const dib_info *src;
+    POINT offset;  /* from the destination to the source */
+    INT rop2;
+};
+
+static BOOL copy_rect_band( struct rects_band_job *job, const RECT *rect )
+{
+    struct copy_rect_job *copy_job = CONTAINING_RECORD( job, struct copy_rect_job, rects_job );
+    POINT origin;
+
+    origin.x = rect->left + copy_job->offset.x;
+    origin.y = rect->top  + copy_job->offset.y;
+    copy_job->dst->funcs->copy_rect( copy_job->dst, rect, copy_job->src, &origin, copy_job->rop2, 0 );
+    return TRUE;
+}
+
 static void copy_rect( dib_info *dst, const RECT *dst_rect, const dib_info *src, const RECT *src_rect,
                         const struct clipped_rects *clipped_rects, INT rop2 )
 {
@@ -547,6 +759,18 @@ static void copy_rect( dib_info *dst, const RECT *dst_rect, const dib_info *src,
     }
     else  /* left to right, top to bottom */
     {
+        if (!overlap && can_use_bands( dst ) && can_use_bands( src ))
+        {
+            struct copy_rect_job job;
+
+            job.rects_job.func = copy_rect_band;
+            job.dst = dst;
+            job.src = src;
+            job.offset.x = src_rect->left - dst_rect->left;
+            job.offset.y = src_rect->top  - dst_rect->top;
+            job.rop2 = rop2;
+            if (run_rects_band_job( &job.rects_job, rects, count )) return;
+        }
         for (i = 0; i < count; i++)
         {
             origin.x = src_rect->left + rects[i].left - dst_rect->left;
@@ -585,17 +809,44 @@ static void mask_rect( dib_info *dst, const RECT *dst_rect, const dib_info *src,
     }
 }
 
+struct blend_rect_job
+{
+    struct rects_band_job rects_job;
+    dib_info *dst;
+    const dib_info *src;
+    POINT offset;
+    BLENDFUNCTION blend;
+};
+
+static BOOL blend_rect_band( struct rects_band_job *job, const RECT *rect )
+{
+    struct blend_rect_job *blend_job = CONTAINING_RECORD( job, struct blend_rect_job, rects_job );
+
+    blend_job->dst->funcs->blend_rects( blend_job->dst, 1, rect, blend_job->src,
+                                        &blend_job->offset, blend_job->blend );
+    return TRUE;
+}
+
 static DWORD blend_rect( dib_info *dst, const RECT *dst_rect, const dib_info *src, const RECT *src_rect,
                          HRGN clip, BLENDFUNCTION blend )
 {
     POINT offset;
     struct clipped_rects clipped_rects;
+    struct blend_rect_job job;
 
     if (!get_clipped_rects( dst, dst_rect, clip, &clipped_rects )) return ERROR_SUCCESS;
 
     offset.x = src_rect->left - dst_rect->left;
     offset.y = src_rect->top  - dst_rect->top;
-    dst->funcs->blend_rects( dst, clipped_rects.count, clipped_rects.rects, src, &offset, blend );
+
+    job.rects_job.func = blend_rect_band;
+    job.dst = dst;
+    job.src = src;
+    job.offset = offset;
+    job.blend = blend;
+    if (get_overlap( dst, dst_rect, src, src_rect ) || !can_use_bands( dst ) || !can_use_bands( src ) ||
+        !run_rects_band_job( &job.rects_job, clipped_rects.rects, clipped_rects.count ))
+        dst->funcs->blend_rects( dst, clipped_rects.count, clipped_rects.rects, src, &offset, blend );
 
     free_clipped_rects( &clipped_rects );
     return ERROR_SUCCESS;
@@ -680,16 +931,40 @@ static void get_gradient_triangle_vertices( const GRADIENT_TRIANGLE *tri, const
     bounds->bottom = v[2].y;
 }
 
+struct gradient_rect_job
+{
+    struct rects_band_job rects_job;
+    dib_info *dib;
+    const TRIVERTEX *v;
+    int mode;
+};
+
+static BOOL gradient_rect_band( struct rects_band_job *job, const RECT *rect )
+{
+    struct gradient_rect_job *gradient_job = CONTAINING_RECORD( job, struct gradient_rect_job, rects_job );
+
+    return gradient_job->dib->funcs->gradient_rect( gradient_job->dib, rect, gradient_job->v, gradient_job->mode );
+}
+
 static BOOL gradient_rect( dib_info *dib, TRIVERTEX *v, int mode, HRGN clip, const RECT *bounds )
 {
     int i;
     struct clipped_rects clipped_rects;
+    struct gradient_rect_job job;
     BOOL ret = TRUE;
 
     if (!get_clipped_rects( dib, bounds, clip, &clipped_rects )) return TRUE;
-    for (i = 0; i < clipped_rects.count; i++)
+
+    job.rects_job.func = gradient_rect_band;
+    job.dib = dib;
+    job.v = v;
+    job.mode = mode;
+    if (can_use_bands( dib ) && run_rects_band_job( &job.rects_job, clipped_rects.rects, clipped_rects.count ))
+        ret = !job.rects_job.failed;
+    else
     {
-        if (!(ret = dib->funcs->gradient_rect( dib, &clipped_rects.rects[i], v, mode ))) break;
+        for (i = 0; i < clipped_rects.count; i++)
+            if (!(ret = dib->funcs->gradient_rect( dib, &clipped_rects.rects[i], v, mode ))) break;
     }
     free_clipped_rects( &clipped_rects );
     return ret;
@@ -734,6 +1009,7 @@ static DWORD create_tmp_dib( const dib_info *copy, int width, int height, dib_in
     ret->bits.is_copy = TRUE;
     ret->bits.free = free_heap_bits;
     ret->bits.param = NULL;
+    ret->private_bits = TRUE;
 
     return ret->bits.ptr ? ERROR_SUCCESS : ERROR_OUTOFMEMORY;
 }
@@ -1198,27 +1474,168 @@ static DWORD calc_1d_stretch_params( INT dst_start, INT dst_length, INT dst_vis_
 }
 
 
-DWORD stretch_bitmapinfo( const BITMAPINFO *src_info, void *src_bits, struct bitblt_coords *src,
-                          const BITMAPINFO *dst_info, void *dst_bits, struct bitblt_coords *dst,
-                          INT mode )
+/* position in the destination and source rows of a stretch operation */
+struct stretch_state
+{
+    POINT dst_start;
+    POINT src_start;
+    int err;
+    unsigned int length;  /* number of steps left */
+};
+
+struct stretch_rows
+{
+    struct band_job job;
+    dib_info *dst_dib;
+    dib_info *src_dib;
+    const struct stretch_params *h_params;
+    const struct stretch_params *v_params;
+    void (* row_fn)(const dib_info *dst_dib, const POINT *dst_start,
+                    const dib_info *src_dib, const POINT *src_start,
+                    const struct stretch_params *params, int mode, BOOL keep_dst);
+    int mode;
+    BOOL vstretch;
+    int width;
+    struct stretch_state *bands;
+};
+
+static void stretch_rows( const struct stretch_rows *rows, const struct stretch_state *state )
+{
+    const struct stretch_params *v_params = rows->v_params;
+    POINT dst_start = state->dst_start, src_start = state->src_start;
+    unsigned int length = state->length;
+    int err = state->err;
+
+    if (rows->vstretch)
+    {
+        BOOL need_row = TRUE;
+        RECT last_row, this_row;
+        last_row.left = 0;
+        last_row.right = rows->width;
+
+        while (length--)
+        {
+            if (need_row)
+            {
+                rows->row_fn( rows->dst_dib, &dst_start, rows->src_dib, &src_start, rows->h_params, rows->mode, FALSE );
+                need_row = FALSE;
+            }
+            else
+            {
+                last_row.top = dst_start.y - v_params->dst_inc;
+                last_row.bottom = last_row.top + 1;
+                this_row = last_row;
+                OffsetRect( &this_row, 0, v_params->dst_inc );
+                copy_rect( rows->dst_dib, &this_row, rows->dst_dib, &last_row, NULL, R2_COPYPEN );
+            }
+
+            if (err > 0)
+            {
+                src_start.y += v_params->src_inc;
+                need_row = TRUE;
+                err += v_params->err_add_1;
+            }
+            else err += v_params->err_add_2;
+            dst_start.y += v_params->dst_inc;
+        }
+    }
+    else
+    {
+        int merged_rows = 0;
+
+        while (length--)
+        {
+            if (rows->mode != STRETCH_DELETESCANS || !merged_rows)
+                rows->row_fn( rows->dst_dib, &dst_start, rows->src_dib, &src_start, rows->h_params,
+                              rows->mode, merged_rows != 0 );
+            merged_rows++;
+
+            if (err > 0)
+            {
+                dst_start.y += v_params->dst_inc;
+                merged_rows = 0;
+                err += v_params->err_add_1;
+            }
+            else err += v_params->err_add_2;
+            src_start.y += v_params->src_inc;
+        }
+    }
+}
+
+static void stretch_rows_band( struct band_job *job, int band )
+{
+    struct stretch_rows *rows = CONTAINING_RECORD( job, struct stretch_rows, job );
+
+    stretch_rows( rows, &rows->bands[band] );
+}
+
+/* find the starting state of each band; a band always starts on a new destination row,
+ * which it builds from scratch so that it never reads rows from the previous band */
+static int split_stretch_rows( struct stretch_rows *rows, const struct stretch_state *state, int height )
+{
+    const struct stretch_params *v_params = rows->v_params;
+    struct stretch_state cur = *state;
+    int band = 0, band_rows = 0, merged_rows = 0, rows_per_band = (height + rows->job.count - 1) / rows->job.count;
+
+    rows->bands[0] = cur;
+    for (; cur.length; cur.length--)
+    {
+        if (band_rows >= rows_per_band && !merged_rows && band + 1 < rows->job.count)
+        {
+            rows->bands[band].length -= cur.length;
+            rows->bands[++band] = cur;
+            band_rows = 0;
+        }
+
+        if (rows->vstretch)
+        {
+            band_rows++;
+            if (cur.err > 0)
+            {
+                cur.src_start.y += v_params->src_inc;
+                cur.err += v_params->err_add_1;
+            }
+            else cur.err += v_params->err_add_2;
+            cur.dst_start.y += v_params->dst_inc;
+        }
+        else
+        {
+            merged_rows++;
+            if (cur.err > 0)
+            {
+                cur.dst_start.y += v_params->dst_inc;
+                merged_rows = 0;
+                band_rows++;
+                cur.err += v_params->err_add_1;
+            }
+            else cur.err += v_params->err_add_2;
+            cur.src_start.y += v_params->src_inc;
+        }
+    }
+    return band + 1;
+}
+
+DWORD stretch_bitmapinfo( const BITMAPINFO *src_info, const struct gdi_image_bits *src_bits,
+                          struct bitblt_coords *src, const BITMAPINFO *dst_info, void *dst_bits,
+                          struct bitblt_coords *dst, INT mode )
 {
     dib_info src_dib, dst_dib;
     POINT dst_start, src_start, dst_end, src_end;
     RECT rect;
     BOOL hstretch, vstretch;
     struct stretch_params v_params, h_params;
-    int err;
+    struct stretch_rows rows;
+    struct stretch_state state;
     DWORD ret;
-    void (* row_fn)(const dib_info *dst_dib, const POINT *dst_start,
-                    const dib_info *src_dib, const POINT *src_start,
-                    const struct stretch_params *params, int mode, BOOL keep_dst);
 
     TRACE("dst %d, %d - %d x %d visrect %s src %d, %d - %d x %d visrect %s\n",
           dst->x, dst->y, dst->width, dst->height, wine_dbgstr_rect(&dst->visrect),
           src->x, src->y, src->width, src->height, wine_dbgstr_rect(&src->visrect));
 
-    init_dib_info_from_bitmapinfo( &src_dib, src_info, src_bits );
+    init_dib_info_from_bitmapinfo( &src_dib, src_info, src_bits->ptr );
     init_dib_info_from_bitmapinfo( &dst_dib, dst_info, dst_bits );
+    src_dib.bits.is_copy = src_bits->is_copy;
+    dst_dib.private_bits = TRUE;  /* always a temporary buffer */
 
     if (mode == HALFTONE)
     {
@@ -1251,64 +1668,31 @@ DWORD stretch_bitmapinfo( const BITMAPINFO *src_info, void *src_bits, struct bit
     dst_start.x -= dst->visrect.left;
     dst_start.y -= dst->visrect.top;
 
-    err = v_params.err_start;
-
-    row_fn = hstretch ? dst_dib.funcs->stretch_row : dst_dib.funcs->shrink_row;
-
-    if (vstretch)
+    rows.dst_dib  = &dst_dib;
+    rows.src_dib  = &src_dib;
+    rows.h_params = &h_params;
+    rows.v_params = &v_params;
+    rows.row_fn   = hstretch ? dst_dib.funcs->stretch_row : dst_dib.funcs->shrink_row;
+    rows.mode     = (vstretch && hstretch) ? STRETCH_DELETESCANS : mode;
+    rows.vstretch = vstretch;
+    rows.width    = dst->visrect.right - dst->visrect.left;
+
+    state.dst_start = dst_start;
+    state.src_start = src_start;
+    state.err       = v_params.err_start;
+    state.length    = v_params.length;
+
+    if (src_bits->ptr != dst_bits && dst_dib.funcs != &funcs_null &&
+        can_use_bands( &src_dib ) && can_use_bands( &dst_dib ) &&
+        (rows.job.count = get_band_count( &dst->visrect )) > 1 &&
+        (rows.bands = malloc( rows.job.count * sizeof(*rows.bands) )))
     {
-        BOOL need_row = TRUE;
-        RECT last_row, this_row;
-        if (hstretch) mode = STRETCH_DELETESCANS;
-        last_row.left = 0;
-        last_row.right = dst->visrect.right - dst->visrect.left;
-
-        while (v_params.length--)
-        {
-            if (need_row)
-            {
-                row_fn( &dst_dib, &dst_start, &src_dib, &src_start, &h_params, mode, FALSE );
-                need_row = FALSE;
-            }
-            else
-            {
-                last_row.top = dst_start.y - v_params.dst_inc;
-                last_row.bottom = last_row.top + 1;
-                this_row = last_row;
-                OffsetRect( &this_row, 0, v_params.dst_inc );
-                copy_rect( &dst_dib, &this_row, &dst_dib, &last_row, NULL, R2_COPYPEN );
-            }
-
-            if (err > 0)
-            {
-                src_start.y += v_params.src_inc;
-                need_row = TRUE;
-                err += v_params.err_add_1;
-            }
-            else err += v_params.err_add_2;
-            dst_start.y += v_params.dst_inc;
-        }
-    }
-    else
-    {
-        int merged_rows = 0;
-
-        while (v_params.length--)
-        {
-            if (mode != STRETCH_DELETESCANS || !merged_rows)
-                row_fn( &dst_dib, &dst_start, &src_dib, &src_start, &h_params, mode, merged_rows != 0 );
-            merged_rows++;
-
-            if (err > 0)
-            {
-                dst_start.y += v_params.dst_inc;
-                merged_rows = 0;
-                err += v_params.err_add_1;
-            }
-            else err += v_params.err_add_2;
-            src_start.y += v_params.src_inc;
-        }
+        rows.job.count = split_stretch_rows( &rows, &state, dst->visrect.bottom - dst->visrect.top );
+        rows.job.func = stretch_rows_band;
+        run_band_job( &rows.job );
+        free( rows.bands );
     }
+    else stretch_rows( &rows, &state );
 
 done:
     /* update coordinates, the destination rectangle is always stored at 0,0 */
@@ -1319,14 +1703,16 @@ done:
     return ERROR_SUCCESS;
 }
 
-DWORD blend_bitmapinfo( const BITMAPINFO *src_info, void *src_bits, struct bitblt_coords *src,
-                        const BITMAPINFO *dst_info, void *dst_bits, struct bitblt_coords *dst,
-                        BLENDFUNCTION blend )
+DWORD blend_bitmapinfo( const BITMAPINFO *src_info, const struct gdi_image_bits *src_bits,
+                        struct bitblt_coords *src, const BITMAPINFO *dst_info, void *dst_bits,
+                        struct bitblt_coords *dst, BLENDFUNCTION blend )
 {
     dib_info src_dib, dst_dib;
 
-    init_dib_info_from_bitmapinfo( &src_dib, src_info, src_bits );
+    init_dib_info_from_bitmapinfo( &src_dib, src_info, src_bits->ptr );
     init_dib_info_from_bitmapinfo( &dst_dib, dst_info, dst_bits );
+    src_dib.bits.is_copy = src_bits->is_copy;
+    dst_dib.private_bits = TRUE;  /* always a temporary buffer */
 
     return blend_rect( &dst_dib, &dst->visrect, &src_dib, &src->visrect, NULL, blend );
 }
@@ -1344,6 +1730,7 @@ DWORD gradient_bitmapinfo( const BITMAPINFO *info, void *bits, TRIVERTEX *vert_a
     DWORD ret = ERROR_SUCCESS;
 
     init_dib_info_from_bitmapinfo( &dib, info, bits );
+    dib.private_bits = TRUE;  /* always a temporary buffer */
 
     switch (mode)
     {
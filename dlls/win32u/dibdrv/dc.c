@@ -88,6 +88,7 @@ static void init_dib_info(dib_info *dib, const BITMAPINFOHEADER *bi, int stride,
     dib->bits.is_copy = FALSE;
     dib->bits.free    = NULL;
     dib->bits.param   = NULL;
+    dib->private_bits = FALSE;
 
     if(dib->height < 0) /* top-down */
     {
@@ -174,6 +175,7 @@ BOOL init_dib_info_from_bitmapobj(dib_info *dib, BITMAPOBJ *bmp)
 
         get_ddb_bitmapinfo( bmp, &info );
         init_dib_info_from_bitmapinfo( dib, &info, bmp->dib.dsBm.bmBits );
+        dib->private_bits = TRUE;
     }
     else init_dib_info( dib, &bmp->dib.dsBmih, bmp->dib.dsBm.bmWidthBytes,
                         bmp->dib.dsBitfields, bmp->color_table, bmp->dib.dsBm.bmBits );
@@ -597,6 +599,7 @@ void dibdrv_set_window_surface( DC *dc, struct window_surface *surface )
             init_dib_info_from_bitmapobj( &dibdrv->dib, bmp );
             GDI_ReleaseObj( surface->color_bitmap );
         }
+        dibdrv->dib.private_bits = TRUE;  /* the surface bits are never exposed to the app */
         dibdrv->dib.rect = dc->attr->vis_rect;
         OffsetRect( &dibdrv->dib.rect, -dc->device_rect.left, -dc->device_rect.top );
         dibdrv->bounds = &surface->bounds;
@@ -23,6 +23,9 @@
 #endif
 
 #include <assert.h>
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#include <immintrin.h>
+#endif
 
 #include "ntgdi_private.h"
 #include "dibdrv.h"
@@ -244,6 +247,265 @@ static inline void do_rop_codes_line_rev_4(BYTE *dst, int dst_x, const BYTE *src
     }
 }
 
+/* The SIMD kernels below handle the bulk of a row and return the number of pixels they
+ * have processed; the callers finish the row with the scalar code, so the kernels must
+ * produce exactly the same results. */
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+
+#define SSE2_TARGET  __attribute__((target("sse2")))
+#define SSSE3_TARGET __attribute__((target("ssse3")))
+#define AVX2_TARGET  __attribute__((target("avx2")))
+
+/* WINEDIBSIMD=0 disables the kernels, to compare them with the scalar code */
+static int simd_enabled = -1;
+
+static inline BOOL use_simd(void)
+{
+    if (simd_enabled == -1)
+    {
+        const char *env = getenv( "WINEDIBSIMD" );
+        simd_enabled = !env || atoi( env );
+    }
+    return simd_enabled;
+}
+
+static inline BOOL have_sse2(void)
+{
+#ifdef __x86_64__
+    return use_simd();
+#else
+    return use_simd() && __builtin_cpu_supports( "sse2" );
+#endif
+}
+
+static inline BOOL have_ssse3(void)
+{
+    return use_simd() && __builtin_cpu_supports( "ssse3" );
+}
+
+static inline BOOL have_avx2(void)
+{
+    return use_simd() && __builtin_cpu_supports( "avx2" );
+}
+
+static inline BOOL have_simd_primitives(void)
+{
+    return have_sse2();
+}
+
+/* the scalar code processes pixels one at a time, so a destination starting slightly
+ * after the source in the same buffer sees values it has just written */
+static inline BOOL simd_overlap( const void *dst, const void *src, int size )
+{
+    return (const BYTE *)dst > (const BYTE *)src && (const BYTE *)dst - (const BYTE *)src < size;
+}
+
+static int SSE2_TARGET rop_codes_row_32_sse2( DWORD *dst, const DWORD *src, const struct rop_codes *codes, int len )
+{
+    const __m128i a1 = _mm_set1_epi32( codes->a1 ), a2 = _mm_set1_epi32( codes->a2 );
+    const __m128i x1 = _mm_set1_epi32( codes->x1 ), x2 = _mm_set1_epi32( codes->x2 );
+    __m128i s, d;
+    int x;
+
+    for (x = 0; x + 4 <= len; x += 4)
+    {
+        s = _mm_loadu_si128( (const __m128i *)(src + x) );
+        d = _mm_loadu_si128( (const __m128i *)(dst + x) );
+        d = _mm_and_si128( d, _mm_xor_si128( _mm_and_si128( s, a1 ), a2 ));
+        d = _mm_xor_si128( d, _mm_xor_si128( _mm_and_si128( s, x1 ), x2 ));
+        _mm_storeu_si128( (__m128i *)(dst + x), d );
+    }
+    return x;
+}
+
+static int AVX2_TARGET rop_codes_row_32_avx2( DWORD *dst, const DWORD *src, const struct rop_codes *codes, int len )
+{
+    const __m256i a1 = _mm256_set1_epi32( codes->a1 ), a2 = _mm256_set1_epi32( codes->a2 );
+    const __m256i x1 = _mm256_set1_epi32( codes->x1 ), x2 = _mm256_set1_epi32( codes->x2 );
+    __m256i s, d;
+    int x;
+
+    for (x = 0; x + 8 <= len; x += 8)
+    {
+        s = _mm256_loadu_si256( (const __m256i *)(src + x) );
+        d = _mm256_loadu_si256( (const __m256i *)(dst + x) );
+        d = _mm256_and_si256( d, _mm256_xor_si256( _mm256_and_si256( s, a1 ), a2 ));
+        d = _mm256_xor_si256( d, _mm256_xor_si256( _mm256_and_si256( s, x1 ), x2 ));
+        _mm256_storeu_si256( (__m256i *)(dst + x), d );
+    }
+    return x;
+}
+
+static int rop_codes_row_32( DWORD *dst, const DWORD *src, const struct rop_codes *codes, int len )
+{
+    int x = 0;
+
+    if (simd_overlap( dst, src, 8 * sizeof(DWORD) )) return 0;
+    if (have_avx2()) x = rop_codes_row_32_avx2( dst, src, codes, len );
+    if (have_sse2()) x += rop_codes_row_32_sse2( dst + x, src + x, codes, len - x );
+    return x;
+}
+
+/* see the funcs_555 case of convert_to_8888 */
+static inline __m128i SSE2_TARGET convert_555_to_8888_sse2( __m128i v )
+{
+    return _mm_or_si128(
+        _mm_or_si128( _mm_or_si128( _mm_and_si128( _mm_slli_epi32( v, 9 ), _mm_set1_epi32( 0xf80000 )),
+                                    _mm_and_si128( _mm_slli_epi32( v, 4 ), _mm_set1_epi32( 0x070000 ))),
+                      _mm_or_si128( _mm_and_si128( _mm_slli_epi32( v, 6 ), _mm_set1_epi32( 0x00f800 )),
+                                    _mm_and_si128( _mm_slli_epi32( v, 1 ), _mm_set1_epi32( 0x000700 )))),
+        _mm_or_si128( _mm_and_si128( _mm_slli_epi32( v, 3 ), _mm_set1_epi32( 0x0000f8 )),
+                      _mm_and_si128( _mm_srli_epi32( v, 2 ), _mm_set1_epi32( 0x000007 ))));
+}
+
+static inline __m256i AVX2_TARGET convert_555_to_8888_avx2( __m256i v )
+{
+    return _mm256_or_si256(
+        _mm256_or_si256( _mm256_or_si256( _mm256_and_si256( _mm256_slli_epi32( v, 9 ), _mm256_set1_epi32( 0xf80000 )),
+                                          _mm256_and_si256( _mm256_slli_epi32( v, 4 ), _mm256_set1_epi32( 0x070000 ))),
+                         _mm256_or_si256( _mm256_and_si256( _mm256_slli_epi32( v, 6 ), _mm256_set1_epi32( 0x00f800 )),
+                                          _mm256_and_si256( _mm256_slli_epi32( v, 1 ), _mm256_set1_epi32( 0x000700 )))),
+        _mm256_or_si256( _mm256_and_si256( _mm256_slli_epi32( v, 3 ), _mm256_set1_epi32( 0x0000f8 )),
+                         _mm256_and_si256( _mm256_srli_epi32( v, 2 ), _mm256_set1_epi32( 0x000007 ))));
+}
+
+static int SSE2_TARGET convert_row_555_to_8888_sse2( DWORD *dst, const WORD *src, int len )
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i v;
+    int x;
+
+    for (x = 0; x + 8 <= len; x += 8)
+    {
+        v = _mm_loadu_si128( (const __m128i *)(src + x) );
+        _mm_storeu_si128( (__m128i *)(dst + x), convert_555_to_8888_sse2( _mm_unpacklo_epi16( v, zero )));
+        _mm_storeu_si128( (__m128i *)(dst + x + 4), convert_555_to_8888_sse2( _mm_unpackhi_epi16( v, zero )));
+    }
+    return x;
+}
+
+static int AVX2_TARGET convert_row_555_to_8888_avx2( DWORD *dst, const WORD *src, int len )
+{
+    int x;
+
+    for (x = 0; x + 8 <= len; x += 8)
+    {
+        __m256i v = _mm256_cvtepu16_epi32( _mm_loadu_si128( (const __m128i *)(src + x) ));
+        _mm256_storeu_si256( (__m256i *)(dst + x), convert_555_to_8888_avx2( v ));
+    }
+    return x;
+}
+
+static int convert_row_555_to_8888( DWORD *dst, const WORD *src, int len )
+{
+    if (have_avx2()) return convert_row_555_to_8888_avx2( dst, src, len );
+    if (have_sse2()) return convert_row_555_to_8888_sse2( dst, src, len );
+    return 0;
+}
+
+/* 32-bpp source with 8-bit channels at arbitrary positions */
+static int SSE2_TARGET convert_row_shifts_to_8888_sse2( DWORD *dst, const DWORD *src, int len,
+                                                        int red_shift, int green_shift, int blue_shift )
+{
+    const __m128i red = _mm_cvtsi32_si128( red_shift ), green = _mm_cvtsi32_si128( green_shift );
+    const __m128i blue = _mm_cvtsi32_si128( blue_shift ), mask = _mm_set1_epi32( 0xff );
+    __m128i v;
+    int x;
+
+    for (x = 0; x + 4 <= len; x += 4)
+    {
+        v = _mm_loadu_si128( (const __m128i *)(src + x) );
+        v = _mm_or_si128( _mm_or_si128( _mm_slli_epi32( _mm_and_si128( _mm_srl_epi32( v, red ), mask ), 16 ),
+                                        _mm_slli_epi32( _mm_and_si128( _mm_srl_epi32( v, green ), mask ), 8 )),
+                          _mm_and_si128( _mm_srl_epi32( v, blue ), mask ));
+        _mm_storeu_si128( (__m128i *)(dst + x), v );
+    }
+    return x;
+}
+
+static int AVX2_TARGET convert_row_shifts_to_8888_avx2( DWORD *dst, const DWORD *src, int len,
+                                                        int red_shift, int green_shift, int blue_shift )
+{
+    const __m128i red = _mm_cvtsi32_si128( red_shift ), green = _mm_cvtsi32_si128( green_shift );
+    const __m128i blue = _mm_cvtsi32_si128( blue_shift );
+    const __m256i mask = _mm256_set1_epi32( 0xff );
+    __m256i v;
+    int x;
+
+    for (x = 0; x + 8 <= len; x += 8)
+    {
+        v = _mm256_loadu_si256( (const __m256i *)(src + x) );
+        v = _mm256_or_si256( _mm256_or_si256( _mm256_slli_epi32( _mm256_and_si256( _mm256_srl_epi32( v, red ), mask ), 16 ),
+                                              _mm256_slli_epi32( _mm256_and_si256( _mm256_srl_epi32( v, green ), mask ), 8 )),
+                             _mm256_and_si256( _mm256_srl_epi32( v, blue ), mask ));
+        _mm256_storeu_si256( (__m256i *)(dst + x), v );
+    }
+    return x;
+}
+
+static int convert_row_shifts_to_8888( DWORD *dst, const DWORD *src, int len,
+                                       int red_shift, int green_shift, int blue_shift )
+{
+    int x = 0;
+
+    if (have_avx2()) x = convert_row_shifts_to_8888_avx2( dst, src, len, red_shift, green_shift, blue_shift );
+    if (have_sse2()) x += convert_row_shifts_to_8888_sse2( dst + x, src + x, len - x,
+                                                           red_shift, green_shift, blue_shift );
+    return x;
+}
+
+/* the loads are 16 bytes wide for 12 bytes of pixels, so stop early enough to stay within the row */
+static int SSSE3_TARGET convert_row_24_to_8888_ssse3( DWORD *dst, const BYTE *src, int len )
+{
+    const __m128i shuffle = _mm_setr_epi8( 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1 );
+    __m128i v;
+    int x;
+
+    for (x = 0; x + 6 <= len; x += 4)
+    {
+        v = _mm_loadu_si128( (const __m128i *)(src + 3 * x) );
+        _mm_storeu_si128( (__m128i *)(dst + x), _mm_shuffle_epi8( v, shuffle ));
+    }
+    return x;
+}
+
+static int AVX2_TARGET convert_row_24_to_8888_avx2( DWORD *dst, const BYTE *src, int len )
+{
+    const __m256i shuffle = _mm256_setr_epi8( 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                              0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1 );
+    __m256i v;
+    int x;
+
+    for (x = 0; x + 10 <= len; x += 8)
+    {
+        v = _mm256_inserti128_si256( _mm256_castsi128_si256( _mm_loadu_si128( (const __m128i *)(src + 3 * x) )),
+                                     _mm_loadu_si128( (const __m128i *)(src + 3 * x + 12) ), 1 );
+        _mm256_storeu_si256( (__m256i *)(dst + x), _mm256_shuffle_epi8( v, shuffle ));
+    }
+    return x;
+}
+
+static int convert_row_24_to_8888( DWORD *dst, const BYTE *src, int len )
+{
+    int x = 0;
+
+    if (have_avx2()) x = convert_row_24_to_8888_avx2( dst, src, len );
+    if (have_ssse3()) x += convert_row_24_to_8888_ssse3( dst + x, src + 3 * x, len - x );
+    return x;
+}
+
+#else  /* __GNUC__ && (__i386__ || __x86_64__) */
+
+static inline BOOL have_simd_primitives(void) { return FALSE; }
+static inline int rop_codes_row_32( DWORD *dst, const DWORD *src, const struct rop_codes *codes, int len ) { return 0; }
+static inline int convert_row_555_to_8888( DWORD *dst, const WORD *src, int len ) { return 0; }
+static inline int convert_row_shifts_to_8888( DWORD *dst, const DWORD *src, int len,
+                                              int red_shift, int green_shift, int blue_shift ) { return 0; }
+static inline int convert_row_24_to_8888( DWORD *dst, const BYTE *src, int len ) { return 0; }
+
+#endif  /* __GNUC__ && (__i386__ || __x86_64__) */
+
 static inline void memset_32( DWORD *start, DWORD val, DWORD size )
 {
 #if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
@@ -1345,6 +1607,17 @@ static inline void copy_rect_bits_32( DWORD *dst_start, const DWORD *src_start,
     DWORD *dst;
     int x, y;
 
+    if (rop2 != R2_NOP && have_simd_primitives())
+    {
+        struct rop_codes codes;
+
+        get_rop_codes( rop2, &codes );
+        for (y = 0; y < size->cy; y++, dst_start += dst_stride, src_start += src_stride)
+            for (x = rop_codes_row_32( dst_start, src_start, &codes, size->cx ); x < size->cx; x++)
+                do_rop_codes_32( dst_start + x, src_start[x], &codes );
+        return;
+    }
+
 #define LOOP( op )                                                                     \
     for (y = 0; y < size->cy; y++, dst_start += dst_stride, src_start += src_stride)   \
         for (x = 0, src = src_start, dst = dst_start; x < size->cx; x++, src++, dst++) \
@@ -2248,9 +2521,11 @@ static void convert_to_8888(dib_info *dst, const dib_info *src, const RECT *src_
         {
             for(y = src_rect->top; y < src_rect->bottom; y++)
             {
-                dst_pixel = dst_start;
-                src_pixel = src_start;
-                for(x = src_rect->left; x < src_rect->right; x++)
+                x = convert_row_shifts_to_8888( dst_start, src_start, src_rect->right - src_rect->left,
+                                                src->red_shift, src->green_shift, src->blue_shift );
+                dst_pixel = dst_start + x;
+                src_pixel = src_start + x;
+                for(x += src_rect->left; x < src_rect->right; x++)
                 {
                     src_val = *src_pixel++;
                     *dst_pixel++ = (((src_val >> src->red_shift)   & 0xff) << 16) |
@@ -2289,9 +2564,10 @@ static void convert_to_8888(dib_info *dst, const dib_info *src, const RECT *src_
 
         for(y = src_rect->top; y < src_rect->bottom; y++)
         {
-            dst_pixel = dst_start;
-            src_pixel = src_start;
-            for(x = src_rect->left; x < src_rect->right; x++)
+            x = convert_row_24_to_8888( dst_start, src_start, src_rect->right - src_rect->left );
+            dst_pixel = dst_start + x;
+            src_pixel = src_start + 3 * x;
+            for(x += src_rect->left; x < src_rect->right; x++)
             {
                 RGBQUAD rgb;
                 rgb.rgbBlue  = *src_pixel++;
@@ -2314,9 +2590,10 @@ static void convert_to_8888(dib_info *dst, const dib_info *src, const RECT *src_
         {
             for(y = src_rect->top; y < src_rect->bottom; y++)
             {
-                dst_pixel = dst_start;
-                src_pixel = src_start;
-                for(x = src_rect->left; x < src_rect->right; x++)
+                x = convert_row_555_to_8888( dst_start, src_start, src_rect->right - src_rect->left );
+                dst_pixel = dst_start + x;
+                src_pixel = src_start + x;
+                for(x += src_rect->left; x < src_rect->right; x++)
                 {
                     src_val = *src_pixel++;
                     *dst_pixel++ = ((src_val << 9) & 0xf80000) | ((src_val << 4) & 0x070000) |
@@ -4682,6 +4959,175 @@ static inline DWORD blend_rgb( BYTE dst_r, BYTE dst_g, BYTE dst_b, DWORD src, BL
             blend_color( dst_r, src >> 16, blend.SourceConstantAlpha ) << 16);
 }
 
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+
+/* (v + 127) / 255 on 16-bit channels, for v <= 255 * 255 */
+static inline __m128i SSE2_TARGET div255_sse2( __m128i v )
+{
+    v = _mm_add_epi16( v, _mm_set1_epi16( 127 ));
+    return _mm_srli_epi16( _mm_add_epi16( _mm_add_epi16( v, _mm_set1_epi16( 1 )), _mm_srli_epi16( v, 8 )), 8 );
+}
+
+static inline __m256i AVX2_TARGET div255_avx2( __m256i v )
+{
+    v = _mm256_add_epi16( v, _mm256_set1_epi16( 127 ));
+    return _mm256_srli_epi16( _mm256_add_epi16( _mm256_add_epi16( v, _mm256_set1_epi16( 1 )),
+                                                _mm256_srli_epi16( v, 8 )), 8 );
+}
+
+/* with sources that aren't premultiplied the channels of blend_argb() can exceed 255,
+ * and the scalar code lets the extra bit spill into the next channel */
+static inline __m128i SSE2_TARGET pack_argb_sse2( __m128i lo, __m128i hi )
+{
+    const __m128i mask = _mm_set1_epi16( 0xff );
+    __m128i res = _mm_packus_epi16( _mm_and_si128( lo, mask ), _mm_and_si128( hi, mask ));
+    __m128i carry = _mm_packus_epi16( _mm_srli_epi16( lo, 8 ), _mm_srli_epi16( hi, 8 ));
+    return _mm_or_si128( res, _mm_slli_epi32( carry, 8 ));
+}
+
+static inline __m256i AVX2_TARGET pack_argb_avx2( __m256i lo, __m256i hi )
+{
+    const __m256i mask = _mm256_set1_epi16( 0xff );
+    __m256i res = _mm256_packus_epi16( _mm256_and_si256( lo, mask ), _mm256_and_si256( hi, mask ));
+    __m256i carry = _mm256_packus_epi16( _mm256_srli_epi16( lo, 8 ), _mm256_srli_epi16( hi, 8 ));
+    return _mm256_or_si256( res, _mm256_slli_epi32( carry, 8 ));
+}
+
+/* blend_argb() on two unpacked pixels */
+static inline __m128i SSE2_TARGET blend_argb_sse2( __m128i dst, __m128i src )
+{
+    __m128i alpha = _mm_shufflehi_epi16( _mm_shufflelo_epi16( src, 0xff ), 0xff );
+    alpha = _mm_sub_epi16( _mm_set1_epi16( 255 ), alpha );
+    return _mm_add_epi16( src, div255_sse2( _mm_mullo_epi16( dst, alpha )));
+}
+
+static inline __m256i AVX2_TARGET blend_argb_avx2( __m256i dst, __m256i src )
+{
+    __m256i alpha = _mm256_shufflehi_epi16( _mm256_shufflelo_epi16( src, 0xff ), 0xff );
+    alpha = _mm256_sub_epi16( _mm256_set1_epi16( 255 ), alpha );
+    return _mm256_add_epi16( src, div255_avx2( _mm256_mullo_epi16( dst, alpha )));
+}
+
+/* blend_argb_alpha(), or blend_argb() for alpha == 255 */
+static int SSE2_TARGET blend_argb_row_sse2( DWORD *dst, const DWORD *src, int len, DWORD alpha )
+{
+    const __m128i zero = _mm_setzero_si128(), a = _mm_set1_epi16( alpha );
+    __m128i s, d, s_lo, s_hi;
+    int x;
+
+    for (x = 0; x + 4 <= len; x += 4)
+    {
+        s = _mm_loadu_si128( (const __m128i *)(src + x) );
+        d = _mm_loadu_si128( (const __m128i *)(dst + x) );
+        s_lo = _mm_unpacklo_epi8( s, zero );
+        s_hi = _mm_unpackhi_epi8( s, zero );
+        if (alpha != 255)
+        {
+            s_lo = div255_sse2( _mm_mullo_epi16( s_lo, a ));
+            s_hi = div255_sse2( _mm_mullo_epi16( s_hi, a ));
+        }
+        d = pack_argb_sse2( blend_argb_sse2( _mm_unpacklo_epi8( d, zero ), s_lo ),
+                            blend_argb_sse2( _mm_unpackhi_epi8( d, zero ), s_hi ));
+        _mm_storeu_si128( (__m128i *)(dst + x), d );
+    }
+    return x;
+}
+
+static int AVX2_TARGET blend_argb_row_avx2( DWORD *dst, const DWORD *src, int len, DWORD alpha )
+{
+    const __m256i zero = _mm256_setzero_si256(), a = _mm256_set1_epi16( alpha );
+    __m256i s, d, s_lo, s_hi;
+    int x;
+
+    for (x = 0; x + 8 <= len; x += 8)
+    {
+        s = _mm256_loadu_si256( (const __m256i *)(src + x) );
+        d = _mm256_loadu_si256( (const __m256i *)(dst + x) );
+        s_lo = _mm256_unpacklo_epi8( s, zero );
+        s_hi = _mm256_unpackhi_epi8( s, zero );
+        if (alpha != 255)
+        {
+            s_lo = div255_avx2( _mm256_mullo_epi16( s_lo, a ));
+            s_hi = div255_avx2( _mm256_mullo_epi16( s_hi, a ));
+        }
+        d = pack_argb_avx2( blend_argb_avx2( _mm256_unpacklo_epi8( d, zero ), s_lo ),
+                            blend_argb_avx2( _mm256_unpackhi_epi8( d, zero ), s_hi ));
+        _mm256_storeu_si256( (__m256i *)(dst + x), d );
+    }
+    return x;
+}
+
+static int blend_argb_row( DWORD *dst, const DWORD *src, int len, DWORD alpha )
+{
+    int x = 0;
+
+    if (simd_overlap( dst, src, 8 * sizeof(DWORD) )) return 0;
+    if (have_avx2()) x = blend_argb_row_avx2( dst, src, len, alpha );
+    if (have_sse2()) x += blend_argb_row_sse2( dst + x, src + x, len - x, alpha );
+    return x;
+}
+
+/* blend_argb_constant_alpha(), or blend_argb_no_src_alpha() with src_alpha set to 0xff000000 */
+static int SSE2_TARGET blend_constant_alpha_row_sse2( DWORD *dst, const DWORD *src, int len,
+                                                      DWORD alpha, DWORD src_alpha )
+{
+    const __m128i zero = _mm_setzero_si128(), mask = _mm_set1_epi32( src_alpha );
+    const __m128i a = _mm_set1_epi16( alpha ), inv = _mm_set1_epi16( 255 - alpha );
+    __m128i s, d, lo, hi;
+    int x;
+
+    for (x = 0; x + 4 <= len; x += 4)
+    {
+        s = _mm_or_si128( _mm_loadu_si128( (const __m128i *)(src + x) ), mask );
+        d = _mm_loadu_si128( (const __m128i *)(dst + x) );
+        lo = div255_sse2( _mm_add_epi16( _mm_mullo_epi16( _mm_unpacklo_epi8( s, zero ), a ),
+                                         _mm_mullo_epi16( _mm_unpacklo_epi8( d, zero ), inv )));
+        hi = div255_sse2( _mm_add_epi16( _mm_mullo_epi16( _mm_unpackhi_epi8( s, zero ), a ),
+                                         _mm_mullo_epi16( _mm_unpackhi_epi8( d, zero ), inv )));
+        _mm_storeu_si128( (__m128i *)(dst + x), _mm_packus_epi16( lo, hi ));
+    }
+    return x;
+}
+
+static int AVX2_TARGET blend_constant_alpha_row_avx2( DWORD *dst, const DWORD *src, int len,
+                                                      DWORD alpha, DWORD src_alpha )
+{
+    const __m256i zero = _mm256_setzero_si256(), mask = _mm256_set1_epi32( src_alpha );
+    const __m256i a = _mm256_set1_epi16( alpha ), inv = _mm256_set1_epi16( 255 - alpha );
+    __m256i s, d, lo, hi;
+    int x;
+
+    for (x = 0; x + 8 <= len; x += 8)
+    {
+        s = _mm256_or_si256( _mm256_loadu_si256( (const __m256i *)(src + x) ), mask );
+        d = _mm256_loadu_si256( (const __m256i *)(dst + x) );
+        lo = div255_avx2( _mm256_add_epi16( _mm256_mullo_epi16( _mm256_unpacklo_epi8( s, zero ), a ),
+                                            _mm256_mullo_epi16( _mm256_unpacklo_epi8( d, zero ), inv )));
+        hi = div255_avx2( _mm256_add_epi16( _mm256_mullo_epi16( _mm256_unpackhi_epi8( s, zero ), a ),
+                                            _mm256_mullo_epi16( _mm256_unpackhi_epi8( d, zero ), inv )));
+        _mm256_storeu_si256( (__m256i *)(dst + x), _mm256_packus_epi16( lo, hi ));
+    }
+    return x;
+}
+
+static int blend_constant_alpha_row( DWORD *dst, const DWORD *src, int len, DWORD alpha, DWORD src_alpha )
+{
+    int x = 0;
+
+    if (simd_overlap( dst, src, 8 * sizeof(DWORD) )) return 0;
+    if (have_avx2()) x = blend_constant_alpha_row_avx2( dst, src, len, alpha, src_alpha );
+    if (have_sse2()) x += blend_constant_alpha_row_sse2( dst + x, src + x, len - x, alpha, src_alpha );
+    return x;
+}
+
+#else  /* __GNUC__ && (__i386__ || __x86_64__) */
+
+static inline int blend_argb_row( DWORD *dst, const DWORD *src, int len, DWORD alpha ) { return 0; }
+static inline int blend_constant_alpha_row( DWORD *dst, const DWORD *src, int len,
+                                            DWORD alpha, DWORD src_alpha ) { return 0; }
+
+#endif  /* __GNUC__ && (__i386__ || __x86_64__) */
+
 static void blend_rects_8888(const dib_info *dst, int num, const RECT *rc,
                              const dib_info *src, const POINT *offset, BLENDFUNCTION blend)
 {
@@ -4696,20 +5142,26 @@ static void blend_rects_8888(const dib_info *dst, int num, const RECT *rc,
         {
             if (blend.SourceConstantAlpha == 255)
                 for (y = rc->top; y < rc->bottom; y++, dst_ptr += dst->stride / 4, src_ptr += src->stride / 4)
-                    for (x = 0; x < rc->right - rc->left; x++)
+                    for (x = blend_argb_row( dst_ptr, src_ptr, rc->right - rc->left, 255 );
+                         x < rc->right - rc->left; x++)
                         dst_ptr[x] = blend_argb( dst_ptr[x], src_ptr[x] );
             else
                 for (y = rc->top; y < rc->bottom; y++, dst_ptr += dst->stride / 4, src_ptr += src->stride / 4)
-                    for (x = 0; x < rc->right - rc->left; x++)
+                    for (x = blend_argb_row( dst_ptr, src_ptr, rc->right - rc->left, blend.SourceConstantAlpha );
+                         x < rc->right - rc->left; x++)
                         dst_ptr[x] = blend_argb_alpha( dst_ptr[x], src_ptr[x], blend.SourceConstantAlpha );
         }
         else if (src->compression == BI_RGB)
             for (y = rc->top; y < rc->bottom; y++, dst_ptr += dst->stride / 4, src_ptr += src->stride / 4)
-                for (x = 0; x < rc->right - rc->left; x++)
+                for (x = blend_constant_alpha_row( dst_ptr, src_ptr, rc->right - rc->left,
+                                                   blend.SourceConstantAlpha, 0 );
+                     x < rc->right - rc->left; x++)
                     dst_ptr[x] = blend_argb_constant_alpha( dst_ptr[x], src_ptr[x], blend.SourceConstantAlpha );
         else
             for (y = rc->top; y < rc->bottom; y++, dst_ptr += dst->stride / 4, src_ptr += src->stride / 4)
-                for (x = 0; x < rc->right - rc->left; x++)
+                for (x = blend_constant_alpha_row( dst_ptr, src_ptr, rc->right - rc->left,
+                                                   blend.SourceConstantAlpha, 0xff000000 );
+                     x < rc->right - rc->left; x++)
                     dst_ptr[x] = blend_argb_no_src_alpha( dst_ptr[x], src_ptr[x], blend.SourceConstantAlpha );
     }
 }
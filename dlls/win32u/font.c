@@ -194,6 +194,7 @@ static const WCHAR font_assoc_keyW[] =
 static UINT font_smoothing = GGO_BITMAP;
 static UINT subpixel_orientation = GGO_GRAY4_BITMAP;
 static BOOL antialias_fakes = TRUE;
+static UINT shared_glyph_cache_size;  /* in megabytes, 0 to disable */
 static struct font_gamma_ramp font_gamma_ramp;
 
 static void add_face_to_cache( struct gdi_font_face *face );
@@ -3790,8 +3791,12 @@ static DWORD get_glyph_outline( struct gdi_font *font, UINT glyph, UINT format,
     if (format == GGO_METRICS && !mat && get_gdi_font_glyph_metrics( font, index, &gm, &abc ))
         goto done;
 
-    ret = font_funcs->get_glyph_outline( font, index, format, &gm, &abc, buflen, buf, mat, tategaki );
-    if (ret == GDI_ERROR) return ret;
+    if (mat || !get_shared_glyph( font, index, format, tategaki, &gm, &abc, buflen, buf, &ret ))
+    {
+        ret = font_funcs->get_glyph_outline( font, index, format, &gm, &abc, buflen, buf, mat, tategaki );
+        if (ret == GDI_ERROR) return ret;
+        if (!mat) add_shared_glyph( font, index, format, tategaki, &gm, &abc, buflen, buf, ret );
+    }
 
     if (format == GGO_METRICS && !mat)
         set_gdi_font_glyph_metrics( font, index, &gm, &abc );
@@ -4728,6 +4733,8 @@ static UINT init_font_options(void)
         antialias_fakes = (wcschr( valsW, *(const WCHAR *)info->Data ) != NULL);
     }
 
+    if (get_key_value( wine_fonts_key, "SharedGlyphCacheSize", &val )) shared_glyph_cache_size = val;
+
     if ((key = reg_open_hkcu_key( "Control Panel\\Desktop" )))
     {
         /* FIXME: handle vertical orientations even though Windows doesn't */
@@ -6749,6 +6756,8 @@ UINT font_init(void)
     if (!(font_funcs = init_freetype_lib()))
         return dpi;
 
+    if (shared_glyph_cache_size) init_shared_glyph_cache( shared_glyph_cache_size );
+
     load_system_bitmap_fonts();
     load_file_system_fonts();
     font_funcs->load_fonts();
@@ -138,6 +138,7 @@ MAKE_FUNCPTR(FcPatternDestroy);
 MAKE_FUNCPTR(FcPatternGetBool);
 MAKE_FUNCPTR(FcPatternGetInteger);
 MAKE_FUNCPTR(FcPatternGetString);
+MAKE_FUNCPTR(FcConfigGetConfigFiles);
 MAKE_FUNCPTR(FcConfigGetFontDirs);
 MAKE_FUNCPTR(FcConfigGetCurrent);
 MAKE_FUNCPTR(FcCacheCopySet);
@@ -1016,6 +1017,342 @@ static void unix_face_destroy( struct unix_face *This )
     free( This );
 }
 
+#ifdef SONAME_LIBFONTCONFIG
+
+/* Persistent index of the faces found through fontconfig, to avoid opening every system font
+ * with FreeType in every process. Like fontconfig's own caches, it is validated against the
+ * modification time of the scanned directories and of the fontconfig configuration files. */
+
+#define FONT_INDEX_MAGIC   0x58444946  /* "FIDX" */
+#define FONT_INDEX_VERSION 1
+#define FONT_INDEX_NONE    ~0u         /* offset of a NULL string */
+
+struct font_index_header
+{
+    UINT magic;
+    UINT version;
+    UINT ft_version;
+    UINT aa_flags;
+    UINT stamp_count;
+    UINT face_count;
+    UINT data_size;    /* size of the string data following the faces */
+    UINT reserved;
+};
+
+struct font_index_stamp
+{
+    ULONGLONG mtime;
+    ULONGLONG size;
+    ULONGLONG inode;
+    UINT      path;    /* offset of the unix path in the string data */
+    UINT      exists;
+};
+
+struct font_index_face
+{
+    UINT                    family_name;   /* offsets of the names in the string data */
+    UINT                    second_name;
+    UINT                    style_name;
+    UINT                    full_name;
+    UINT                    file;
+    UINT                    face_index;
+    UINT                    flags;
+    UINT                    ntm_flags;
+    UINT                    weight;
+    UINT                    font_version;
+    UINT                    scalable;
+    FONTSIGNATURE           fs;
+    struct bitmap_font_size size;
+};
+
+struct font_index_builder
+{
+    struct font_index_header header;
+    struct font_index_stamp *stamps;
+    UINT                     stamps_size;
+    struct font_index_face  *faces;
+    UINT                     faces_size;
+    char                    *data;
+    UINT                     data_alloc;
+};
+
+static struct font_index_builder *font_index;
+
+static UINT get_ft_version(void)
+{
+    return (FT_Version.major << 16) | (FT_Version.minor << 8) | FT_Version.patch;
+}
+
+static char *get_font_index_path(void)
+{
+    WCHAR pathW[MAX_PATH];
+    char *path = NULL;
+
+    asciiz_to_unicode( pathW, "\\??\\C:\\windows\\system32\\fntcache.dat" );
+    if (ntdll_get_unix_file_name( pathW, &path, FILE_OPEN_IF )) return NULL;
+    return path;
+}
+
+static void get_font_index_stamp( const char *path, struct font_index_stamp *stamp )
+{
+    struct stat st;
+
+    memset( stamp, 0, sizeof(*stamp) );
+    if (stat( path, &st )) return;
+    stamp->exists = TRUE;
+    stamp->mtime = (ULONGLONG)st.st_mtime * 1000000000;
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+    stamp->mtime += st.st_mtim.tv_nsec;
+#elif defined(HAVE_STRUCT_STAT_ST_MTIMESPEC)
+    stamp->mtime += st.st_mtimespec.tv_nsec;
+#endif
+    stamp->size = st.st_size;
+    stamp->inode = st.st_ino;
+}
+
+static UINT add_font_index_data( const void *ptr, UINT size )
+{
+    struct font_index_builder *index = font_index;
+    UINT offset = (index->header.data_size + 1) & ~1;  /* keep strings WCHAR aligned */
+    char *data;
+
+    if (offset + size > index->data_alloc)
+    {
+        UINT alloc = max( index->data_alloc * 2, offset + size + 4096 );
+        if (!(data = realloc( index->data, alloc ))) return FONT_INDEX_NONE;
+        index->data = data;
+        index->data_alloc = alloc;
+    }
+    if (offset > index->header.data_size) index->data[index->header.data_size] = 0;
+    memcpy( index->data + offset, ptr, size );
+    index->header.data_size = offset + size;
+    return offset;
+}
+
+static UINT add_font_index_string( const WCHAR *str )
+{
+    if (!str) return FONT_INDEX_NONE;
+    return add_font_index_data( str, (wcslen( str ) + 1) * sizeof(WCHAR) );
+}
+
+static void add_font_index_stamp( const char *path )
+{
+    struct font_index_builder *index = font_index;
+    struct font_index_stamp *stamps;
+    UINT count = index->header.stamp_count;
+
+    if (count == index->stamps_size)
+    {
+        UINT size = max( 64, index->stamps_size * 2 );
+        if (!(stamps = realloc( index->stamps, size * sizeof(*stamps) ))) return;
+        index->stamps = stamps;
+        index->stamps_size = size;
+    }
+    get_font_index_stamp( path, &index->stamps[count] );
+    index->stamps[count].path = add_font_index_data( path, strlen( path ) + 1 );
+    index->header.stamp_count++;
+}
+
+static void add_font_index_face( struct unix_face *unix_face, const WCHAR *file, UINT face_index, UINT flags )
+{
+    struct font_index_builder *index = font_index;
+    struct font_index_face *face;
+    UINT count = index->header.face_count;
+
+    if (count == index->faces_size)
+    {
+        UINT size = max( 256, index->faces_size * 2 );
+        if (!(face = realloc( index->faces, size * sizeof(*face) ))) return;
+        index->faces = face;
+        index->faces_size = size;
+    }
+    face = &index->faces[count];
+    memset( face, 0, sizeof(*face) );
+    face->family_name  = add_font_index_string( unix_face->family_name );
+    face->second_name  = add_font_index_string( unix_face->second_name );
+    face->style_name   = add_font_index_string( unix_face->style_name );
+    face->full_name    = add_font_index_string( unix_face->full_name );
+    face->file         = add_font_index_string( file );
+    face->face_index   = face_index;
+    face->flags        = flags;
+    face->ntm_flags    = unix_face->ntm_flags;
+    face->weight       = unix_face->weight;
+    face->font_version = unix_face->font_version;
+    face->scalable     = unix_face->scalable;
+    face->fs           = unix_face->fs;
+    if (!face->scalable) face->size = unix_face->size;
+    index->header.face_count++;
+}
+
+static void write_font_index( const char *path )
+{
+    struct font_index_builder *index = font_index;
+    struct font_index_header header;
+    static const WCHAR terminator;
+    BOOL written;
+    char *tmp;
+    int fd;
+
+    /* terminate the data so that no string can run past its end */
+    add_font_index_data( &terminator, sizeof(terminator) );
+
+    if (!(tmp = malloc( strlen( path ) + 16 ))) return;
+    sprintf( tmp, "%s.%u", path, (int)getpid() );
+    if ((fd = open( tmp, O_WRONLY | O_CREAT | O_TRUNC, 0666 )) == -1)
+    {
+        WARN( "failed to create %s\n", debugstr_a(tmp) );
+        free( tmp );
+        return;
+    }
+
+    header = index->header;
+    header.magic = FONT_INDEX_MAGIC;
+    header.version = FONT_INDEX_VERSION;
+    header.ft_version = get_ft_version();
+    header.aa_flags = default_aa_flags;
+    written = write( fd, &header, sizeof(header) ) == sizeof(header) &&
+              write( fd, index->stamps, header.stamp_count * sizeof(*index->stamps) ) ==
+                  header.stamp_count * sizeof(*index->stamps) &&
+              write( fd, index->faces, header.face_count * sizeof(*index->faces) ) ==
+                  header.face_count * sizeof(*index->faces) &&
+              write( fd, index->data, header.data_size ) == header.data_size;
+    if (close( fd )) written = FALSE;
+
+    if (written)
+    {
+        /* replace atomically, processes starting concurrently may be reading it */
+        if (rename( tmp, path )) unlink( tmp );
+        else TRACE( "wrote %u faces and %u stamps to %s\n", header.face_count,
+                    header.stamp_count, debugstr_a(path) );
+    }
+    else
+    {
+        WARN( "failed to write %s\n", debugstr_a(tmp) );
+        unlink( tmp );
+    }
+    free( tmp );
+}
+
+static const WCHAR *get_font_index_string( const char *data, UINT offset )
+{
+    return offset == FONT_INDEX_NONE ? NULL : (const WCHAR *)(data + offset);
+}
+
+static BOOL check_font_index_string( const struct font_index_header *header, UINT offset )
+{
+    return offset == FONT_INDEX_NONE || (!(offset & 1) && offset < header->data_size);
+}
+
+static BOOL is_font_index_path( const struct font_index_stamp *stamps, UINT count,
+                                const char *data, const char *path )
+{
+    UINT i;
+
+    for (i = 0; i < count; i++) if (!strcmp( data + stamps[i].path, path )) return TRUE;
+    return FALSE;
+}
+
+/* check that all the paths of a fontconfig list have a stamp in the index, and free the list */
+static BOOL is_font_index_list_stamped( FcStrList *list, const struct font_index_stamp *stamps,
+                                        UINT count, const char *data )
+{
+    const FcChar8 *path;
+
+    if (!list) return FALSE;
+    while ((path = pFcStrListNext( list )))
+        if (!is_font_index_path( stamps, count, data, (const char *)path )) break;
+    pFcStrListDone( list );
+    return !path;
+}
+
+/* add the faces listed in the index, if it's still valid */
+static BOOL load_font_index( const char *path, FcConfig *config )
+{
+    const struct font_index_header *header;
+    const struct font_index_stamp *stamps;
+    const struct font_index_face *faces, *face;
+    struct font_index_stamp stamp;
+    const char *data;
+    struct stat st;
+    void *ptr;
+    BOOL ret = FALSE;
+    UINT i;
+    int fd;
+
+    if ((fd = open( path, O_RDONLY )) == -1) return FALSE;
+    if (fstat( fd, &st ) || st.st_size < sizeof(*header) ||
+        (ptr = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 )) == MAP_FAILED)
+    {
+        close( fd );
+        return FALSE;
+    }
+    close( fd );
+
+    header = ptr;
+    stamps = (const struct font_index_stamp *)(header + 1);
+    faces = (const struct font_index_face *)(stamps + header->stamp_count);
+    data = (const char *)(faces + header->face_count);
+
+    if (header->magic != FONT_INDEX_MAGIC || header->version != FONT_INDEX_VERSION ||
+        header->ft_version != get_ft_version() || header->aa_flags != default_aa_flags ||
+        sizeof(*header) + (ULONGLONG)header->stamp_count * sizeof(*stamps) +
+        (ULONGLONG)header->face_count * sizeof(*faces) + header->data_size != st.st_size ||
+        header->data_size < sizeof(WCHAR) || *(const WCHAR *)(data + header->data_size - sizeof(WCHAR)))
+    {
+        TRACE( "ignoring invalid index %s\n", debugstr_a(path) );
+        goto done;
+    }
+
+    for (i = 0; i < header->stamp_count; i++)
+    {
+        if (stamps[i].path >= header->data_size) goto done;
+        get_font_index_stamp( data + stamps[i].path, &stamp );
+        stamp.path = stamps[i].path;
+        if (memcmp( &stamp, &stamps[i], sizeof(stamp) ))
+        {
+            TRACE( "%s changed, rebuilding index\n", debugstr_a(data + stamps[i].path) );
+            goto done;
+        }
+    }
+
+    /* the configuration may list files or directories that didn't exist when the index was
+     * built, e.g. a file added to conf.d */
+    if (!is_font_index_list_stamped( pFcConfigGetConfigFiles( config ), stamps, header->stamp_count, data ) ||
+        !is_font_index_list_stamped( pFcConfigGetFontDirs( config ), stamps, header->stamp_count, data ))
+    {
+        TRACE( "configuration changed, rebuilding index\n" );
+        goto done;
+    }
+
+    for (i = 0; i < header->face_count; i++)
+    {
+        face = &faces[i];
+        if (!check_font_index_string( header, face->family_name ) ||
+            !check_font_index_string( header, face->second_name ) ||
+            !check_font_index_string( header, face->style_name ) ||
+            !check_font_index_string( header, face->full_name ) ||
+            !check_font_index_string( header, face->file ) ||
+            face->family_name == FONT_INDEX_NONE)
+            continue;
+
+        add_gdi_face( get_font_index_string( data, face->family_name ),
+                      get_font_index_string( data, face->second_name ),
+                      get_font_index_string( data, face->style_name ),
+                      get_font_index_string( data, face->full_name ),
+                      get_font_index_string( data, face->file ), NULL, 0, face->face_index, face->fs,
+                      face->ntm_flags, face->weight, face->font_version, face->flags,
+                      face->scalable ? NULL : &face->size );
+    }
+    TRACE( "loaded %u faces from %s\n", header->face_count, debugstr_a(path) );
+    ret = TRUE;
+
+done:
+    munmap( ptr, st.st_size );
+    return ret;
+}
+
+#endif /* SONAME_LIBFONTCONFIG */
+
 static int add_unix_face( const char *unix_name, const WCHAR *file, void *data_ptr, SIZE_T data_size,
                           DWORD face_index, DWORD flags, DWORD *num_faces )
 {
@@ -1039,6 +1376,9 @@ static int add_unix_face( const char *unix_name, const WCHAR *file, void *data_p
     ret = add_gdi_face( unix_face->family_name, unix_face->second_name, unix_face->style_name, unix_face->full_name,
                         file, data_ptr, data_size, face_index, unix_face->fs, unix_face->ntm_flags, unix_face->weight,
                         unix_face->font_version, flags, unix_face->scalable ? NULL : &unix_face->size );
+#ifdef SONAME_LIBFONTCONFIG
+    if (font_index) add_font_index_face( unix_face, file, face_index, flags );
+#endif
 
     TRACE("fsCsb = %08x %08x/%08x %08x %08x %08x\n",
           unix_face->fs.fsCsb[0], unix_face->fs.fsCsb[1],
@@ -1256,6 +1596,7 @@ static void init_fontconfig(void)
     LOAD_FUNCPTR(FcPatternGetBool);
     LOAD_FUNCPTR(FcPatternGetInteger);
     LOAD_FUNCPTR(FcPatternGetString);
+    LOAD_FUNCPTR(FcConfigGetConfigFiles);
     LOAD_FUNCPTR(FcConfigGetFontDirs);
     LOAD_FUNCPTR(FcConfigGetCurrent);
     LOAD_FUNCPTR(FcCacheCopySet);
@@ -1308,6 +1649,7 @@ static void fontconfig_add_fonts_from_dir_list( FcConfig *config, FcStrList *dir
         if (pFcStrSetMember( done_set, dir )) continue;
 
         TRACE( "adding fonts from %s\n", dir );
+        if (font_index) add_font_index_stamp( (const char *)dir );
         if (!(cache = pFcDirCacheRead( dir, FcFalse, config ))) continue;
 
         if (!(font_set = pFcCacheCopySet( cache ))) goto done;
@@ -1339,18 +1681,42 @@ done:
 
 static void load_fontconfig_fonts( void )
 {
-    FcStrList *dir_list = NULL;
+    FcStrList *dir_list = NULL, *file_list;
     FcStrSet *done_set = NULL;
+    const FcChar8 *file;
     FcConfig *config;
+    char *index_path;
 
     if (!fontconfig_enabled) return;
-    if (!(config = pFcConfigGetCurrent())) goto done;
+    if (!(config = pFcConfigGetCurrent())) return;
+
+    if ((index_path = get_font_index_path()))
+    {
+        if (load_font_index( index_path, config )) goto done;
+        if ((font_index = calloc( 1, sizeof(*font_index) )) &&
+            (file_list = pFcConfigGetConfigFiles( config )))
+        {
+            while ((file = pFcStrListNext( file_list ))) add_font_index_stamp( (const char *)file );
+            pFcStrListDone( file_list );
+        }
+    }
+
     if (!(done_set = pFcStrSetCreate())) goto done;
     if (!(dir_list = pFcConfigGetFontDirs( config ))) goto done;
 
     fontconfig_add_fonts_from_dir_list( config, dir_list, done_set, ADDFONT_EXTERNAL_FONT );
+    if (font_index) write_font_index( index_path );
 
 done:
+    if (font_index)
+    {
+        free( font_index->stamps );
+        free( font_index->faces );
+        free( font_index->data );
+        free( font_index );
+        font_index = NULL;
+    }
+    free( index_path );
     if (dir_list) pFcStrListDone( dir_list );
     if (done_set) pFcStrSetDestroy( done_set );
 }
@@ -0,0 +1,490 @@
+/*
+ * Glyph cache shared between the processes of a prefix
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#if 0
+#pragma makedep unix
+#endif
+
+#include <errno.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ntstatus.h"
+#include "windef.h"
+#include "winbase.h"
+#include "winternl.h"
+#include "ntgdi_private.h"
+
+#include "wine/debug.h"
+
+WINE_DEFAULT_DEBUG_CHANNEL(font);
+
+/* The cache lives in a named section, and is only ever accessed with its lock held. Glyphs
+ * are stored in a ring of variable sized entries, hashed on their face, index and format,
+ * and evicted from the head of the ring, giving entries that were used since they were added
+ * a second chance by moving them to the tail. Faces (a font file rendered with a given size
+ * and transform) are kept in a small table with LRU replacement; replacing a face bumps its
+ * generation, which makes its glyphs unreachable until they reach the head of the ring. */
+
+#define GLYPH_CACHE_MAGIC  0x31434c47  /* "GLC1" */
+#define GLYPH_CACHE_FACES  128
+#define GLYPH_CACHE_SPINS  100         /* yields before giving up on the lock */
+#define GLYPH_CACHE_MOVES  32          /* entries given a second chance per insertion */
+#define PADDING_ENTRY      ~0u
+
+struct glyph_cache_key
+{
+    LOGFONTW  lf;          /* with the face name cleared */
+    FMAT2     matrix;
+    FILETIME  writetime;
+    UINT      face_index;
+    INT       scale_y;
+    INT       aveWidth;
+    INT       ppem;
+    UINT      ntmFlags;
+    UINT      flags;
+    WCHAR     file[MAX_PATH];
+};
+
+struct glyph_cache_face
+{
+    UINT                   generation;  /* 0 if the slot is free */
+    UINT                   hash;
+    UINT                   last_used;
+    struct glyph_cache_key key;
+};
+
+struct glyph_cache_entry
+{
+    UINT         size;        /* size of the entry in the ring */
+    UINT         face;        /* face slot, PADDING_ENTRY for the unused end of the ring */
+    UINT         next;        /* offset of the next entry in the hash chain, 0 if none */
+    UINT         generation;  /* generation of the face when the glyph was added */
+    UINT         index;
+    UINT         format;
+    UINT         tategaki;
+    UINT         referenced;  /* used since it was last considered for eviction */
+    DWORD        ret;
+    DWORD        bits_size;
+    GLYPHMETRICS gm;
+    ABC          abc;
+    BYTE         bits[1];
+};
+
+struct glyph_cache
+{
+    UINT                    magic;
+    UINT                    size;          /* size of the section */
+    LONG                    owner;         /* unix pid of the lock owner, 0 if unlocked */
+    UINT                    dirty;         /* set while the lock is held */
+    UINT                    generation;    /* last face generation, preserved across resets */
+    UINT                    clock;         /* face LRU clock */
+    UINT                    bucket_count;
+    UINT                    data_start;    /* offset of the entry ring */
+    UINT                    data_size;
+    UINT                    head;          /* oldest entry, relative to data_start */
+    UINT                    used;          /* bytes used in the ring */
+    struct glyph_cache_face faces[GLYPH_CACHE_FACES];
+    UINT                    buckets[1];    /* offset of the first entry in each chain, 0 if none */
+};
+
+static struct glyph_cache *glyph_cache;
+static HANDLE glyph_cache_section;
+static UINT glyph_cache_size;
+static LONG unix_pid;
+
+static inline struct glyph_cache_entry *get_entry( UINT offset )
+{
+    return (struct glyph_cache_entry *)((char *)glyph_cache + offset);
+}
+
+static inline UINT glyph_hash( UINT generation, UINT index, UINT format, UINT tategaki )
+{
+    UINT hash = (generation * 0x9e3779b1) ^ index ^ ((format << 1 | tategaki) * 0x27d4eb2d);
+    hash *= 0x85ebca6b;
+    return (hash ^ (hash >> 15)) & (glyph_cache->bucket_count - 1);
+}
+
+static void reset_glyph_cache(void)
+{
+    struct glyph_cache *cache = glyph_cache;
+    UINT count = 1;
+
+    TRACE( "resetting cache %p\n", cache );
+
+    /* about one bucket per 512 bytes of glyph data */
+    while (count < glyph_cache_size / 512) count *= 2;
+    cache->size = glyph_cache_size;
+    cache->bucket_count = count;
+    cache->data_start = (offsetof( struct glyph_cache, buckets[count] ) + 7) & ~7;
+    cache->data_size = (glyph_cache_size - cache->data_start) & ~7;
+    cache->head = cache->used = 0;
+    cache->clock = 0;
+    memset( cache->faces, 0, sizeof(cache->faces) );
+    memset( cache->buckets, 0, count * sizeof(cache->buckets[0]) );
+    cache->magic = GLYPH_CACHE_MAGIC;
+}
+
+static BOOL lock_glyph_cache(void)
+{
+    struct glyph_cache *cache = glyph_cache;
+    LONG owner;
+    UINT i;
+
+    for (i = 0; i < GLYPH_CACHE_SPINS; i++)
+    {
+        if (!(owner = InterlockedCompareExchange( &cache->owner, unix_pid, 0 ))) break;
+        /* steal the lock from a process that died while holding it, the cache is reset below */
+        if (owner != unix_pid && kill( owner, 0 ) == -1 && errno == ESRCH &&
+            InterlockedCompareExchange( &cache->owner, unix_pid, owner ) == owner)
+            break;
+        sched_yield();
+    }
+    if (i == GLYPH_CACHE_SPINS)
+    {
+        WARN( "cache busy, owner %d\n", (int)cache->owner );
+        return FALSE;
+    }
+
+    if (cache->magic != GLYPH_CACHE_MAGIC || cache->size != glyph_cache_size || cache->dirty)
+        reset_glyph_cache();
+    cache->dirty = 1;
+    return TRUE;
+}
+
+static void unlock_glyph_cache(void)
+{
+    glyph_cache->dirty = 0;
+    InterlockedExchange( &glyph_cache->owner, 0 );
+}
+
+static BOOL is_cacheable( struct gdi_font *font, UINT format )
+{
+    switch (format & ~GGO_UNHINTED)
+    {
+    case GGO_METRICS:
+    case GGO_BITMAP:
+    case GGO_GRAY2_BITMAP:
+    case GGO_GRAY4_BITMAP:
+    case GGO_GRAY8_BITMAP:
+    case WINE_GGO_GRAY16_BITMAP:
+    case WINE_GGO_HRGB_BITMAP:
+    case WINE_GGO_HBGR_BITMAP:
+    case WINE_GGO_VRGB_BITMAP:
+    case WINE_GGO_VBGR_BITMAP:
+        /* memory fonts can't be identified across processes */
+        return font->file[0] && lstrlenW( font->file ) < MAX_PATH;
+    default:
+        return FALSE;
+    }
+}
+
+static UINT get_face_slot( struct gdi_font *font )
+{
+    struct glyph_cache *cache = glyph_cache;
+    struct glyph_cache_face *face;
+    struct glyph_cache_key key;
+    const BYTE *ptr;
+    UINT i, hash, slot;
+
+    if (font->glyph_cache_generation &&
+        cache->faces[font->glyph_cache_face].generation == font->glyph_cache_generation)
+    {
+        slot = font->glyph_cache_face;
+        cache->faces[slot].last_used = ++cache->clock;
+        return slot;
+    }
+
+    memset( &key, 0, sizeof(key) );
+    key.lf = font->lf;
+    memset( key.lf.lfFaceName, 0, sizeof(key.lf.lfFaceName) );
+    key.matrix = font->matrix;
+    key.writetime = font->writetime;
+    key.face_index = font->face_index;
+    key.scale_y = font->scale_y;
+    key.aveWidth = font->aveWidth;
+    key.ppem = font->ppem;
+    key.ntmFlags = font->ntmFlags;
+    key.flags = font->can_use_bitmap | font->fake_italic << 1 | font->fake_bold << 2 | font->scalable << 3;
+    lstrcpyW( key.file, font->file );
+
+    for (i = 0, hash = 2166136261u, ptr = (const BYTE *)&key; i < sizeof(key); i++)
+        hash = (hash ^ ptr[i]) * 16777619;
+
+    for (slot = 0; slot < GLYPH_CACHE_FACES; slot++)
+    {
+        face = &cache->faces[slot];
+        if (face->generation && face->hash == hash && !memcmp( &face->key, &key, sizeof(key) )) break;
+    }
+
+    if (slot == GLYPH_CACHE_FACES)
+    {
+        /* replace the least recently used face, free slots have never been used */
+        for (i = slot = 0; i < GLYPH_CACHE_FACES; i++)
+            if (cache->faces[i].last_used < cache->faces[slot].last_used) slot = i;
+
+        face = &cache->faces[slot];
+        if (!++cache->generation) cache->generation = 1;
+        face->generation = cache->generation;
+        face->hash = hash;
+        face->key = key;
+        TRACE( "face %u generation %u for %s\n", slot, face->generation, debugstr_w(font->file) );
+    }
+
+    font->glyph_cache_face = slot;
+    font->glyph_cache_generation = cache->faces[slot].generation;
+    cache->faces[slot].last_used = ++cache->clock;
+    return slot;
+}
+
+static struct glyph_cache_entry *find_entry( UINT slot, UINT index, UINT format, UINT tategaki )
+{
+    struct glyph_cache *cache = glyph_cache;
+    struct glyph_cache_entry *entry;
+    UINT generation = cache->faces[slot].generation;
+    UINT offset = cache->buckets[glyph_hash( generation, index, format, tategaki )];
+
+    for (; offset; offset = entry->next)
+    {
+        entry = get_entry( offset );
+        if (entry->generation == generation && entry->face == slot && entry->index == index &&
+            entry->format == format && entry->tategaki == tategaki)
+            return entry;
+    }
+    return NULL;
+}
+
+/* return the link pointing to the entry in its hash chain */
+static UINT *get_entry_link( struct glyph_cache_entry *entry, UINT offset )
+{
+    struct glyph_cache *cache = glyph_cache;
+    UINT *link = &cache->buckets[glyph_hash( entry->generation, entry->index, entry->format, entry->tategaki )];
+
+    while (*link != offset) link = &get_entry( *link )->next;
+    return link;
+}
+
+static UINT get_ring_tail(void)
+{
+    return (glyph_cache->head + glyph_cache->used) % glyph_cache->data_size;
+}
+
+/* size of the free space following the tail, not wrapping around */
+static UINT get_ring_space(void)
+{
+    struct glyph_cache *cache = glyph_cache;
+    UINT tail = get_ring_tail();
+
+    if (cache->used < cache->data_size && tail >= cache->head) return cache->data_size - tail;
+    return cache->head - tail;
+}
+
+static void evict_head( UINT *moves )
+{
+    struct glyph_cache *cache = glyph_cache;
+    UINT offset = cache->data_start + cache->head;
+    struct glyph_cache_entry *entry = get_entry( offset );
+    UINT *link, size = entry->size;
+
+    if (entry->face != PADDING_ENTRY)
+    {
+        link = get_entry_link( entry, offset );
+        if (entry->referenced && *moves < GLYPH_CACHE_MOVES &&
+            cache->faces[entry->face].generation == entry->generation &&
+            get_ring_space() >= size)
+        {
+            UINT tail = cache->data_start + get_ring_tail();
+
+            memcpy( get_entry( tail ), entry, size );
+            get_entry( tail )->referenced = 0;
+            *link = tail;
+            cache->used += size;
+            (*moves)++;
+        }
+        else *link = entry->next;
+    }
+
+    cache->head = (cache->head + size) % cache->data_size;
+    cache->used -= size;
+}
+
+/* make room for an entry of the given size at the tail of the ring, and return its offset */
+static UINT alloc_entry( UINT size )
+{
+    struct glyph_cache *cache = glyph_cache;
+    struct glyph_cache_entry *pad;
+    UINT tail, moves = 0;
+
+    for (;;)
+    {
+        if (!cache->used) cache->head = 0;
+        if (get_ring_space() >= size) break;
+
+        tail = get_ring_tail();
+        if (cache->used < cache->data_size && tail >= cache->head && cache->head >= size)
+        {
+            /* not enough room before the end of the ring, but enough after wrapping around */
+            pad = get_entry( cache->data_start + tail );
+            pad->size = cache->data_size - tail;
+            pad->face = PADDING_ENTRY;
+            cache->used += pad->size;
+            continue;
+        }
+        evict_head( &moves );
+    }
+
+    tail = get_ring_tail();
+    cache->used += size;
+    return cache->data_start + tail;
+}
+
+/***********************************************************************
+ *           get_shared_glyph
+ *
+ * Look up the glyph in the shared cache, filling the output parameters the same way as
+ * the font backend get_glyph_outline would. Return FALSE if it has to be rendered.
+ */
+BOOL get_shared_glyph( struct gdi_font *font, UINT index, UINT format, BOOL tategaki,
+                       GLYPHMETRICS *gm, ABC *abc, DWORD buflen, void *buf, DWORD *ret )
+{
+    struct glyph_cache_entry *entry;
+    BOOL found = FALSE;
+
+    if (!glyph_cache || !is_cacheable( font, format )) return FALSE;
+    if (!lock_glyph_cache()) return FALSE;
+
+    if ((entry = find_entry( get_face_slot( font ), index, format, !!tategaki )) &&
+        (!buflen || buflen >= entry->bits_size))
+    {
+        entry->referenced = 1;
+        *gm = entry->gm;
+        *abc = entry->abc;
+        *ret = entry->ret;
+        if (buf && buflen) memcpy( buf, entry->bits, entry->bits_size );
+        found = TRUE;
+    }
+
+    unlock_glyph_cache();
+    return found;
+}
+
+/***********************************************************************
+ *           add_shared_glyph
+ *
+ * Store a glyph returned by the font backend in the shared cache.
+ */
+void add_shared_glyph( struct gdi_font *font, UINT index, UINT format, BOOL tategaki,
+                       const GLYPHMETRICS *gm, const ABC *abc, DWORD buflen, const void *buf, DWORD ret )
+{
+    struct glyph_cache_entry *entry;
+    UINT slot, size, bits_size = 0;
+
+    if (!glyph_cache || !is_cacheable( font, format )) return;
+
+    if ((format & ~GGO_UNHINTED) != GGO_METRICS)
+    {
+        /* only the size was queried, the bits aren't available yet */
+        if (ret && (!buf || buflen < ret)) return;
+        bits_size = ret;
+    }
+
+    if (!lock_glyph_cache()) return;
+
+    size = (offsetof( struct glyph_cache_entry, bits[bits_size] ) + 7) & ~7;
+    slot = get_face_slot( font );
+    if (size <= glyph_cache->data_size / 4 && !find_entry( slot, index, format, !!tategaki ))
+    {
+        UINT offset = alloc_entry( size ), *bucket;
+
+        entry = get_entry( offset );
+        entry->size = size;
+        entry->face = slot;
+        entry->generation = glyph_cache->faces[slot].generation;
+        entry->index = index;
+        entry->format = format;
+        entry->tategaki = !!tategaki;
+        entry->referenced = 0;
+        entry->ret = ret;
+        entry->bits_size = bits_size;
+        entry->gm = *gm;
+        entry->abc = *abc;
+        memcpy( entry->bits, buf, bits_size );
+
+        bucket = &glyph_cache->buckets[glyph_hash( entry->generation, index, format, entry->tategaki )];
+        entry->next = *bucket;
+        *bucket = offset;
+    }
+
+    unlock_glyph_cache();
+}
+
+/***********************************************************************
+ *           init_shared_glyph_cache
+ *
+ * Map the shared glyph cache, creating it with the given size in megabytes if needed.
+ */
+void init_shared_glyph_cache( UINT size )
+{
+    static WCHAR glyph_cacheW[] =
+        {'\\','B','a','s','e','N','a','m','e','d','O','b','j','e','c','t','s',
+         '\\','_','_','w','i','n','e','_','g','l','y','p','h','_','c','a','c','h','e'};
+    OBJECT_ATTRIBUTES attr;
+    UNICODE_STRING name;
+    LARGE_INTEGER section_size;
+    SIZE_T view_size = 0;
+    void *ptr = NULL;
+    NTSTATUS status;
+
+    size = min( size, 256 );
+    section_size.QuadPart = (ULONGLONG)size << 20;
+    name.Buffer = glyph_cacheW;
+    name.Length = name.MaximumLength = sizeof(glyph_cacheW);
+    InitializeObjectAttributes( &attr, &name, OBJ_OPENIF, NULL, NULL );
+
+    if ((status = NtCreateSection( &glyph_cache_section, SECTION_ALL_ACCESS, &attr, &section_size,
+                                   PAGE_READWRITE, SEC_COMMIT, 0 )) < 0)
+    {
+        WARN( "failed to create glyph cache section, status %#x\n", (int)status );
+        return;
+    }
+    if ((status = NtMapViewOfSection( glyph_cache_section, GetCurrentProcess(), &ptr, 0, 0, NULL,
+                                      &view_size, ViewShare, 0, PAGE_READWRITE )))
+    {
+        WARN( "failed to map glyph cache, status %#x\n", (int)status );
+        NtClose( glyph_cache_section );
+        glyph_cache_section = 0;
+        return;
+    }
+
+    /* the section may have been created by a process using a different size */
+    glyph_cache_size = min( view_size, 256 << 20 );
+    if (glyph_cache_size < 2 * sizeof(struct glyph_cache))
+    {
+        WARN( "glyph cache too small, %u bytes\n", glyph_cache_size );
+        NtUnmapViewOfSection( GetCurrentProcess(), ptr );
+        NtClose( glyph_cache_section );
+        glyph_cache_section = 0;
+        return;
+    }
+    unix_pid = getpid();
+    glyph_cache = ptr;
+    TRACE( "mapped %u bytes at %p\n", glyph_cache_size, glyph_cache );
+}
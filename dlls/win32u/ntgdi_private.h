@@ -201,12 +201,12 @@ extern BITMAPINFO *copy_packed_dib( const BITMAPINFO *src_info, UINT usage );
 extern DWORD convert_bitmapinfo( const BITMAPINFO *src_info, void *src_bits, struct bitblt_coords *src,
                                  const BITMAPINFO *dst_info, void *dst_bits );
 
-extern DWORD stretch_bitmapinfo( const BITMAPINFO *src_info, void *src_bits, struct bitblt_coords *src,
-                                 const BITMAPINFO *dst_info, void *dst_bits, struct bitblt_coords *dst,
-                                 INT mode );
-extern DWORD blend_bitmapinfo( const BITMAPINFO *src_info, void *src_bits, struct bitblt_coords *src,
-                               const BITMAPINFO *dst_info, void *dst_bits, struct bitblt_coords *dst,
-                               BLENDFUNCTION blend );
+extern DWORD stretch_bitmapinfo( const BITMAPINFO *src_info, const struct gdi_image_bits *src_bits,
+                                 struct bitblt_coords *src, const BITMAPINFO *dst_info, void *dst_bits,
+                                 struct bitblt_coords *dst, INT mode );
+extern DWORD blend_bitmapinfo( const BITMAPINFO *src_info, const struct gdi_image_bits *src_bits,
+                               struct bitblt_coords *src, const BITMAPINFO *dst_info, void *dst_bits,
+                               struct bitblt_coords *dst, BLENDFUNCTION blend );
 extern DWORD gradient_bitmapinfo( const BITMAPINFO *info, void *bits, TRIVERTEX *vert_array, ULONG nvert,
                                   void *grad_array, ULONG ngrad, ULONG mode, const POINT *dev_pts, HRGN rgn );
 extern COLORREF get_pixel_bitmapinfo( const BITMAPINFO *info, void *bits, struct bitblt_coords *src );
@@ -263,6 +263,8 @@ struct gdi_font
     OUTLINETEXTMETRICW     otm;
     KERNINGPAIR           *kern_pairs;
     int                    kern_count;
+    UINT                   glyph_cache_face;        /* face slot in the shared glyph cache */
+    UINT                   glyph_cache_generation;  /* generation of that slot, 0 if not looked up */
     /* the following members can be accessed without locking, they are never modified after creation */
     void                  *private;  /* font backend private data */
     struct list            child_fonts;
@@ -348,6 +350,14 @@ extern int add_gdi_face( const WCHAR *family_name, const WCHAR *second_name,
 extern UINT font_init(void);
 extern const struct font_backend_funcs *init_freetype_lib(void);
 
+/* glyphcache.c */
+extern void init_shared_glyph_cache( UINT size );
+extern BOOL get_shared_glyph( struct gdi_font *font, UINT index, UINT format, BOOL tategaki,
+                              GLYPHMETRICS *gm, ABC *abc, DWORD buflen, void *buf, DWORD *ret );
+extern void add_shared_glyph( struct gdi_font *font, UINT index, UINT format, BOOL tategaki,
+                              const GLYPHMETRICS *gm, const ABC *abc, DWORD buflen, const void *buf,
+                              DWORD ret );
+
 /* opentype.c */
 
 struct ttc_sfnt_v1;
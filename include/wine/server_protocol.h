@@ -1058,12 +1058,38 @@ typedef volatile struct
     object_shm_t         shm;
 } shared_object_t;
 
+#define REGISTRY_SERIAL_COUNT 4096
+
 typedef volatile struct
 {
     struct user_entry user_entries[MAX_USER_HANDLES];
+    LONG64            registry_serials[REGISTRY_SERIAL_COUNT];
 } session_shm_t;
 
 
+#define REQUEST_RING_SLOTS  64
+#define REQUEST_SLOT_SIZE   8192
+
+#define REQUEST_SLOT_IDLE     0
+#define REQUEST_SLOT_POSTED   1
+#define REQUEST_SLOT_REPLIED  2
+#define REQUEST_SLOT_CLOSED   3
+
+typedef volatile struct
+{
+    int                  state;
+    data_size_t          size;
+    char                 data[REQUEST_SLOT_SIZE - 2 * sizeof(int)];
+} request_slot_shm_t;
+
+typedef volatile struct
+{
+    LONG64               posted;
+    LONG64               __pad[7];
+    request_slot_shm_t   slots[REQUEST_RING_SLOTS];
+} request_ring_shm_t;
+
+
 
 
 
@@ -1207,6 +1233,32 @@ struct init_thread_reply
 
 
 
+struct init_request_ring_request
+{
+    struct request_header __header;
+    char __pad_12[4];
+};
+struct init_request_ring_reply
+{
+    struct reply_header __header;
+    obj_handle_t ring;
+    obj_handle_t doorbell;
+};
+
+
+
+struct set_request_slot_request
+{
+    struct request_header __header;
+    int          slot;
+};
+struct set_request_slot_reply
+{
+    struct reply_header __header;
+};
+
+
+
 struct terminate_process_request
 {
     struct request_header __header;
@@ -1844,14 +1896,18 @@ struct create_file_request
     int          create;
     unsigned int options;
     unsigned int attrs;
+    int          want_fd;
     /* VARARG(objattr,object_attributes); */
     /* VARARG(filename,string); */
+    char __pad_36[4];
 };
 struct create_file_reply
 {
     struct reply_header __header;
     obj_handle_t handle;
-    char __pad_12[4];
+    int          type;
+    unsigned int access;
+    unsigned int options;
 };
 
 
@@ -2210,6 +2266,8 @@ struct get_mapping_info_reply
     mem_size_t   size;
     unsigned int flags;
     obj_handle_t shared_file;
+    obj_handle_t relocated_file;
+    int          relocated_build;
     data_size_t  name_len;
     data_size_t  ver_len;
     data_size_t  total;
@@ -2217,7 +2275,7 @@ struct get_mapping_info_reply
     /* VARARG(version,version_res,ver_len); */
     /* VARARG(name,unicode_str,name_len); */
     /* VARARG(exp_name,string); */
-    char __pad_36[4];
+    char __pad_44[4];
 };
 
 
@@ -2235,6 +2293,34 @@ struct get_image_map_address_reply
 
 
 
+struct create_relocated_image_request
+{
+    struct request_header __header;
+    obj_handle_t handle;
+};
+struct create_relocated_image_reply
+{
+    struct reply_header __header;
+    obj_handle_t file;
+    char __pad_12[4];
+};
+
+
+
+struct set_relocated_image_request
+{
+    struct request_header __header;
+    obj_handle_t handle;
+    int          success;
+    char __pad_20[4];
+};
+struct set_relocated_image_reply
+{
+    struct reply_header __header;
+};
+
+
+
 struct map_view_request
 {
     struct request_header __header;
@@ -2666,7 +2752,10 @@ struct get_key_value_reply
     struct reply_header __header;
     int          type;
     data_size_t  total;
+    unsigned __int64 serial;
+    unsigned int serial_slot;
     /* VARARG(data,bytes); */
+    char __pad_28[4];
 };
 
 
@@ -5565,6 +5654,56 @@ struct query_completion_reply
 
 
 
+struct create_wait_completion_packet_request
+{
+    struct request_header __header;
+    unsigned int access;
+    /* VARARG(objattr,object_attributes); */
+};
+struct create_wait_completion_packet_reply
+{
+    struct reply_header __header;
+    obj_handle_t handle;
+    char __pad_12[4];
+};
+
+
+
+struct associate_wait_completion_packet_request
+{
+    struct request_header __header;
+    obj_handle_t  packet;
+    obj_handle_t  completion;
+    obj_handle_t  target;
+    apc_param_t   ckey;
+    apc_param_t   cvalue;
+    apc_param_t   information;
+    unsigned int  status;
+    char __pad_52[4];
+};
+struct associate_wait_completion_packet_reply
+{
+    struct reply_header __header;
+    int           signaled;
+    char __pad_12[4];
+};
+
+
+
+struct cancel_wait_completion_packet_request
+{
+    struct request_header __header;
+    obj_handle_t  packet;
+    int           remove_signaled;
+    char __pad_20[4];
+};
+struct cancel_wait_completion_packet_reply
+{
+    struct reply_header __header;
+};
+
+
+
 struct set_completion_info_request
 {
     struct request_header __header;
@@ -6171,6 +6310,8 @@ enum request
     REQ_init_process_done,
     REQ_init_first_thread,
     REQ_init_thread,
+    REQ_init_request_ring,
+    REQ_set_request_slot,
     REQ_terminate_process,
     REQ_terminate_thread,
     REQ_get_process_info,
@@ -6231,6 +6372,8 @@ enum request
     REQ_open_mapping,
     REQ_get_mapping_info,
     REQ_get_image_map_address,
+    REQ_create_relocated_image,
+    REQ_set_relocated_image,
     REQ_map_view,
     REQ_map_image_view,
     REQ_map_builtin_view,
@@ -6433,6 +6576,9 @@ enum request
     REQ_remove_completion,
     REQ_get_thread_completion,
     REQ_query_completion,
+    REQ_create_wait_completion_packet,
+    REQ_associate_wait_completion_packet,
+    REQ_cancel_wait_completion_packet,
     REQ_set_completion_info,
     REQ_add_fd_completion,
     REQ_set_fd_completion_mode,
@@ -6484,6 +6630,8 @@ union generic_request
     struct init_process_done_request init_process_done_request;
     struct init_first_thread_request init_first_thread_request;
     struct init_thread_request init_thread_request;
+    struct init_request_ring_request init_request_ring_request;
+    struct set_request_slot_request set_request_slot_request;
     struct terminate_process_request terminate_process_request;
     struct terminate_thread_request terminate_thread_request;
     struct get_process_info_request get_process_info_request;
@@ -6544,6 +6692,8 @@ union generic_request
     struct open_mapping_request open_mapping_request;
     struct get_mapping_info_request get_mapping_info_request;
     struct get_image_map_address_request get_image_map_address_request;
+    struct create_relocated_image_request create_relocated_image_request;
+    struct set_relocated_image_request set_relocated_image_request;
     struct map_view_request map_view_request;
     struct map_image_view_request map_image_view_request;
     struct map_builtin_view_request map_builtin_view_request;
@@ -6746,6 +6896,9 @@ union generic_request
     struct remove_completion_request remove_completion_request;
     struct get_thread_completion_request get_thread_completion_request;
     struct query_completion_request query_completion_request;
+    struct create_wait_completion_packet_request create_wait_completion_packet_request;
+    struct associate_wait_completion_packet_request associate_wait_completion_packet_request;
+    struct cancel_wait_completion_packet_request cancel_wait_completion_packet_request;
     struct set_completion_info_request set_completion_info_request;
     struct add_fd_completion_request add_fd_completion_request;
     struct set_fd_completion_mode_request set_fd_completion_mode_request;
@@ -6795,6 +6948,8 @@ union generic_reply
     struct init_process_done_reply init_process_done_reply;
     struct init_first_thread_reply init_first_thread_reply;
     struct init_thread_reply init_thread_reply;
+    struct init_request_ring_reply init_request_ring_reply;
+    struct set_request_slot_reply set_request_slot_reply;
     struct terminate_process_reply terminate_process_reply;
     struct terminate_thread_reply terminate_thread_reply;
     struct get_process_info_reply get_process_info_reply;
@@ -6855,6 +7010,8 @@ union generic_reply
     struct open_mapping_reply open_mapping_reply;
     struct get_mapping_info_reply get_mapping_info_reply;
     struct get_image_map_address_reply get_image_map_address_reply;
+    struct create_relocated_image_reply create_relocated_image_reply;
+    struct set_relocated_image_reply set_relocated_image_reply;
     struct map_view_reply map_view_reply;
     struct map_image_view_reply map_image_view_reply;
     struct map_builtin_view_reply map_builtin_view_reply;
@@ -7057,6 +7214,9 @@ union generic_reply
     struct remove_completion_reply remove_completion_reply;
     struct get_thread_completion_reply get_thread_completion_reply;
     struct query_completion_reply query_completion_reply;
+    struct create_wait_completion_packet_reply create_wait_completion_packet_reply;
+    struct associate_wait_completion_packet_reply associate_wait_completion_packet_reply;
+    struct cancel_wait_completion_packet_reply cancel_wait_completion_packet_reply;
     struct set_completion_info_reply set_completion_info_reply;
     struct add_fd_completion_reply add_fd_completion_reply;
     struct set_fd_completion_mode_reply set_fd_completion_mode_reply;
@@ -7096,6 +7256,6 @@ union generic_reply
     struct d3dkmt_mutex_release_reply d3dkmt_mutex_release_reply;
 };
 
-#define SERVER_PROTOCOL_VERSION 931
+#define SERVER_PROTOCOL_VERSION 936
 
 #endif /* __WINE_WINE_SERVER_PROTOCOL_H */
@@ -50,6 +50,20 @@ struct type_descr completion_type =
     },
 };
 
+static const WCHAR wait_completion_packet_name[] = {'W','a','i','t','C','o','m','p','l','e','t','i','o','n','P','a','c','k','e','t'};
+
+struct type_descr wait_completion_packet_type =
+{
+    { wait_completion_packet_name, sizeof(wait_completion_packet_name) },  /* name */
+    STANDARD_RIGHTS_REQUIRED | 0x1,                                       /* valid_access */
+    {                                                                     /* mapping */
+        STANDARD_RIGHTS_READ,
+        STANDARD_RIGHTS_WRITE | 0x1,
+        STANDARD_RIGHTS_EXECUTE,
+        STANDARD_RIGHTS_REQUIRED | 0x1
+    },
+};
+
 struct comp_msg
 {
     struct   list queue_entry;
@@ -57,6 +71,7 @@ struct comp_msg
     apc_param_t   cvalue;
     apc_param_t   information;
     unsigned int  status;
+    struct wait_completion_packet *packet;  /* wait completion packet that queued the message */
 };
 
 struct completion_wait
@@ -78,6 +93,57 @@ struct completion
     unsigned int        depth;
 };
 
+/* a wait completion packet posts a message to a completion port once its target object is signaled */
+struct wait_completion_packet
+{
+    struct object       obj;
+    struct thread_wait *wait;          /* pending wait on the target object */
+    struct completion  *completion;    /* completion port to post to */
+    apc_param_t         ckey;          /* completion key */
+    apc_param_t         cvalue;        /* completion value */
+    apc_param_t         information;   /* IO_STATUS_BLOCK Information */
+    unsigned int        status;        /* completion result */
+    struct completion  *queued_port;   /* port holding the queued message */
+    struct comp_msg    *queued_msg;    /* message queued once the target was signaled */
+};
+
+static void wait_completion_packet_dump( struct object *obj, int verbose );
+static void wait_completion_packet_destroy( struct object *obj );
+
+static const struct object_ops wait_completion_packet_ops =
+{
+    sizeof(struct wait_completion_packet), /* size */
+    &wait_completion_packet_type,   /* type */
+    wait_completion_packet_dump,    /* dump */
+    no_add_queue,                   /* add_queue */
+    NULL,                           /* remove_queue */
+    NULL,                           /* signaled */
+    no_satisfied,                   /* satisfied */
+    no_signal,                      /* signal */
+    no_get_fd,                      /* get_fd */
+    default_get_sync,               /* get_sync */
+    default_map_access,             /* map_access */
+    default_get_sd,                 /* get_sd */
+    default_set_sd,                 /* set_sd */
+    default_get_full_name,          /* get_full_name */
+    no_lookup_name,                 /* lookup_name */
+    directory_link_name,            /* link_name */
+    default_unlink_name,            /* unlink_name */
+    no_open_file,                   /* open_file */
+    no_kernel_obj_list,             /* get_kernel_obj_list */
+    no_close_handle,                /* close_handle */
+    wait_completion_packet_destroy  /* destroy */
+};
+
+/* detach a message which is being removed from its port from the packet that queued it */
+static void unlink_comp_msg( struct comp_msg *msg )
+{
+    if (!msg->packet) return;
+    msg->packet->queued_port = NULL;
+    msg->packet->queued_msg = NULL;
+    msg->packet = NULL;
+}
+
 static void completion_wait_dump( struct object*, int );
 static int completion_wait_signaled( struct object *obj, struct wait_queue_entry *entry );
 static void completion_wait_satisfied( struct object *obj, struct wait_queue_entry *entry );
@@ -149,6 +215,7 @@ static void completion_wait_satisfied( struct object *obj, struct wait_queue_ent
     msg = LIST_ENTRY( msg_entry, struct comp_msg, queue_entry );
     --wait->completion->depth;
     list_remove( &msg->queue_entry );
+    unlink_comp_msg( msg );
     if (wait->msg) free( wait->msg );
     wait->msg = msg;
 }
@@ -190,6 +257,7 @@ static void completion_destroy( struct object *obj)
 
     LIST_FOR_EACH_ENTRY_SAFE( tmp, next, &completion->queue, struct comp_msg, queue_entry )
     {
+        unlink_comp_msg( tmp );
         free( tmp );
     }
 
@@ -294,8 +362,9 @@ struct completion *get_completion_obj( struct process *process, obj_handle_t han
     return (struct completion *) get_handle_obj( process, handle, access, &completion_ops );
 }
 
-void add_completion( struct completion *completion, apc_param_t ckey, apc_param_t cvalue,
-                     unsigned int status, apc_param_t information )
+static void queue_completion( struct completion *completion, apc_param_t ckey, apc_param_t cvalue,
+                              unsigned int status, apc_param_t information,
+                              struct wait_completion_packet *packet )
 {
     struct comp_msg *msg = mem_alloc( sizeof( *msg ) );
     struct completion_wait *wait;
@@ -307,6 +376,14 @@ void add_completion( struct completion *completion, apc_param_t ckey, apc_param_
     msg->cvalue = cvalue;
     msg->status = status;
     msg->information = information;
+    msg->packet = packet;
+    if (packet)
+    {
+        /* only the most recent message of a packet can be removed */
+        if (packet->queued_msg) packet->queued_msg->packet = NULL;
+        packet->queued_port = completion;
+        packet->queued_msg = msg;
+    }
 
     list_add_tail( &completion->queue, &msg->queue_entry );
     completion->depth++;
@@ -318,6 +395,70 @@ void add_completion( struct completion *completion, apc_param_t ckey, apc_param_
     if (!list_empty( &completion->queue )) signal_sync( completion->sync );
 }
 
+void add_completion( struct completion *completion, apc_param_t ckey, apc_param_t cvalue,
+                     unsigned int status, apc_param_t information )
+{
+    queue_completion( completion, ckey, cvalue, status, information, NULL );
+}
+
+static void wait_completion_packet_dump( struct object *obj, int verbose )
+{
+    struct wait_completion_packet *packet = (struct wait_completion_packet *)obj;
+
+    assert( obj->ops == &wait_completion_packet_ops );
+    fprintf( stderr, "Wait completion packet completion=%p pending=%d\n", packet->completion, !!packet->wait );
+}
+
+/* remove the message queued by a packet from its port */
+static void wait_completion_packet_dequeue( struct wait_completion_packet *packet )
+{
+    struct completion *completion = packet->queued_port;
+    struct comp_msg *msg = packet->queued_msg;
+
+    list_remove( &msg->queue_entry );
+    unlink_comp_msg( msg );
+    free( msg );
+    completion->depth--;
+    if (list_empty( &completion->queue )) reset_sync( completion->sync );
+}
+
+static void wait_completion_packet_reset( struct wait_completion_packet *packet )
+{
+    if (packet->wait) remove_callback_wait( packet->wait );
+    packet->wait = NULL;
+    if (packet->completion) release_object( packet->completion );
+    packet->completion = NULL;
+}
+
+static void wait_completion_packet_destroy( struct object *obj )
+{
+    struct wait_completion_packet *packet = (struct wait_completion_packet *)obj;
+
+    assert( obj->ops == &wait_completion_packet_ops );
+    wait_completion_packet_reset( packet );
+    /* a message still queued stays on the port */
+    if (packet->queued_msg) packet->queued_msg->packet = NULL;
+}
+
+/* callback invoked when the target object of a packet has been signaled */
+static void wait_completion_packet_signaled( void *arg, unsigned int status )
+{
+    struct wait_completion_packet *packet = arg;
+    struct completion *completion = packet->completion;
+
+    /* the wait has already been freed, the packet may be associated again from now on */
+    packet->wait = NULL;
+    packet->completion = NULL;
+    queue_completion( completion, packet->ckey, packet->cvalue, packet->status, packet->information, packet );
+    release_object( completion );
+}
+
+static struct wait_completion_packet *get_wait_completion_packet_obj( struct process *process, obj_handle_t handle,
+                                                                      unsigned int access )
+{
+    return (struct wait_completion_packet *)get_handle_obj( process, handle, access, &wait_completion_packet_ops );
+}
+
 /* create a completion */
 DECL_HANDLER(create_completion)
 {
@@ -410,6 +551,7 @@ DECL_HANDLER(remove_completion)
         list_remove( entry );
         completion->depth--;
         msg = LIST_ENTRY( entry, struct comp_msg, queue_entry );
+        unlink_comp_msg( msg );
         reply->ckey = msg->ckey;
         reply->cvalue = msg->cvalue;
         reply->status = msg->status;
@@ -453,3 +595,91 @@ DECL_HANDLER(query_completion)
 
     release_object( completion );
 }
+
+
+/* create a wait completion packet */
+DECL_HANDLER(create_wait_completion_packet)
+{
+    struct wait_completion_packet *packet;
+    struct unicode_str name;
+    struct object *root;
+    const struct security_descriptor *sd;
+    const struct object_attributes *objattr = get_req_object_attributes( &sd, &name, &root );
+
+    if (!objattr) return;
+
+    if ((packet = create_named_object( root, &wait_completion_packet_ops, &name, objattr->attributes, sd )))
+    {
+        if (get_error() != STATUS_OBJECT_NAME_EXISTS)
+        {
+            packet->wait        = NULL;
+            packet->completion  = NULL;
+            packet->queued_port = NULL;
+            packet->queued_msg  = NULL;
+        }
+        reply->handle = alloc_handle( current->process, packet, req->access, objattr->attributes );
+        release_object( packet );
+    }
+
+    if (root) release_object( root );
+}
+
+/* associate a wait completion packet with a target object and a completion port */
+DECL_HANDLER(associate_wait_completion_packet)
+{
+    struct wait_completion_packet *packet;
+    struct completion *completion;
+    struct object *target;
+
+    if (!(packet = get_wait_completion_packet_obj( current->process, req->packet, 0x1 ))) return;
+
+    if (packet->wait)
+    {
+        set_error( STATUS_INVALID_PARAMETER_1 );
+        goto done;
+    }
+    if (!(completion = get_completion_obj( current->process, req->completion, IO_COMPLETION_MODIFY_STATE )))
+        goto done;
+    if (!(target = get_handle_obj( current->process, req->target, SYNCHRONIZE, NULL )))
+    {
+        release_object( completion );
+        goto done;
+    }
+    /* the wait isn't tied to a thread which could own the mutex */
+    if (target->ops->type == &mutex_type)
+    {
+        set_error( STATUS_OBJECT_TYPE_MISMATCH );
+        release_object( target );
+        release_object( completion );
+        goto done;
+    }
+
+    packet->ckey        = req->ckey;
+    packet->cvalue      = req->cvalue;
+    packet->information = req->information;
+    packet->status      = req->status;
+    if ((packet->wait = add_callback_wait( target, wait_completion_packet_signaled, packet )))
+    {
+        packet->completion = completion;
+        reply->signaled = wake_callback_wait( packet->wait );
+    }
+    else release_object( completion );
+
+    release_object( target );
+done:
+    release_object( packet );
+}
+
+/* cancel a pending wait completion packet */
+DECL_HANDLER(cancel_wait_completion_packet)
+{
+    struct wait_completion_packet *packet;
+
+    if (!(packet = get_wait_completion_packet_obj( current->process, req->packet, 0x1 ))) return;
+
+    if (packet->wait) wait_completion_packet_reset( packet );
+    else if (req->remove_signaled && packet->queued_msg) wait_completion_packet_dequeue( packet );
+    else set_error( STATUS_CANCELLED );
+
+    release_object( packet );
+}
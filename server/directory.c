@@ -164,6 +164,7 @@ static struct type_descr *types[] =
     &key_type,
     &apc_reserve_type,
     &completion_reserve_type,
+    &wait_completion_packet_type,
 };
 
 static void object_type_dump( struct object *obj, int verbose )
@@ -186,7 +187,10 @@ static struct object_type *create_object_type( struct object *root, unsigned int
 
 static void directory_dump( struct object *obj, int verbose )
 {
+    struct directory *dir = (struct directory *)obj;
+
     fputs( "Directory\n", stderr );
+    if (verbose && dir->entries) dump_namespace( dir->entries );
 }
 
 static struct object *directory_lookup_name( struct object *obj, struct unicode_str *name,
@@ -248,7 +252,7 @@ static void directory_destroy( struct object *obj )
 {
     struct directory *dir = (struct directory *)obj;
     assert( obj->ops == &directory_ops );
-    free( dir->entries );
+    free_namespace( dir->entries );
 }
 
 static struct directory *create_directory( struct object *root, const struct unicode_str *name,
@@ -109,6 +109,11 @@
 #if defined(HAVE_SYS_EPOLL_H) && defined(HAVE_EPOLL_CREATE)
 # include <sys/epoll.h>
 # define USE_EPOLL
+# if defined(HAVE_IO_URING_EXT_ARG) && defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#  include <sys/mman.h>
+#  include <linux/io_uring.h>
+#  define USE_IO_URING
+# endif
 #endif /* HAVE_SYS_EPOLL_H && HAVE_EPOLL_CREATE */
 
 #if defined(HAVE_PORT_H) && defined(HAVE_PORT_CREATE)
@@ -340,14 +345,23 @@ static file_pos_t max_unix_offset = OFF_T_MAX;
 
 struct timeout_user
 {
-    struct list           entry;      /* entry in sorted timeout list */
+    struct list           entry;      /* entry in expired list */
+    int                   index;      /* index in the timeout heap, -1 once expired */
     abstime_t             when;       /* timeout expiry */
     timeout_callback      callback;   /* callback function */
     void                 *private;    /* callback private data */
 };
 
-static struct list abs_timeout_list = LIST_INIT(abs_timeout_list); /* sorted absolute timeouts list */
-static struct list rel_timeout_list = LIST_INIT(rel_timeout_list); /* sorted relative timeouts list */
+/* binary min-heap of timeouts, ordered by expiry */
+struct timeout_heap
+{
+    struct timeout_user **entries;    /* heap entries */
+    unsigned int          count;      /* number of timeouts in the heap */
+    unsigned int          size;       /* allocated size of the entries array */
+};
+
+static struct timeout_heap abs_timeouts;  /* absolute timeouts */
+static struct timeout_heap rel_timeouts;  /* relative timeouts, keyed by negated expiry */
 timeout_t current_time;
 timeout_t monotonic_time;
 
@@ -437,43 +451,97 @@ void set_current_time(void)
     if (user_shared_data) set_user_shared_data_time();
 }
 
+/* sort key of a timeout in its heap, relative timeouts are stored as negative values */
+static inline abstime_t timeout_key( const struct timeout_user *timeout )
+{
+    return timeout->when > 0 ? timeout->when : -timeout->when;
+}
+
+static inline struct timeout_heap *get_timeout_heap( const struct timeout_user *timeout )
+{
+    return timeout->when > 0 ? &abs_timeouts : &rel_timeouts;
+}
+
+static inline void set_heap_entry( struct timeout_heap *heap, unsigned int index, struct timeout_user *timeout )
+{
+    heap->entries[index] = timeout;
+    timeout->index = index;
+}
+
+/* move an entry up or down the heap to restore the heap order */
+static void fix_timeout_heap( struct timeout_heap *heap, unsigned int index )
+{
+    struct timeout_user *timeout = heap->entries[index];
+    abstime_t key = timeout_key( timeout );
+    unsigned int parent, child;
+
+    while (index)
+    {
+        parent = (index - 1) / 2;
+        if (timeout_key( heap->entries[parent] ) <= key) break;
+        set_heap_entry( heap, index, heap->entries[parent] );
+        index = parent;
+    }
+    while ((child = 2 * index + 1) < heap->count)
+    {
+        if (child + 1 < heap->count &&
+            timeout_key( heap->entries[child + 1] ) < timeout_key( heap->entries[child] )) child++;
+        if (key <= timeout_key( heap->entries[child] )) break;
+        set_heap_entry( heap, index, heap->entries[child] );
+        index = child;
+    }
+    set_heap_entry( heap, index, timeout );
+}
+
+static void remove_timeout_from_heap( struct timeout_heap *heap, struct timeout_user *timeout )
+{
+    unsigned int index = timeout->index;
+    struct timeout_user *last = heap->entries[--heap->count];
+
+    timeout->index = -1;
+    if (last == timeout) return;
+    set_heap_entry( heap, index, last );
+    fix_timeout_heap( heap, index );
+}
+
 /* add a timeout user */
 struct timeout_user *add_timeout_user( timeout_t when, timeout_callback func, void *private )
 {
     struct timeout_user *user;
-    struct list *ptr;
+    struct timeout_heap *heap;
 
     if (!(user = mem_alloc( sizeof(*user) ))) return NULL;
     user->when     = timeout_to_abstime( when );
     user->callback = func;
     user->private  = private;
 
-    /* Now insert it in the linked list */
+    /* Now insert it in the heap */
 
-    if (user->when > 0)
+    heap = get_timeout_heap( user );
+    if (heap->count == heap->size)
     {
-        LIST_FOR_EACH( ptr, &abs_timeout_list )
-        {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
-            if (timeout->when >= user->when) break;
-        }
-    }
-    else
-    {
-        LIST_FOR_EACH( ptr, &rel_timeout_list )
+        unsigned int size = max( 64, heap->size * 2 );
+        struct timeout_user **entries;
+
+        if (!(entries = realloc( heap->entries, size * sizeof(*entries) )))
         {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
-            if (timeout->when <= user->when) break;
+            set_error( STATUS_NO_MEMORY );
+            free( user );
+            return NULL;
         }
+        heap->entries = entries;
+        heap->size    = size;
     }
-    list_add_before( ptr, &user->entry );
+    set_heap_entry( heap, heap->count++, user );
+    fix_timeout_heap( heap, user->index );
     return user;
 }
 
 /* remove a timeout user */
 void remove_timeout_user( struct timeout_user *user )
 {
-    list_remove( &user->entry );
+    if (user->index != -1) remove_timeout_from_heap( get_timeout_heap( user ), user );
+    else list_remove( &user->entry );  /* expired, callback not called yet */
     free( user );
 }
 
@@ -534,8 +602,260 @@ static inline void fd_poll_event( struct fd *fd, int event )
 
 static int epoll_fd = -1;
 
+#ifdef USE_IO_URING
+
+/* When available, io_uring is used instead of epoll. Poll requests are one-shot and
+ * only queued in the submission ring, so that all the changes made while processing
+ * a batch of events are submitted with a single syscall, together with the next wait. */
+
+#define URING_SQ_ENTRIES 256
+#define URING_CQ_ENTRIES 4096
+
+static int uring_fd = -1;
+static void *uring_ring;                    /* mapping of the submission and completion rings */
+static size_t uring_ring_size;
+static struct io_uring_sqe *uring_sqes;     /* submission entries */
+static unsigned int uring_sq_entries;
+static unsigned int *uring_sq_head;
+static unsigned int *uring_sq_tail;
+static unsigned int *uring_sq_mask;
+static struct io_uring_cqe *uring_cqes;     /* completion entries */
+static unsigned int *uring_cq_head;
+static unsigned int *uring_cq_tail;
+static unsigned int *uring_cq_mask;
+static unsigned int *uring_polls;           /* tag of the pending poll request of each user, 0 if none */
+static int uring_polls_size;
+static unsigned int uring_tag;              /* tag of the last poll request */
+
+static int uring_enter( unsigned int to_submit, unsigned int min_complete, unsigned int flags,
+                        void *arg, size_t size )
+{
+    return syscall( __NR_io_uring_enter, uring_fd, to_submit, min_complete, flags, arg, size );
+}
+
+static inline unsigned int uring_to_submit(void)
+{
+    return *uring_sq_tail - __atomic_load_n( uring_sq_head, __ATOMIC_ACQUIRE );
+}
+
+static int init_uring(void)
+{
+    const unsigned int features = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+    const char *env = getenv( "WINESERVERIOURING" );
+    struct io_uring_params params;
+    size_t sq_size, cq_size;
+    unsigned int i, *array;
+    void *sqes;
+    int fd;
+
+    if (env && !atoi( env )) return 0;  /* disabled by the user, use epoll */
+
+    memset( &params, 0, sizeof(params) );
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = URING_CQ_ENTRIES;
+    if ((fd = syscall( __NR_io_uring_setup, URING_SQ_ENTRIES, &params )) == -1) return 0;
+    if ((params.features & features) != features) goto failed;
+
+    sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    uring_ring_size = max( sq_size, cq_size );
+    uring_ring = mmap( NULL, uring_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       fd, IORING_OFF_SQ_RING );
+    if (uring_ring == MAP_FAILED) goto failed;
+    sqes = mmap( NULL, params.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES );
+    if (sqes == MAP_FAILED)
+    {
+        munmap( uring_ring, uring_ring_size );
+        goto failed;
+    }
+
+    uring_sqes       = sqes;
+    uring_sq_entries = params.sq_entries;
+    uring_sq_head    = (unsigned int *)((char *)uring_ring + params.sq_off.head);
+    uring_sq_tail    = (unsigned int *)((char *)uring_ring + params.sq_off.tail);
+    uring_sq_mask    = (unsigned int *)((char *)uring_ring + params.sq_off.ring_mask);
+    uring_cqes       = (struct io_uring_cqe *)((char *)uring_ring + params.cq_off.cqes);
+    uring_cq_head    = (unsigned int *)((char *)uring_ring + params.cq_off.head);
+    uring_cq_tail    = (unsigned int *)((char *)uring_ring + params.cq_off.tail);
+    uring_cq_mask    = (unsigned int *)((char *)uring_ring + params.cq_off.ring_mask);
+
+    /* entries are always used in order */
+    array = (unsigned int *)((char *)uring_ring + params.sq_off.array);
+    for (i = 0; i < params.sq_entries; i++) array[i] = i;
+
+    uring_fd = fd;
+    return 1;
+
+failed:
+    close( fd );
+    return 0;
+}
+
+/* give up on io_uring, the main loop will fall back to poll() */
+static void close_uring(void)
+{
+    munmap( uring_sqes, uring_sq_entries * sizeof(struct io_uring_sqe) );
+    munmap( uring_ring, uring_ring_size );
+    close( uring_fd );
+    uring_fd = -1;
+}
+
+/* get a free submission entry, flushing the ring if needed */
+static struct io_uring_sqe *get_uring_sqe(void)
+{
+    struct io_uring_sqe *sqe;
+
+    if (uring_to_submit() == uring_sq_entries &&
+        (uring_enter( uring_sq_entries, 0, 0, NULL, 0 ) == -1 || uring_to_submit() == uring_sq_entries))
+    {
+        perror( "io_uring_enter" );  /* should not happen */
+        close_uring();
+        return NULL;
+    }
+    sqe = &uring_sqes[*uring_sq_tail & *uring_sq_mask];
+    memset( sqe, 0, sizeof(*sqe) );
+    return sqe;
+}
+
+static inline void queue_uring_sqe(void)
+{
+    __atomic_store_n( uring_sq_tail, *uring_sq_tail + 1, __ATOMIC_RELEASE );
+}
+
+/* queue a poll request for this user */
+static void add_uring_poll( int unix_fd, int user, int events )
+{
+    struct io_uring_sqe *sqe;
+
+    if (user >= uring_polls_size)
+    {
+        unsigned int *new_polls;
+        int new_size = max( allocated_users, user + 1 );
+
+        if (!(new_polls = realloc( uring_polls, new_size * sizeof(*new_polls) )))
+        {
+            close_uring();
+            return;
+        }
+        memset( new_polls + uring_polls_size, 0, (new_size - uring_polls_size) * sizeof(*new_polls) );
+        uring_polls = new_polls;
+        uring_polls_size = new_size;
+    }
+
+    if (!(sqe = get_uring_sqe())) return;
+    if (!++uring_tag) uring_tag++;
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = unix_fd;
+#ifdef WORDS_BIGENDIAN
+    sqe->poll32_events = ((unsigned int)events << 16) | ((unsigned int)events >> 16);
+#else
+    sqe->poll32_events = events;
+#endif
+    sqe->user_data = ((__u64)uring_tag << 32) | user;
+    queue_uring_sqe();
+    uring_polls[user] = uring_tag;
+}
+
+/* cancel the pending poll request of this user, if any */
+static void remove_uring_poll( int user )
+{
+    struct io_uring_sqe *sqe;
+
+    if (user >= uring_polls_size || !uring_polls[user]) return;
+    if (!(sqe = get_uring_sqe())) return;
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = ((__u64)uring_polls[user] << 32) | user;
+    sqe->user_data = 0;  /* tag 0 is never used, the completion is ignored */
+    queue_uring_sqe();
+    uring_polls[user] = 0;
+}
+
+static void set_fd_uring_events( struct fd *fd, int user, int events )
+{
+    if (events != -1 && pollfd[user].fd != -1 && pollfd[user].events == events &&
+        user < uring_polls_size && uring_polls[user])
+        return;  /* nothing to do */
+
+    remove_uring_poll( user );
+    if (events != -1 && uring_fd != -1) add_uring_poll( fd->unix_fd, user, events );
+}
+
+static void main_loop_uring(void)
+{
+    struct io_uring_getevents_arg arg;
+    struct __kernel_timespec kts;
+    struct timespec ts;
+    int users[128];
+    unsigned int head, tail, tag;
+    int i, ret, count, timeout, user;
+
+    memset( &arg, 0, sizeof(arg) );
+    arg.sigmask_sz = _NSIG / 8;
+
+    while (active_users)
+    {
+        timeout = get_next_timeout( &ts );
+
+        if (!active_users) break;  /* last user removed by a timeout */
+        if (uring_fd == -1) break;  /* an error occurred with io_uring */
+
+        if (timeout == -1) arg.ts = 0;
+        else
+        {
+            kts.tv_sec = ts.tv_sec;
+            kts.tv_nsec = ts.tv_nsec;
+            arg.ts = (ULONG_PTR)&kts;
+        }
+        ret = uring_enter( uring_to_submit(), 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                           &arg, sizeof(arg) );
+        if (ret == -1 && errno != EINTR && errno != ETIME && errno != EBUSY)
+        {
+            perror( "io_uring_enter" );
+            close_uring();
+            break;
+        }
+
+        set_current_time();
+
+        /* put the events into the pollfd array first, like poll does */
+        head = *uring_cq_head;
+        tail = __atomic_load_n( uring_cq_tail, __ATOMIC_ACQUIRE );
+        for (count = 0; head != tail && count < ARRAY_SIZE( users ); head++)
+        {
+            struct io_uring_cqe *cqe = &uring_cqes[head & *uring_cq_mask];
+
+            user = cqe->user_data & 0xffffffff;
+            tag = cqe->user_data >> 32;
+            if (!tag || user >= uring_polls_size || uring_polls[user] != tag) continue;  /* stale */
+            uring_polls[user] = 0;
+            pollfd[user].revents = cqe->res < 0 ? POLLERR : cqe->res;
+            users[count++] = user;
+        }
+        __atomic_store_n( uring_cq_head, head, __ATOMIC_RELEASE );
+
+        /* read events from the pollfd array, as set_fd_events may modify them */
+        for (i = 0; i < count; i++)
+        {
+            user = users[i];
+            if (pollfd[user].revents) fd_poll_event( poll_users[user], pollfd[user].revents );
+            pollfd[user].revents = 0;
+            if (uring_fd == -1) break;
+            /* if we are still interested, queue a new poll request */
+            if (pollfd[user].fd != -1 && !uring_polls[user])
+                add_uring_poll( pollfd[user].fd, user, pollfd[user].events );
+        }
+    }
+}
+
+#endif /* USE_IO_URING */
+
 static inline void init_epoll(void)
 {
+#ifdef USE_IO_URING
+    if (init_uring()) return;
+#endif
     epoll_fd = epoll_create( 128 );
 }
 
@@ -545,6 +865,13 @@ static inline void set_fd_epoll_events( struct fd *fd, int user, int events )
     struct epoll_event ev;
     int ctl;
 
+#ifdef USE_IO_URING
+    if (uring_fd != -1)
+    {
+        set_fd_uring_events( fd, user, events );
+        return;
+    }
+#endif
     if (epoll_fd == -1) return;
 
     if (events == -1)  /* stop waiting on this fd completely */
@@ -579,6 +906,13 @@ static inline void set_fd_epoll_events( struct fd *fd, int user, int events )
 
 static inline void remove_epoll_user( struct fd *fd, int user )
 {
+#ifdef USE_IO_URING
+    if (uring_fd != -1)
+    {
+        remove_uring_poll( user );
+        return;
+    }
+#endif
     if (epoll_fd == -1) return;
 
     if (pollfd[user].fd != -1)
@@ -602,6 +936,13 @@ static inline void main_loop_epoll(void)
     assert( POLLERR == EPOLLERR );
     assert( POLLHUP == EPOLLHUP );
 
+#ifdef USE_IO_URING
+    if (uring_fd != -1)
+    {
+        main_loop_uring();
+        return;
+    }
+#endif
     if (epoll_fd == -1) return;
 
     while (active_users)
@@ -909,58 +1250,45 @@ static int get_next_timeout( struct timespec *ts )
 {
     timeout_t ret = user_shared_data ? user_shared_data_timeout : -1;
 
-    if (!list_empty( &abs_timeout_list ) || !list_empty( &rel_timeout_list ))
+    if (abs_timeouts.count || rel_timeouts.count)
     {
         struct list expired_list, *ptr;
+        struct timeout_user *timeout;
 
-        /* first remove all expired timers from the list */
+        /* first remove all expired timers from the heaps */
 
         list_init( &expired_list );
-        while ((ptr = list_head( &abs_timeout_list )) != NULL)
+        while (abs_timeouts.count && (timeout = abs_timeouts.entries[0])->when <= current_time)
         {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
-
-            if (timeout->when <= current_time)
-            {
-                list_remove( &timeout->entry );
-                list_add_tail( &expired_list, &timeout->entry );
-            }
-            else break;
+            remove_timeout_from_heap( &abs_timeouts, timeout );
+            list_add_tail( &expired_list, &timeout->entry );
         }
-        while ((ptr = list_head( &rel_timeout_list )) != NULL)
+        while (rel_timeouts.count && -(timeout = rel_timeouts.entries[0])->when <= monotonic_time)
         {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
-
-            if (-timeout->when <= monotonic_time)
-            {
-                list_remove( &timeout->entry );
-                list_add_tail( &expired_list, &timeout->entry );
-            }
-            else break;
+            remove_timeout_from_heap( &rel_timeouts, timeout );
+            list_add_tail( &expired_list, &timeout->entry );
         }
 
         /* now call the callback for all the removed timers */
 
         while ((ptr = list_head( &expired_list )) != NULL)
         {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
+            timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
             list_remove( &timeout->entry );
             timeout->callback( timeout->private );
             free( timeout );
         }
 
-        if ((ptr = list_head( &abs_timeout_list )) != NULL)
+        if (abs_timeouts.count)
         {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
-            timeout_t diff = timeout->when - current_time;
+            timeout_t diff = abs_timeouts.entries[0]->when - current_time;
             if (diff < 0) diff = 0;
             if (ret == -1 || diff < ret) ret = diff;
         }
 
-        if ((ptr = list_head( &rel_timeout_list )) != NULL)
+        if (rel_timeouts.count)
         {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
-            timeout_t diff = -timeout->when - monotonic_time;
+            timeout_t diff = -rel_timeouts.entries[0]->when - monotonic_time;
             if (diff < 0) diff = 0;
             if (ret == -1 || diff < ret) ret = diff;
         }
@@ -2185,6 +2513,29 @@ void allow_fd_caching( struct fd *fd )
     fd->cacheable = 1;
 }
 
+/* send the unix fd of a new handle along with the reply if the client can cache it */
+enum server_fd_type send_cacheable_fd( struct process *process, struct object *obj, obj_handle_t handle,
+                                       unsigned int *options )
+{
+    unsigned int error = get_error();
+    enum server_fd_type type = FD_TYPE_INVALID;
+    struct fd *fd;
+    int unix_fd;
+
+    if ((fd = get_obj_fd( obj )))
+    {
+        if (fd->cacheable && (unix_fd = get_unix_fd( fd )) != -1)
+        {
+            type = fd->fd_ops->get_fd_type( fd );
+            *options = fd->options;
+            send_client_fd( process, unix_fd, handle );
+        }
+        release_object( fd );
+    }
+    set_error( error );
+    return type;
+}
+
 /* check if fd is on a removable device */
 int is_fd_removable( struct fd *fd )
 {
@@ -667,6 +667,12 @@ DECL_HANDLER(create_file)
                              req->create, req->options, req->attrs, sd )))
     {
         reply->handle = alloc_handle( current->process, file, req->access, objattr->attributes );
+        if (reply->handle && req->want_fd)
+        {
+            /* save the client a get_handle_fd request */
+            reply->type = send_cacheable_fd( current->process, file, reply->handle, &reply->options );
+            reply->access = get_handle_access( current->process, reply->handle );
+        }
         release_object( file );
     }
     if (root_fd) release_object( root_fd );
@@ -44,14 +44,19 @@ struct handle_entry
     unsigned int   access;    /* access rights */
 };
 
+/* entries are allocated in pages, so that they never move once allocated */
+#define HANDLE_PAGE_SHIFT   8
+#define HANDLE_PAGE_SIZE    (1 << HANDLE_PAGE_SHIFT)
+
 struct handle_table
 {
-    struct object        obj;         /* object header */
-    struct process      *process;     /* process owning this table */
-    int                  count;       /* number of allocated entries */
-    int                  last;        /* last used entry */
-    int                  free;        /* first entry that may be free */
-    struct handle_entry *entries;     /* handle entries */
+    struct object         obj;         /* object header */
+    struct process       *process;     /* process owning this table */
+    int                   count;       /* number of allocated entries */
+    int                   last;        /* last used entry */
+    int                   free;        /* first entry of the free list, -1 if empty */
+    int                   unused;      /* first entry never used since the free list was built */
+    struct handle_entry **pages;       /* pages of handle entries */
 };
 
 static struct handle_table *global_table;
@@ -62,7 +67,7 @@ static struct handle_table *global_table;
 #define RESERVED_CLOSE_PROTECT (HANDLE_FLAG_PROTECT_FROM_CLOSE << RESERVED_SHIFT)
 #define RESERVED_ALL           (RESERVED_INHERIT | RESERVED_CLOSE_PROTECT)
 
-#define MIN_HANDLE_ENTRIES  32
+#define MIN_HANDLE_ENTRIES  HANDLE_PAGE_SIZE
 #define MAX_HANDLE_ENTRIES  0x00ffffff
 
 
@@ -78,6 +83,11 @@ static inline int handle_to_index( obj_handle_t handle )
     return (handle >> 2) - 1;
 }
 
+static inline struct handle_entry *get_entry( struct handle_table *table, int index )
+{
+    return &table->pages[index >> HANDLE_PAGE_SHIFT][index & (HANDLE_PAGE_SIZE - 1)];
+}
+
 /* global handle conversion */
 
 #define HANDLE_OBFUSCATOR 0x544a4def
@@ -154,9 +164,9 @@ static void handle_table_dump( struct object *obj, int verbose )
     fprintf( stderr, "Handle table last=%d count=%d process=%p\n",
              table->last, table->count, table->process );
     if (!verbose) return;
-    entry = table->entries;
-    for (i = 0; i <= table->last; i++, entry++)
+    for (i = 0; i <= table->last; i++)
     {
+        entry = get_entry( table, i );
         if (!entry->ptr) continue;
         fprintf( stderr, "    %04x: %p %08x ",
                  index_to_handle(i), entry->ptr, entry->access );
@@ -174,9 +184,12 @@ static void handle_table_destroy( struct object *obj )
 
     assert( obj->ops == &handle_table_ops );
 
-    for (i = 0, entry = table->entries; i <= table->last; i++, entry++)
+    for (i = 0; i <= table->last; i++)
     {
-        struct object *obj = entry->ptr;
+        struct object *obj;
+
+        entry = get_entry( table, i );
+        obj = entry->ptr;
         entry->ptr = NULL;
         if (obj)
         {
@@ -185,7 +198,11 @@ static void handle_table_destroy( struct object *obj )
             release_object_from_handle( obj );
         }
     }
-    free( table->entries );
+    if (table->pages)
+    {
+        for (i = 0; i < table->count / HANDLE_PAGE_SIZE; i++) free( table->pages[i] );
+        free( table->pages );
+    }
 }
 
 /* close all the process handles and free the handle table */
@@ -197,55 +214,99 @@ void close_process_handles( struct process *process )
     if (table) release_object( table );
 }
 
+/* set the number of allocated pages of a handle table */
+static int resize_handle_table( struct handle_table *table, int count )
+{
+    int i, old_pages = table->count / HANDLE_PAGE_SIZE, new_pages = count / HANDLE_PAGE_SIZE;
+    struct handle_entry **pages;
+
+    for (i = new_pages; i < old_pages; i++) free( table->pages[i] );
+    if (!(pages = realloc( table->pages, new_pages * sizeof(*pages) )))
+    {
+        if (new_pages < old_pages) table->count = count;  /* keep the old, larger, array */
+        return 0;
+    }
+    table->pages = pages;
+    for (i = old_pages; i < new_pages; i++)
+    {
+        if (!(pages[i] = calloc( HANDLE_PAGE_SIZE, sizeof(*pages[i]) )))
+        {
+            table->count = i * HANDLE_PAGE_SIZE;
+            return 0;
+        }
+    }
+    table->count = count;
+    return 1;
+}
+
 /* allocate a new handle table */
 struct handle_table *alloc_handle_table( struct process *process, int count )
 {
     struct handle_table *table;
 
-    if (count < MIN_HANDLE_ENTRIES) count = MIN_HANDLE_ENTRIES;
+    count = (max( count, MIN_HANDLE_ENTRIES ) + HANDLE_PAGE_SIZE - 1) & ~(HANDLE_PAGE_SIZE - 1);
     if (!(table = alloc_object( &handle_table_ops )))
         return NULL;
     table->process = process;
-    table->count   = count;
+    table->count   = 0;
     table->last    = -1;
-    table->free    = 0;
-    if ((table->entries = mem_alloc( count * sizeof(*table->entries) ))) return table;
+    table->free    = -1;
+    table->unused  = 0;
+    table->pages   = NULL;
+    if (resize_handle_table( table, count )) return table;
+    set_error( STATUS_NO_MEMORY );
     release_object( table );
     return NULL;
 }
 
-/* grow a handle table */
+/* grow a handle table by one page */
 static int grow_handle_table( struct handle_table *table )
 {
-    struct handle_entry *new_entries;
-    int count = min( table->count * 2, MAX_HANDLE_ENTRIES );
+    int count = min( table->count + HANDLE_PAGE_SIZE, MAX_HANDLE_ENTRIES & ~(HANDLE_PAGE_SIZE - 1) );
 
-    if (count == table->count ||
-        !(new_entries = realloc( table->entries, count * sizeof(struct handle_entry) )))
+    if (count == table->count || !resize_handle_table( table, count ))
     {
         set_error( STATUS_INSUFFICIENT_RESOURCES );
         return 0;
     }
-    table->entries = new_entries;
-    table->count   = count;
     return 1;
 }
 
-/* allocate the first free entry in the handle table */
+/* rebuild the free list, with the lowest entries first */
+static void build_free_list( struct handle_table *table )
+{
+    struct handle_entry *entry;
+    int i;
+
+    table->free = -1;
+    table->unused = table->last + 1;
+    for (i = table->last; i >= 0; i--)
+    {
+        entry = get_entry( table, i );
+        if (entry->ptr) continue;
+        entry->access = table->free;  /* the access field links the free entries */
+        table->free = i;
+    }
+}
+
+/* allocate a free entry in the handle table */
 static obj_handle_t alloc_entry( struct handle_table *table, void *obj, unsigned int access )
 {
-    struct handle_entry *entry = table->entries + table->free;
+    struct handle_entry *entry;
     int i;
 
-    for (i = table->free; i <= table->last; i++, entry++) if (!entry->ptr) goto found;
-    if (i >= table->count)
+    if ((i = table->free) != -1)
     {
-        if (!grow_handle_table( table )) return 0;
-        entry = table->entries + i;  /* the entries may have moved */
+        entry = get_entry( table, i );
+        table->free = entry->access;
     }
-    table->last = i;
- found:
-    table->free = i + 1;
+    else
+    {
+        if ((i = table->unused) >= table->count && !grow_handle_table( table )) return 0;
+        entry = get_entry( table, i );
+        table->unused++;
+    }
+    if (i > table->last) table->last = i;
     entry->ptr    = grab_object_for_handle( obj );
     entry->access = access;
     return index_to_handle(i);
@@ -331,7 +392,7 @@ static struct handle_entry *get_handle( struct process *process, obj_handle_t ha
     index = handle_to_index( handle );
     if (index < 0) return NULL;
     if (index > table->last) return NULL;
-    entry = table->entries + index;
+    entry = get_entry( table, index );
     if (!entry->ptr) return NULL;
     return entry;
 }
@@ -339,22 +400,16 @@ static struct handle_entry *get_handle( struct process *process, obj_handle_t ha
 /* attempt to shrink a table */
 static void shrink_handle_table( struct handle_table *table )
 {
-    struct handle_entry *entry = table->entries + table->last;
-    struct handle_entry *new_entries;
     int count = table->count;
 
-    while (table->last >= 0)
-    {
-        if (entry->ptr) break;
-        table->last--;
-        entry--;
-    }
+    while (table->last >= 0 && !get_entry( table, table->last )->ptr) table->last--;
+
     if (table->last >= count / 4) return;  /* no need to shrink */
     if (count < MIN_HANDLE_ENTRIES * 2) return;  /* too small to shrink */
-    count /= 2;
-    if (!(new_entries = realloc( table->entries, count * sizeof(*new_entries) ))) return;
-    table->count   = count;
-    table->entries = new_entries;
+    count = max( (count / 2) & ~(HANDLE_PAGE_SIZE - 1), MIN_HANDLE_ENTRIES );
+    /* the free list may link entries in the freed pages */
+    resize_handle_table( table, count );
+    build_free_list( table );
 }
 
 static void inherit_handle( struct process *parent, const obj_handle_t handle, struct handle_table *table )
@@ -362,14 +417,13 @@ static void inherit_handle( struct process *parent, const obj_handle_t handle, s
     struct handle_entry *dst, *src;
     int index;
 
-    dst = table->entries;
-
     src = get_handle( parent, handle );
     if (!src || !(src->access & RESERVED_INHERIT)) return;
     index = handle_to_index( handle );
-    if (dst[index].ptr) return;
+    dst = get_entry( table, index );
+    if (dst->ptr) return;
     grab_object_for_handle( src->ptr );
-    dst[index] = *src;
+    *dst = *src;
     table->last = max( table->last, index );
 }
 
@@ -391,8 +445,6 @@ struct handle_table *copy_handle_table( struct process *process, struct process
 
     if (handles)
     {
-        memset( table->entries, 0, parent_table->count * sizeof(*table->entries) );
-
         for (i = 0; i < handle_count; i++)
         {
             inherit_handle( parent, handles[i], table );
@@ -407,10 +459,11 @@ struct handle_table *copy_handle_table( struct process *process, struct process
     {
         if ((table->last = parent_table->last) >= 0)
         {
-            struct handle_entry *ptr = table->entries;
-            memcpy( ptr, parent_table->entries, (table->last + 1) * sizeof(struct handle_entry) );
-            for (i = 0; i <= table->last; i++, ptr++)
+            for (i = 0; i <= table->last; i++)
             {
+                struct handle_entry *ptr = get_entry( table, i );
+
+                *ptr = *get_entry( parent_table, i );
                 if (!ptr->ptr) continue;
                 if (ptr->access & RESERVED_INHERIT) grab_object_for_handle( ptr->ptr );
                 else ptr->ptr = NULL; /* don't inherit this entry */
@@ -419,6 +472,7 @@ struct handle_table *copy_handle_table( struct process *process, struct process
     }
     /* attempt to shrink the table */
     shrink_handle_table( table );
+    build_free_list( table );
     return table;
 }
 
@@ -435,9 +489,15 @@ unsigned int close_handle( struct process *process, obj_handle_t handle )
     obj = entry->ptr;
     if (!obj->ops->close_handle( obj, process, handle )) return STATUS_HANDLE_NOT_CLOSABLE;
 
-    table = handle_is_global(handle) ? global_table : process->handles;
-    table->entries[index].ptr = NULL;
-    if (index < table->free) table->free = index;
+    if (handle_is_global(handle))
+    {
+        table = global_table;
+        index = handle_to_index( handle_global_to_local( handle ));
+    }
+    else table = process->handles;
+    entry->ptr = NULL;
+    entry->access = table->free;
+    table->free = index;
     if (index == table->last) shrink_handle_table( table );
     release_object_from_handle( obj );
     return STATUS_SUCCESS;
@@ -518,8 +578,9 @@ obj_handle_t find_inherited_handle( struct process *process, const struct object
 
     if (!table) return 0;
 
-    for (i = 0, ptr = table->entries; i <= table->last; i++, ptr++)
+    for (i = 0; i <= table->last; i++)
     {
+        ptr = get_entry( table, i );
         if (!ptr->ptr) continue;
         if (ptr->ptr->ops != ops) continue;
         if (ptr->access & RESERVED_INHERIT) return index_to_handle(i);
@@ -537,8 +598,11 @@ unsigned int get_obj_handle_count( struct process *process, const struct object
 
     if (!table) return 0;
 
-    for (i = 0, ptr = table->entries; i <= table->last; i++, ptr++)
+    for (i = 0; i <= table->last; i++)
+    {
+        ptr = get_entry( table, i );
         if (ptr->ptr == obj) ++count;
+    }
     return count;
 }
 
@@ -848,8 +912,9 @@ static int enum_handles( struct process *process, void *user )
     if (!table)
         return 0;
 
-    for (i = 0, entry = table->entries; i <= table->last; i++, entry++)
+    for (i = 0; i <= table->last; i++)
     {
+        entry = get_entry( table, i );
         if (!entry->ptr) continue;
         if (!info->handle)
         {
@@ -908,8 +973,9 @@ static int enum_process_handles_cb( struct process *process, void *user )
     if (!table)
         return 0;
 
-    for (i = 0, entry = table->entries; i <= table->last; i++, entry++)
+    for (i = 0; i <= table->last; i++)
     {
+        entry = get_entry( table, i );
         if (!entry->ptr || entry->ptr->ops != info->ops) continue;
         if ((info->cb)( process, entry->ptr, info->user )) return 1;
     }
@@ -86,12 +86,23 @@ static const struct object_ops ranges_ops =
     ranges_destroy             /* destroy */
 };
 
-/* file backing the shared sections of a PE image mapping */
+/* identity of the contents of a PE file, in addition to its inode */
+struct file_stamp
+{
+    file_pos_t      size;            /* file size */
+    time_t          mtime;           /* modification time */
+    long            mtime_nsec;      /* modification time nanoseconds */
+};
+
+/* file backing the shared sections of a PE image mapping, or its relocated sections */
 struct shared_map
 {
     struct object   obj;             /* object header */
     struct fd      *fd;              /* file descriptor of the mapped PE file */
-    struct file    *file;            /* temp file holding the shared data */
+    struct file_stamp stamp;         /* PE file contents the data was built from */
+    struct file    *file;            /* temp file holding the shared data, NULL if it couldn't be built */
+    client_ptr_t    base;            /* address the sections are relocated to, 0 for shared sections */
+    struct process *builder;         /* process writing the relocated sections, NULL once done */
     struct list     entry;           /* entry in global shared maps list */
 };
 
@@ -132,6 +143,7 @@ struct memory_view
     struct fd      *fd;              /* fd for mapped file */
     struct ranges  *committed;       /* list of committed ranges in this mapping */
     struct shared_map *shared;       /* temp file for shared PE mapping */
+    struct shared_map *relocated;    /* temp file for relocated PE mapping */
     struct pe_image_info image;      /* image info (for PE image mapping) */
     unsigned int    flags;           /* SEC_* flags */
     client_ptr_t    base;            /* view base address (in process addr space) */
@@ -165,6 +177,7 @@ struct mapping
     struct pe_image_info image;      /* image info (for PE image mapping) */
     struct ranges       *committed;  /* list of committed ranges in this mapping */
     struct shared_map   *shared;     /* temp file for shared PE mapping */
+    struct shared_map   *relocated;  /* temp file for relocated PE mapping */
     char                *exp_name;   /* export name (for PE image mapping) */
     void                *ver_res;    /* version resource (for PE image mapping) */
     data_size_t          exp_len;    /* length of export name (for PE image mapping) */
@@ -302,7 +315,8 @@ static void shared_map_destroy( struct object *obj )
     struct shared_map *shared = (struct shared_map *)obj;
 
     release_object( shared->fd );
-    release_object( shared->file );
+    if (shared->file) release_object( shared->file );
+    if (shared->builder) release_object( shared->builder );
     list_remove( &shared->entry );
 }
 
@@ -363,7 +377,7 @@ static int check_current_dir_for_exec(void)
 }
 
 /* create a temp file for anonymous mappings */
-static int create_temp_file( file_pos_t size )
+int create_temp_file( file_pos_t size )
 {
     static int temp_dir_fd = -1;
     char tmpfn[16];
@@ -497,6 +511,7 @@ static void free_memory_view( struct memory_view *view )
     if (view->fd) release_object( view->fd );
     if (view->committed) release_object( view->committed );
     if (view->shared) release_object( view->shared );
+    if (view->relocated) release_object( view->relocated );
     list_remove( &view->entry );
     free( view );
 }
@@ -510,13 +525,49 @@ void free_mapped_views( struct process *process )
         free_memory_view( LIST_ENTRY( ptr, struct memory_view, entry ));
 }
 
+/* get the stamp of the current contents of a PE file */
+static int get_file_stamp( struct fd *fd, struct file_stamp *stamp )
+{
+    struct stat st;
+    int unix_fd = get_unix_fd( fd );
+
+    if (unix_fd == -1 || fstat( unix_fd, &st ) == -1) return 0;
+    stamp->size  = st.st_size;
+    stamp->mtime = st.st_mtime;
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+    stamp->mtime_nsec = st.st_mtim.tv_nsec;
+#else
+    stamp->mtime_nsec = 0;
+#endif
+    return 1;
+}
+
+/* create a shared PE mapping object for a given mapping */
+static struct shared_map *create_shared_file( struct fd *fd, const struct file_stamp *stamp,
+                                              struct file *file, client_ptr_t base )
+{
+    struct shared_map *shared;
+
+    if (!(shared = alloc_object( &shared_map_ops ))) return NULL;
+    shared->fd      = (struct fd *)grab_object( fd );
+    shared->stamp   = *stamp;
+    shared->file    = file;
+    shared->base    = base;
+    shared->builder = NULL;
+    list_add_head( &shared_map_list, &shared->entry );
+    return shared;
+}
+
 /* find the shared PE mapping for a given mapping */
-static struct shared_map *get_shared_file( struct fd *fd )
+static struct shared_map *get_shared_file( struct fd *fd, const struct file_stamp *stamp, client_ptr_t base )
 {
     struct shared_map *ptr;
 
+    /* the file may have been rewritten in place, only use data built from the same contents */
     LIST_FOR_EACH_ENTRY( ptr, &shared_map_list, struct shared_map, entry )
-        if (is_same_file_fd( ptr->fd, fd ))
+        if (ptr->base == base && is_same_file_fd( ptr->fd, fd ) &&
+            ptr->stamp.size == stamp->size && ptr->stamp.mtime == stamp->mtime &&
+            ptr->stamp.mtime_nsec == stamp->mtime_nsec)
             return (struct shared_map *)grab_object( ptr );
     return NULL;
 }
@@ -637,6 +688,7 @@ static int build_shared_mapping( struct mapping *mapping, size_t align_mask, int
     mem_size_t total_size;
     size_t file_size, map_size, max_size;
     off_t shared_pos, read_pos, write_pos;
+    struct file_stamp stamp;
     char *buffer = NULL;
     int shared_fd;
     long toread;
@@ -656,7 +708,8 @@ static int build_shared_mapping( struct mapping *mapping, size_t align_mask, int
     }
     if (!total_size) return 1;  /* nothing to do */
 
-    if ((mapping->shared = get_shared_file( mapping->fd ))) return 1;
+    if (!get_file_stamp( mapping->fd, &stamp )) return 0;
+    if ((mapping->shared = get_shared_file( mapping->fd, &stamp, 0 ))) return 1;
 
     /* create a temp file for the mapping */
 
@@ -692,10 +745,7 @@ static int build_shared_mapping( struct mapping *mapping, size_t align_mask, int
         if (pwrite( shared_fd, buffer, file_size, write_pos ) != file_size) goto error;
     }
 
-    if (!(shared = alloc_object( &shared_map_ops ))) goto error;
-    shared->fd = (struct fd *)grab_object( mapping->fd );
-    shared->file = file;
-    list_add_head( &shared_map_list, &shared->entry );
+    if (!(shared = create_shared_file( mapping->fd, &stamp, file, 0 ))) goto error;
     mapping->shared = shared;
     free( buffer );
     return 1;
@@ -706,6 +756,27 @@ static int build_shared_mapping( struct mapping *mapping, size_t align_mask, int
     return 0;
 }
 
+/* check if the relocated sections of an image mapping can be shared between processes */
+static int is_relocated_mapping_shareable( struct mapping *mapping )
+{
+    static const mem_size_t max_image_size = 256 * 1024 * 1024;
+
+    if (!(mapping->flags & SEC_IMAGE)) return 0;
+    if (!mapping->image.map_addr || mapping->image.map_addr == mapping->image.base) return 0;
+    if (!(mapping->image.image_flags & IMAGE_FLAGS_ImageDynamicallyRelocated)) return 0;
+    return !mapping->shared && mapping->image.map_size <= max_image_size;
+}
+
+/* find the relocated sections of an image mapping, if a process has already started building them */
+static struct shared_map *get_relocated_mapping( struct mapping *mapping )
+{
+    struct file_stamp stamp;
+
+    if (!mapping->relocated && get_file_stamp( mapping->fd, &stamp ))
+        mapping->relocated = get_shared_file( mapping->fd, &stamp, mapping->image.map_addr );
+    return mapping->relocated;
+}
+
 /* load a data directory header from its section */
 static int load_data_dir( void *dir, size_t dir_size, size_t va, size_t size, size_t align_mask,
                           int unix_fd, IMAGE_SECTION_HEADER *sec, unsigned int nb_sec )
@@ -1134,6 +1205,7 @@ static struct mapping *create_mapping( struct object *root, const struct unicode
     mapping->size        = size;
     mapping->fd          = NULL;
     mapping->shared      = NULL;
+    mapping->relocated   = NULL;
     mapping->committed   = NULL;
     mapping->exp_name    = NULL;
     mapping->ver_res     = NULL;
@@ -1227,6 +1299,7 @@ struct mapping *create_fd_mapping( struct object *root, const struct unicode_str
     if (get_error() == STATUS_OBJECT_NAME_EXISTS) return mapping;  /* Nothing else to do */
 
     mapping->shared    = NULL;
+    mapping->relocated = NULL;
     mapping->committed = NULL;
     mapping->exp_name  = NULL;
     mapping->ver_res   = NULL;
@@ -1343,6 +1416,7 @@ static void mapping_destroy( struct object *obj )
     if (mapping->fd) release_object( mapping->fd );
     if (mapping->committed) release_object( mapping->committed );
     if (mapping->shared) release_object( mapping->shared );
+    if (mapping->relocated) release_object( mapping->relocated );
     free( mapping->exp_name );
     free( mapping->ver_res );
 }
@@ -1668,6 +1742,14 @@ DECL_HANDLER(get_mapping_info)
     if (mapping->shared)
         reply->shared_file = alloc_handle( current->process, mapping->shared->file,
                                            GENERIC_READ|GENERIC_WRITE, 0 );
+    if (is_relocated_mapping_shareable( mapping ))
+    {
+        struct shared_map *relocated = get_relocated_mapping( mapping );
+
+        if (!relocated) reply->relocated_build = 1;
+        else if (relocated->file && !relocated->builder)
+            reply->relocated_file = alloc_handle( current->process, relocated->file, GENERIC_READ, 0 );
+    }
     release_object( mapping );
 }
 
@@ -1689,6 +1771,72 @@ DECL_HANDLER(get_image_map_address)
     release_object( mapping );
 }
 
+/* create the file that the relocated sections of an image mapping are written to */
+DECL_HANDLER(create_relocated_image)
+{
+    struct mapping *mapping;
+    struct shared_map *relocated;
+    struct file_stamp stamp;
+    struct file *file;
+    int unix_fd;
+
+    if (!(mapping = get_mapping_obj( current->process, req->handle, SECTION_MAP_READ ))) return;
+
+    if (!is_relocated_mapping_shareable( mapping ))
+    {
+        set_error( STATUS_INVALID_PARAMETER );
+        goto done;
+    }
+    if ((relocated = get_relocated_mapping( mapping )))
+    {
+        /* take over from a process that died while writing the sections */
+        if (!relocated->builder || !relocated->builder->end_time) goto done;
+    }
+    else
+    {
+        if (!get_file_stamp( mapping->fd, &stamp )) goto done;
+        if ((unix_fd = create_temp_file( mapping->image.map_size )) == -1) goto done;
+        if (!(file = create_file_for_fd( unix_fd, FILE_GENERIC_READ|FILE_GENERIC_WRITE, 0 ))) goto done;
+        if (!(relocated = create_shared_file( mapping->fd, &stamp, file, mapping->image.map_addr )))
+        {
+            release_object( file );
+            goto done;
+        }
+        mapping->relocated = relocated;
+    }
+
+    if (relocated->builder) release_object( relocated->builder );
+    relocated->builder = (struct process *)grab_object( current->process );
+    reply->file = alloc_handle( current->process, relocated->file, GENERIC_READ|GENERIC_WRITE, 0 );
+
+done:
+    release_object( mapping );
+}
+
+/* mark the relocated sections of an image mapping as written */
+DECL_HANDLER(set_relocated_image)
+{
+    struct mapping *mapping;
+    struct shared_map *relocated;
+
+    if (!(mapping = get_mapping_obj( current->process, req->handle, SECTION_MAP_READ ))) return;
+
+    if (!(relocated = mapping->relocated) || relocated->builder != current->process)
+        set_error( STATUS_INVALID_PARAMETER );
+    else
+    {
+        /* remember failures too, so that the image isn't processed again */
+        if (!req->success)
+        {
+            release_object( relocated->file );
+            relocated->file = NULL;
+        }
+        release_object( relocated->builder );
+        relocated->builder = NULL;
+    }
+    release_object( mapping );
+}
+
 /* add a memory view in the current process */
 DECL_HANDLER(map_view)
 {
@@ -1722,6 +1870,7 @@ DECL_HANDLER(map_view)
         view->fd        = !is_fd_removable( mapping->fd ) ? (struct fd *)grab_object( mapping->fd ) : NULL;
         view->committed = mapping->committed ? (struct ranges *)grab_object( mapping->committed ) : NULL;
         view->shared    = NULL;
+        view->relocated = NULL;
         add_process_view( current, view );
     }
 
@@ -1759,6 +1908,7 @@ DECL_HANDLER(map_image_view)
         view->fd        = !is_fd_removable( mapping->fd ) ? (struct fd *)grab_object( mapping->fd ) : NULL;
         view->committed = NULL;
         view->shared    = mapping->shared ? (struct shared_map *)grab_object( mapping->shared ) : NULL;
+        view->relocated = mapping->relocated ? (struct shared_map *)grab_object( mapping->relocated ) : NULL;
         view->image     = mapping->image;
         if (add_process_view( current, view ))
         {
@@ -47,9 +47,19 @@
 struct namespace
 {
     unsigned int        hash_size;       /* size of hash table */
-    struct list         names[1];        /* array of hash entry lists */
+    unsigned int        count;           /* number of names in the namespace */
+    struct list        *names;           /* array of hash entry lists */
+    struct list        *old_names;       /* previous hash table while it is being rehashed */
+    unsigned int        old_size;        /* size of the previous hash table */
+    unsigned int        rehash_pos;      /* next entry of the previous hash table to rehash */
+    unsigned int        resizes;         /* statistics: number of times the hash table was grown */
+    unsigned int        lookups;         /* statistics: number of lookups */
+    unsigned int        probes;          /* statistics: number of names compared in lookups */
 };
 
+#define NAMESPACE_MAX_LOAD     2   /* average chain length that triggers a resize */
+#define NAMESPACE_REHASH_STEP  8   /* number of old hash entries moved on each operation */
+
 
 struct type_descr no_type =
 {
@@ -238,11 +248,83 @@ void *memdup( const void *data, size_t len )
 
 /*****************************************************************/
 
+/* move some names from the previous hash table to the current one */
+static void namespace_rehash( struct namespace *namespace, unsigned int count )
+{
+    struct object_name *ptr, *next;
+    unsigned int hash;
+
+    while (count-- && namespace->rehash_pos < namespace->old_size)
+    {
+        struct list *list = &namespace->old_names[namespace->rehash_pos++];
+
+        LIST_FOR_EACH_ENTRY_SAFE( ptr, next, list, struct object_name, entry )
+        {
+            hash = hash_strW( ptr->name, ptr->len, namespace->hash_size );
+            list_remove( &ptr->entry );
+            list_add_head( &namespace->names[hash], &ptr->entry );
+        }
+    }
+    if (namespace->rehash_pos == namespace->old_size)
+    {
+        free( namespace->old_names );
+        namespace->old_names = NULL;
+        namespace->old_size = 0;
+    }
+}
+
+/* grow the hash table; names are moved to the new one incrementally */
+static void namespace_grow( struct namespace *namespace )
+{
+    unsigned int i, size = namespace->hash_size * 2 + 1;
+    struct list *names;
+
+    if (namespace->old_names) namespace_rehash( namespace, namespace->old_size );  /* finish the previous one */
+    if (!(names = malloc( size * sizeof(*names) ))) return;  /* not fatal, keep the current size */
+    for (i = 0; i < size; i++) list_init( &names[i] );
+
+    namespace->old_names  = namespace->names;
+    namespace->old_size   = namespace->hash_size;
+    namespace->rehash_pos = 0;
+    namespace->names      = names;
+    namespace->hash_size  = size;
+    namespace->resizes++;
+}
+
 void namespace_add( struct namespace *namespace, struct object_name *ptr )
 {
-    unsigned int hash = hash_strW( ptr->name, ptr->len, namespace->hash_size );
+    unsigned int hash;
 
+    if (namespace->old_names) namespace_rehash( namespace, NAMESPACE_REHASH_STEP );
+    else if (namespace->count >= namespace->hash_size * NAMESPACE_MAX_LOAD) namespace_grow( namespace );
+
+    hash = hash_strW( ptr->name, ptr->len, namespace->hash_size );
     list_add_head( &namespace->names[hash], &ptr->entry );
+    ptr->namespace = namespace;
+    namespace->count++;
+}
+
+/* dump the hash table statistics of a namespace */
+void dump_namespace( const struct namespace *namespace )
+{
+    unsigned int i, len, max_len = 0, used = 0;
+
+    for (i = 0; i < namespace->hash_size; i++)
+    {
+        if (!(len = list_count( &namespace->names[i] ))) continue;
+        used++;
+        if (len > max_len) max_len = len;
+    }
+    fprintf( stderr, "  names=%u size=%u used=%u max_chain=%u resizes=%u lookups=%u probes=%u",
+             namespace->count, namespace->hash_size, used, max_len, namespace->resizes,
+             namespace->lookups, namespace->probes );
+    if (namespace->old_names)
+    {
+        for (i = namespace->rehash_pos, len = 0; i < namespace->old_size; i++)
+            len += list_count( &namespace->old_names[i] );
+        fprintf( stderr, " rehashing=%u", len );
+    }
+    fputc( '\n', stderr );
 }
 
 /* allocate a name for an object */
@@ -253,6 +335,7 @@ static struct object_name *alloc_name( const struct unicode_str *name )
     if ((ptr = mem_alloc( sizeof(*ptr) + name->len - sizeof(ptr->name) )))
     {
         ptr->len = name->len;
+        ptr->namespace = NULL;
         ptr->parent = NULL;
         memcpy( ptr->name, name->str, name->len );
     }
@@ -558,47 +641,70 @@ void release_object( void *ptr )
     }
 }
 
-/* find an object by its name; the refcount is incremented */
-struct object *find_object( const struct namespace *namespace, const struct unicode_str *name,
-                            unsigned int attributes )
+/* find a name in a hash list */
+static struct object_name *find_name_in_list( struct namespace *namespace, const struct list *list,
+                                              const struct unicode_str *name, unsigned int attributes )
 {
-    const struct list *list;
-    const struct object_name *ptr;
-
-    if (!name || !name->len) return NULL;
+    struct object_name *ptr;
 
-    list = &namespace->names[ hash_strW( name->str, name->len, namespace->hash_size ) ];
     LIST_FOR_EACH_ENTRY( ptr, list, struct object_name, entry )
     {
+        namespace->probes++;
         if (ptr->len != name->len) continue;
         if (attributes & OBJ_CASE_INSENSITIVE)
         {
-            if (!memicmp_strW( ptr->name, name->str, name->len ))
-                return grab_object( ptr->obj );
+            if (!memicmp_strW( ptr->name, name->str, name->len )) return ptr;
         }
         else
         {
-            if (!memcmp( ptr->name, name->str, name->len ))
-                return grab_object( ptr->obj );
+            if (!memcmp( ptr->name, name->str, name->len )) return ptr;
         }
     }
     return NULL;
 }
 
+/* find an object by its name; the refcount is incremented */
+struct object *find_object( struct namespace *namespace, const struct unicode_str *name,
+                            unsigned int attributes )
+{
+    struct object_name *ptr;
+
+    if (!name || !name->len) return NULL;
+
+    namespace->lookups++;
+    /* names are only moved on insertion, so that lookups don't change the
+     * enumeration order used by find_object_index() */
+    if (namespace->old_names &&
+        (ptr = find_name_in_list( namespace, &namespace->old_names[hash_strW( name->str, name->len, namespace->old_size )],
+                                  name, attributes )))
+        return grab_object( ptr->obj );
+    if ((ptr = find_name_in_list( namespace, &namespace->names[hash_strW( name->str, name->len, namespace->hash_size )],
+                                  name, attributes )))
+        return grab_object( ptr->obj );
+    return NULL;
+}
+
 /* find an object by its index; the refcount is incremented */
 struct object *find_object_index( const struct namespace *namespace, unsigned int index )
 {
+    const struct object_name *ptr;
     unsigned int i;
 
     /* FIXME: not efficient at all */
     for (i = 0; i < namespace->hash_size; i++)
     {
-        const struct object_name *ptr;
         LIST_FOR_EACH_ENTRY( ptr, &namespace->names[i], const struct object_name, entry )
         {
             if (!index--) return grab_object( ptr->obj );
         }
     }
+    for (i = namespace->rehash_pos; i < namespace->old_size; i++)
+    {
+        LIST_FOR_EACH_ENTRY( ptr, &namespace->old_names[i], const struct object_name, entry )
+        {
+            if (!index--) return grab_object( ptr->obj );
+        }
+    }
     return NULL;
 }
 
@@ -608,15 +714,33 @@ struct namespace *create_namespace( unsigned int hash_size )
     struct namespace *namespace;
     unsigned int i;
 
-    namespace = mem_alloc( sizeof(*namespace) + (hash_size - 1) * sizeof(namespace->names[0]) );
-    if (namespace)
+    if (!(namespace = mem_alloc( sizeof(*namespace) ))) return NULL;
+    if (!(namespace->names = mem_alloc( hash_size * sizeof(*namespace->names) )))
     {
-        namespace->hash_size      = hash_size;
-        for (i = 0; i < hash_size; i++) list_init( &namespace->names[i] );
+        free( namespace );
+        return NULL;
     }
+    namespace->hash_size  = hash_size;
+    namespace->count      = 0;
+    namespace->old_names  = NULL;
+    namespace->old_size   = 0;
+    namespace->rehash_pos = 0;
+    namespace->resizes    = 0;
+    namespace->lookups    = 0;
+    namespace->probes     = 0;
+    for (i = 0; i < hash_size; i++) list_init( &namespace->names[i] );
     return namespace;
 }
 
+/* free a namespace, which must not contain any name */
+void free_namespace( struct namespace *namespace )
+{
+    if (!namespace) return;
+    free( namespace->names );
+    free( namespace->old_names );
+    free( namespace );
+}
+
 /* functions for unimplemented/default object operations */
 
 int no_add_queue( struct object *obj, struct wait_queue_entry *entry )
@@ -804,6 +928,7 @@ int no_link_name( struct object *obj, struct object_name *name, struct object *p
 
 void default_unlink_name( struct object *obj, struct object_name *name )
 {
+    if (name->namespace) name->namespace->count--;
     list_remove( &name->entry );
 }
 
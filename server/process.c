@@ -690,6 +690,7 @@ struct process *create_process( int fd, struct process *parent, unsigned int fla
     process->idle_event      = NULL;
     process->peb             = 0;
     process->dir_cache       = NULL;
+    process->request_ring    = NULL;
     process->winstation      = 0;
     process->desktop         = 0;
     process->token           = NULL;
@@ -989,6 +990,8 @@ static void process_killed( struct process *process )
     close_process_handles( process );
     if (process->idle_event) release_object( process->idle_event );
     process->idle_event = NULL;
+    if (process->request_ring) release_object( process->request_ring );
+    process->request_ring = NULL;
     assert( !process->console );
 
     destroy_process_classes( process );
@@ -27,6 +27,7 @@ struct atom_table;
 struct handle_table;
 struct startup_info;
 struct job;
+struct request_ring;
 
 /* process startup state */
 enum startup_state { STARTUP_IN_PROGRESS, STARTUP_DONE, STARTUP_ABORTED };
@@ -80,6 +81,7 @@ struct process
     struct list          views;           /* list of memory views */
     client_ptr_t         peb;             /* PEB address in client address space */
     struct dir_cache    *dir_cache;       /* map of client-side directory cache */
+    struct request_ring *request_ring;    /* shared memory request ring */
     unsigned int         trace_data;      /* opaque data used by the process tracing mechanism */
     struct rawinput_device *rawinput_devices;     /* list of registered rawinput devices */
     unsigned int         rawinput_device_count;   /* number of registered rawinput devices */
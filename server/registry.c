@@ -86,6 +86,9 @@ struct key
     int               last_subkey; /* last in use subkey */
     int               nb_subkeys;  /* count of allocated subkeys */
     struct key      **subkeys;     /* subkeys array */
+    int               unsorted_subkeys; /* number of unsorted subkeys at the end of the array */
+    struct key      **subkey_hash; /* hash table of subkeys for keys with many subkeys */
+    unsigned int      subkey_hash_size; /* size of the hash table (power of 2) */
     struct key       *wow6432node; /* Wow6432Node subkey */
     int               last_value;  /* last in use value */
     int               nb_values;   /* count of allocated values in array */
@@ -116,6 +119,7 @@ struct key_value
 };
 
 #define MIN_SUBKEYS  8   /* min. number of allocated subkeys per key */
+#define SUBKEY_HASH_THRESHOLD 256  /* number of subkeys above which they are indexed by name */
 #define MIN_VALUES   8   /* min. number of allocated values per key */
 
 #define MAX_NAME_LEN  256    /* max. length of a key name */
@@ -161,6 +165,12 @@ struct file_load_info
     int         line;     /* current input line */
     WCHAR      *tmp;      /* temp buffer to use while parsing input */
     size_t      tmplen;   /* length of temp buffer */
+    WCHAR      *path;     /* name of the last loaded key */
+    data_size_t pathlen;  /* allocated length of the name buffer */
+    struct key **path_keys; /* keys along the path of the last loaded key */
+    data_size_t *path_ends; /* end offset of each path element in the name */
+    int         depth;    /* number of valid entries in path_keys */
+    int         max_depth; /* allocated entries in path_keys */
 };
 
 
@@ -235,10 +245,43 @@ static void dump_path( const struct key *key, const struct key *base, FILE *f )
     dump_strW( key->obj.name->name, key->obj.name->len, f, "[]" );
 }
 
+/* dump binary data as a list of hex bytes, wrapping lines after 76 chars */
+static void dump_hex( const unsigned char *data, data_size_t len, int count, FILE *f )
+{
+    static const char hex[16] = "0123456789abcdef";
+    char buffer[1024];
+    char *pos = buffer;
+    data_size_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        if (pos > buffer + sizeof(buffer) - 8)
+        {
+            fwrite( buffer, pos - buffer, 1, f );
+            pos = buffer;
+        }
+        *pos++ = hex[data[i] >> 4];
+        *pos++ = hex[data[i] & 0x0f];
+        count += 2;
+        if (i < len - 1)
+        {
+            *pos++ = ',';
+            if (++count > 76)
+            {
+                memcpy( pos, "\\\n  ", 4 );
+                pos += 4;
+                count = 2;
+            }
+        }
+    }
+    *pos++ = '\n';
+    fwrite( buffer, pos - buffer, 1, f );
+}
+
 /* dump a value to a text file */
 static void dump_value( const struct key_value *value, FILE *f )
 {
-    unsigned int i, dw;
+    unsigned int dw;
     int count;
 
     if (value->namelen)
@@ -273,36 +316,150 @@ static void dump_value( const struct key_value *value, FILE *f )
 
     if (value->type == REG_BINARY) count += fprintf( f, "hex:" );
     else count += fprintf( f, "hex(%x):", value->type );
-    for (i = 0; i < value->len; i++)
+    dump_hex( value->data, value->len, count, f );
+}
+
+/* compare the name of a subkey with a given name */
+static int compare_subkey_name( const struct key *subkey, const struct unicode_str *name )
+{
+    data_size_t len = min( subkey->obj.name->len, name->len );
+    int res = memicmp_strW( subkey->obj.name->name, name->str, len );
+
+    if (!res) res = subkey->obj.name->len - name->len;
+    return res;
+}
+
+static int compare_subkeys( const void *p1, const void *p2 )
+{
+    const struct key *key2 = *(const struct key * const *)p2;
+    struct unicode_str name = { key2->obj.name->name, key2->obj.name->len };
+
+    return compare_subkey_name( *(const struct key * const *)p1, &name );
+}
+
+static inline unsigned int hash_subkey_name( const struct key *key, const WCHAR *str, data_size_t len )
+{
+    return hash_strW( str, len, key->subkey_hash_size );
+}
+
+/* find a subkey in the hash table */
+static struct key *find_hashed_subkey( const struct key *key, const struct unicode_str *name )
+{
+    unsigned int i = hash_subkey_name( key, name->str, name->len );
+    struct key *subkey;
+
+    while ((subkey = key->subkey_hash[i]))
+    {
+        if (subkey->obj.name->len == name->len &&
+            !memicmp_strW( subkey->obj.name->name, name->str, name->len )) return subkey;
+        i = (i + 1) & (key->subkey_hash_size - 1);
+    }
+    return NULL;
+}
+
+/* add a subkey to the hash table, which must have a free entry */
+static void add_hashed_subkey( struct key *key, struct key *subkey )
+{
+    unsigned int i = hash_subkey_name( key, subkey->obj.name->name, subkey->obj.name->len );
+
+    while (key->subkey_hash[i]) i = (i + 1) & (key->subkey_hash_size - 1);
+    key->subkey_hash[i] = subkey;
+}
+
+/* remove a subkey from the hash table, moving back the following entries as needed */
+static void remove_hashed_subkey( struct key *key, struct key *subkey )
+{
+    unsigned int i, j, home, mask = key->subkey_hash_size - 1;
+
+    i = hash_subkey_name( key, subkey->obj.name->name, subkey->obj.name->len );
+    while (key->subkey_hash[i] != subkey) i = (i + 1) & mask;
+    key->subkey_hash[i] = NULL;
+
+    for (j = (i + 1) & mask; key->subkey_hash[j]; j = (j + 1) & mask)
+    {
+        subkey = key->subkey_hash[j];
+        home = hash_subkey_name( key, subkey->obj.name->name, subkey->obj.name->len );
+        /* the entry can stay where it is if its home slot is between the hole and itself */
+        if (i <= j ? (i < home && home <= j) : (i < home || home <= j)) continue;
+        key->subkey_hash[i] = subkey;
+        key->subkey_hash[j] = NULL;
+        i = j;
+    }
+}
+
+/* (re)build the hash table of subkeys with a size suitable for count entries */
+static int build_subkey_hash( struct key *key, int count )
+{
+    unsigned int size = 2 * SUBKEY_HASH_THRESHOLD;
+    struct key **hash;
+    int i;
+
+    while (size < 2 * count) size *= 2;
+    if (!(hash = mem_alloc( size * sizeof(*hash) ))) return 0;
+    memset( hash, 0, size * sizeof(*hash) );
+    free( key->subkey_hash );
+    key->subkey_hash = hash;
+    key->subkey_hash_size = size;
+    for (i = 0; i <= key->last_subkey; i++) add_hashed_subkey( key, key->subkeys[i] );
+    return 1;
+}
+
+/* sort the subkeys that have been appended to the array since the last sort */
+static void sort_subkeys( struct key *key )
+{
+    int sorted = key->last_subkey + 1 - key->unsorted_subkeys;
+    int i, j, k, count = key->unsorted_subkeys;
+    struct key **tail;
+
+    if (!count) return;
+    /* subkeys are appended in order when loading or populating a key, make it cheap */
+    for (i = sorted; i < key->last_subkey; i++)
+        if (compare_subkeys( &key->subkeys[i], &key->subkeys[i + 1] ) > 0) break;
+    if (i < key->last_subkey) qsort( key->subkeys + sorted, count, sizeof(*tail), compare_subkeys );
+
+    if (sorted && compare_subkeys( &key->subkeys[sorted - 1], &key->subkeys[sorted] ) > 0)
     {
-        count += fprintf( f, "%02x", *((unsigned char *)value->data + i) );
-        if (i < value->len-1)
+        /* merge from the end, so that only the sorted tail needs to be copied out */
+        if (!(tail = malloc( count * sizeof(*tail) )))
         {
-            fputc( ',', f );
-            if (++count > 76)
-            {
-                fprintf( f, "\\\n  " );
-                count = 2;
-            }
+            qsort( key->subkeys, key->last_subkey + 1, sizeof(*tail), compare_subkeys );
+            key->unsorted_subkeys = 0;
+            return;
         }
+        memcpy( tail, key->subkeys + sorted, count * sizeof(*tail) );
+        i = sorted - 1;
+        j = count - 1;
+        for (k = key->last_subkey; j >= 0; k--)
+        {
+            if (i >= 0 && compare_subkeys( &key->subkeys[i], &tail[j] ) > 0)
+                key->subkeys[k] = key->subkeys[i--];
+            else
+                key->subkeys[k] = tail[j--];
+        }
+        free( tail );
     }
-    fputc( '\n', f );
+    key->unsorted_subkeys = 0;
 }
 
 /* find the named child of a given key and return its index */
+/* if the subkeys are hashed, the index is only meaningful if the subkey is not found,
+ * and it is then the end of the array where new subkeys are appended */
 static struct key *find_subkey( const struct key *key, const struct unicode_str *name, int *index )
 {
     int i, min, max, res;
-    data_size_t len;
+
+    if (key->subkey_hash)
+    {
+        *index = key->last_subkey + 1;
+        return find_hashed_subkey( key, name );
+    }
 
     min = 0;
     max = key->last_subkey;
     while (min <= max)
     {
         i = (min + max) / 2;
-        len = min( key->subkeys[i]->obj.name->len, name->len );
-        res = memicmp_strW( key->subkeys[i]->obj.name->name, name->str, len );
-        if (!res) res = key->subkeys[i]->obj.name->len - name->len;
+        res = compare_subkey_name( key->subkeys[i], name );
         if (!res)
         {
             *index = i;
@@ -341,11 +498,12 @@ static int grow_subkeys( struct key *key )
 }
 
 /* save a registry and all its subkeys to a text file */
-static void save_subkeys( const struct key *key, const struct key *base, FILE *f )
+static void save_subkeys( struct key *key, const struct key *base, FILE *f )
 {
     int i;
 
     if (key->flags & KEY_VOLATILE) return;
+    sort_subkeys( key );
     /* save key if it has either some values or no subkeys, or needs special options */
     /* keys with no values but subkeys are saved implicitly by saving the subkeys */
     if ((key->last_value >= 0) || (key->last_subkey == -1) || key->class || (key->flags & KEY_SYMLINK))
@@ -601,6 +759,11 @@ static int key_link_name( struct object *obj, struct object_name *name, struct o
         /* need to grow the array */
         if (!grow_subkeys( parent_key )) return 0;
     }
+    if (parent_key->subkey_hash && 2 * (parent_key->last_subkey + 2) > parent_key->subkey_hash_size)
+    {
+        /* need to grow the hash table */
+        if (!build_subkey_hash( parent_key, parent_key->last_subkey + 2 )) return 0;
+    }
     tmp.str = name->name;
     tmp.len = name->len;
     find_subkey( parent_key, &tmp, &index );
@@ -608,6 +771,14 @@ static int key_link_name( struct object *obj, struct object_name *name, struct o
     for (i = ++parent_key->last_subkey; i > index; i--)
         parent_key->subkeys[i] = parent_key->subkeys[i - 1];
     parent_key->subkeys[index] = (struct key *)grab_object( key );
+    if (parent_key->subkey_hash)
+    {
+        /* the new subkey has been appended, it will be sorted when needed */
+        parent_key->unsorted_subkeys++;
+        add_hashed_subkey( parent_key, key );
+    }
+    else if (parent_key->last_subkey >= SUBKEY_HASH_THRESHOLD)
+        build_subkey_hash( parent_key, parent_key->last_subkey + 1 );  /* failure is not fatal */
     if (is_wow6432node( name->name, name->len ) &&
         !is_wow6432node( parent_key->obj.name->name, parent_key->obj.name->len ))
         parent_key->wow6432node = key;
@@ -631,12 +802,25 @@ static void key_unlink_name( struct object *obj, struct object_name *name )
 
     for (i = 0; i <= parent->last_subkey; i++) if (parent->subkeys[i] == key) break;
     assert( i <= parent->last_subkey );
+    if (i > parent->last_subkey - parent->unsorted_subkeys) parent->unsorted_subkeys--;
+    if (parent->subkey_hash) remove_hashed_subkey( parent, key );
     for ( ; i < parent->last_subkey; i++) parent->subkeys[i] = parent->subkeys[i + 1];
     parent->last_subkey--;
     name->parent = NULL;
     if (parent->wow6432node == key) parent->wow6432node = NULL;
     release_object( key );
 
+    if (parent->subkey_hash && parent->last_subkey < SUBKEY_HASH_THRESHOLD / 2)
+    {
+        /* few enough subkeys left for a binary search */
+        sort_subkeys( parent );
+        free( parent->subkey_hash );
+        parent->subkey_hash = NULL;
+        parent->subkey_hash_size = 0;
+    }
+    else if (parent->subkey_hash && 8 * (parent->last_subkey + 1) < parent->subkey_hash_size)
+        build_subkey_hash( parent, parent->last_subkey + 1 );  /* shrink the hash table */
+
     /* try to shrink the array */
     nb_subkeys = parent->nb_subkeys;
     if (nb_subkeys > MIN_SUBKEYS && parent->last_subkey < nb_subkeys / 2)
@@ -650,12 +834,28 @@ static void key_unlink_name( struct object *obj, struct object_name *name )
     }
 }
 
+/* index of the session serial used to validate client caches of the key values */
+static unsigned int get_key_serial_slot( const struct key *key )
+{
+    return ((unsigned long)key / 64) % REGISTRY_SERIAL_COUNT;
+}
+
+/* invalidate the values of a key cached by the clients */
+static void invalidate_key_values( const struct key *key )
+{
+    unsigned int slot = get_key_serial_slot( key );
+
+    if (shared_session) shared_session->registry_serials[slot]++;
+}
+
 /* close the notification associated with a handle */
 static int key_close_handle( struct object *obj, struct process *process, obj_handle_t handle )
 {
     struct key * key = (struct key *) obj;
     struct notify *notify = find_notify( key, process, handle );
     if (notify) do_notification( key, notify, 1 );
+    /* clients cache values by handle, make sure a reused handle value can't match */
+    invalidate_key_values( key );
     return 1;  /* ok to close */
 }
 
@@ -679,6 +879,7 @@ static void key_destroy( struct object *obj )
         release_object( key->subkeys[i] );
     }
     free( key->subkeys );
+    free( key->subkey_hash );
     /* unconditionally notify everything waiting on this key */
     while ((ptr = list_head( &key->notify_list )))
     {
@@ -707,6 +908,9 @@ static struct key *create_key_object( struct object *parent, const struct unicod
             key->last_subkey = -1;
             key->nb_subkeys  = 0;
             key->subkeys     = NULL;
+            key->unsorted_subkeys = 0;
+            key->subkey_hash = NULL;
+            key->subkey_hash_size = 0;
             key->wow6432node = NULL;
             key->nb_values   = 0;
             key->last_value  = -1;
@@ -768,6 +972,7 @@ static void check_notify( struct key *key, unsigned int change, int not_subtree
 static void touch_key( struct key *key, unsigned int change )
 {
     key->modif = current_time;
+    invalidate_key_values( key );
     make_dirty( key );
 
     /* do notifications */
@@ -927,6 +1132,7 @@ static void enum_key( struct key *key, int index, int info_class, struct enum_ke
             set_error( STATUS_NO_MORE_ENTRIES );
             return;
         }
+        sort_subkeys( key );
         key = key->subkeys[index];
     }
 
@@ -1034,6 +1240,7 @@ static void rename_key( struct key *key, const struct unicode_str *new_name )
         return;
 
     new_name_ptr->obj = &key->obj;
+    new_name_ptr->namespace = NULL;
     new_name_ptr->len = new_name->len;
     new_name_ptr->parent = &parent->obj;
     memcpy( new_name_ptr->name, new_name->str, new_name->len );
@@ -1041,6 +1248,13 @@ static void rename_key( struct key *key, const struct unicode_str *new_name )
     for (cur_index = 0; cur_index <= parent->last_subkey; cur_index++)
         if (parent->subkeys[cur_index] == key) break;
 
+    if (parent->subkey_hash)
+    {
+        /* the key is moved to the unsorted end of the array */
+        if (cur_index <= parent->last_subkey - parent->unsorted_subkeys) parent->unsorted_subkeys++;
+        remove_hashed_subkey( parent, key );
+    }
+
     if (cur_index < index)
     {
         --index;
@@ -1054,6 +1268,7 @@ static void rename_key( struct key *key, const struct unicode_str *new_name )
 
     free( key->obj.name );
     key->obj.name = new_name_ptr;
+    if (parent->subkey_hash) add_hashed_subkey( parent, key );
 
     if (debug_level > 1) dump_operation( key, NULL, "Rename" );
     touch_key( key, REG_NOTIFY_CHANGE_NAME );
@@ -1090,6 +1305,7 @@ static int delete_key( struct key *key, int recurse )
 
     if (debug_level > 1) dump_operation( key, NULL, "Delete" );
     key->flags |= KEY_DELETED;
+    invalidate_key_values( key );
     unlink_named_object( &key->obj );
     touch_key( parent, REG_NOTIFY_CHANGE_NAME );
     return 1;
@@ -1450,6 +1666,85 @@ static int get_data_type( const char *buffer, int *type, int *parse_type )
     return 0;
 }
 
+/* remember a key along the path of the key being loaded */
+static int add_load_path_key( struct file_load_info *info, struct key *key, data_size_t end )
+{
+    if (info->depth == info->max_depth)
+    {
+        int max_depth = max( 16, info->max_depth * 2 );
+        struct key **keys;
+        data_size_t *ends;
+
+        if (!(keys = realloc( info->path_keys, max_depth * sizeof(*keys) ))) return 0;
+        info->path_keys = keys;
+        if (!(ends = realloc( info->path_ends, max_depth * sizeof(*ends) ))) return 0;
+        info->path_ends = ends;
+        info->max_depth = max_depth;
+    }
+    info->path_keys[info->depth] = key;
+    info->path_ends[info->depth] = end;
+    info->depth++;
+    return 1;
+}
+
+/* create a key while loading; this is equivalent to create_key_recursive(), but the
+ * path elements shared with the previously loaded key don't need to be looked up again,
+ * which matters since the keys in the file are sorted */
+static struct key *load_key_path( struct key *base, const struct unicode_str *name,
+                                  struct file_load_info *info )
+{
+    struct key *key, *parent;
+    struct unicode_str tmp;
+    data_size_t start = 0, end, len;
+    int depth, record = 1;
+    WCHAR *path;
+
+    for (depth = 0; depth < info->depth; depth++)
+    {
+        end = info->path_ends[depth];
+        if (end > name->len) break;
+        if (end < name->len && name->str[end / sizeof(WCHAR)] != '\\') break;
+        if (memcmp( name->str + start / sizeof(WCHAR), info->path + start / sizeof(WCHAR), end - start )) break;
+        start = end + sizeof(WCHAR);
+    }
+    info->depth = depth;
+    parent = (struct key *)grab_object( depth ? info->path_keys[depth - 1] : base );
+    if (start >= name->len) return parent;
+
+    if (name->len > info->pathlen)
+    {
+        if (!(path = realloc( info->path, name->len ))) record = 0;
+        else
+        {
+            info->path = path;
+            info->pathlen = name->len;
+        }
+    }
+    if (record) memcpy( info->path, name->str, name->len );
+
+    len = name->len - start;
+    while (len)
+    {
+        tmp.str = name->str + start / sizeof(WCHAR);
+        tmp.len = get_path_element( tmp.str, len );
+        key = create_key_object( &parent->obj, &tmp, OBJ_OPENIF, 0, 0, NULL );
+        release_object( parent );
+        if (!key) return NULL;
+        parent = key;
+        if (record) record = add_load_path_key( info, key, start + tmp.len );
+
+        /* skip trailing \\ and move to the next element */
+        if (tmp.len < len)
+        {
+            tmp.len += sizeof(WCHAR);
+            start += tmp.len;
+            len -= tmp.len;
+        }
+        else break;
+    }
+    return parent;
+}
+
 /* load and create a key from the input file */
 static struct key *load_key( struct key *base, const char *buffer, int prefix_len,
                              struct file_load_info *info, timeout_t *modif )
@@ -1488,7 +1783,7 @@ static struct key *load_key( struct key *base, const char *buffer, int prefix_le
     }
     name.str = p;
     name.len = len - (p - info->tmp + 1) * sizeof(WCHAR);
-    return create_key_recursive( base, &name, 0 );
+    return load_key_path( base, &name, info );
 }
 
 /* update the modification time of a key (and its parents) after it has been loaded from a file */
@@ -1559,11 +1854,21 @@ static int load_key_option( struct key *key, const char *buffer, struct file_loa
         if (!(key->class = memdup( info->tmp, len ))) len = 0;
         key->classlen = len;
     }
-    if (!strncmp( buffer, "#link", 5 )) key->flags |= KEY_SYMLINK;
+    if (!strncmp( buffer, "#link", 5 ))
+    {
+        key->flags |= KEY_SYMLINK;
+        info->depth = 0;  /* lookups may now have to follow the link */
+    }
     /* ignore unknown options */
     return 1;
 }
 
+static inline unsigned int hex_digit( char c )
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    return (c | 0x20) - 'a' + 10;
+}
+
 /* parse a comma-separated list of hex digits */
 static int parse_hex( unsigned char *dest, data_size_t *len, const char *buffer )
 {
@@ -1573,8 +1878,15 @@ static int parse_hex( unsigned char *dest, data_size_t *len, const char *buffer
 
     while (isxdigit(*p))
     {
-        unsigned int val = strtoul( p, &end, 16 );
-        if (end == p || val > 0xff) return -1;
+        unsigned int val;
+
+        /* fast path for the two-digit format that we write ourselves */
+        if (isxdigit(p[1]) && !isxdigit(p[2]))
+        {
+            val = (hex_digit( p[0] ) << 4) | hex_digit( p[1] );
+            end = (char *)p + 2;
+        }
+        else if ((val = strtoul( p, &end, 16 )) > 0xff || end == p) return -1;
         if (count++ >= *len) return -1;  /* dest buffer overflow */
         *dest++ = val;
         p = end;
@@ -1631,6 +1943,7 @@ static int load_value( struct key *key, const char *buffer, struct file_load_inf
     struct key_value *value;
 
     if (!(value = parse_value_name( key, buffer, &len, info ))) return 0;
+    invalidate_key_values( key );
     if (!(res = get_data_type( buffer + len, &type, &parse_type ))) goto error;
     buffer += len + res;
 
@@ -1730,6 +2043,12 @@ static void load_keys( struct key *key, const char *filename, FILE *f, int prefi
     info.len    = 4;
     info.tmplen = 4;
     info.line   = 0;
+    info.path   = NULL;
+    info.pathlen = 0;
+    info.path_keys = NULL;
+    info.path_ends = NULL;
+    info.depth  = 0;
+    info.max_depth = 0;
     if (!(info.buffer = mem_alloc( info.len ))) return;
     if (!(info.tmp = mem_alloc( info.tmplen )))
     {
@@ -1786,6 +2105,9 @@ static void load_keys( struct key *key, const char *filename, FILE *f, int prefi
     }
     free( info.buffer );
     free( info.tmp );
+    free( info.path );
+    free( info.path_keys );
+    free( info.path_ends );
 }
 
 /* load a part of the registry from a file */
@@ -2301,6 +2623,8 @@ DECL_HANDLER(get_key_value)
     reply->total = 0;
     if ((key = get_hkey_obj( req->hkey, KEY_QUERY_VALUE )))
     {
+        reply->serial_slot = get_key_serial_slot( key );
+        reply->serial = shared_session ? shared_session->registry_serials[reply->serial_slot] : 0;
         get_value( key, &name, &reply->type, &reply->total );
         release_object( key );
     }
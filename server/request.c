@@ -47,6 +47,13 @@
 #ifdef __APPLE__
 # include <mach/mach_time.h>
 #endif
+#if defined(__linux__) && defined(HAVE_SYS_EVENTFD_H)
+# include <sys/eventfd.h>
+# include <sys/mman.h>
+# include <sys/syscall.h>
+# include <linux/futex.h>
+# define USE_REQUEST_RING
+#endif
 
 #include "ntstatus.h"
 #include "windef.h"
@@ -70,6 +77,9 @@
 static const char * const server_socket_name = "socket";   /* name of the socket file */
 static const char * const server_lock_name = "lock";       /* name of the server lock file */
 
+#define INITIAL_REQ_BUFFER_SIZE  1024   /* initial size of the per-thread request data buffer */
+#define MAX_KEPT_REQ_BUFFER_SIZE 65536  /* larger request buffers are freed after use */
+
 struct master_socket
 {
     struct object        obj;        /* object header */
@@ -127,6 +137,60 @@ int config_dir_fd = -1;    /* file descriptor for the config dir */
 static struct master_socket *master_socket;  /* the master socket object */
 static struct timeout_user *master_timeout;
 
+#ifdef USE_REQUEST_RING
+
+#define MAX_RING_PASSES 4  /* max passes over the posted slots before going back to the main loop */
+
+struct request_ring
+{
+    struct object        obj;        /* object header */
+    struct fd           *fd;         /* doorbell eventfd */
+    request_ring_shm_t  *shm;        /* shared memory of the ring */
+    struct thread       *threads[REQUEST_RING_SLOTS];  /* thread using each slot */
+};
+
+static void request_ring_dump( struct object *obj, int verbose );
+static void request_ring_destroy( struct object *obj );
+static void request_ring_poll_event( struct fd *fd, int event );
+
+static const struct object_ops request_ring_ops =
+{
+    sizeof(struct request_ring),   /* size */
+    &no_type,                      /* type */
+    request_ring_dump,             /* dump */
+    no_add_queue,                  /* add_queue */
+    NULL,                          /* remove_queue */
+    NULL,                          /* signaled */
+    NULL,                          /* satisfied */
+    no_signal,                     /* signal */
+    no_get_fd,                     /* get_fd */
+    default_get_sync,              /* get_sync */
+    default_map_access,            /* map_access */
+    default_get_sd,                /* get_sd */
+    default_set_sd,                /* set_sd */
+    no_get_full_name,              /* get_full_name */
+    no_lookup_name,                /* lookup_name */
+    no_link_name,                  /* link_name */
+    NULL,                          /* unlink_name */
+    no_open_file,                  /* open_file */
+    no_kernel_obj_list,            /* get_kernel_obj_list */
+    no_close_handle,               /* close_handle */
+    request_ring_destroy           /* destroy */
+};
+
+static const struct fd_ops request_ring_fd_ops =
+{
+    NULL,                          /* get_poll_events */
+    request_ring_poll_event,       /* poll_event */
+    NULL,                          /* flush */
+    NULL,                          /* get_fd_type */
+    NULL,                          /* ioctl */
+    NULL,                          /* queue_async */
+    NULL                           /* reselect_async */
+};
+
+#endif  /* USE_REQUEST_RING */
+
 /* complain about a protocol error and terminate the client connection */
 void fatal_protocol_error( struct thread *thread, const char *err, ... )
 {
@@ -287,8 +351,29 @@ static void send_reply( union generic_reply *reply )
         fatal_protocol_error( current, "reply write: %s\n", strerror( errno ));
 }
 
-/* call a request handler */
-static void call_req_handler( struct thread *thread )
+#ifdef USE_REQUEST_RING
+/* write the reply to the request slot of the current thread and wake it up */
+static void send_slot_reply( request_slot_shm_t *slot, union generic_reply *reply )
+{
+    memcpy( (char *)slot->data, reply, sizeof(*reply) );
+    if (current->reply_size)
+        memcpy( (char *)slot->data + sizeof(*reply), current->reply_data, current->reply_size );
+    slot->size = sizeof(*reply) + current->reply_size;
+    free( current->reply_data );
+    current->reply_data = NULL;
+
+    __atomic_store_n( &slot->state, REQUEST_SLOT_REPLIED, __ATOMIC_SEQ_CST );
+    syscall( __NR_futex, &slot->state, FUTEX_WAKE, 1, NULL, 0, 0 );
+}
+#else
+static void send_slot_reply( request_slot_shm_t *slot, union generic_reply *reply )
+{
+    assert( 0 );
+}
+#endif
+
+/* call a request handler, sending the reply to the slot if not NULL, or to the reply pipe */
+static void call_req_handler( struct thread *thread, request_slot_shm_t *slot )
 {
     union generic_reply reply;
     enum request req = thread->req.request_header.req;
@@ -312,7 +397,8 @@ static void call_req_handler( struct thread *thread )
             reply.reply_header.error = current->error;
             reply.reply_header.reply_size = current->reply_size;
             if (debug_level) trace_reply( req, &reply );
-            send_reply( &reply );
+            if (slot) send_slot_reply( slot, &reply );
+            else send_reply( &reply );
         }
         else
         {
@@ -323,30 +409,73 @@ static void call_req_handler( struct thread *thread )
     current = NULL;
 }
 
+/* make sure the request buffer can hold the variable-size data of the current request */
+static int grow_request_buffer( struct thread *thread, data_size_t size )
+{
+    void *buffer;
+    data_size_t new_size = max( size, INITIAL_REQ_BUFFER_SIZE );
+
+    if (!(buffer = realloc( thread->req_buffer, new_size ))) return 0;
+    thread->req_buffer = buffer;
+    thread->req_buffer_size = new_size;
+    return 1;
+}
+
+/* release the request data once the handler is done with it */
+static void release_request_data( struct thread *thread )
+{
+    thread->req_data = NULL;
+    if (thread->req_buffer_size <= MAX_KEPT_REQ_BUFFER_SIZE) return;
+    /* don't keep huge buffers around for the lifetime of the thread */
+    free( thread->req_buffer );
+    thread->req_buffer = NULL;
+    thread->req_buffer_size = 0;
+}
+
 /* read a request from a thread */
 void read_request( struct thread *thread )
 {
+    data_size_t size;
     int ret;
 
     if (!thread->req_toread)  /* no pending request */
     {
-        if ((ret = read( get_unix_fd( thread->request_fd ), &thread->req,
-                         sizeof(thread->req) )) != sizeof(thread->req)) goto error;
-        if (!(thread->req_toread = thread->req.request_header.request_size))
+        struct iovec vec[2];
+
+        /* the client waits for the reply before sending anything else, so we can read
+         * the variable-size data together with the fixed part if it fits in the buffer */
+        vec[0].iov_base = &thread->req;
+        vec[0].iov_len  = sizeof(thread->req);
+        vec[1].iov_base = thread->req_buffer;
+        vec[1].iov_len  = thread->req_buffer_size;
+
+        if ((ret = readv( get_unix_fd( thread->request_fd ), vec, thread->req_buffer ? 2 : 1 )) <
+            (int)sizeof(thread->req)) goto error;
+        ret -= sizeof(thread->req);
+        if (!(size = thread->req.request_header.request_size))
         {
             /* no data, handle request at once */
-            call_req_handler( thread );
+            if (ret) goto error;
+            call_req_handler( thread, NULL );
             return;
         }
-        if (!(thread->req_data = malloc( thread->req_toread )))
+        if (ret > size) goto error;
+        if (size > thread->req_buffer_size && !grow_request_buffer( thread, size ))
         {
             fatal_protocol_error( thread, "no memory for %u bytes request %d\n",
-                                  thread->req_toread, thread->req.request_header.req );
+                                  size, thread->req.request_header.req );
+            return;
+        }
+        thread->req_data = thread->req_buffer;
+        if (!(thread->req_toread = size - ret))
+        {
+            call_req_handler( thread, NULL );
+            release_request_data( thread );
             return;
         }
     }
 
-    /* read the variable sized data */
+    /* read the rest of the variable sized data */
     for (;;)
     {
         ret = read( get_unix_fd( thread->request_fd ),
@@ -356,9 +485,8 @@ void read_request( struct thread *thread )
         if (ret <= 0) break;
         if (!(thread->req_toread -= ret))
         {
-            call_req_handler( thread );
-            free( thread->req_data );
-            thread->req_data = NULL;
+            call_req_handler( thread, NULL );
+            release_request_data( thread );
             return;
         }
     }
@@ -372,6 +500,109 @@ error:
         fatal_protocol_error( thread, "read: %s\n", strerror( errno ));
 }
 
+#ifdef USE_REQUEST_RING
+
+static void request_ring_dump( struct object *obj, int verbose )
+{
+    struct request_ring *ring = (struct request_ring *)obj;
+    assert( obj->ops == &request_ring_ops );
+    fprintf( stderr, "Request ring fd=%p shm=%p\n", ring->fd, ring->shm );
+}
+
+static void request_ring_destroy( struct object *obj )
+{
+    struct request_ring *ring = (struct request_ring *)obj;
+    unsigned int i;
+
+    assert( obj->ops == &request_ring_ops );
+    for (i = 0; i < REQUEST_RING_SLOTS; i++)
+        if (ring->threads[i]) ring->threads[i]->request_slot = -1;
+    if (ring->fd) release_object( ring->fd );
+    if (ring->shm) munmap( (void *)ring->shm, sizeof(*ring->shm) );
+}
+
+/* handle a request posted in a ring slot */
+static void read_slot_request( struct request_ring *ring, unsigned int index )
+{
+    struct thread *thread = ring->threads[index];
+    request_slot_shm_t *slot = &ring->shm->slots[index];
+    data_size_t size, reply_size;
+
+    if (!thread) return;
+    if (__atomic_load_n( &slot->state, __ATOMIC_ACQUIRE ) != REQUEST_SLOT_POSTED) return;
+
+    /* the client can't be trusted to leave the slot alone, so copy the request out of it */
+    size = slot->size;
+    memcpy( &thread->req, (char *)slot->data, sizeof(thread->req) );
+    reply_size = thread->req.request_header.reply_size;
+
+    /* variable-size request data is always sent through the pipe */
+    if (size != sizeof(thread->req) || thread->req.request_header.request_size ||
+        reply_size > sizeof(slot->data) - sizeof(union generic_reply))
+    {
+        fatal_protocol_error( thread, "bad request slot size %u/%u\n", size, reply_size );
+        return;
+    }
+    call_req_handler( thread, slot );
+}
+
+/* handle posted requests when the ring doorbell is rung */
+static void request_ring_poll_event( struct fd *fd, int event )
+{
+    struct request_ring *ring = get_fd_user( fd );
+    unsigned int pass, index;
+    ULONG64 count, posted;
+
+    assert( ring->obj.ops == &request_ring_ops );
+
+    if (event & (POLLERR | POLLHUP))
+    {
+        set_fd_events( ring->fd, -1 );
+        return;
+    }
+    read( get_unix_fd( ring->fd ), &count, sizeof(count) );
+
+    /* several requests may have been posted for a single wakeup, handle them all */
+    grab_object( ring );
+    for (pass = 0; pass < MAX_RING_PASSES; pass++)
+    {
+        if (!ring->shm || !(posted = __atomic_exchange_n( &ring->shm->posted, 0, __ATOMIC_SEQ_CST ))) break;
+        for (index = 0; posted; index++, posted >>= 1)
+            if (posted & 1) read_slot_request( ring, index );
+    }
+    /* give the other fds a chance, the doorbell won't be rung again while slots are posted */
+    if (pass == MAX_RING_PASSES)
+    {
+        count = 1;
+        write( get_unix_fd( ring->fd ), &count, sizeof(count) );
+    }
+    release_object( ring );
+}
+
+/* stop using the request slot of a thread, waking it up if it is waiting on it */
+void release_request_slot( struct thread *thread )
+{
+    struct request_ring *ring = thread->process->request_ring;
+    request_slot_shm_t *slot;
+
+    if (thread->request_slot == -1) return;
+    assert( ring && ring->threads[thread->request_slot] == thread );
+    ring->threads[thread->request_slot] = NULL;
+    slot = &ring->shm->slots[thread->request_slot];
+    thread->request_slot = -1;
+
+    __atomic_store_n( &slot->state, REQUEST_SLOT_CLOSED, __ATOMIC_SEQ_CST );
+    syscall( __NR_futex, &slot->state, FUTEX_WAKE, 1, NULL, 0, 0 );
+}
+
+#else  /* USE_REQUEST_RING */
+
+void release_request_slot( struct thread *thread )
+{
+}
+
+#endif  /* USE_REQUEST_RING */
+
 /* receive a file descriptor on the process socket */
 int receive_fd( struct process *process )
 {
@@ -927,3 +1158,88 @@ void close_master_socket( timeout_t timeout )
 
     master_timeout = add_timeout_user( timeout, close_socket_timeout, NULL );
 }
+
+/* create the shared memory request ring of the current process */
+DECL_HANDLER(init_request_ring)
+{
+#ifdef USE_REQUEST_RING
+    struct process *process = current->process;
+    struct request_ring *ring;
+    void *ptr;
+    int shm_fd, doorbell_fd;
+
+    if (process->request_ring)
+    {
+        set_error( STATUS_INVALID_PARAMETER );
+        return;
+    }
+    if (!(ring = alloc_object( &request_ring_ops ))) return;
+    ring->fd  = NULL;
+    ring->shm = NULL;
+    memset( ring->threads, 0, sizeof(ring->threads) );
+
+    if ((shm_fd = create_temp_file( sizeof(*ring->shm) )) == -1)
+    {
+        file_set_error();
+        goto done;
+    }
+    if ((ptr = mmap( NULL, sizeof(*ring->shm), PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0 )) == MAP_FAILED)
+    {
+        file_set_error();
+        close( shm_fd );
+        goto done;
+    }
+    ring->shm = ptr;
+
+    if ((doorbell_fd = eventfd( 0, EFD_CLOEXEC | EFD_NONBLOCK )) == -1)
+    {
+        file_set_error();
+        close( shm_fd );
+        goto done;
+    }
+    if (!(ring->fd = create_anonymous_fd( &request_ring_fd_ops, doorbell_fd, &ring->obj, 0 )))
+    {
+        close( shm_fd );
+        goto done;
+    }
+
+    reply->ring     = get_process_id( process ) | 1;
+    reply->doorbell = get_process_id( process ) | 2;
+    send_client_fd( process, shm_fd, reply->ring );
+    send_client_fd( process, get_unix_fd( ring->fd ), reply->doorbell );
+    close( shm_fd );
+
+    set_fd_events( ring->fd, POLLIN );
+    process->request_ring = (struct request_ring *)grab_object( ring );
+done:
+    release_object( ring );
+#else
+    set_error( STATUS_NOT_SUPPORTED );
+#endif
+}
+
+/* set the request ring slot used by the current thread */
+DECL_HANDLER(set_request_slot)
+{
+#ifdef USE_REQUEST_RING
+    struct request_ring *ring = current->process->request_ring;
+    struct thread *thread;
+
+    if (!ring || req->slot < -1 || req->slot >= REQUEST_RING_SLOTS)
+    {
+        set_error( STATUS_INVALID_PARAMETER );
+        return;
+    }
+    if (current->request_slot != -1) ring->threads[current->request_slot] = NULL;
+    current->request_slot = -1;
+    if (req->slot == -1) return;
+
+    /* the slot may still belong to a thread that exited but hasn't been cleaned up yet */
+    if ((thread = ring->threads[req->slot])) thread->request_slot = -1;
+    ring->threads[req->slot] = current;
+    current->request_slot = req->slot;
+    ring->shm->slots[req->slot].state = REQUEST_SLOT_IDLE;
+#else
+    set_error( STATUS_NOT_SUPPORTED );
+#endif
+}
@@ -14,6 +14,8 @@ DECL_HANDLER(get_startup_info);
 DECL_HANDLER(init_process_done);
 DECL_HANDLER(init_first_thread);
 DECL_HANDLER(init_thread);
+DECL_HANDLER(init_request_ring);
+DECL_HANDLER(set_request_slot);
 DECL_HANDLER(terminate_process);
 DECL_HANDLER(terminate_thread);
 DECL_HANDLER(get_process_info);
@@ -74,6 +76,8 @@ DECL_HANDLER(create_mapping);
 DECL_HANDLER(open_mapping);
 DECL_HANDLER(get_mapping_info);
 DECL_HANDLER(get_image_map_address);
+DECL_HANDLER(create_relocated_image);
+DECL_HANDLER(set_relocated_image);
 DECL_HANDLER(map_view);
 DECL_HANDLER(map_image_view);
 DECL_HANDLER(map_builtin_view);
@@ -276,6 +280,9 @@ DECL_HANDLER(add_completion);
 DECL_HANDLER(remove_completion);
 DECL_HANDLER(get_thread_completion);
 DECL_HANDLER(query_completion);
+DECL_HANDLER(create_wait_completion_packet);
+DECL_HANDLER(associate_wait_completion_packet);
+DECL_HANDLER(cancel_wait_completion_packet);
 DECL_HANDLER(set_completion_info);
 DECL_HANDLER(add_fd_completion);
 DECL_HANDLER(set_fd_completion_mode);
@@ -324,6 +331,8 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_init_process_done,
     (req_handler)req_init_first_thread,
     (req_handler)req_init_thread,
+    (req_handler)req_init_request_ring,
+    (req_handler)req_set_request_slot,
     (req_handler)req_terminate_process,
     (req_handler)req_terminate_thread,
     (req_handler)req_get_process_info,
@@ -384,6 +393,8 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_open_mapping,
     (req_handler)req_get_mapping_info,
     (req_handler)req_get_image_map_address,
+    (req_handler)req_create_relocated_image,
+    (req_handler)req_set_relocated_image,
     (req_handler)req_map_view,
     (req_handler)req_map_image_view,
     (req_handler)req_map_builtin_view,
@@ -586,6 +597,9 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_remove_completion,
     (req_handler)req_get_thread_completion,
     (req_handler)req_query_completion,
+    (req_handler)req_create_wait_completion_packet,
+    (req_handler)req_associate_wait_completion_packet,
+    (req_handler)req_cancel_wait_completion_packet,
     (req_handler)req_set_completion_info,
     (req_handler)req_add_fd_completion,
     (req_handler)req_set_fd_completion_mode,
@@ -736,6 +750,12 @@ C_ASSERT( offsetof(struct init_thread_request, entry) == 32 );
 C_ASSERT( sizeof(struct init_thread_request) == 40 );
 C_ASSERT( offsetof(struct init_thread_reply, suspend) == 8 );
 C_ASSERT( sizeof(struct init_thread_reply) == 16 );
+C_ASSERT( sizeof(struct init_request_ring_request) == 16 );
+C_ASSERT( offsetof(struct init_request_ring_reply, ring) == 8 );
+C_ASSERT( offsetof(struct init_request_ring_reply, doorbell) == 12 );
+C_ASSERT( sizeof(struct init_request_ring_reply) == 16 );
+C_ASSERT( offsetof(struct set_request_slot_request, slot) == 12 );
+C_ASSERT( sizeof(struct set_request_slot_request) == 16 );
 C_ASSERT( offsetof(struct terminate_process_request, handle) == 12 );
 C_ASSERT( offsetof(struct terminate_process_request, exit_code) == 16 );
 C_ASSERT( sizeof(struct terminate_process_request) == 24 );
@@ -966,9 +986,13 @@ C_ASSERT( offsetof(struct create_file_request, sharing) == 16 );
 C_ASSERT( offsetof(struct create_file_request, create) == 20 );
 C_ASSERT( offsetof(struct create_file_request, options) == 24 );
 C_ASSERT( offsetof(struct create_file_request, attrs) == 28 );
-C_ASSERT( sizeof(struct create_file_request) == 32 );
+C_ASSERT( offsetof(struct create_file_request, want_fd) == 32 );
+C_ASSERT( sizeof(struct create_file_request) == 40 );
 C_ASSERT( offsetof(struct create_file_reply, handle) == 8 );
-C_ASSERT( sizeof(struct create_file_reply) == 16 );
+C_ASSERT( offsetof(struct create_file_reply, type) == 12 );
+C_ASSERT( offsetof(struct create_file_reply, access) == 16 );
+C_ASSERT( offsetof(struct create_file_reply, options) == 20 );
+C_ASSERT( sizeof(struct create_file_reply) == 24 );
 C_ASSERT( offsetof(struct open_file_object_request, access) == 12 );
 C_ASSERT( offsetof(struct open_file_object_request, attributes) == 16 );
 C_ASSERT( offsetof(struct open_file_object_request, rootdir) == 20 );
@@ -1092,14 +1116,23 @@ C_ASSERT( sizeof(struct get_mapping_info_request) == 24 );
 C_ASSERT( offsetof(struct get_mapping_info_reply, size) == 8 );
 C_ASSERT( offsetof(struct get_mapping_info_reply, flags) == 16 );
 C_ASSERT( offsetof(struct get_mapping_info_reply, shared_file) == 20 );
-C_ASSERT( offsetof(struct get_mapping_info_reply, name_len) == 24 );
-C_ASSERT( offsetof(struct get_mapping_info_reply, ver_len) == 28 );
-C_ASSERT( offsetof(struct get_mapping_info_reply, total) == 32 );
-C_ASSERT( sizeof(struct get_mapping_info_reply) == 40 );
+C_ASSERT( offsetof(struct get_mapping_info_reply, relocated_file) == 24 );
+C_ASSERT( offsetof(struct get_mapping_info_reply, relocated_build) == 28 );
+C_ASSERT( offsetof(struct get_mapping_info_reply, name_len) == 32 );
+C_ASSERT( offsetof(struct get_mapping_info_reply, ver_len) == 36 );
+C_ASSERT( offsetof(struct get_mapping_info_reply, total) == 40 );
+C_ASSERT( sizeof(struct get_mapping_info_reply) == 48 );
 C_ASSERT( offsetof(struct get_image_map_address_request, handle) == 12 );
 C_ASSERT( sizeof(struct get_image_map_address_request) == 16 );
 C_ASSERT( offsetof(struct get_image_map_address_reply, addr) == 8 );
 C_ASSERT( sizeof(struct get_image_map_address_reply) == 16 );
+C_ASSERT( offsetof(struct create_relocated_image_request, handle) == 12 );
+C_ASSERT( sizeof(struct create_relocated_image_request) == 16 );
+C_ASSERT( offsetof(struct create_relocated_image_reply, file) == 8 );
+C_ASSERT( sizeof(struct create_relocated_image_reply) == 16 );
+C_ASSERT( offsetof(struct set_relocated_image_request, handle) == 12 );
+C_ASSERT( offsetof(struct set_relocated_image_request, success) == 16 );
+C_ASSERT( sizeof(struct set_relocated_image_request) == 24 );
 C_ASSERT( offsetof(struct map_view_request, mapping) == 12 );
 C_ASSERT( offsetof(struct map_view_request, access) == 16 );
 C_ASSERT( offsetof(struct map_view_request, base) == 24 );
@@ -1225,7 +1258,9 @@ C_ASSERT( offsetof(struct get_key_value_request, hkey) == 12 );
 C_ASSERT( sizeof(struct get_key_value_request) == 16 );
 C_ASSERT( offsetof(struct get_key_value_reply, type) == 8 );
 C_ASSERT( offsetof(struct get_key_value_reply, total) == 12 );
-C_ASSERT( sizeof(struct get_key_value_reply) == 16 );
+C_ASSERT( offsetof(struct get_key_value_reply, serial) == 16 );
+C_ASSERT( offsetof(struct get_key_value_reply, serial_slot) == 24 );
+C_ASSERT( sizeof(struct get_key_value_reply) == 32 );
 C_ASSERT( offsetof(struct enum_key_value_request, hkey) == 12 );
 C_ASSERT( offsetof(struct enum_key_value_request, index) == 16 );
 C_ASSERT( offsetof(struct enum_key_value_request, info_class) == 20 );
@@ -2189,6 +2224,23 @@ C_ASSERT( offsetof(struct query_completion_request, handle) == 12 );
 C_ASSERT( sizeof(struct query_completion_request) == 16 );
 C_ASSERT( offsetof(struct query_completion_reply, depth) == 8 );
 C_ASSERT( sizeof(struct query_completion_reply) == 16 );
+C_ASSERT( offsetof(struct create_wait_completion_packet_request, access) == 12 );
+C_ASSERT( sizeof(struct create_wait_completion_packet_request) == 16 );
+C_ASSERT( offsetof(struct create_wait_completion_packet_reply, handle) == 8 );
+C_ASSERT( sizeof(struct create_wait_completion_packet_reply) == 16 );
+C_ASSERT( offsetof(struct associate_wait_completion_packet_request, packet) == 12 );
+C_ASSERT( offsetof(struct associate_wait_completion_packet_request, completion) == 16 );
+C_ASSERT( offsetof(struct associate_wait_completion_packet_request, target) == 20 );
+C_ASSERT( offsetof(struct associate_wait_completion_packet_request, ckey) == 24 );
+C_ASSERT( offsetof(struct associate_wait_completion_packet_request, cvalue) == 32 );
+C_ASSERT( offsetof(struct associate_wait_completion_packet_request, information) == 40 );
+C_ASSERT( offsetof(struct associate_wait_completion_packet_request, status) == 48 );
+C_ASSERT( sizeof(struct associate_wait_completion_packet_request) == 56 );
+C_ASSERT( offsetof(struct associate_wait_completion_packet_reply, signaled) == 8 );
+C_ASSERT( sizeof(struct associate_wait_completion_packet_reply) == 16 );
+C_ASSERT( offsetof(struct cancel_wait_completion_packet_request, packet) == 12 );
+C_ASSERT( offsetof(struct cancel_wait_completion_packet_request, remove_signaled) == 16 );
+C_ASSERT( sizeof(struct cancel_wait_completion_packet_request) == 24 );
 C_ASSERT( offsetof(struct set_completion_info_request, handle) == 12 );
 C_ASSERT( offsetof(struct set_completion_info_request, ckey) == 16 );
 C_ASSERT( offsetof(struct set_completion_info_request, chandle) == 24 );
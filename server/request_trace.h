@@ -167,6 +167,21 @@ static void dump_init_thread_reply( const struct init_thread_reply *req )
     fprintf( stderr, " suspend=%d", req->suspend );
 }
 
+static void dump_init_request_ring_request( const struct init_request_ring_request *req )
+{
+}
+
+static void dump_init_request_ring_reply( const struct init_request_ring_reply *req )
+{
+    fprintf( stderr, " ring=%04x", req->ring );
+    fprintf( stderr, ", doorbell=%04x", req->doorbell );
+}
+
+static void dump_set_request_slot_request( const struct set_request_slot_request *req )
+{
+    fprintf( stderr, " slot=%d", req->slot );
+}
+
 static void dump_terminate_process_request( const struct terminate_process_request *req )
 {
     fprintf( stderr, " handle=%04x", req->handle );
@@ -626,6 +641,7 @@ static void dump_create_file_request( const struct create_file_request *req )
     fprintf( stderr, ", create=%d", req->create );
     fprintf( stderr, ", options=%08x", req->options );
     fprintf( stderr, ", attrs=%08x", req->attrs );
+    fprintf( stderr, ", want_fd=%d", req->want_fd );
     dump_varargs_object_attributes( ", objattr=", cur_size );
     dump_varargs_string( ", filename=", cur_size );
 }
@@ -633,6 +649,9 @@ static void dump_create_file_request( const struct create_file_request *req )
 static void dump_create_file_reply( const struct create_file_reply *req )
 {
     fprintf( stderr, " handle=%04x", req->handle );
+    fprintf( stderr, ", type=%d", req->type );
+    fprintf( stderr, ", access=%08x", req->access );
+    fprintf( stderr, ", options=%08x", req->options );
 }
 
 static void dump_open_file_object_request( const struct open_file_object_request *req )
@@ -884,6 +903,8 @@ static void dump_get_mapping_info_reply( const struct get_mapping_info_reply *re
     dump_uint64( " size=", &req->size );
     fprintf( stderr, ", flags=%08x", req->flags );
     fprintf( stderr, ", shared_file=%04x", req->shared_file );
+    fprintf( stderr, ", relocated_file=%04x", req->relocated_file );
+    fprintf( stderr, ", relocated_build=%d", req->relocated_build );
     fprintf( stderr, ", name_len=%u", req->name_len );
     fprintf( stderr, ", ver_len=%u", req->ver_len );
     fprintf( stderr, ", total=%u", req->total );
@@ -903,6 +924,22 @@ static void dump_get_image_map_address_reply( const struct get_image_map_address
     dump_uint64( " addr=", &req->addr );
 }
 
+static void dump_create_relocated_image_request( const struct create_relocated_image_request *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+}
+
+static void dump_create_relocated_image_reply( const struct create_relocated_image_reply *req )
+{
+    fprintf( stderr, " file=%04x", req->file );
+}
+
+static void dump_set_relocated_image_request( const struct set_relocated_image_request *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+    fprintf( stderr, ", success=%d", req->success );
+}
+
 static void dump_map_view_request( const struct map_view_request *req )
 {
     fprintf( stderr, " mapping=%04x", req->mapping );
@@ -1161,6 +1198,8 @@ static void dump_get_key_value_reply( const struct get_key_value_reply *req )
 {
     fprintf( stderr, " type=%d", req->type );
     fprintf( stderr, ", total=%u", req->total );
+    dump_uint64( ", serial=", &req->serial );
+    fprintf( stderr, ", serial_slot=%08x", req->serial_slot );
     dump_varargs_bytes( ", data=", cur_size );
 }
 
@@ -3143,6 +3182,39 @@ static void dump_query_completion_reply( const struct query_completion_reply *re
     fprintf( stderr, " depth=%08x", req->depth );
 }
 
+static void dump_create_wait_completion_packet_request( const struct create_wait_completion_packet_request *req )
+{
+    fprintf( stderr, " access=%08x", req->access );
+    dump_varargs_object_attributes( ", objattr=", cur_size );
+}
+
+static void dump_create_wait_completion_packet_reply( const struct create_wait_completion_packet_reply *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+}
+
+static void dump_associate_wait_completion_packet_request( const struct associate_wait_completion_packet_request *req )
+{
+    fprintf( stderr, " packet=%04x", req->packet );
+    fprintf( stderr, ", completion=%04x", req->completion );
+    fprintf( stderr, ", target=%04x", req->target );
+    dump_uint64( ", ckey=", &req->ckey );
+    dump_uint64( ", cvalue=", &req->cvalue );
+    dump_uint64( ", information=", &req->information );
+    fprintf( stderr, ", status=%08x", req->status );
+}
+
+static void dump_associate_wait_completion_packet_reply( const struct associate_wait_completion_packet_reply *req )
+{
+    fprintf( stderr, " signaled=%d", req->signaled );
+}
+
+static void dump_cancel_wait_completion_packet_request( const struct cancel_wait_completion_packet_request *req )
+{
+    fprintf( stderr, " packet=%04x", req->packet );
+    fprintf( stderr, ", remove_signaled=%d", req->remove_signaled );
+}
+
 static void dump_set_completion_info_request( const struct set_completion_info_request *req )
 {
     fprintf( stderr, " handle=%04x", req->handle );
@@ -3523,6 +3595,8 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] =
     (dump_func)dump_init_process_done_request,
     (dump_func)dump_init_first_thread_request,
     (dump_func)dump_init_thread_request,
+    (dump_func)dump_init_request_ring_request,
+    (dump_func)dump_set_request_slot_request,
     (dump_func)dump_terminate_process_request,
     (dump_func)dump_terminate_thread_request,
     (dump_func)dump_get_process_info_request,
@@ -3583,6 +3657,8 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] =
     (dump_func)dump_open_mapping_request,
     (dump_func)dump_get_mapping_info_request,
     (dump_func)dump_get_image_map_address_request,
+    (dump_func)dump_create_relocated_image_request,
+    (dump_func)dump_set_relocated_image_request,
     (dump_func)dump_map_view_request,
     (dump_func)dump_map_image_view_request,
     (dump_func)dump_map_builtin_view_request,
@@ -3785,6 +3861,9 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] =
     (dump_func)dump_remove_completion_request,
     (dump_func)dump_get_thread_completion_request,
     (dump_func)dump_query_completion_request,
+    (dump_func)dump_create_wait_completion_packet_request,
+    (dump_func)dump_associate_wait_completion_packet_request,
+    (dump_func)dump_cancel_wait_completion_packet_request,
     (dump_func)dump_set_completion_info_request,
     (dump_func)dump_add_fd_completion_request,
     (dump_func)dump_set_fd_completion_mode_request,
@@ -3833,6 +3912,8 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] =
     (dump_func)dump_init_process_done_reply,
     (dump_func)dump_init_first_thread_reply,
     (dump_func)dump_init_thread_reply,
+    (dump_func)dump_init_request_ring_reply,
+    NULL,
     (dump_func)dump_terminate_process_reply,
     (dump_func)dump_terminate_thread_reply,
     (dump_func)dump_get_process_info_reply,
@@ -3893,6 +3974,8 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] =
     (dump_func)dump_open_mapping_reply,
     (dump_func)dump_get_mapping_info_reply,
     (dump_func)dump_get_image_map_address_reply,
+    (dump_func)dump_create_relocated_image_reply,
+    NULL,
     NULL,
     NULL,
     NULL,
@@ -4095,6 +4178,9 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] =
     (dump_func)dump_remove_completion_reply,
     (dump_func)dump_get_thread_completion_reply,
     (dump_func)dump_query_completion_reply,
+    (dump_func)dump_create_wait_completion_packet_reply,
+    (dump_func)dump_associate_wait_completion_packet_reply,
+    NULL,
     NULL,
     NULL,
     NULL,
@@ -4143,6 +4229,8 @@ static const char * const req_names[REQ_NB_REQUESTS] =
     "init_process_done",
     "init_first_thread",
     "init_thread",
+    "init_request_ring",
+    "set_request_slot",
     "terminate_process",
     "terminate_thread",
     "get_process_info",
@@ -4203,6 +4291,8 @@ static const char * const req_names[REQ_NB_REQUESTS] =
     "open_mapping",
     "get_mapping_info",
     "get_image_map_address",
+    "create_relocated_image",
+    "set_relocated_image",
     "map_view",
     "map_image_view",
     "map_builtin_view",
@@ -4405,6 +4495,9 @@ static const char * const req_names[REQ_NB_REQUESTS] =
     "remove_completion",
     "get_thread_completion",
     "query_completion",
+    "create_wait_completion_packet",
+    "associate_wait_completion_packet",
+    "cancel_wait_completion_packet",
     "set_completion_info",
     "add_fd_completion",
     "set_fd_completion_mode",
@@ -4517,6 +4610,7 @@ static const struct
     { "INVALID_LOCK_SEQUENCE",       STATUS_INVALID_LOCK_SEQUENCE },
     { "INVALID_OWNER",               STATUS_INVALID_OWNER },
     { "INVALID_PARAMETER",           STATUS_INVALID_PARAMETER },
+    { "INVALID_PARAMETER_1",         STATUS_INVALID_PARAMETER_1 },
     { "INVALID_PARAMETER_2",         STATUS_INVALID_PARAMETER_2 },
     { "INVALID_PIPE_STATE",          STATUS_INVALID_PIPE_STATE },
     { "INVALID_READ_MODE",           STATUS_INVALID_READ_MODE },
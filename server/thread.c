@@ -76,6 +76,8 @@ struct thread_wait
     abstime_t               when;
     struct timeout_user    *user;
     int                     status;     /* status to return (unless STATUS_PENDING) */
+    wait_callback_t         callback;   /* callback for waits not blocking a thread */
+    void                   *arg;        /* callback argument */
     struct wait_queue_entry queues[1];
 };
 
@@ -410,11 +412,14 @@ static inline void init_thread_structure( struct thread *thread )
     thread->error           = 0;
     thread->req_data        = NULL;
     thread->req_toread      = 0;
+    thread->req_buffer      = NULL;
+    thread->req_buffer_size = 0;
     thread->reply_data      = NULL;
     thread->reply_towrite   = 0;
     thread->request_fd      = NULL;
     thread->reply_fd        = NULL;
     thread->wait_fd         = NULL;
+    thread->request_slot    = -1;
     thread->state           = RUNNING;
     thread->exit_code       = 0;
     thread->priority        = 0;
@@ -619,8 +624,9 @@ static void cleanup_thread( struct thread *thread )
     }
     clear_apc_queue( &thread->system_apc );
     clear_apc_queue( &thread->user_apc );
-    free( thread->req_data );
+    free( thread->req_buffer );
     free( thread->reply_data );
+    release_request_slot( thread );
     if (thread->request_fd) release_object( thread->request_fd );
     if (thread->reply_fd) release_object( thread->reply_fd );
     if (thread->wait_fd) release_object( thread->wait_fd );
@@ -638,6 +644,8 @@ static void cleanup_thread( struct thread *thread )
     }
     free( thread->desc );
     thread->req_data = NULL;
+    thread->req_buffer = NULL;
+    thread->req_buffer_size = 0;
     thread->reply_data = NULL;
     thread->request_fd = NULL;
     thread->reply_fd = NULL;
@@ -1117,6 +1125,8 @@ static int wait_on( const union select_op *select_op, unsigned int count, struct
     wait->user    = NULL;
     wait->when = when;
     wait->abandoned = 0;
+    wait->callback = NULL;
+    wait->arg = NULL;
     current->wait = wait;
 
     for (i = 0, entry = wait->queues; i < count; i++, entry++)
@@ -1155,6 +1165,72 @@ static int wait_on_handles( const union select_op *select_op, unsigned int count
     return ret;
 }
 
+/* add a wait on a single object that invokes a callback instead of waking a thread */
+/* the wait is attributed to the current thread, it must not be used for objects that get owned */
+struct thread_wait *add_callback_wait( struct object *obj, wait_callback_t callback, void *arg )
+{
+    struct thread_wait *wait;
+    struct wait_queue_entry *entry;
+
+    if (!(wait = mem_alloc( sizeof(*wait) ))) return NULL;
+    wait->next      = NULL;
+    wait->thread    = (struct thread *)grab_object( current );
+    wait->count     = 1;
+    wait->flags     = 0;
+    wait->abandoned = 0;
+    wait->select    = SELECT_WAIT;
+    wait->key       = 0;
+    wait->cookie    = 0;
+    wait->when      = TIMEOUT_INFINITE;
+    wait->user      = NULL;
+    wait->status    = 0;
+    wait->callback  = callback;
+    wait->arg       = arg;
+
+    entry = wait->queues;
+    entry->wait = wait;
+    if (!object_sync_add_queue( obj, entry ))
+    {
+        release_object( wait->thread );
+        free( wait );
+        return NULL;
+    }
+    entry->obj = grab_object( obj );
+    return wait;
+}
+
+/* remove a callback wait without invoking the callback */
+void remove_callback_wait( struct thread_wait *wait )
+{
+    struct wait_queue_entry *entry = wait->queues;
+
+    assert( wait->callback );
+    object_sync_remove_queue( entry->obj, entry );
+    release_object( entry->obj );
+    release_object( wait->thread );
+    free( wait );
+}
+
+/* invoke a callback wait if its object is signaled; the wait is freed in that case */
+int wake_callback_wait( struct thread_wait *wait )
+{
+    struct wait_queue_entry *entry = wait->queues;
+    wait_callback_t callback = wait->callback;
+    void *arg = wait->arg;
+    unsigned int status;
+
+    assert( callback );
+    if (!object_sync_signaled( entry->obj, entry )) return 0;
+
+    object_sync_satisfied( entry->obj, entry );
+    status = wait->status;
+    if (wait->abandoned) status += STATUS_ABANDONED_WAIT_0;
+    if (debug_level) fprintf( stderr, "%04x: *callback wakeup* signaled=%d\n", wait->thread->id, status );
+    remove_callback_wait( wait );
+    callback( arg, status );
+    return 1;
+}
+
 /* check if the thread waiting condition is satisfied */
 static int check_wait( struct thread *thread )
 {
@@ -1254,6 +1330,7 @@ int wake_thread_queue_entry( struct wait_queue_entry *entry )
     int signaled;
     client_ptr_t cookie;
 
+    if (wait->callback) return 0;  /* keyed events cannot be waited on with a callback */
     if (thread->wait != wait) return 0;  /* not the current wait */
     if (is_thread_suspended( thread )) return 0;  /* cannot acquire locks */
 
@@ -1392,7 +1469,9 @@ void wake_up( struct object *obj, int max )
     LIST_FOR_EACH( ptr, &obj->wait_queue )
     {
         struct wait_queue_entry *entry = LIST_ENTRY( ptr, struct wait_queue_entry, entry );
-        if (!(ret = wake_thread( get_wait_queue_thread( entry )))) continue;
+        if (entry->wait->callback) ret = wake_callback_wait( entry->wait );
+        else ret = wake_thread( get_wait_queue_thread( entry ));
+        if (!ret) continue;
         if (ret > 0 && max && !--max) break;
         /* restart at the head of the list since a wake up can change the object wait queue */
         ptr = &obj->wait_queue;
@@ -69,12 +69,15 @@ struct thread
     union generic_request  req;           /* current request */
     void                  *req_data;      /* variable-size data for request */
     unsigned int           req_toread;    /* amount of data still to read in request */
+    void                  *req_buffer;    /* buffer kept across requests for the variable-size data */
+    unsigned int           req_buffer_size; /* allocated size of the request buffer */
     void                  *reply_data;    /* variable-size data for reply */
     unsigned int           reply_size;    /* size of reply data */
     unsigned int           reply_towrite; /* amount of data still to write in reply */
     struct fd             *request_fd;    /* fd for receiving client requests */
     struct fd             *reply_fd;      /* fd to send a reply to a client */
     struct fd             *wait_fd;       /* fd to use to wake a sleeping client */
+    int                    request_slot;  /* slot in the process request ring, -1 if none */
     enum run_state         state;         /* running state */
     int                    exit_code;     /* thread exit code */
     int                    unix_pid;      /* Unix pid of client */
@@ -119,6 +122,9 @@ extern void set_wait_status( struct wait_queue_entry *entry, int status );
 extern void stop_thread( struct thread *thread );
 extern int wake_thread( struct thread *thread );
 extern int wake_thread_queue_entry( struct wait_queue_entry *entry );
+extern struct thread_wait *add_callback_wait( struct object *obj, wait_callback_t callback, void *arg );
+extern void remove_callback_wait( struct thread_wait *wait );
+extern int wake_callback_wait( struct thread_wait *wait );
 extern int add_queue( struct object *obj, struct wait_queue_entry *entry );
 extern void remove_queue( struct object *obj, struct wait_queue_entry *entry );
 extern void kill_thread( struct thread *thread, int violent_death );